@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "base/CCRef.h"
 #include "math/CCGeometry.h"
 #include "base/CCScriptSupport.h"
+#include "base/allocator/CCAllocatorMacros.h"
 
 NS_CC_BEGIN
 
@@ -181,6 +182,10 @@ protected:
 #if CC_ENABLE_SCRIPT_BINDING
     ccScriptType _scriptType;         ///< type of script binding, lua or javascript
 #endif
+    /** Index of the action in ActionManager's batched storage, or -1 if the action is stepped individually. */
+    ssize_t _batchIndex;
+
+    friend class ActionManager;
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Action);
 };
@@ -38,9 +38,26 @@ THE SOFTWARE.
 #include "base/CCEventDispatcher.h"
 #include "platform/CCStdC.h"
 #include "base/CCScriptSupport.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(Sequence, 64)
+CC_DEFINE_ALLOCATOR_POOL(Repeat, 64)
+CC_DEFINE_ALLOCATOR_POOL(RepeatForever, 64)
+CC_DEFINE_ALLOCATOR_POOL(Spawn, 64)
+CC_DEFINE_ALLOCATOR_POOL(RotateTo, 64)
+CC_DEFINE_ALLOCATOR_POOL(RotateBy, 64)
+CC_DEFINE_ALLOCATOR_POOL(MoveBy, 64)
+CC_DEFINE_ALLOCATOR_POOL(MoveTo, 64)
+CC_DEFINE_ALLOCATOR_POOL(ScaleTo, 64)
+CC_DEFINE_ALLOCATOR_POOL(ScaleBy, 64)
+CC_DEFINE_ALLOCATOR_POOL(FadeTo, 64)
+CC_DEFINE_ALLOCATOR_POOL(FadeIn, 64)
+CC_DEFINE_ALLOCATOR_POOL(FadeOut, 64)
+CC_DEFINE_ALLOCATOR_POOL(TintTo, 64)
+CC_DEFINE_ALLOCATOR_POOL(DelayTime, 64)
+
 // Extra action for making a Sequence or Spawn when only adding one action to it.
 class ExtraAction : public FiniteTimeAction
 {
@@ -118,6 +118,8 @@ protected:
 
 protected:
     bool sendUpdateEventToScript(float dt, Action *actionObject);
+
+    friend class ActionManager;
 };
 
 /** @class Sequence
@@ -126,6 +128,8 @@ protected:
 class CC_DLL Sequence : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(Sequence)
+
     /** Helper constructor to create an array of sequenceable actions.
      *
      * @return An autoreleased Sequence object.
@@ -213,6 +217,8 @@ private:
 class CC_DLL Repeat : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(Repeat)
+
     /** Creates a Repeat action. Times is an unsigned integer between 1 and pow(2,30).
      *
      * @param action The action needs to repeat.
@@ -284,6 +290,8 @@ private:
 class CC_DLL RepeatForever : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(RepeatForever)
+
     /** Creates the action.
      *
      * @param action The action need to repeat forever.
@@ -349,6 +357,8 @@ private:
 class CC_DLL Spawn : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(Spawn)
+
     /** Helper constructor to create an array of spawned actions.
      * @code
      * When this function bound to the js or lua, the input params changed.
@@ -438,6 +448,8 @@ private:
 class CC_DLL RotateTo : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(RotateTo)
+
     /** 
      * Creates the action with separate rotation angles.
      *
@@ -505,6 +517,8 @@ protected:
     Vec3 _startAngle;
     Vec3 _diffAngle;
 
+    friend class ActionManager;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(RotateTo);
 };
@@ -515,6 +529,8 @@ private:
 class CC_DLL RotateBy : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(RotateBy)
+
     /** 
      * Creates the action.
      *
@@ -585,6 +601,8 @@ private:
 class CC_DLL MoveBy : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(MoveBy)
+
     /** 
      * Creates the action.
      *
@@ -627,6 +645,8 @@ protected:
     Vec3 _startPosition;
     Vec3 _previousPosition;
 
+    friend class ActionManager;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(MoveBy);
 };
@@ -640,6 +660,8 @@ private:
 class CC_DLL MoveTo : public MoveBy
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(MoveTo)
+
     /** 
      * Creates the action.
      * @param duration Duration time, in seconds.
@@ -1050,6 +1072,8 @@ private:
 class CC_DLL ScaleTo : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(ScaleTo)
+
     /** 
      * Creates the action with the same scale factor for X and Y.
      * @param duration Duration time, in seconds.
@@ -1122,6 +1146,8 @@ protected:
     float _deltaY;
     float _deltaZ;
 
+    friend class ActionManager;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(ScaleTo);
 };
@@ -1133,6 +1159,8 @@ private:
 class CC_DLL ScaleBy : public ScaleTo
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(ScaleBy)
+
     /** 
      * Creates the action with the same scale factor for X and Y.
      * @param duration Duration time, in seconds.
@@ -1227,6 +1255,8 @@ private:
 class CC_DLL FadeTo : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(FadeTo)
+
     /** 
      * Creates an action with duration and opacity.
      * @param duration Duration time, in seconds.
@@ -1261,6 +1291,7 @@ protected:
     GLubyte _fromOpacity;
     friend class FadeOut;
     friend class FadeIn;
+    friend class ActionManager;
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(FadeTo);
 };
@@ -1272,6 +1303,8 @@ private:
 class CC_DLL FadeIn : public FadeTo
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(FadeIn)
+
     /** 
      * Creates the action.
      * @param d Duration time, in seconds.
@@ -1307,6 +1340,8 @@ private:
 class CC_DLL FadeOut : public FadeTo
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(FadeOut)
+
     /** 
      * Creates the action.
      * @param d Duration time, in seconds.
@@ -1341,6 +1376,8 @@ private:
 class CC_DLL TintTo : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(TintTo)
+
     /** 
      * Creates an action with duration and color.
      * @param duration Duration time, in seconds.
@@ -1380,6 +1417,8 @@ protected:
     Color3B _to;
     Color3B _from;
 
+    friend class ActionManager;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(TintTo);
 };
@@ -1438,6 +1477,8 @@ private:
 class CC_DLL DelayTime : public ActionInterval
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(DelayTime)
+
     /** 
      * Creates the action.
      * @param d Duration time, in seconds.
@@ -29,6 +29,9 @@ THE SOFTWARE.
 #include "2d/CCActionManager.h"
 #include "2d/CCNode.h"
 #include "2d/CCAction.h"
+#include "2d/CCActionInterval.h"
+#include "2d/CCActionEase.h"
+#include "2d/CCTweenFunction.h"
 #include "base/CCScheduler.h"
 #include "base/ccMacros.h"
 #include "base/ccCArray.h"
@@ -49,12 +52,197 @@ typedef struct _hashElement
     UT_hash_handle      hh;
 } tHashElement;
 
+//
+// batched actions
+//
+
+typedef float (*tEaseFunc)(float);
+typedef float (*tEaseRateFunc)(float, float);
+
+enum class BatchedActionType : unsigned char
+{
+    MOVE,
+    SCALE,
+    ROTATE,
+    ROTATE_3D,
+    FADE,
+    TINT
+};
+
+// Structure of arrays holding the state of the batched actions.
+// Every vector has one entry per action; removed entries are swapped with the last one.
+typedef struct _batchedActions
+{
+    std::vector<ActionInterval*>    actions;        // the outermost action, retained by the actions array of its hash element
+    std::vector<tHashElement*>      elements;
+    std::vector<BatchedActionType>  types;
+    std::vector<tEaseFunc>          easeFuncs;
+    std::vector<tEaseRateFunc>      easeRateFuncs;
+    std::vector<float>              easeRates;
+    std::vector<float>              durations;
+    std::vector<float>              elapsed;
+    std::vector<float>              nextElapsed;    // elapsed time after the step of the current frame
+    std::vector<float>              firstTicks;     // 1 until the first unpaused step, then 0
+    std::vector<float>              actives;        // 1 once advanced in the current frame, until applied by its target
+    std::vector<float>              times;
+    std::vector<float>              starts[3];
+    std::vector<float>              deltas[3];
+    std::vector<float>              previous[3];    // last position set by a move, used by stackable actions
+    std::vector<float>              values[3];
+
+    // While locked, removed entries are only cleared, and compacted once the update is over
+    bool                            locked;
+    bool                            hasRemovedEntries;
+} tBatchedActions;
+
+static const struct
+{
+    const std::type_info *type;
+    tEaseFunc func;
+} s_easeFuncs[] = {
+    { &typeid(EaseExponentialIn), tweenfunc::expoEaseIn },
+    { &typeid(EaseExponentialOut), tweenfunc::expoEaseOut },
+    { &typeid(EaseExponentialInOut), tweenfunc::expoEaseInOut },
+    { &typeid(EaseSineIn), tweenfunc::sineEaseIn },
+    { &typeid(EaseSineOut), tweenfunc::sineEaseOut },
+    { &typeid(EaseSineInOut), tweenfunc::sineEaseInOut },
+    { &typeid(EaseBounceIn), tweenfunc::bounceEaseIn },
+    { &typeid(EaseBounceOut), tweenfunc::bounceEaseOut },
+    { &typeid(EaseBounceInOut), tweenfunc::bounceEaseInOut },
+    { &typeid(EaseBackIn), tweenfunc::backEaseIn },
+    { &typeid(EaseBackOut), tweenfunc::backEaseOut },
+    { &typeid(EaseBackInOut), tweenfunc::backEaseInOut },
+    { &typeid(EaseQuadraticActionIn), tweenfunc::quadraticIn },
+    { &typeid(EaseQuadraticActionOut), tweenfunc::quadraticOut },
+    { &typeid(EaseQuadraticActionInOut), tweenfunc::quadraticInOut },
+    { &typeid(EaseQuarticActionIn), tweenfunc::quartEaseIn },
+    { &typeid(EaseQuarticActionOut), tweenfunc::quartEaseOut },
+    { &typeid(EaseQuarticActionInOut), tweenfunc::quartEaseInOut },
+    { &typeid(EaseQuinticActionIn), tweenfunc::quintEaseIn },
+    { &typeid(EaseQuinticActionOut), tweenfunc::quintEaseOut },
+    { &typeid(EaseQuinticActionInOut), tweenfunc::quintEaseInOut },
+    { &typeid(EaseCircleActionIn), tweenfunc::circEaseIn },
+    { &typeid(EaseCircleActionOut), tweenfunc::circEaseOut },
+    { &typeid(EaseCircleActionInOut), tweenfunc::circEaseInOut },
+    { &typeid(EaseCubicActionIn), tweenfunc::cubicEaseIn },
+    { &typeid(EaseCubicActionOut), tweenfunc::cubicEaseOut },
+    { &typeid(EaseCubicActionInOut), tweenfunc::cubicEaseInOut },
+};
+
+static const struct
+{
+    const std::type_info *type;
+    tEaseRateFunc func;
+} s_easeRateFuncs[] = {
+    { &typeid(EaseIn), tweenfunc::easeIn },
+    { &typeid(EaseOut), tweenfunc::easeOut },
+    { &typeid(EaseInOut), tweenfunc::easeInOut },
+};
+
+static void removeBatchedActionAtIndex(tBatchedActions *batch, size_t index)
+{
+    size_t last = batch->actions.size() - 1;
+    if (index != last)
+    {
+        batch->actions[index] = batch->actions[last];
+        batch->elements[index] = batch->elements[last];
+        batch->types[index] = batch->types[last];
+        batch->easeFuncs[index] = batch->easeFuncs[last];
+        batch->easeRateFuncs[index] = batch->easeRateFuncs[last];
+        batch->easeRates[index] = batch->easeRates[last];
+        batch->durations[index] = batch->durations[last];
+        batch->elapsed[index] = batch->elapsed[last];
+        batch->nextElapsed[index] = batch->nextElapsed[last];
+        batch->firstTicks[index] = batch->firstTicks[last];
+        batch->actives[index] = batch->actives[last];
+        batch->times[index] = batch->times[last];
+        for (int c = 0; c < 3; ++c)
+        {
+            batch->starts[c][index] = batch->starts[c][last];
+            batch->deltas[c][index] = batch->deltas[c][last];
+            batch->previous[c][index] = batch->previous[c][last];
+            batch->values[c][index] = batch->values[c][last];
+        }
+    }
+
+    batch->actions.pop_back();
+    batch->elements.pop_back();
+    batch->types.pop_back();
+    batch->easeFuncs.pop_back();
+    batch->easeRateFuncs.pop_back();
+    batch->easeRates.pop_back();
+    batch->durations.pop_back();
+    batch->elapsed.pop_back();
+    batch->nextElapsed.pop_back();
+    batch->firstTicks.pop_back();
+    batch->actives.pop_back();
+    batch->times.pop_back();
+    for (int c = 0; c < 3; ++c)
+    {
+        batch->starts[c].pop_back();
+        batch->deltas[c].pop_back();
+        batch->previous[c].pop_back();
+        batch->values[c].pop_back();
+    }
+}
+
+// Computes the next step of the actions in [begin, end) without applying it, the active ones are the unpaused ones
+static void advanceBatchedActions(tBatchedActions *batch, size_t begin, size_t end, float dt)
+{
+    tHashElement **elements = batch->elements.data();
+    const float *durations = batch->durations.data();
+    const float *elapsed = batch->elapsed.data();
+    const float *firstTicks = batch->firstTicks.data();
+    float *nextElapsed = batch->nextElapsed.data();
+    float *actives = batch->actives.data();
+    float *times = batch->times.data();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        actives[i] = (elements[i] == nullptr || elements[i]->paused) ? 0.0f : 1.0f;
+    }
+
+    // Same as ActionInterval::step(): the first step only resets the elapsed time
+    for (size_t i = begin; i < end; ++i)
+    {
+        float first = firstTicks[i] * actives[i];
+        nextElapsed[i] = (elapsed[i] + dt * actives[i]) * (1.0f - first);
+        times[i] = MAX(0.0f, MIN(1.0f, nextElapsed[i] / durations[i]));
+    }
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (batch->easeFuncs[i])
+        {
+            times[i] = batch->easeFuncs[i](times[i]);
+        }
+        else if (batch->easeRateFuncs[i])
+        {
+            times[i] = batch->easeRateFuncs[i](times[i], batch->easeRates[i]);
+        }
+    }
+
+    for (int c = 0; c < 3; ++c)
+    {
+        const float *starts = batch->starts[c].data();
+        const float *deltas = batch->deltas[c].data();
+        float *values = batch->values[c].data();
+        for (size_t i = begin; i < end; ++i)
+        {
+            values[i] = starts[i] + deltas[i] * times[i];
+        }
+    }
+}
+
 ActionManager::ActionManager()
 : _targets(nullptr),
   _currentTarget(nullptr),
-  _currentTargetSalvaged(false)
+  _currentTargetSalvaged(false),
+  _batchedActions(nullptr)
 {
-
+    _batchedActions = new tBatchedActions();
+    _batchedActions->locked = false;
+    _batchedActions->hasRemovedEntries = false;
 }
 
 ActionManager::~ActionManager()
@@ -62,12 +250,299 @@ ActionManager::~ActionManager()
     CCLOGINFO("deallocing ActionManager: %p", this);
 
     removeAllActions();
+
+    CC_SAFE_DELETE(_batchedActions);
+}
+
+// batched actions
+
+void ActionManager::addBatchedAction(Action *action, tHashElement *element)
+{
+#if CC_ENABLE_SCRIPT_BINDING
+    // script actions may receive their updates from the script engine
+    if (action->_scriptType != kScriptTypeNone)
+    {
+        return;
+    }
+#endif
+
+    // Only the exact types are batched: subclasses may override update()
+    ActionInterval *outer = dynamic_cast<ActionInterval*>(action);
+    if (outer == nullptr)
+    {
+        return;
+    }
+
+    ActionInterval *inner = outer;
+    tEaseFunc easeFunc = nullptr;
+    tEaseRateFunc easeRateFunc = nullptr;
+    float easeRate = 0;
+
+    const std::type_info &outerType = typeid(*outer);
+    for (const auto &ease : s_easeFuncs)
+    {
+        if (*ease.type == outerType)
+        {
+            easeFunc = ease.func;
+            break;
+        }
+    }
+    for (const auto &ease : s_easeRateFuncs)
+    {
+        if (*ease.type == outerType)
+        {
+            easeRateFunc = ease.func;
+            easeRate = static_cast<EaseRateAction*>(outer)->getRate();
+            break;
+        }
+    }
+    if (easeFunc || easeRateFunc)
+    {
+        inner = static_cast<ActionEase*>(outer)->getInnerAction();
+    }
+
+    BatchedActionType type;
+    float starts[3] = { 0, 0, 0 };
+    float deltas[3] = { 0, 0, 0 };
+
+    const std::type_info &innerType = typeid(*inner);
+    if (innerType == typeid(MoveTo) || innerType == typeid(MoveBy))
+    {
+        auto move = static_cast<MoveBy*>(inner);
+        type = BatchedActionType::MOVE;
+        starts[0] = move->_startPosition.x; starts[1] = move->_startPosition.y; starts[2] = move->_startPosition.z;
+        deltas[0] = move->_positionDelta.x; deltas[1] = move->_positionDelta.y; deltas[2] = move->_positionDelta.z;
+    }
+    else if (innerType == typeid(ScaleTo) || innerType == typeid(ScaleBy))
+    {
+        auto scale = static_cast<ScaleTo*>(inner);
+        type = BatchedActionType::SCALE;
+        starts[0] = scale->_startScaleX; starts[1] = scale->_startScaleY; starts[2] = scale->_startScaleZ;
+        deltas[0] = scale->_deltaX; deltas[1] = scale->_deltaY; deltas[2] = scale->_deltaZ;
+    }
+    else if (innerType == typeid(RotateTo))
+    {
+        auto rotate = static_cast<RotateTo*>(inner);
+        type = rotate->_is3D ? BatchedActionType::ROTATE_3D : BatchedActionType::ROTATE;
+        starts[0] = rotate->_startAngle.x; starts[1] = rotate->_startAngle.y; starts[2] = rotate->_startAngle.z;
+        deltas[0] = rotate->_diffAngle.x; deltas[1] = rotate->_diffAngle.y; deltas[2] = rotate->_diffAngle.z;
+    }
+    else if (innerType == typeid(FadeTo) || innerType == typeid(FadeIn) || innerType == typeid(FadeOut))
+    {
+        auto fade = static_cast<FadeTo*>(inner);
+        type = BatchedActionType::FADE;
+        starts[0] = fade->_fromOpacity;
+        deltas[0] = (float)(fade->_toOpacity - fade->_fromOpacity);
+    }
+    else if (innerType == typeid(TintTo))
+    {
+        auto tint = static_cast<TintTo*>(inner);
+        type = BatchedActionType::TINT;
+        starts[0] = tint->_from.r; starts[1] = tint->_from.g; starts[2] = tint->_from.b;
+        deltas[0] = (float)(tint->_to.r - tint->_from.r);
+        deltas[1] = (float)(tint->_to.g - tint->_from.g);
+        deltas[2] = (float)(tint->_to.b - tint->_from.b);
+    }
+    else
+    {
+        return;
+    }
+
+    tBatchedActions *batch = _batchedActions;
+    action->_batchIndex = batch->actions.size();
+
+    batch->actions.push_back(outer);
+    batch->elements.push_back(element);
+    batch->types.push_back(type);
+    batch->easeFuncs.push_back(easeFunc);
+    batch->easeRateFuncs.push_back(easeRateFunc);
+    batch->easeRates.push_back(easeRate);
+    batch->durations.push_back(outer->_duration);
+    batch->elapsed.push_back(outer->_elapsed);
+    batch->nextElapsed.push_back(outer->_elapsed);
+    batch->firstTicks.push_back(outer->_firstTick ? 1.0f : 0.0f);
+    batch->actives.push_back(0);
+    batch->times.push_back(0);
+    for (int c = 0; c < 3; ++c)
+    {
+        batch->starts[c].push_back(starts[c]);
+        batch->deltas[c].push_back(deltas[c]);
+        batch->previous[c].push_back(starts[c]);
+        batch->values[c].push_back(starts[c]);
+    }
+}
+
+void ActionManager::removeBatchedAction(Action *action)
+{
+    if (action == nullptr || action->_batchIndex < 0)
+    {
+        return;
+    }
+
+    tBatchedActions *batch = _batchedActions;
+    size_t index = action->_batchIndex;
+    action->_batchIndex = -1;
+
+    // Give back the state which only the batch kept up to date, the action may be stepped alone afterwards
+    ActionInterval *outer = batch->actions[index];
+    outer->_elapsed = batch->elapsed[index];
+    outer->_firstTick = batch->firstTicks[index] != 0;
+    if (batch->types[index] == BatchedActionType::MOVE)
+    {
+        ActionInterval *inner = (batch->easeFuncs[index] || batch->easeRateFuncs[index])
+            ? static_cast<ActionEase*>(outer)->getInnerAction() : outer;
+        auto move = static_cast<MoveBy*>(inner);
+        move->_startPosition.set(batch->starts[0][index], batch->starts[1][index], batch->starts[2][index]);
+        move->_previousPosition.set(batch->previous[0][index], batch->previous[1][index], batch->previous[2][index]);
+    }
+
+    if (batch->locked)
+    {
+        batch->actions[index] = nullptr;
+        batch->elements[index] = nullptr;
+        batch->actives[index] = 0;
+        batch->hasRemovedEntries = true;
+        return;
+    }
+
+    removeBatchedActionAtIndex(batch, index);
+    if (index < batch->actions.size())
+    {
+        batch->actions[index]->_batchIndex = index;
+    }
+}
+
+void ActionManager::removeBatchedActions(struct _ccArray *actions)
+{
+    if (actions == nullptr || _batchedActions->actions.empty())
+    {
+        return;
+    }
+
+    for (ssize_t i = 0; i < actions->num; ++i)
+    {
+        removeBatchedAction(static_cast<Action*>(actions->arr[i]));
+    }
+}
+
+void ActionManager::updateBatchedActions(float dt)
+{
+    tBatchedActions *batch = _batchedActions;
+    if (batch->actions.empty())
+    {
+        return;
+    }
+
+    // The entries stay at their index until the update is over, new actions are appended
+    batch->locked = true;
+    advanceBatchedActions(batch, 0, batch->actions.size(), dt);
+}
+
+void ActionManager::stepBatchedAction(Action *action, float dt)
+{
+    tBatchedActions *batch = _batchedActions;
+    size_t index = action->_batchIndex;
+
+    // Added, or its target resumed, during this update
+    if (batch->actives[index] == 0)
+    {
+        advanceBatchedActions(batch, index, index + 1, dt);
+    }
+    batch->actives[index] = 0;
+
+    // Keep the action in sync, so getElapsed() and isDone() keep working
+    batch->elapsed[index] = batch->nextElapsed[index];
+    batch->firstTicks[index] = 0;
+    ActionInterval *interval = batch->actions[index];
+    interval->_elapsed = batch->elapsed[index];
+    interval->_firstTick = false;
+
+    // Node setters may add or remove actions, so read everything through the vectors
+    Node *target = batch->elements[index]->target;
+    const float x = batch->values[0][index];
+    const float y = batch->values[1][index];
+    const float z = batch->values[2][index];
+
+    switch (batch->types[index])
+    {
+        case BatchedActionType::MOVE:
+        {
+#if CC_ENABLE_STACKABLE_ACTIONS
+            Vec3 currentPos = target->getPosition3D();
+            Vec3 diff(currentPos.x - batch->previous[0][index], currentPos.y - batch->previous[1][index], currentPos.z - batch->previous[2][index]);
+            batch->starts[0][index] += diff.x;
+            batch->starts[1][index] += diff.y;
+            batch->starts[2][index] += diff.z;
+            Vec3 newPos(x + diff.x, y + diff.y, z + diff.z);
+            batch->previous[0][index] = newPos.x;
+            batch->previous[1][index] = newPos.y;
+            batch->previous[2][index] = newPos.z;
+            target->setPosition3D(newPos);
+#else
+            target->setPosition3D(Vec3(x, y, z));
+#endif // CC_ENABLE_STACKABLE_ACTIONS
+            break;
+        }
+        case BatchedActionType::SCALE:
+            target->setScaleX(x);
+            target->setScaleY(y);
+            target->setScaleZ(z);
+            break;
+        case BatchedActionType::ROTATE:
+#if CC_USE_PHYSICS
+            if (batch->starts[0][index] == batch->starts[1][index] && batch->deltas[0][index] == batch->deltas[1][index])
+            {
+                target->setRotation(x);
+            }
+            else
+            {
+                target->setRotationSkewX(x);
+                target->setRotationSkewY(y);
+            }
+#else
+            target->setRotationSkewX(x);
+            target->setRotationSkewY(y);
+#endif // CC_USE_PHYSICS
+            break;
+        case BatchedActionType::ROTATE_3D:
+            target->setRotation3D(Vec3(x, y, z));
+            break;
+        case BatchedActionType::FADE:
+            target->setOpacity((GLubyte)x);
+            break;
+        case BatchedActionType::TINT:
+            target->setColor(Color3B((GLubyte)x, (GLubyte)y, (GLubyte)z));
+            break;
+    }
+}
+
+void ActionManager::compactBatchedActions()
+{
+    tBatchedActions *batch = _batchedActions;
+    batch->locked = false;
+
+    if (batch->hasRemovedEntries)
+    {
+        batch->hasRemovedEntries = false;
+        for (size_t i = batch->actions.size(); i > 0; --i)
+        {
+            if (batch->actions[i - 1] == nullptr)
+            {
+                removeBatchedActionAtIndex(batch, i - 1);
+                if (i - 1 < batch->actions.size())
+                {
+                    batch->actions[i - 1]->_batchIndex = i - 1;
+                }
+            }
+        }
+    }
 }
 
 // private
 
 void ActionManager::deleteHashElement(tHashElement *element)
 {
+    removeBatchedActions(element->actions);
     ccArrayFree(element->actions);
     HASH_DEL(_targets, element);
     element->target->release();
@@ -98,6 +573,7 @@ void ActionManager::removeActionAtIndex(ssize_t index, tHashElement *element)
         element->currentActionSalvaged = true;
     }
 
+    removeBatchedAction(action);
     ccArrayRemoveObjectAtIndex(element->actions, index, true);
 
     // update actionIndex in case we are in tick. looping over the actions
@@ -193,6 +669,10 @@ void ActionManager::addAction(Action *action, Node *target, bool paused)
      ccArrayAppendObject(element->actions, action);
  
      action->startWithTarget(target);
+
+#if CC_ENABLE_BATCHED_ACTIONS
+     addBatchedAction(action, element);
+#endif
 }
 
 // remove
@@ -225,6 +705,7 @@ void ActionManager::removeAllActionsFromTarget(Node *target)
             element->currentActionSalvaged = true;
         }
 
+        removeBatchedActions(element->actions);
         ccArrayRemoveAllObjects(element->actions);
         if (_currentTarget == element)
         {
@@ -427,6 +908,9 @@ size_t ActionManager::getNumberOfRunningActionsInTargetByTag(const Node *target,
 // main loop
 void ActionManager::update(float dt)
 {
+    // the batched actions are computed together, and applied in the order of the actions of their target
+    updateBatchedActions(dt);
+
     for (tHashElement *elt = _targets; elt != nullptr; )
     {
         _currentTarget = elt;
@@ -440,13 +924,14 @@ void ActionManager::update(float dt)
             {
                 _currentTarget->currentAction = static_cast<Action*>(_currentTarget->actions->arr[_currentTarget->actionIndex]);
                 if (_currentTarget->currentAction == nullptr)
-                {
                     continue;
-                }
 
                 _currentTarget->currentActionSalvaged = false;
 
-                _currentTarget->currentAction->step(dt);
+                if (_currentTarget->currentAction->_batchIndex >= 0)
+                    stepBatchedAction(_currentTarget->currentAction, dt);
+                else
+                    _currentTarget->currentAction->step(dt);
 
                 if (_currentTarget->currentActionSalvaged)
                 {
@@ -487,6 +972,8 @@ void ActionManager::update(float dt)
 
     // issue #635
     _currentTarget = nullptr;
+
+    compactBatchedActions();
 }
 
 NS_CC_END
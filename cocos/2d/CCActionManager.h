@@ -38,6 +38,7 @@ NS_CC_BEGIN
 class Action;
 
 struct _hashElement;
+struct _batchedActions;
 
 /**
  * @addtogroup actions
@@ -199,10 +200,20 @@ protected:
     void deleteHashElement(struct _hashElement *element);
     void actionAllocWithHashElement(struct _hashElement *element);
 
+    // batched actions specific
+
+    void addBatchedAction(Action *action, struct _hashElement *element);
+    void removeBatchedAction(Action *action);
+    void removeBatchedActions(struct _ccArray *actions);
+    void updateBatchedActions(float dt);
+    void stepBatchedAction(Action *action, float dt);
+    void compactBatchedActions();
+
 protected:
     struct _hashElement    *_targets;
     struct _hashElement    *_currentTarget;
     bool            _currentTargetSalvaged;
+    struct _batchedActions *_batchedActions;
 };
 
 // end of actions group
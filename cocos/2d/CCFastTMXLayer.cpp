@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "2d/CCFastTMXTiledMap.h"
 #include "2d/CCSprite.h"
 #include "2d/CCCamera.h"
+#include "2d/CCTMXCompiledMap.h"
 #include "renderer/CCTextureCache.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/ccGLStateCache.h"
@@ -52,6 +53,10 @@ namespace experimental {
 const int TMXLayer::FAST_TMX_ORIENTATION_ORTHO = 0;
 const int TMXLayer::FAST_TMX_ORIENTATION_HEX = 1;
 const int TMXLayer::FAST_TMX_ORIENTATION_ISO = 2;
+const int TMXLayer::CHUNK_SIZE = 32;
+
+// frames after which a chunk out of view is released
+static const unsigned int CHUNK_RELEASE_FRAMES = 60;
 
 // FastTMXLayer - init & alloc & dealloc
 TMXLayer * TMXLayer::create(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *layerInfo, TMXMapInfo *mapInfo)
@@ -79,7 +84,12 @@ bool TMXLayer::initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *la
     _layerName = layerInfo->_name;
     _layerSize = layerInfo->_layerSize;
     _tiles = layerInfo->_tiles;
+    _compiledMap = layerInfo->_compiledMap;
+    CC_SAFE_RETAIN(_compiledMap);
+    _compiledLayer = layerInfo->_compiledLayer;
     _quadsDirty = true;
+    _chunksWide = ((int)_layerSize.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    _chunksHigh = ((int)_layerSize.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
     setOpacity( layerInfo->_opacity );
     setProperties(layerInfo->getProperties());
 
@@ -113,6 +123,8 @@ TMXLayer::TMXLayer()
 , _layerSize(Size::ZERO)
 , _mapTileSize(Size::ZERO)
 , _tiles(nullptr)
+, _compiledMap(nullptr)
+, _compiledLayer(-1)
 , _tileSet(nullptr)
 , _layerOrientation(FAST_TMX_ORIENTATION_ORTHO)
 , _texture(nullptr)
@@ -120,9 +132,8 @@ TMXLayer::TMXLayer()
 , _useAutomaticVertexZ(false)
 , _quadsDirty(true)
 , _dirty(true)
-, _vertexBuffer(nullptr)
-, _vData(nullptr)
-, _indexBuffer(nullptr)
+, _chunksWide(0)
+, _chunksHigh(0)
 {
 }
 
@@ -131,15 +142,18 @@ TMXLayer::~TMXLayer()
     CC_SAFE_RELEASE(_tileSet);
     CC_SAFE_RELEASE(_texture);
     CC_SAFE_FREE(_tiles);
-    CC_SAFE_RELEASE(_vData);
-    CC_SAFE_RELEASE(_vertexBuffer);
-    CC_SAFE_RELEASE(_indexBuffer);
-    
+    CC_SAFE_RELEASE(_compiledMap);
+    releaseChunks();
 }
 
 void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
 {
-    updateTotalQuads();
+    if (_quadsDirty)
+    {
+        releaseChunks();
+        _quadsDirty = false;
+        _dirty = true;
+    }
 
     bool isViewProjectionUpdated = true;
     auto visitingCamera = Camera::getVisitingCamera();
@@ -148,7 +162,7 @@ void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
         isViewProjectionUpdated = visitingCamera->isViewProjectionUpdated();
     }
     
-    if( flags != 0 || _dirty || _quadsDirty || isViewProjectionUpdated)
+    if( flags != 0 || _dirty || isViewProjectionUpdated)
     {
         Size s = Director::getInstance()->getVisibleSize();
         auto rect = Rect(Camera::getVisitingCamera()->getPositionX() - s.width * 0.5f,
@@ -160,24 +174,29 @@ void TMXLayer::draw(Renderer *renderer, const Mat4& transform, uint32_t flags)
         inv.inverse();
         rect = RectApplyTransform(rect, inv);
         
-        updateTiles(rect);
-        updateIndexBuffer();
-        updatePrimitives();
+        updateVisibleChunks(rect, transform);
         _dirty = false;
     }
     
-    if(_renderCommands.size() < static_cast<size_t>(_primitives.size()))
+    size_t commandCount = 0;
+    for (auto chunk : _visibleChunks)
+    {
+        updateChunk(chunk);
+        commandCount += chunk->primitives.size();
+    }
+
+    if(_renderCommands.size() < commandCount)
     {
-        _renderCommands.resize(_primitives.size());
+        _renderCommands.resize(commandCount);
     }
     
+    auto blendfunc = _texture->hasPremultipliedAlpha() ? BlendFunc::ALPHA_PREMULTIPLIED : BlendFunc::ALPHA_NON_PREMULTIPLIED;
     int index = 0;
-    for(const auto& iter : _primitives)
+    for (auto chunk : _visibleChunks)
     {
-        if(iter.second->getCount() > 0)
+        for(const auto& iter : chunk->primitives)
         {
             auto& cmd = _renderCommands[index++];
-            auto blendfunc = _texture->hasPremultipliedAlpha() ? BlendFunc::ALPHA_PREMULTIPLIED : BlendFunc::ALPHA_NON_PREMULTIPLIED;
             cmd.init(iter.first, _texture->getName(), getGLProgramState(), blendfunc, iter.second, _modelViewTransform, flags);
             renderer->addCommand(&cmd);
         }
@@ -196,7 +215,7 @@ void TMXLayer::onDraw(Primitive *primitive)
     CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, primitive->getCount() * 4);
 }
 
-void TMXLayer::updateTiles(const Rect& culledRect)
+void TMXLayer::updateVisibleChunks(const Rect& culledRect, const Mat4& transform)
 {
     Rect visibleTiles = Rect(culledRect.origin, culledRect.size * Director::getInstance()->getContentScaleFactor());
     Size mapTileSize = CC_SIZE_PIXELS_TO_POINTS(_mapTileSize);
@@ -242,86 +261,364 @@ void TMXLayer::updateTiles(const Rect& culledRect)
         //CCASSERT(0, "TMX invalid value");
     }
     
-    _indicesVertexZNumber.clear();
-    
-    for(const auto& iter : _indicesVertexZOffsets)
-    {
-        _indicesVertexZNumber[iter.first] = iter.second;
-    }
-    
     int yBegin = std::max(0.f,visibleTiles.origin.y - tilesOverY);
     int yEnd = std::min(_layerSize.height,visibleTiles.origin.y + visibleTiles.size.height + tilesOverY);
     int xBegin = std::max(0.f,visibleTiles.origin.x - tilesOverX);
     int xEnd = std::min(_layerSize.width,visibleTiles.origin.x + visibleTiles.size.width + tilesOverX);
-    
-    for (int y =  yBegin; y < yEnd; ++y)
+
+    _visibleChunks.clear();
+    auto camera = Camera::getVisitingCamera();
+    auto frame = Director::getInstance()->getTotalFrames();
+    if (xBegin < xEnd && yBegin < yEnd)
     {
-        for (int x = xBegin; x < xEnd; ++x)
+        for (int chunkY = yBegin / CHUNK_SIZE; chunkY <= (yEnd - 1) / CHUNK_SIZE; ++chunkY)
         {
-            int tileIndex = getTileIndexByPos(x, y);
-            if(_tiles[tileIndex] == 0) continue;
-            
-            int vertexZ = getVertexZForPos(Vec2(x,y));
-            auto iter = _indicesVertexZNumber.find(vertexZ);
-            int offset = iter->second;
-            iter->second++;
-            
-            int quadIndex = _tileToQuadIndex[tileIndex];
-            CC_ASSERT(-1 != quadIndex);
-            _indices[6 * offset + 0] = quadIndex * 4 + 0;
-            _indices[6 * offset + 1] = quadIndex * 4 + 1;
-            _indices[6 * offset + 2] = quadIndex * 4 + 2;
-            _indices[6 * offset + 3] = quadIndex * 4 + 3;
-            _indices[6 * offset + 4] = quadIndex * 4 + 2;
-            _indices[6 * offset + 5] = quadIndex * 4 + 1;
-            
-        } // for x
-    } // for y
-    
-    for(const auto& iter : _indicesVertexZOffsets)
+            for (int chunkX = xBegin / CHUNK_SIZE; chunkX <= (xEnd - 1) / CHUNK_SIZE; ++chunkX)
+            {
+                // the culled rect is computed for a camera looking straight at the layer, the frustum catches the other cases
+                AABB bounds = getChunkBounds(chunkX, chunkY);
+                bounds.transform(transform);
+                if (camera && !camera->isVisibleInFrustum(&bounds))
+                {
+                    continue;
+                }
+
+                auto chunk = getChunk(chunkX, chunkY);
+                chunk->lastVisibleFrame = frame;
+                _visibleChunks.push_back(chunk);
+            }
+        }
+    }
+
+    for (auto it = _chunks.begin(); it != _chunks.end(); )
+    {
+        if (frame - it->second->lastVisibleFrame > CHUNK_RELEASE_FRAMES)
+        {
+            delete it->second;
+            it = _chunks.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // streamed tiles are loaded again from the compiled map when they are needed
+    for (auto it = _tileChunks.begin(); it != _tileChunks.end(); )
     {
-        _indicesVertexZNumber[iter.first] -= iter.second;
-        if(_indicesVertexZNumber[iter.first] == 0)
+        if (!it->second.modified && frame - it->second.lastUsedFrame > CHUNK_RELEASE_FRAMES)
         {
-            _indicesVertexZNumber.erase(iter.first);
+            it = _tileChunks.erase(it);
         }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+TMXLayer::Chunk::Chunk()
+: x(0)
+, y(0)
+, vertexBuffer(nullptr)
+, vertexData(nullptr)
+, indexBuffer(nullptr)
+, dirtyQuadBegin(0)
+, dirtyQuadEnd(0)
+, needsRebuild(true)
+, lastVisibleFrame(0)
+{
+}
+
+TMXLayer::Chunk::~Chunk()
+{
+    for (auto& iter : primitives)
+    {
+        iter.second->release();
     }
+    CC_SAFE_RELEASE(vertexData);
+    CC_SAFE_RELEASE(vertexBuffer);
+    CC_SAFE_RELEASE(indexBuffer);
+}
+
+TMXLayer::Chunk* TMXLayer::getChunk(int chunkX, int chunkY)
+{
+    int key = chunkX + chunkY * _chunksWide;
+    auto it = _chunks.find(key);
+    if (it != _chunks.end())
+    {
+        return it->second;
+    }
+
+    auto chunk = new (std::nothrow) Chunk();
+    chunk->x = chunkX;
+    chunk->y = chunkY;
+    _chunks[key] = chunk;
+    return chunk;
+}
+
+AABB TMXLayer::getChunkBounds(int chunkX, int chunkY)
+{
+    int xBegin = chunkX * CHUNK_SIZE;
+    int yBegin = chunkY * CHUNK_SIZE;
+    int xLast = std::min(xBegin + CHUNK_SIZE, (int)_layerSize.width) - 1;
+    int yLast = std::min(yBegin + CHUNK_SIZE, (int)_layerSize.height) - 1;
+    Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
+    float tileSizeMax = std::max(tileSize.width, tileSize.height);
+
+    // the node position and the vertexZ of a tile are linear in its coordinate, the extremes are at the corner tiles
+    AABB bounds;
+    const int corners[4][2] = { { xBegin, yBegin }, { xLast, yBegin }, { xBegin, yLast }, { xLast, yLast } };
+    for (auto& corner : corners)
+    {
+        Vec3 points[2];
+        points[0].set(float(corner[0]), float(corner[1]), 0);
+        _tileToNodeTransform.transformPoint(&points[0]);
+        points[0].z = (float)getVertexZForPos(Vec2(corner[0], corner[1]));
+        points[1] = points[0] + Vec3(tileSizeMax, tileSizeMax, 0);
+        bounds.updateMinMax(points, 2);
+    }
+    return bounds;
+}
+
+int TMXLayer::setupTileQuad(V3F_C4B_T2F_Quad& quad, int x, int y, uint32_t tileGID)
+{
+    Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
+    Size texSize = _tileSet->_imageSize;
+
+    Vec3 nodePos(float(x), float(y), 0);
+    _tileToNodeTransform.transformPoint(&nodePos);
+    
+    float left, right, top, bottom, z;
+    
+    z = getVertexZForPos(Vec2(x, y));
+    // vertices
+    if (tileGID & kTMXTileDiagonalFlag)
+    {
+        left = nodePos.x;
+        right = nodePos.x + tileSize.height;
+        bottom = nodePos.y + tileSize.width;
+        top = nodePos.y;
+    }
+    else
+    {
+        left = nodePos.x;
+        right = nodePos.x + tileSize.width;
+        bottom = nodePos.y + tileSize.height;
+        top = nodePos.y;
+    }
+    
+    if(tileGID & kTMXTileVerticalFlag)
+        std::swap(top, bottom);
+    if(tileGID & kTMXTileHorizontalFlag)
+        std::swap(left, right);
+    
+    if(tileGID & kTMXTileDiagonalFlag)
+    {
+        // FIXME: not working correctly
+        quad.bl.vertices.x = left;
+        quad.bl.vertices.y = bottom;
+        quad.bl.vertices.z = z;
+        quad.br.vertices.x = left;
+        quad.br.vertices.y = top;
+        quad.br.vertices.z = z;
+        quad.tl.vertices.x = right;
+        quad.tl.vertices.y = bottom;
+        quad.tl.vertices.z = z;
+        quad.tr.vertices.x = right;
+        quad.tr.vertices.y = top;
+        quad.tr.vertices.z = z;
+    }
+    else
+    {
+        quad.bl.vertices.x = left;
+        quad.bl.vertices.y = bottom;
+        quad.bl.vertices.z = z;
+        quad.br.vertices.x = right;
+        quad.br.vertices.y = bottom;
+        quad.br.vertices.z = z;
+        quad.tl.vertices.x = left;
+        quad.tl.vertices.y = top;
+        quad.tl.vertices.z = z;
+        quad.tr.vertices.x = right;
+        quad.tr.vertices.y = top;
+        quad.tr.vertices.z = z;
+    }
+    
+    // texcoords
+    Rect tileTexture = _tileSet->getRectForGID(tileGID);
+    left   = (tileTexture.origin.x / texSize.width);
+    right  = left + (tileTexture.size.width / texSize.width);
+    bottom = (tileTexture.origin.y / texSize.height);
+    top    = bottom + (tileTexture.size.height / texSize.height);
+    
+    quad.bl.texCoords.u = left;
+    quad.bl.texCoords.v = bottom;
+    quad.br.texCoords.u = right;
+    quad.br.texCoords.v = bottom;
+    quad.tl.texCoords.u = left;
+    quad.tl.texCoords.v = top;
+    quad.tr.texCoords.u = right;
+    quad.tr.texCoords.v = top;
     
+    quad.bl.colors = Color4B::WHITE;
+    quad.br.colors = Color4B::WHITE;
+    quad.tl.colors = Color4B::WHITE;
+    quad.tr.colors = Color4B::WHITE;
+
+    return (int)z;
 }
 
-void TMXLayer::updateVertexBuffer()
+void TMXLayer::buildChunk(Chunk* chunk)
 {
+    int xBegin = chunk->x * CHUNK_SIZE;
+    int yBegin = chunk->y * CHUNK_SIZE;
+    int xEnd = std::min(xBegin + CHUNK_SIZE, (int)_layerSize.width);
+    int yEnd = std::min(yBegin + CHUNK_SIZE, (int)_layerSize.height);
+
+    chunk->tileToQuadIndex.assign(CHUNK_SIZE * CHUNK_SIZE, -1);
+    chunk->quads.clear();
+    std::vector<int> quadsVertexZ;
+    // number of quads of each vertexZ, then offset of the first one in the indices
+    std::map<int, int> vertexZOffsets;
+    for (int y = yBegin; y < yEnd; ++y)
+    {
+        for (int x = xBegin; x < xEnd; ++x)
+        {
+            uint32_t tileGID = getFlaggedTileGIDByIndex(getTileIndexByPos(x, y));
+            if (tileGID == 0) continue;
+
+            chunk->tileToQuadIndex[(x - xBegin) + (y - yBegin) * CHUNK_SIZE] = (int)chunk->quads.size();
+            chunk->quads.push_back(V3F_C4B_T2F_Quad());
+            int z = setupTileQuad(chunk->quads.back(), x, y, tileGID);
+            quadsVertexZ.push_back(z);
+            ++vertexZOffsets[z];
+        }
+    }
+
+    std::map<int, int> vertexZCounts = vertexZOffsets;
+    int offset = 0;
+    for(auto& vertexZOffset : vertexZOffsets)
+    {
+        std::swap(offset, vertexZOffset.second);
+        offset += vertexZOffset.second;
+    }
+
+    int quadCount = (int)chunk->quads.size();
+    chunk->indices.resize(6 * quadCount);
+    std::map<int, int> nextOffsets = vertexZOffsets;
+    for (int quadIndex = 0; quadIndex < quadCount; ++quadIndex)
+    {
+        int index = nextOffsets[quadsVertexZ[quadIndex]]++;
+        chunk->indices[6 * index + 0] = quadIndex * 4 + 0;
+        chunk->indices[6 * index + 1] = quadIndex * 4 + 1;
+        chunk->indices[6 * index + 2] = quadIndex * 4 + 2;
+        chunk->indices[6 * index + 3] = quadIndex * 4 + 3;
+        chunk->indices[6 * index + 4] = quadIndex * 4 + 2;
+        chunk->indices[6 * index + 5] = quadIndex * 4 + 1;
+    }
+
+    for (auto& iter : chunk->primitives)
+    {
+        iter.second->release();
+    }
+    chunk->primitives.clear();
+    chunk->needsRebuild = false;
+    chunk->dirtyQuadBegin = chunk->dirtyQuadEnd = 0;
+
+    if (quadCount == 0)
+    {
+        return;
+    }
+
     GL::bindVAO(0);
-    if(nullptr == _vData)
+    if (chunk->vertexBuffer == nullptr || chunk->vertexBuffer->getVertexNumber() < quadCount * 4)
     {
-        _vertexBuffer = VertexBuffer::create(sizeof(V3F_C4B_T2F), (int)_totalQuads.size() * 4);
-        _vData = VertexData::create();
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(0, GLProgram::VERTEX_ATTRIB_POSITION, GL_FLOAT, 3));
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, colors), GLProgram::VERTEX_ATTRIB_COLOR, GL_UNSIGNED_BYTE, 4, true));
-        _vData->setStream(_vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, texCoords), GLProgram::VERTEX_ATTRIB_TEX_COORD, GL_FLOAT, 2));
-        CC_SAFE_RETAIN(_vData);
-        CC_SAFE_RETAIN(_vertexBuffer);
+        CC_SAFE_RELEASE_NULL(chunk->vertexData);
+        CC_SAFE_RELEASE_NULL(chunk->vertexBuffer);
+        chunk->vertexBuffer = VertexBuffer::create(sizeof(V3F_C4B_T2F), quadCount * 4);
+        chunk->vertexData = VertexData::create();
+        chunk->vertexData->setStream(chunk->vertexBuffer, VertexStreamAttribute(0, GLProgram::VERTEX_ATTRIB_POSITION, GL_FLOAT, 3));
+        chunk->vertexData->setStream(chunk->vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, colors), GLProgram::VERTEX_ATTRIB_COLOR, GL_UNSIGNED_BYTE, 4, true));
+        chunk->vertexData->setStream(chunk->vertexBuffer, VertexStreamAttribute(offsetof(V3F_C4B_T2F, texCoords), GLProgram::VERTEX_ATTRIB_TEX_COORD, GL_FLOAT, 2));
+        CC_SAFE_RETAIN(chunk->vertexData);
+        CC_SAFE_RETAIN(chunk->vertexBuffer);
     }
-    if(_vertexBuffer)
+    if (chunk->indexBuffer == nullptr || chunk->indexBuffer->getIndexNumber() < quadCount * 6)
     {
-        _vertexBuffer->updateVertices((void*)&_totalQuads[0], (int)_totalQuads.size() * 4, 0);
+        CC_SAFE_RELEASE_NULL(chunk->indexBuffer);
+        chunk->indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, quadCount * 6);
+        CC_SAFE_RETAIN(chunk->indexBuffer);
+    }
+    chunk->vertexBuffer->updateVertices((void*)&chunk->quads[0], quadCount * 4, 0);
+    chunk->indexBuffer->updateIndices(&chunk->indices[0], quadCount * 6, 0);
+
+    for (const auto& iter : vertexZOffsets)
+    {
+        auto primitive = Primitive::create(chunk->vertexData, chunk->indexBuffer, GL_TRIANGLES);
+        primitive->setStart(iter.second * 6);
+        primitive->setCount(vertexZCounts[iter.first] * 6);
+        primitive->retain();
+        chunk->primitives[iter.first] = primitive;
     }
-    
 }
 
-void TMXLayer::updateIndexBuffer()
+void TMXLayer::updateChunk(Chunk* chunk)
 {
-    if(nullptr == _indexBuffer)
+    if (chunk->needsRebuild)
     {
-#ifdef CC_FAST_TILEMAP_32_BIT_INDICES
-        _indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_UINT_32, (int)_indices.size());
-#else
-        _indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)_indices.size());
-#endif
-        CC_SAFE_RETAIN(_indexBuffer);
+        buildChunk(chunk);
+    }
+    else if (chunk->dirtyQuadBegin < chunk->dirtyQuadEnd)
+    {
+        chunk->vertexBuffer->updateVertices((void*)&chunk->quads[chunk->dirtyQuadBegin],
+            (chunk->dirtyQuadEnd - chunk->dirtyQuadBegin) * 4, chunk->dirtyQuadBegin * 4);
+        chunk->dirtyQuadBegin = chunk->dirtyQuadEnd = 0;
+    }
+}
+
+void TMXLayer::updateTileQuad(int tileIndex)
+{
+    int x = tileIndex % (int)_layerSize.width;
+    int y = tileIndex / (int)_layerSize.width;
+    auto it = _chunks.find(x / CHUNK_SIZE + (y / CHUNK_SIZE) * _chunksWide);
+    // a chunk that is not built reads the tile when it comes into view
+    if (it == _chunks.end() || it->second->needsRebuild)
+    {
+        return;
+    }
+
+    auto chunk = it->second;
+    int quadIndex = chunk->tileToQuadIndex[(x % CHUNK_SIZE) + (y % CHUNK_SIZE) * CHUNK_SIZE];
+    uint32_t tileGID = getFlaggedTileGIDByIndex(tileIndex);
+    if (quadIndex < 0 || tileGID == 0)
+    {
+        // a tile was added or removed, the indices change
+        chunk->needsRebuild = true;
+        return;
+    }
+
+    setupTileQuad(chunk->quads[quadIndex], x, y, tileGID);
+    if (chunk->dirtyQuadBegin == chunk->dirtyQuadEnd)
+    {
+        chunk->dirtyQuadBegin = quadIndex;
+        chunk->dirtyQuadEnd = quadIndex + 1;
+    }
+    else
+    {
+        chunk->dirtyQuadBegin = std::min(chunk->dirtyQuadBegin, quadIndex);
+        chunk->dirtyQuadEnd = std::max(chunk->dirtyQuadEnd, quadIndex + 1);
     }
-    _indexBuffer->updateIndices(&_indices[0], (int)_indices.size(), 0);
-    
+}
+
+void TMXLayer::releaseChunks()
+{
+    for (auto& iter : _chunks)
+    {
+        delete iter.second;
+    }
+    _chunks.clear();
+    _visibleChunks.clear();
 }
 
 // FastTMXLayer - setup Tiles
@@ -417,165 +714,11 @@ Mat4 TMXLayer::tileToNodeTransform()
     
 }
 
-void TMXLayer::updatePrimitives()
-{
-    for(const auto& iter : _indicesVertexZNumber)
-    {
-        int start = _indicesVertexZOffsets.at(iter.first);
-        
-        auto primitiveIter= _primitives.find(iter.first);
-        if(primitiveIter == _primitives.end())
-        {
-            auto primitive = Primitive::create(_vData, _indexBuffer, GL_TRIANGLES);
-            primitive->setCount(iter.second * 6);
-            primitive->setStart(start * 6);
-            
-            _primitives.insert(iter.first, primitive);
-        }
-        else
-        {
-            primitiveIter->second->setCount(iter.second * 6);
-            primitiveIter->second->setStart(start * 6);
-        }
-    }
-}
-
-void TMXLayer::updateTotalQuads()
-{
-    if(_quadsDirty)
-    {
-        Size tileSize = CC_SIZE_PIXELS_TO_POINTS(_tileSet->_tileSize);
-        Size texSize = _tileSet->_imageSize;
-        _tileToQuadIndex.clear();
-        _totalQuads.resize(int(_layerSize.width * _layerSize.height));
-        _indices.resize(6 * int(_layerSize.width * _layerSize.height));
-        _tileToQuadIndex.resize(int(_layerSize.width * _layerSize.height),-1);
-        _indicesVertexZOffsets.clear();
-        
-        int quadIndex = 0;
-        for(int y = 0; y < _layerSize.height; ++y)
-        {
-            for(int x =0; x < _layerSize.width; ++x)
-            {
-                int tileIndex = getTileIndexByPos(x, y);
-                int tileGID = _tiles[tileIndex];
-                
-                if(tileGID == 0) continue;
-                
-                _tileToQuadIndex[tileIndex] = quadIndex;
-                
-                auto& quad = _totalQuads[quadIndex];
-                
-                Vec3 nodePos(float(x), float(y), 0);
-                _tileToNodeTransform.transformPoint(&nodePos);
-                
-                float left, right, top, bottom, z;
-                
-                z = getVertexZForPos(Vec2(x, y));
-                auto iter = _indicesVertexZOffsets.find(z);
-                if(iter == _indicesVertexZOffsets.end())
-                {
-                    _indicesVertexZOffsets[z] = 1;
-                }
-                else
-                {
-                    iter->second++;
-                }
-                // vertices
-                if (tileGID & kTMXTileDiagonalFlag)
-                {
-                    left = nodePos.x;
-                    right = nodePos.x + tileSize.height;
-                    bottom = nodePos.y + tileSize.width;
-                    top = nodePos.y;
-                }
-                else
-                {
-                    left = nodePos.x;
-                    right = nodePos.x + tileSize.width;
-                    bottom = nodePos.y + tileSize.height;
-                    top = nodePos.y;
-                }
-                
-                if(tileGID & kTMXTileVerticalFlag)
-                    std::swap(top, bottom);
-                if(tileGID & kTMXTileHorizontalFlag)
-                    std::swap(left, right);
-                
-                if(tileGID & kTMXTileDiagonalFlag)
-                {
-                    // FIXME: not working correctly
-                    quad.bl.vertices.x = left;
-                    quad.bl.vertices.y = bottom;
-                    quad.bl.vertices.z = z;
-                    quad.br.vertices.x = left;
-                    quad.br.vertices.y = top;
-                    quad.br.vertices.z = z;
-                    quad.tl.vertices.x = right;
-                    quad.tl.vertices.y = bottom;
-                    quad.tl.vertices.z = z;
-                    quad.tr.vertices.x = right;
-                    quad.tr.vertices.y = top;
-                    quad.tr.vertices.z = z;
-                }
-                else
-                {
-                    quad.bl.vertices.x = left;
-                    quad.bl.vertices.y = bottom;
-                    quad.bl.vertices.z = z;
-                    quad.br.vertices.x = right;
-                    quad.br.vertices.y = bottom;
-                    quad.br.vertices.z = z;
-                    quad.tl.vertices.x = left;
-                    quad.tl.vertices.y = top;
-                    quad.tl.vertices.z = z;
-                    quad.tr.vertices.x = right;
-                    quad.tr.vertices.y = top;
-                    quad.tr.vertices.z = z;
-                }
-                
-                // texcoords
-                Rect tileTexture = _tileSet->getRectForGID(tileGID);
-                left   = (tileTexture.origin.x / texSize.width);
-                right  = left + (tileTexture.size.width / texSize.width);
-                bottom = (tileTexture.origin.y / texSize.height);
-                top    = bottom + (tileTexture.size.height / texSize.height);
-                
-                quad.bl.texCoords.u = left;
-                quad.bl.texCoords.v = bottom;
-                quad.br.texCoords.u = right;
-                quad.br.texCoords.v = bottom;
-                quad.tl.texCoords.u = left;
-                quad.tl.texCoords.v = top;
-                quad.tr.texCoords.u = right;
-                quad.tr.texCoords.v = top;
-                
-                quad.bl.colors = Color4B::WHITE;
-                quad.br.colors = Color4B::WHITE;
-                quad.tl.colors = Color4B::WHITE;
-                quad.tr.colors = Color4B::WHITE;
-                
-                ++quadIndex;
-            }
-        }
-        
-        int offset = 0;
-        for(auto& vertexZOffset : _indicesVertexZOffsets)
-        {
-            std::swap(offset, vertexZOffset.second);
-            offset += vertexZOffset.second;
-        }
-        updateVertexBuffer();
-        
-        _quadsDirty = false;
-    }
-}
-
 // removing / getting tiles
 Sprite* TMXLayer::getTileAt(const Vec2& tileCoordinate)
 {
     CCASSERT( tileCoordinate.x < _layerSize.width && tileCoordinate.y < _layerSize.height && tileCoordinate.x >=0 && tileCoordinate.y >=0, "TMXLayer: invalid position");
-    CCASSERT( _tiles, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles || _compiledMap, "TMXLayer: the tiles map has been released");
     
     Sprite *tile = nullptr;
     int gid = this->getTileGIDAt(tileCoordinate);
@@ -615,12 +758,12 @@ Sprite* TMXLayer::getTileAt(const Vec2& tileCoordinate)
 int TMXLayer::getTileGIDAt(const Vec2& tileCoordinate, TMXTileFlags* flags/* = nullptr*/)
 {
     CCASSERT(tileCoordinate.x < _layerSize.width && tileCoordinate.y < _layerSize.height && tileCoordinate.x >=0 && tileCoordinate.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles || _compiledMap, "TMXLayer: the tiles map has been released");
     
     int idx = static_cast<int>(((int) tileCoordinate.x + (int) tileCoordinate.y * _layerSize.width));
     
     // Bits on the far end of the 32-bit global tile ID are used for tile flags
-    int tile = _tiles[idx];
+    int tile = getFlaggedTileGIDByIndex(idx);
     auto it = _spriteContainer.find(idx);
     
     // converted to sprite.
@@ -699,10 +842,45 @@ void TMXLayer::removeTileAt(const Vec2& tileCoordinate)
 
 void TMXLayer::setFlaggedTileGIDByIndex(int index, uint32_t gid)
 {
-    if(gid == _tiles[index]) return;
-    _tiles[index] = gid;
-    _quadsDirty = true;
-    _dirty = true;
+    if(gid == getFlaggedTileGIDByIndex(index)) return;
+    if (_tiles)
+    {
+        _tiles[index] = gid;
+    }
+    else
+    {
+        getStreamedTile(index, true) = gid;
+    }
+    updateTileQuad(index);
+}
+
+uint32_t TMXLayer::getFlaggedTileGIDByIndex(int index)
+{
+    return _tiles ? _tiles[index] : getStreamedTile(index, false);
+}
+
+uint32_t& TMXLayer::getStreamedTile(int index, bool modify)
+{
+    const int chunkSize = TMXCompiledMap::CHUNK_SIZE;
+    int width = (int)_layerSize.width;
+    int x = index % width;
+    int y = index / width;
+    int chunkX = x / chunkSize;
+    int chunkY = y / chunkSize;
+
+    auto& chunk = _tileChunks[chunkX + chunkY * ((width + chunkSize - 1) / chunkSize)];
+    if (chunk.tiles.empty())
+    {
+        chunk.tiles.resize(chunkSize * chunkSize);
+        chunk.modified = false;
+        if (!_compiledMap->loadChunk(_compiledLayer, chunkX, chunkY, chunk.tiles.data()))
+        {
+            std::fill(chunk.tiles.begin(), chunk.tiles.end(), 0);
+        }
+    }
+    chunk.lastUsedFrame = Director::getInstance()->getTotalFrames();
+    chunk.modified = chunk.modified || modify;
+    return chunk.tiles[(x % chunkSize) + (y % chunkSize) * chunkSize];
 }
 
 void TMXLayer::removeChild(Node* node, bool cleanup)
@@ -784,7 +962,7 @@ void TMXLayer::setTileGID(int gid, const Vec2& tileCoordinate)
 void TMXLayer::setTileGID(int gid, const Vec2& tileCoordinate, TMXTileFlags flags)
 {
     CCASSERT(tileCoordinate.x < _layerSize.width && tileCoordinate.y < _layerSize.height && tileCoordinate.x >=0 && tileCoordinate.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles || _compiledMap, "TMXLayer: the tiles map has been released");
     CCASSERT(gid == 0 || gid >= _tileSet->_firstGid, "TMXLayer: invalid gid" );
     
     TMXTileFlags currentFlags;
@@ -29,9 +29,11 @@ THE SOFTWARE.
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 #include "2d/CCNode.h"
 #include "2d/CCTMXXMLParser.h"
 #include "renderer/CCPrimitiveCommand.h"
+#include "3d/CCAABB.h"
 #include "base/CCMap.h"
 
 NS_CC_BEGIN
@@ -71,6 +73,11 @@ namespace experimental{
  
  * For further information, please see the programming guide:
  * http://www.cocos2d-iphone.org/wiki/doku.php/prog_guide:tiled_maps
+
+ * The layer is rendered in chunks of CHUNK_SIZE x CHUNK_SIZE tiles, each with its own vertex and index buffers.
+ * Only the chunks in the view of the camera are built and drawn, and the chunks that stay out of view are released,
+ * so the memory used by the quads depends on the size of the view rather than on the size of the layer.
+ * Changing a tile updates its quad in place, or rebuilds its chunk when a tile is added or removed.
  
  * @since v3.2
  * @js NA
@@ -184,6 +191,7 @@ public:
     void setMapTileSize(const Size& size) { _mapTileSize = size; }
     
     /** Pointer to the map of tiles.
+     * It is nullptr when the tiles are loaded from a compiled map, see TMXCompiledMap.
      * @js NA
      * @lua NA
      * @return The pointer to the map of tiles.
@@ -270,10 +278,49 @@ public:
     virtual void draw(Renderer *renderer, const Mat4& transform, uint32_t flags) override;
     void removeChild(Node* child, bool cleanup = true) override;
 
+    /** Number of tiles of a chunk side.
+     * @since v3.15
+     */
+    static const int CHUNK_SIZE;
+
 protected:
+    /** CHUNK_SIZE x CHUNK_SIZE tiles rendered with their own buffers, a chunk holds at most 16384 vertices */
+    struct Chunk
+    {
+        Chunk();
+        ~Chunk();
+
+        int x;
+        int y;
+        /** quad of each tile of the chunk, -1 for empty tiles */
+        std::vector<int> tileToQuadIndex;
+        std::vector<V3F_C4B_T2F_Quad> quads;
+        /** indices of the quads, sorted by vertexZ */
+        std::vector<GLushort> indices;
+        /** primitive drawing the quads of each vertexZ */
+        std::map<int/*vertexZ*/, Primitive*> primitives;
+        VertexBuffer* vertexBuffer;
+        VertexData* vertexData;
+        IndexBuffer* indexBuffer;
+        /** quads updated in place and not uploaded yet */
+        int dirtyQuadBegin;
+        int dirtyQuadEnd;
+        bool needsRebuild;
+        unsigned int lastVisibleFrame;
+    };
+
+    /** TMXCompiledMap::CHUNK_SIZE x TMXCompiledMap::CHUNK_SIZE tiles loaded from the compiled map */
+    struct TileChunk
+    {
+        std::vector<uint32_t> tiles;
+        /** a modified chunk is never released */
+        bool modified;
+        unsigned int lastUsedFrame;
+    };
 
     bool initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *layerInfo, TMXMapInfo *mapInfo);
-    void updateTiles(const Rect& culledRect);
+    /** Collects the chunks in the culled rect and in the frustum of the camera, and releases the chunks out of view for a while */
+    void updateVisibleChunks(const Rect& culledRect, const Mat4& transform);
     Vec2 calculateLayerOffset(const Vec2& offset);
 
     /* The layer recognizes some special properties, like cc_vertexz */
@@ -286,16 +333,26 @@ protected:
     
     //Flip flags is packed into gid
     void setFlaggedTileGIDByIndex(int index, uint32_t gid);
-    
-    //
-    void updateTotalQuads();
+    uint32_t getFlaggedTileGIDByIndex(int index);
+    /** Returns a tile streamed from the compiled map, loading its chunk if needed */
+    uint32_t& getStreamedTile(int index, bool modify);
     
     void onDraw(Primitive* primitive);
     int getTileIndexByPos(int x, int y) const { return x + y * (int) _layerSize.width; }
-    
-    void updateVertexBuffer();
-    void updateIndexBuffer();
-    void updatePrimitives();
+
+    /** Returns the chunk, creating it without quads if it was not built */
+    Chunk* getChunk(int chunkX, int chunkY);
+    /** Bounds of the quads of a chunk in node space */
+    AABB getChunkBounds(int chunkX, int chunkY);
+    /** Builds the quads, the indices and the buffers of a chunk */
+    void buildChunk(Chunk* chunk);
+    /** Rebuilds a chunk if needed, or uploads the quads updated in place */
+    void updateChunk(Chunk* chunk);
+    void releaseChunks();
+    /** Writes the quad of a tile, returns its vertexZ */
+    int setupTileQuad(V3F_C4B_T2F_Quad& quad, int x, int y, uint32_t tileGID);
+    /** Updates the quad of a changed tile in place, or marks its chunk to be rebuilt */
+    void updateTileQuad(int tileIndex);
 protected:
     
     //! name of the layer
@@ -307,6 +364,10 @@ protected:
     Size _mapTileSize;
     /** pointer to the map of tiles */
     uint32_t* _tiles;
+    /** when _tiles is nullptr, the tiles are loaded from this layer of a compiled map */
+    TMXCompiledMap* _compiledMap;
+    int _compiledLayer;
+    std::unordered_map<int, TileChunk> _tileChunks;
     /** Tileset information for the layer */
     TMXTilesetInfo* _tileSet;
     /** Layer orientation, which is the same as the map orientation */
@@ -330,28 +391,17 @@ protected:
     
     /** tile coordinate to node coordinate transform */
     Mat4 _tileToNodeTransform;
-    /** data for rendering */
+    /** every chunk must be built again */
     bool _quadsDirty;
-    std::vector<int> _tileToQuadIndex;
-    std::vector<V3F_C4B_T2F_Quad> _totalQuads;
-#ifdef CC_FAST_TILEMAP_32_BIT_INDICES
-    std::vector<GLuint> _indices;
-#else
-    std::vector<GLushort> _indices;
-#endif
-    std::map<int/*vertexZ*/, int/*offset to _indices by quads*/> _indicesVertexZOffsets;
-    std::unordered_map<int/*vertexZ*/, int/*number to quads*/> _indicesVertexZNumber;
     std::vector<PrimitiveCommand> _renderCommands;
     bool _dirty;
-    
-    VertexBuffer* _vertexBuffer;
-    
-    VertexData* _vData;
-    
-    IndexBuffer* _indexBuffer;
-    
-    Map<int , Primitive*> _primitives;
-    
+
+    int _chunksWide;
+    int _chunksHigh;
+    /** built chunks, by chunkX + chunkY * _chunksWide */
+    std::unordered_map<int, Chunk*> _chunks;
+    std::vector<Chunk*> _visibleChunks;
+
 public:
     /** Possible orientations of the TMX map */
     static const int FAST_TMX_ORIENTATION_ORTHO;
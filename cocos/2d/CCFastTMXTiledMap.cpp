@@ -26,6 +26,7 @@ THE SOFTWARE.
 ****************************************************************************/
 #include "2d/CCFastTMXTiledMap.h"
 #include "2d/CCFastTMXLayer.h"
+#include "2d/CCTMXCompiledMap.h"
 #include "base/ccUTF8.h"
 
 NS_CC_BEGIN
@@ -63,7 +64,8 @@ bool TMXTiledMap::initWithTMXFile(const std::string& tmxFile)
     
     setContentSize(Size::ZERO);
 
-    TMXMapInfo *mapInfo = TMXMapInfo::create(tmxFile);
+    // the layers load their tiles from the compiled map when there is one
+    TMXMapInfo *mapInfo = TMXMapInfo::create(tmxFile, true);
 
     if (! mapInfo)
     {
@@ -118,6 +120,22 @@ TMXTilesetInfo * TMXTiledMap::tilesetForLayer(TMXLayerInfo *layerInfo, TMXMapInf
     Size size = layerInfo->_layerSize;
     auto& tilesets = mapInfo->getTilesets();
 
+    if (layerInfo->_tiles == nullptr && layerInfo->_compiledMap)
+    {
+        // the same as the search below, from the largest gid of the layer
+        uint32_t maxGID = layerInfo->_compiledMap->getMaxGID(layerInfo->_compiledLayer);
+        for (auto iter = tilesets.crbegin(), iterCrend = tilesets.crend(); iter != iterCrend && maxGID != 0; ++iter)
+        {
+            TMXTilesetInfo* tilesetInfo = *iter;
+            if (tilesetInfo && maxGID >= static_cast<uint32_t>(tilesetInfo->_firstGid))
+            {
+                return tilesetInfo;
+            }
+        }
+        CCLOG("cocos2d: Warning: TMX Layer '%s' has no tiles", layerInfo->_name.c_str());
+        return nullptr;
+    }
+
     for (auto iter = tilesets.crbegin(), iterCrend = tilesets.crend(); iter != iterCrend; ++iter)
     {
         TMXTilesetInfo* tilesetInfo = *iter;
@@ -30,28 +30,43 @@
 #include "platform/android/jni/Java_org_cocos2dx_lib_Cocos2dxHelper.h"
 #endif
 #include "2d/CCFontFreeType.h"
+#include "2d/CCFontGlyphCache.h"
 #include "base/ccUTF8.h"
 #include "base/CCDirector.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "base/CCAsyncTaskPool.h"
+
+#include <algorithm>
+#include <mutex>
 
 NS_CC_BEGIN
 
 const int FontAtlas::CacheTextureWidth = 512;
 const int FontAtlas::CacheTextureHeight = 512;
+// 2 MB of alpha textures, a label rarely uses more than a texture
+const int FontAtlas::DefaultMaxPageCount = 8;
 const char* FontAtlas::CMD_PURGE_FONTATLAS = "__cc_PURGE_FONTATLAS";
 const char* FontAtlas::CMD_RESET_FONTATLAS = "__cc_RESET_FONTATLAS";
+const char* FontAtlas::CMD_UPDATE_FONTATLAS = "__cc_UPDATE_FONTATLAS";
+unsigned int FontAtlas::s_nextUniqueID = 0;
 
 FontAtlas::FontAtlas(Font &theFont) 
 : _font(&theFont)
 , _fontFreeType(nullptr)
 , _iconv(nullptr)
-, _currentPageData(nullptr)
+, _pageDataSize(0)
+, _maxPageCount(DefaultMaxPageCount)
+, _usageClock(0)
 , _fontAscender(0)
 , _rendererRecreatedListener(nullptr)
+, _glyphCache(nullptr)
+, _toBackgroundListener(nullptr)
+, _asyncRasterization(false)
+, _rasterFont(nullptr)
 , _antialiasEnabled(true)
-, _currLineHeight(0)
+, _uniqueID(++s_nextUniqueID)
 {
     _font->retain();
 
@@ -60,10 +75,6 @@ FontAtlas::FontAtlas(Font &theFont)
     {
         _lineHeight = _font->getFontMaxHeight();
         _fontAscender = _fontFreeType->getFontAscender();
-        auto texture = new (std::nothrow) Texture2D;
-        _currentPage = 0;
-        _currentPageOrigX = 0;
-        _currentPageOrigY = 0;
         _letterEdgeExtend = 2;
         _letterPadding = 0;
 
@@ -71,23 +82,15 @@ FontAtlas::FontAtlas(Font &theFont)
         {
             _letterPadding += 2 * FontFreeType::DistanceMapSpread;    
         }
-        _currentPageDataSize = CacheTextureWidth * CacheTextureHeight;
+        _pageDataSize = CacheTextureWidth * CacheTextureHeight;
         auto outlineSize = _fontFreeType->getOutlineSize();
         if(outlineSize > 0)
         {
             _lineHeight += 2 * outlineSize;
-            _currentPageDataSize *= 2;
+            _pageDataSize *= 2;
         }
 
-        _currentPageData = new (std::nothrow) unsigned char[_currentPageDataSize];
-        memset(_currentPageData, 0, _currentPageDataSize);
-
-        auto  pixelFormat = outlineSize > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8; 
-        texture->initWithData(_currentPageData, _currentPageDataSize, 
-            pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth,CacheTextureHeight) );
-
-        addTexture(texture,0);
-        texture->release();
+        addPage();
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
@@ -95,6 +98,15 @@ FontAtlas::FontAtlas(Font &theFont)
         _rendererRecreatedListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, CC_CALLBACK_1(FontAtlas::listenRendererRecreated, this));
         eventDispatcher->addEventListenerWithFixedPriority(_rendererRecreatedListener, 1);
 #endif
+
+#if CC_ENABLE_FONT_GLYPH_CACHE
+        _glyphCache = FontGlyphCache::create(_fontFreeType);
+        if (_glyphCache)
+        {
+            _toBackgroundListener = EventListenerCustom::create(EVENT_COME_TO_BACKGROUND, CC_CALLBACK_1(FontAtlas::saveGlyphCache, this));
+            Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(_toBackgroundListener, 1);
+        }
+#endif
     }
 }
 
@@ -109,11 +121,20 @@ FontAtlas::~FontAtlas()
     }
 #endif
 
+    if (_toBackgroundListener)
+    {
+        Director::getInstance()->getEventDispatcher()->removeEventListener(_toBackgroundListener);
+        _toBackgroundListener = nullptr;
+    }
+    cancelRasterJobs();
+    CC_SAFE_RELEASE(_rasterFont);
+
+    // saves the glyphs added since the last save
+    delete _glyphCache;
+
     _font->release();
     releaseTextures();
 
-    delete []_currentPageData;
-
 #if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32 && CC_TARGET_PLATFORM != CC_PLATFORM_WINRT && CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID
     if (_iconv)
     {
@@ -125,13 +146,21 @@ FontAtlas::~FontAtlas()
 
 void FontAtlas::reset()
 {
+    cancelRasterJobs();
     releaseTextures();
     
-    _currLineHeight = 0;
-    _currentPage = 0;
-    _currentPageOrigX = 0;
-    _currentPageOrigY = 0;
+    _pages.clear();
+    _glyphSlots.clear();
     _letterDefinitions.clear();
+
+    // the letters still in use are kept, they are rasterized again
+    for (auto it = _letterUsages.begin(); it != _letterUsages.end();)
+    {
+        if (it->second.references <= 0)
+            it = _letterUsages.erase(it);
+        else
+            ++it;
+    }
 }
 
 void FontAtlas::releaseTextures()
@@ -159,6 +188,14 @@ void FontAtlas::listenRendererRecreated(EventCustom * /*event*/)
     purgeTexturesAtlas();
 }
 
+void FontAtlas::saveGlyphCache(EventCustom * /*event*/)
+{
+    if (_glyphCache)
+    {
+        _glyphCache->save();
+    }
+}
+
 void FontAtlas::addLetterDefinition(char16_t utf16Char, const FontLetterDefinition &letterDefinition)
 {
     _letterDefinitions[utf16Char] = letterDefinition;
@@ -318,6 +355,19 @@ void FontAtlas::findNewCharacters(const std::u16string& u16Text, std::unordered_
     }
 }
 
+struct FontAtlas::RasterJob
+{
+    // only used on the cocos thread, nullptr once the job is cancelled
+    FontAtlas* atlas;
+    // only used by the rasterization thread while the job runs
+    FontFreeType* font;
+    std::vector<std::pair<char16_t, unsigned short>> letters;
+    std::vector<RasterizedGlyph> glyphs;
+    // held while a glyph is rendered
+    std::mutex mutex;
+    bool cancelled;
+};
+
 bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16Text)
 {
     if (_fontFreeType == nullptr)
@@ -327,124 +377,525 @@ bool FontAtlas::prepareLetterDefinitions(const std::u16string& utf16Text)
     
     std::unordered_map<unsigned short, unsigned short> codeMapOfNewChar;
     findNewCharacters(utf16Text, codeMapOfNewChar);
+    for (auto it = codeMapOfNewChar.begin(); !_pendingLetters.empty() && it != codeMapOfNewChar.end();)
+    {
+        if (isLetterPending(it->first))
+            it = codeMapOfNewChar.erase(it);
+        else
+            ++it;
+    }
     if (codeMapOfNewChar.empty())
     {
         return false;
     }
 
+    std::shared_ptr<RasterJob> job;
+    FontGlyphCache::Glyph cachedGlyph;
+    RasterizedGlyph rasterized;
+
+    for (auto&& it : codeMapOfNewChar)
+    {
+        if (_glyphCache && _glyphCache->findGlyph(it.second, cachedGlyph))
+        {
+            addGlyph(it.first, cachedGlyph);
+        }
+        else if (_asyncRasterization && _rasterFont)
+        {
+            if (!job)
+            {
+                job = std::make_shared<RasterJob>();
+                job->atlas = this;
+                job->font = _rasterFont;
+                job->cancelled = false;
+            }
+            job->letters.push_back(std::make_pair((char16_t)it.first, it.second));
+            _pendingLetters.insert(it.first);
+        }
+        else
+        {
+            rasterized.utf16Char = it.first;
+            rasterized.charCode = it.second;
+            rasterizeGlyph(_fontFreeType, it.second, rasterized);
+            addRasterizedGlyph(rasterized);
+        }
+    }
+
+    updatePages();
+
+    if (job)
+    {
+        _rasterJobs.push_back(job);
+        AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_OTHER, [job](void*) {
+            if (job->atlas)
+            {
+                job->atlas->onGlyphsRasterized(job.get());
+            }
+        }, nullptr, [job]() {
+            job->glyphs.reserve(job->letters.size());
+            for (auto&& letter : job->letters)
+            {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (job->cancelled)
+                    break;
+
+                RasterizedGlyph glyph;
+                glyph.utf16Char = letter.first;
+                glyph.charCode = letter.second;
+                rasterizeGlyph(job->font, letter.second, glyph);
+                job->glyphs.push_back(std::move(glyph));
+            }
+        });
+    }
+
+    return true;
+}
+
+void FontAtlas::rasterizeGlyph(FontFreeType* font, unsigned short charCode, RasterizedGlyph& rasterized)
+{
+    auto& glyph = rasterized.glyph;
+    long bitmapWidth = 0;
+    long bitmapHeight = 0;
+    glyph.xAdvance = 0;
+    auto bitmap = font->getGlyphBitmap(charCode, bitmapWidth, bitmapHeight, glyph.rect, glyph.xAdvance);
+
+    glyph.bitmapWidth = bitmapWidth;
+    glyph.bitmapHeight = bitmapHeight;
+    glyph.imageWidth = 0;
+    glyph.imageHeight = 0;
+    glyph.image = nullptr;
+    rasterized.image.clear();
+
+    if (bitmap && bitmapWidth > 0 && bitmapHeight > 0)
+    {
+        // the distance field has a spread border, and one byte per pixel even with an outline
+        int padding = 0;
+        int bytesPerPixel = font->getOutlineSize() > 0 ? 2 : 1;
+        if (font->isDistanceFieldEnabled())
+        {
+            padding = 2 * FontFreeType::DistanceMapSpread;
+            bytesPerPixel = 1;
+        }
+        glyph.imageWidth = static_cast<int>(bitmapWidth) + padding;
+        glyph.imageHeight = static_cast<int>(bitmapHeight) + padding;
+        rasterized.image.assign(glyph.imageWidth * glyph.imageHeight * bytesPerPixel, 0);
+        font->renderCharAt(rasterized.image.data(), 0, 0, bitmap, bitmapWidth, bitmapHeight, glyph.imageWidth);
+        glyph.image = rasterized.image.data();
+    }
+}
+
+void FontAtlas::addRasterizedGlyph(RasterizedGlyph& rasterized)
+{
+    // the vector may have been moved since the glyph was rendered
+    rasterized.glyph.image = rasterized.image.empty() ? nullptr : rasterized.image.data();
+    addGlyph(rasterized.utf16Char, rasterized.glyph);
+    if (_glyphCache)
+    {
+        _glyphCache->addGlyph(rasterized.charCode, rasterized.glyph);
+    }
+}
+
+void FontAtlas::addGlyph(char16_t utf16Char, const FontGlyphCache::Glyph& glyph)
+{
     int adjustForDistanceMap = _letterPadding / 2;
     int adjustForExtend = _letterEdgeExtend / 2;
-    long bitmapWidth;
-    long bitmapHeight;
-    int glyphHeight;
-    Rect tempRect;
     FontLetterDefinition tempDef;
+    tempDef.xAdvance = glyph.xAdvance;
 
     auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
-    auto  pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
-
-    float startY = _currentPageOrigY;
+    bool packed = false;
 
-    for (auto&& it : codeMapOfNewChar)
+    if (glyph.image && glyph.bitmapWidth > 0 && glyph.bitmapHeight > 0)
     {
-        auto bitmap = _fontFreeType->getGlyphBitmap(it.second, bitmapWidth, bitmapHeight, tempRect, tempDef.xAdvance);
-        if (bitmap && bitmapWidth > 0 && bitmapHeight > 0)
+        auto& tempRect = glyph.rect;
+        tempDef.validDefinition = true;
+        tempDef.width = tempRect.size.width + _letterPadding + _letterEdgeExtend;
+        tempDef.height = tempRect.size.height + _letterPadding + _letterEdgeExtend;
+        tempDef.offsetX = tempRect.origin.x - adjustForDistanceMap - adjustForExtend;
+        tempDef.offsetY = _fontAscender + tempRect.origin.y - adjustForDistanceMap - adjustForExtend;
+
+        // the slot holds the image and its extended edge, glyphs are one pixel apart
+        GlyphSlot slot;
+        int slotWidth = std::max(static_cast<int>(ceilf(tempDef.width)), glyph.imageWidth + _letterEdgeExtend) + 1;
+        int slotHeight = std::max(static_cast<int>(ceilf(tempDef.height)), glyph.imageHeight + _letterEdgeExtend) + 1;
+        if (allocGlyphSlot(slotWidth, slotHeight, slot))
         {
-            tempDef.validDefinition = true;
-            tempDef.width = tempRect.size.width + _letterPadding + _letterEdgeExtend;
-            tempDef.height = tempRect.size.height + _letterPadding + _letterEdgeExtend;
-            tempDef.offsetX = tempRect.origin.x - adjustForDistanceMap - adjustForExtend;
-            tempDef.offsetY = _fontAscender + tempRect.origin.y - adjustForDistanceMap - adjustForExtend;
-
-            if (_currentPageOrigX + tempDef.width > CacheTextureWidth)
+            auto& page = _pages[slot.page];
+            int bytesPerPixel = getBytesPerPixel();
+            int pageRowSize = _pageDataSize / CacheTextureHeight;
+
+            // the slot may hold pixels of evicted glyphs
+            int clearHeight = std::min(slot.height, CacheTextureHeight - slot.y);
+            int clearSize = std::min(slot.width, CacheTextureWidth - slot.x) * bytesPerPixel;
+            for (int y = 0; y < clearHeight; ++y)
             {
-                _currentPageOrigY += _currLineHeight;
-                _currLineHeight = 0;
-                _currentPageOrigX = 0;
-                if (_currentPageOrigY + _lineHeight + _letterPadding + _letterEdgeExtend >= CacheTextureHeight)
-                {
-                    unsigned char *data = nullptr;
-                    if (pixelFormat == Texture2D::PixelFormat::AI88)
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
-                    }
-                    else
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY;
-                    }
-                    _atlasTextures[_currentPage]->updateWithData(data, 0, startY,
-                        CacheTextureWidth, CacheTextureHeight - startY);
-
-                    startY = 0.0f;
-
-                    _currentPageOrigY = 0;
-                    memset(_currentPageData, 0, _currentPageDataSize);
-                    _currentPage++;
-                    auto tex = new (std::nothrow) Texture2D;
-                    if (_antialiasEnabled)
-                    {
-                        tex->setAntiAliasTexParameters();
-                    }
-                    else
-                    {
-                        tex->setAliasTexParameters();
-                    }
-                    tex->initWithData(_currentPageData, _currentPageDataSize,
-                        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
-                    addTexture(tex, _currentPage);
-                    tex->release();
-                }
+                memset(page.data.data() + (slot.y + y) * pageRowSize + slot.x * bytesPerPixel, 0, clearSize);
             }
-            glyphHeight = static_cast<int>(bitmapHeight) + _letterPadding + _letterEdgeExtend;
-            if (glyphHeight > _currLineHeight)
+
+            int posX = slot.x + adjustForExtend;
+            int posY = slot.y + adjustForExtend;
+            size_t rowSize = glyph.imageWidth * bytesPerPixel;
+            for (int y = 0; y < glyph.imageHeight; ++y)
             {
-                _currLineHeight = glyphHeight;
+                memcpy(page.data.data() + (posY + y) * pageRowSize + posX * bytesPerPixel,
+                    glyph.image + y * rowSize, rowSize);
             }
-            _fontFreeType->renderCharAt(_currentPageData, _currentPageOrigX + adjustForExtend, _currentPageOrigY + adjustForExtend, bitmap, bitmapWidth, bitmapHeight);
+            page.dirtyMinY = std::min(page.dirtyMinY, slot.y);
+            page.dirtyMaxY = std::max(page.dirtyMaxY, slot.y + clearHeight);
 
-            tempDef.U = _currentPageOrigX;
-            tempDef.V = _currentPageOrigY;
-            tempDef.textureID = _currentPage;
-            _currentPageOrigX += tempDef.width + 1;
+            tempDef.U = slot.x;
+            tempDef.V = slot.y;
+            tempDef.textureID = slot.page;
             // take from pixels to points
             tempDef.width = tempDef.width / scaleFactor;
             tempDef.height = tempDef.height / scaleFactor;
             tempDef.U = tempDef.U / scaleFactor;
             tempDef.V = tempDef.V / scaleFactor;
-        }
-        else{
-            if (tempDef.xAdvance)
-                tempDef.validDefinition = true;
-            else
-                tempDef.validDefinition = false;
 
-            tempDef.width = 0;
-            tempDef.height = 0;
-            tempDef.U = 0;
-            tempDef.V = 0;
-            tempDef.offsetX = 0;
-            tempDef.offsetY = 0;
-            tempDef.textureID = 0;
-            _currentPageOrigX += 1;
+            _glyphSlots[utf16Char] = slot;
+            packed = true;
         }
+        else
+        {
+            CCLOG("FontAtlas: glyph of letter %d is larger than a texture", (int)utf16Char);
+        }
+    }
 
-        _letterDefinitions[it.first] = tempDef;
+    if (!packed)
+    {
+        if (tempDef.xAdvance)
+            tempDef.validDefinition = true;
+        else
+            tempDef.validDefinition = false;
+
+        tempDef.width = 0;
+        tempDef.height = 0;
+        tempDef.U = 0;
+        tempDef.V = 0;
+        tempDef.offsetX = 0;
+        tempDef.offsetY = 0;
+        tempDef.textureID = 0;
     }
 
-    unsigned char *data = nullptr;
-    if (pixelFormat == Texture2D::PixelFormat::AI88)
+    _letterDefinitions[utf16Char] = tempDef;
+}
+
+int FontAtlas::getBytesPerPixel() const
+{
+    // FontFreeType::renderCharAt writes distance fields with one byte per pixel, even with an outline
+    return (_fontFreeType->getOutlineSize() > 0 && !_fontFreeType->isDistanceFieldEnabled()) ? 2 : 1;
+}
+
+void FontAtlas::updatePages()
+{
+    int pageRowSize = _pageDataSize / CacheTextureHeight;
+    for (size_t index = 0; index < _pages.size(); ++index)
+    {
+        auto& page = _pages[index];
+        if (page.dirtyMinY < page.dirtyMaxY)
+        {
+            _atlasTextures[index]->updateWithData(page.data.data() + page.dirtyMinY * pageRowSize, 0, page.dirtyMinY,
+                CacheTextureWidth, page.dirtyMaxY - page.dirtyMinY);
+            page.dirtyMinY = CacheTextureHeight;
+            page.dirtyMaxY = 0;
+        }
+    }
+}
+
+bool FontAtlas::addPage()
+{
+    auto texture = new (std::nothrow) Texture2D;
+    if (texture == nullptr)
+        return false;
+
+    Page page;
+    page.data.assign(_pageDataSize, 0);
+    SkylineNode node = { 0, 0, CacheTextureWidth };
+    page.skyline.push_back(node);
+    page.dirtyMinY = CacheTextureHeight;
+    page.dirtyMaxY = 0;
+
+    if (_antialiasEnabled)
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
+        texture->setAntiAliasTexParameters();
     }
     else
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY;
+        texture->setAliasTexParameters();
+    }
+    auto  pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+    texture->initWithData(page.data.data(), _pageDataSize,
+        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+    addTexture(texture, (int)_pages.size());
+    texture->release();
+
+    _pages.push_back(std::move(page));
+    return true;
+}
+
+bool FontAtlas::allocGlyphSlot(int width, int height, GlyphSlot& slot)
+{
+    if (width > CacheTextureWidth || height > CacheTextureHeight)
+        return false;
+
+    // the last pages are the least full
+    for (int index = (int)_pages.size() - 1; index >= 0; --index)
+    {
+        if (packInPage(index, width, height, slot))
+            return true;
+    }
+
+    if (_maxPageCount > 0 && (int)_pages.size() >= _maxPageCount)
+    {
+        // pages holding glyphs of unused letters, the least recently used first
+        // letters in use count as used now
+        std::vector<std::pair<unsigned int, int>> candidates(_pages.size(), std::make_pair(0u, -1));
+        for (auto&& it : _glyphSlots)
+        {
+            auto usage = _letterUsages.find(it.first);
+            bool inUse = usage != _letterUsages.end() && usage->second.references > 0;
+            unsigned int lastUsed = inUse ? _usageClock + 1 : (usage != _letterUsages.end() ? usage->second.lastUsed : 0);
+
+            auto& candidate = candidates[it.second.page];
+            candidate.first = std::max(candidate.first, lastUsed);
+            if (!inUse)
+            {
+                candidate.second = it.second.page;
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (auto&& candidate : candidates)
+        {
+            if (candidate.second < 0)
+                continue;
+
+            compactPage(candidate.second);
+            if (packInPage(candidate.second, width, height, slot))
+                return true;
+        }
+        CCLOG("FontAtlas: every glyph is in use, exceeding the limit of %d textures", _maxPageCount);
+    }
+
+    return addPage() && packInPage((int)_pages.size() - 1, width, height, slot);
+}
+
+bool FontAtlas::packInPage(int pageIndex, int width, int height, GlyphSlot& slot)
+{
+    auto& skyline = _pages[pageIndex].skyline;
+
+    // lowest position, then leftmost
+    int bestIndex = -1;
+    int bestX = 0;
+    int bestY = CacheTextureHeight;
+    for (size_t index = 0; index < skyline.size(); ++index)
+    {
+        int x = skyline[index].x;
+        if (x + width > CacheTextureWidth)
+            break;
+
+        int y = 0;
+        int remaining = width;
+        for (size_t next = index; remaining > 0; ++next)
+        {
+            y = std::max(y, skyline[next].y);
+            remaining -= skyline[next].width;
+        }
+        if (y + height <= CacheTextureHeight && y < bestY)
+        {
+            bestIndex = (int)index;
+            bestX = x;
+            bestY = y;
+        }
     }
-    _atlasTextures[_currentPage]->updateWithData(data, 0, startY, CacheTextureWidth, _currentPageOrigY - startY + _currLineHeight);
+    if (bestIndex < 0)
+        return false;
 
+    SkylineNode node = { bestX, bestY + height, width };
+    skyline.insert(skyline.begin() + bestIndex, node);
+
+    // shrink or remove the nodes under the new one
+    size_t index = bestIndex + 1;
+    while (index < skyline.size())
+    {
+        int covered = bestX + width - skyline[index].x;
+        if (covered <= 0)
+            break;
+
+        if (covered >= skyline[index].width)
+        {
+            skyline.erase(skyline.begin() + index);
+        }
+        else
+        {
+            skyline[index].x += covered;
+            skyline[index].width -= covered;
+            break;
+        }
+    }
+
+    // merge the nodes of the same height
+    for (index = 0; index + 1 < skyline.size();)
+    {
+        if (skyline[index].y == skyline[index + 1].y)
+        {
+            skyline[index].width += skyline[index + 1].width;
+            skyline.erase(skyline.begin() + index + 1);
+        }
+        else
+        {
+            ++index;
+        }
+    }
+
+    slot.page = pageIndex;
+    slot.x = bestX;
+    slot.y = bestY;
+    slot.width = width;
+    slot.height = height;
     return true;
 }
 
+void FontAtlas::compactPage(int pageIndex)
+{
+    // glyphs in use don't move, labels keep drawing them with the same texture coordinates.
+    // the new skyline is the top of the remaining glyphs
+    std::vector<int> tops(CacheTextureWidth, 0);
+    for (auto it = _glyphSlots.begin(); it != _glyphSlots.end();)
+    {
+        auto& slot = it->second;
+        if (slot.page != pageIndex)
+        {
+            ++it;
+            continue;
+        }
+
+        auto usage = _letterUsages.find(it->first);
+        if (usage == _letterUsages.end() || usage->second.references <= 0)
+        {
+            // the usage only ordered the eviction
+            if (usage != _letterUsages.end())
+                _letterUsages.erase(usage);
+            _letterDefinitions.erase(it->first);
+            it = _glyphSlots.erase(it);
+        }
+        else
+        {
+            for (int x = slot.x; x < slot.x + slot.width; ++x)
+            {
+                tops[x] = std::max(tops[x], slot.y + slot.height);
+            }
+            ++it;
+        }
+    }
+
+    auto& skyline = _pages[pageIndex].skyline;
+    skyline.clear();
+    for (int x = 0; x < CacheTextureWidth; ++x)
+    {
+        if (!skyline.empty() && skyline.back().y == tops[x])
+        {
+            skyline.back().width += 1;
+        }
+        else
+        {
+            SkylineNode node = { x, tops[x], 1 };
+            skyline.push_back(node);
+        }
+    }
+}
+
+void FontAtlas::retainLetters(const std::u16string& letters)
+{
+    if (_fontFreeType == nullptr)
+        return;
+
+    ++_usageClock;
+    for (auto letter : letters)
+    {
+        auto& usage = _letterUsages[letter];
+        ++usage.references;
+        usage.lastUsed = _usageClock;
+    }
+}
+
+void FontAtlas::releaseLetters(const std::u16string& letters)
+{
+    if (_fontFreeType == nullptr)
+        return;
+
+    ++_usageClock;
+    for (auto letter : letters)
+    {
+        auto usage = _letterUsages.find(letter);
+        if (usage != _letterUsages.end() && usage->second.references > 0)
+        {
+            --usage->second.references;
+            usage->second.lastUsed = _usageClock;
+            // letters without a glyph, e.g. spaces, have nothing to evict
+            if (usage->second.references == 0 && _glyphSlots.find(letter) == _glyphSlots.end())
+                _letterUsages.erase(usage);
+        }
+    }
+}
+
+void FontAtlas::setAsyncRasterizationEnabled(bool enabled)
+{
+    if (_fontFreeType == nullptr || enabled == _asyncRasterization)
+        return;
+
+    _asyncRasterization = enabled;
+    if (enabled && _rasterFont == nullptr)
+    {
+        _rasterFont = _fontFreeType->cloneForThread();
+        if (_rasterFont)
+        {
+            _rasterFont->retain();
+        }
+        else
+        {
+            CCLOG("FontAtlas: can't create the font of the rasterization thread, rasterizing on the cocos thread");
+        }
+    }
+}
+
+void FontAtlas::onGlyphsRasterized(RasterJob* job)
+{
+    job->atlas = nullptr;
+    for (auto it = _rasterJobs.begin(); it != _rasterJobs.end(); ++it)
+    {
+        if (it->get() == job)
+        {
+            _rasterJobs.erase(it);
+            break;
+        }
+    }
+
+    for (auto&& glyph : job->glyphs)
+    {
+        _pendingLetters.erase(glyph.utf16Char);
+        if (_letterDefinitions.find(glyph.utf16Char) == _letterDefinitions.end())
+        {
+            addRasterizedGlyph(glyph);
+        }
+    }
+    updatePages();
+
+    Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(CMD_UPDATE_FONTATLAS, this);
+}
+
+void FontAtlas::cancelRasterJobs()
+{
+    for (auto&& job : _rasterJobs)
+    {
+        // waits for the glyph being rendered, the font isn't used by the job afterwards
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->cancelled = true;
+        job->atlas = nullptr;
+    }
+    _rasterJobs.clear();
+    _pendingLetters.clear();
+}
+
 void FontAtlas::addTexture(Texture2D *texture, int slot)
 {
     texture->retain();
@@ -29,11 +29,15 @@
 /// @cond DO_NOT_SHOW
 
 #include <string>
+#include <memory>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
 #include "platform/CCStdC.h" // ssize_t on windows
+#include "2d/CCFontGlyphCache.h"
 
 NS_CC_BEGIN
 
@@ -42,6 +46,7 @@ class Texture2D;
 class EventCustom;
 class EventListenerCustom;
 class FontFreeType;
+class FontGlyphCache;
 
 struct FontLetterDefinition
 {
@@ -61,8 +66,12 @@ class CC_DLL FontAtlas : public Ref
 public:
     static const int CacheTextureWidth;
     static const int CacheTextureHeight;
+    /** The default maximum number of textures of a TTF atlas, see setMaxPageCount. @since v3.15 */
+    static const int DefaultMaxPageCount;
     static const char* CMD_PURGE_FONTATLAS;
     static const char* CMD_RESET_FONTATLAS;
+    /** Dispatched with the atlas as user data when glyphs rasterized in the background have been added to it. */
+    static const char* CMD_UPDATE_FONTATLAS;
     /**
      * @js ctor
      */
@@ -78,6 +87,40 @@ public:
     
     bool prepareLetterDefinitions(const std::u16string& utf16String);
 
+    /** Enables the rasterization of new characters on a background thread.
+     * prepareLetterDefinitions then returns before the characters that are not in the glyph cache have a definition,
+     * they are added to the atlas on the cocos thread once rendered, and CMD_UPDATE_FONTATLAS is dispatched
+     * so that labels are laid out again. Until then labels leave them out.
+     * The thread has its own copy of the FreeType face. It only has effect on TTF fonts, and is disabled by default.
+     * @since v3.15
+     */
+    void setAsyncRasterizationEnabled(bool enabled);
+    bool isAsyncRasterizationEnabled() const { return _asyncRasterization; }
+
+    /** Returns true if the character is being rasterized in the background. */
+    bool isLetterPending(char16_t utf16Char) const { return _pendingLetters.find(utf16Char) != _pendingLetters.end(); }
+
+    /** Counts a use of each letter by a label. The glyphs of letters in use are never evicted from the atlas.
+     * A label retains the distinct letters of its text, and releases them when its text or its atlas changes.
+     * @since v3.15
+     */
+    void retainLetters(const std::u16string& letters);
+    void releaseLetters(const std::u16string& letters);
+
+    /** Sets the maximum number of textures of a TTF atlas, 0 means no limit. It is DefaultMaxPageCount by default.
+     * When no texture has room for a new glyph and the limit is reached, the glyphs of letters no label uses
+     * are evicted from the least recently used texture, and its free space is packed again.
+     * The limit is exceeded when every glyph of every texture is in use.
+     * @since v3.15
+     */
+    void setMaxPageCount(int count) { _maxPageCount = count; }
+    int getMaxPageCount() const { return _maxPageCount; }
+
+    /** Returns a number identifying the atlas, it is not given to another atlas when this one is deleted.
+     * @since v3.15
+     */
+    unsigned int getUniqueID() const { return _uniqueID; }
+
     const std::unordered_map<ssize_t, Texture2D*>& getTextures() const { return _atlasTextures; }
     void  addTexture(Texture2D *texture, int slot);
     float getLineHeight() const { return _lineHeight; }
@@ -90,6 +133,11 @@ public:
      It only has effect on Android and WP8.
      */
     void listenRendererRecreated(EventCustom *event);
+
+    /** Writes the glyphs rendered since the last save to the glyph cache, when CC_ENABLE_FONT_GLYPH_CACHE is enabled.
+     * It is done when the application goes to the background and when the atlas is released.
+     */
+    void saveGlyphCache(EventCustom *event = nullptr);
     
     /** Removes textures atlas.
      It will purge the textures atlas and if multiple texture exist in the FontAtlas.
@@ -109,7 +157,64 @@ public:
      void setAliasTexParameters();
 
 protected:
+    struct RasterizedGlyph
+    {
+        char16_t utf16Char;
+        unsigned short charCode;
+        FontGlyphCache::Glyph glyph;
+        std::vector<unsigned char> image;
+    };
+    struct RasterJob;
+
     void reset();
+
+    /** Renders a glyph with font, may be called from the rasterization thread. */
+    static void rasterizeGlyph(FontFreeType* font, unsigned short charCode, RasterizedGlyph& rasterized);
+    struct SkylineNode
+    {
+        int x;
+        int y;
+        int width;
+    };
+    struct Page
+    {
+        std::vector<unsigned char> data;
+        // top of the packed glyphs, by increasing x, covering the width of the page
+        std::vector<SkylineNode> skyline;
+        // rows to upload
+        int dirtyMinY;
+        int dirtyMaxY;
+    };
+    struct GlyphSlot
+    {
+        int page;
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+    struct LetterUsage
+    {
+        int references;
+        // value of _usageClock when the letter was last retained or released
+        unsigned int lastUsed;
+    };
+
+    /** Packs a glyph into a page. */
+    void addGlyph(char16_t utf16Char, const FontGlyphCache::Glyph& glyph);
+    void addRasterizedGlyph(RasterizedGlyph& rasterized);
+    /** Uploads the dirty rows of the pages. */
+    void updatePages();
+    bool addPage();
+    /** Finds room for a width x height rectangle, evicting unused glyphs when the page limit is reached. */
+    bool allocGlyphSlot(int width, int height, GlyphSlot& slot);
+    /** Bottom-left skyline placement of a rectangle in a page. */
+    bool packInPage(int pageIndex, int width, int height, GlyphSlot& slot);
+    /** Evicts the glyphs of unused letters from a page and rebuilds its skyline over the remaining ones. */
+    void compactPage(int pageIndex);
+    int getBytesPerPixel() const;
+    void onGlyphsRasterized(RasterJob* job);
+    void cancelRasterJobs();
     
     void releaseTextures();
 
@@ -132,18 +237,29 @@ protected:
     void* _iconv;
 
     // Dynamic GlyphCollection related stuff
-    int _currentPage;
-    unsigned char *_currentPageData;
-    int _currentPageDataSize;
-    float _currentPageOrigX;
-    float _currentPageOrigY;
+    std::vector<Page> _pages;
+    int _pageDataSize;
+    int _maxPageCount;
+    std::unordered_map<char16_t, GlyphSlot> _glyphSlots;
+    std::unordered_map<char16_t, LetterUsage> _letterUsages;
+    unsigned int _usageClock;
     int _letterPadding;
     int _letterEdgeExtend;
 
     int _fontAscender;
     EventListenerCustom* _rendererRecreatedListener;
+    FontGlyphCache* _glyphCache;
+    EventListenerCustom* _toBackgroundListener;
+
+    // background rasterization
+    bool _asyncRasterization;
+    FontFreeType* _rasterFont;
+    std::vector<std::shared_ptr<RasterJob>> _rasterJobs;
+    std::unordered_set<char16_t> _pendingLetters;
     bool _antialiasEnabled;
-    int _currLineHeight;
+    unsigned int _uniqueID;
+
+    static unsigned int s_nextUniqueID;
 
     friend class Label;
 };
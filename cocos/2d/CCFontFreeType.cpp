@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base/CCDirector.h"
 #include "base/ccUTF8.h"
 #include "platform/CCFileUtils.h"
+#include "xxhash.h"
 
 NS_CC_BEGIN
 
@@ -39,12 +40,17 @@ bool       FontFreeType::_FTInitialized = false;
 const int  FontFreeType::DistanceMapSpread = 3;
 
 const char* FontFreeType::_glyphASCII = "\"!#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~¡¢£¤¥¦§¨©ª«¬­®¯°±²³´µ¶·¸¹º»¼½¾¿ÀÁÂÃÄÅÆÇÈÉÊËÌÍÎÏÐÑÒÓÔÕÖ×ØÙÚÛÜÝÞßàáâãäåæçèéêëìíîïðñòóôõö÷øùúûüýþ ";
+// the table directory of a font starts its file, and is followed by the tables of the first font of a collection
+static const ssize_t FONT_DIRECTORY_HASH_SIZE = 4096;
+
 const char* FontFreeType::_glyphNEHE = "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~ ";
 
 typedef struct _DataRef
 {
     Data data;
     unsigned int referenceCount;
+    unsigned int hash;
+    bool hashComputed;
 }DataRef;
 
 static std::unordered_map<std::string, DataRef> s_cacheFontData;
@@ -92,6 +98,9 @@ void FontFreeType::shutdownFreeType()
 
 FT_Library FontFreeType::getFTLibrary()
 {
+    if (_ownLibrary)
+        return _ownLibrary;
+
     initFreeType();
     return _FTlibrary;
 }
@@ -101,6 +110,9 @@ FontFreeType::FontFreeType(bool distanceFieldEnabled /* = false */,int outline /
 , _stroker(nullptr)
 , _distanceFieldEnabled(distanceFieldEnabled)
 , _outlineSize(0.0f)
+, _fontSize(0.0f)
+, _charSize(0)
+, _ownLibrary(nullptr)
 , _lineHeight(0)
 , _fontAtlas(nullptr)
 , _encoding(FT_ENCODING_UNICODE)
@@ -123,6 +135,7 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
     FT_Face face;
     // save font name locally
     _fontName = fontName;
+    _fontSize = fontSize;
 
     auto it = s_cacheFontData.find(fontName);
     if (it != s_cacheFontData.end())
@@ -132,6 +145,7 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
     else
     {
         s_cacheFontData[fontName].referenceCount = 1;
+        s_cacheFontData[fontName].hashComputed = false;
         s_cacheFontData[fontName].data = FileUtils::getInstance()->getDataFromFile(fontName);    
 
         if (s_cacheFontData[fontName].data.isNull())
@@ -175,15 +189,51 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
     
     // store the face globally
     _fontRef = face;
+    _charSize = fontSizePoints;
     _lineHeight = static_cast<int>(_fontRef->size->metrics.height >> 6);
     
     // done and good
     return true;
 }
 
+FontFreeType* FontFreeType::cloneForThread() const
+{
+    auto font = new (std::nothrow) FontFreeType(_distanceFieldEnabled, 0);
+    if (!font)
+        return nullptr;
+
+    if (FT_Init_FreeType(&font->_ownLibrary))
+    {
+        font->_ownLibrary = nullptr;
+        delete font;
+        return nullptr;
+    }
+
+    if (_stroker)
+    {
+        font->_outlineSize = _outlineSize;
+        FT_Stroker_New(font->_ownLibrary, &font->_stroker);
+        FT_Stroker_Set(font->_stroker,
+            (int)(_outlineSize * 64),
+            FT_STROKER_LINECAP_ROUND,
+            FT_STROKER_LINEJOIN_ROUND,
+            0);
+    }
+    font->_usedGlyphs = _usedGlyphs;
+    font->_customGlyphs = _customGlyphs;
+
+    if (!font->createFontObject(_fontName, _fontSize))
+    {
+        delete font;
+        return nullptr;
+    }
+    font->autorelease();
+    return font;
+}
+
 FontFreeType::~FontFreeType()
 {
-    if (_FTInitialized)
+    if (_FTInitialized || _ownLibrary)
     {
         if (_stroker)
         {
@@ -194,6 +244,10 @@ FontFreeType::~FontFreeType()
             FT_Done_Face(_fontRef);
         }
     }
+    if (_ownLibrary)
+    {
+        FT_Done_FreeType(_ownLibrary);
+    }
 
     auto iter = s_cacheFontData.find(_fontName);
     if (iter != s_cacheFontData.end())
@@ -274,6 +328,27 @@ int  FontFreeType::getHorizontalKerningForChars(unsigned short firstChar, unsign
     return (static_cast<int>(kerning.x >> 6));
 }
 
+unsigned int FontFreeType::getFontDataHash() const
+{
+    auto it = s_cacheFontData.find(_fontName);
+    if (it == s_cacheFontData.end())
+        return 0;
+
+    auto& dataRef = it->second;
+    if (!dataRef.hashComputed)
+    {
+        dataRef.hash = XXH32(dataRef.data.getBytes(), (int)std::min(dataRef.data.getSize(), FONT_DIRECTORY_HASH_SIZE), 0);
+        dataRef.hashComputed = true;
+    }
+    return dataRef.hash;
+}
+
+ssize_t FontFreeType::getFontDataSize() const
+{
+    auto it = s_cacheFontData.find(_fontName);
+    return it != s_cacheFontData.end() ? it->second.data.getSize() : 0;
+}
+
 int FontFreeType::getFontAscender() const
 {
     return (static_cast<int>(_fontRef->size->metrics.ascender >> 6));
@@ -442,7 +517,7 @@ unsigned char * FontFreeType::getGlyphBitmapWithOutline(unsigned short theChar,
                     params.target = &bmp;
                     params.flags = FT_RASTER_FLAG_AA;
                     FT_Outline_Translate(outline,-bbox.xMin,-bbox.yMin);
-                    FT_Outline_Render(_FTlibrary, outline, &params);
+                    FT_Outline_Render(getFTLibrary(), outline, &params);
 
                     ret = bmp.buffer;
                 }
@@ -535,11 +610,16 @@ unsigned char * makeDistanceMap( unsigned char *img, long width, long height)
     return out;
 }
 
-void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight)
+void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight, int destWidth /* = 0 */)
 {
     int iX = posX;
     int iY = posY;
 
+    if (destWidth == 0)
+    {
+        destWidth = FontAtlas::CacheTextureWidth;
+    }
+
     if (_distanceFieldEnabled)
     {
         auto distanceMap = makeDistanceMap(bitmap,bitmapWidth,bitmapHeight);
@@ -561,7 +641,7 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
                 dest[index + 2] = out[index2 + 2];*/
 
                 //Single channel 8-bit output 
-                dest[iX + ( iY * FontAtlas::CacheTextureWidth )] = distanceMap[bitmap_y + x];
+                dest[iX + ( iY * destWidth )] = distanceMap[bitmap_y + x];
 
                 iX += 1;
             }
@@ -581,9 +661,9 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
             for (int x = 0; x < bitmapWidth; ++x)
             {
                 tempChar = bitmap[(bitmap_y + x) * 2];
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) ) * 2] = tempChar;
+                dest[(iX + ( iY * destWidth ) ) * 2] = tempChar;
                 tempChar = bitmap[(bitmap_y + x) * 2 + 1];
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) ) * 2 + 1] = tempChar;
+                dest[(iX + ( iY * destWidth ) ) * 2 + 1] = tempChar;
 
                 iX += 1;
             }
@@ -604,7 +684,7 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
                 unsigned char cTemp = bitmap[bitmap_y + x];
 
                 // the final pixel
-                dest[(iX + ( iY * FontAtlas::CacheTextureWidth ) )] = cTemp;
+                dest[(iX + ( iY * destWidth ) )] = cTemp;
 
                 iX += 1;
             }
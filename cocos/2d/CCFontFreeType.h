@@ -62,7 +62,24 @@ public:
 
     float getOutlineSize() const { return _outlineSize; }
 
-    void renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight); 
+    /** Size of the characters, in 26.6 fractional points. */
+    int getCharSize() const { return _charSize; }
+
+    /** Hash of the table directory of the font file and size of the file, to tell fonts apart in caches outliving the process.
+     *  The directory holds the checksums of all the tables of the font, so hashing it is enough and does not read the whole font.
+     */
+    unsigned int getFontDataHash() const;
+    /** The font file name, as passed to create. */
+    const std::string& getFontName() const { return _fontName; }
+    ssize_t getFontDataSize() const;
+
+    /** Renders a glyph bitmap into dest, whose rows are destWidth pixels wide, FontAtlas::CacheTextureWidth when it is 0. */
+    void renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight, int destWidth = 0);
+
+    /** Creates a font with the same face on its own FT_Library, to render glyphs on another thread while this one is used.
+     * It must be created and released on the cocos thread.
+     */
+    FontFreeType* cloneForThread() const;
 
     FT_Encoding getEncoding() const { return _encoding; }
 
@@ -105,6 +122,10 @@ private:
     std::string _fontName;
     bool _distanceFieldEnabled;
     float _outlineSize;
+    float _fontSize;
+    int _charSize;
+    // set for fonts used by another thread
+    FT_Library _ownLibrary;
     int _lineHeight;
     FontAtlas* _fontAtlas;
 
@@ -0,0 +1,414 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCFontGlyphCache.h"
+
+#include <algorithm>
+
+#include "2d/CCFontFreeType.h"
+#include "base/ccMacros.h"
+#include "base/CCData.h"
+#include "base/ccUTF8.h"
+#include "platform/CCFileUtils.h"
+#include "xxhash.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char GLYPH_CACHE_MAGIC[4] = { 'C', 'C', 'G', 'C' };
+    const uint32_t GLYPH_CACHE_VERSION = 2;
+}
+
+std::string FontGlyphCache::s_cacheDirectory;
+
+FontGlyphCache* FontGlyphCache::create(FontFreeType* font)
+{
+    auto ret = new (std::nothrow) FontGlyphCache();
+    if (ret && ret->init(font))
+    {
+        return ret;
+    }
+    delete ret;
+    return nullptr;
+}
+
+void FontGlyphCache::setCacheDirectory(const std::string& directory)
+{
+    s_cacheDirectory = directory;
+    if (!s_cacheDirectory.empty() && s_cacheDirectory.back() != '/')
+    {
+        s_cacheDirectory += '/';
+    }
+}
+
+const std::string& FontGlyphCache::getCacheDirectory()
+{
+    if (s_cacheDirectory.empty())
+    {
+        auto writablePath = FileUtils::getInstance()->getWritablePath();
+        if (!writablePath.empty())
+        {
+            setCacheDirectory(writablePath + "glyphcache/");
+        }
+    }
+    return s_cacheDirectory;
+}
+
+FontGlyphCache::FontGlyphCache()
+: _bytesPerPixel(1)
+, _fileData(nullptr)
+, _fileSize(0)
+, _mapping(nullptr)
+{
+    memset(&_header, 0, sizeof(_header));
+}
+
+FontGlyphCache::~FontGlyphCache()
+{
+    save();
+    unmapFile();
+}
+
+bool FontGlyphCache::init(FontFreeType* font)
+{
+    auto& directory = getCacheDirectory();
+    if (directory.empty())
+    {
+        return false;
+    }
+
+    // FontFreeType::renderCharAt writes distance fields with one byte per pixel, even with an outline
+    bool distanceField = font->isDistanceFieldEnabled();
+    _bytesPerPixel = (!distanceField && font->getOutlineSize() > 0) ? 2 : 1;
+
+    memcpy(_header.magic, GLYPH_CACHE_MAGIC, sizeof(_header.magic));
+    _header.version = GLYPH_CACHE_VERSION;
+    auto fullPath = FileUtils::getInstance()->fullPathForFilename(font->getFontName());
+    _header.pathHash = XXH32(fullPath.data(), (int)fullPath.size(), 0);
+    _header.fontHash = font->getFontDataHash();
+    _header.fontDataSize = (uint32_t)font->getFontDataSize();
+    _header.fontSize = font->getCharSize();
+    _header.outlineSize = (int32_t)(font->getOutlineSize() * 64);
+    _header.distanceFieldSpread = distanceField ? FontFreeType::DistanceMapSpread : 0;
+    _header.encoding = (int32_t)font->getEncoding();
+    _header.bytesPerPixel = _bytesPerPixel;
+    _header.glyphCount = 0;
+
+    _filePath = StringUtils::format("%s%08x%08x_%x_%x_%x_%x_%x.glyphs", directory.c_str(),
+        _header.pathHash, _header.fontHash, _header.fontDataSize, _header.fontSize, _header.outlineSize,
+        _header.distanceFieldSpread, _header.encoding);
+
+    mapFile();
+    return true;
+}
+
+bool FontGlyphCache::mapFile()
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    std::u16string widePath;
+    if (!StringUtils::UTF8ToUTF16(_filePath, widePath))
+        return false;
+
+    HANDLE file = CreateFileW((LPCWSTR)widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+
+    _fileData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (_fileData == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    _fileSize = (size_t)size.QuadPart;
+    _mapping = mapping;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+    // no file mapping on WinRT, the file is read instead
+    auto data = new (std::nothrow) Data(FileUtils::getInstance()->getDataFromFile(_filePath));
+    if (data == nullptr || data->isNull())
+    {
+        delete data;
+        return false;
+    }
+    _fileData = data->getBytes();
+    _fileSize = (size_t)data->getSize();
+    _mapping = data;
+#else
+    int fd = open(_filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void* address = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        address = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (address == MAP_FAILED)
+        return false;
+
+    _fileData = (const unsigned char*)address;
+    _fileSize = (size_t)st.st_size;
+#endif
+
+    // only the header and the glyph table are checked here, images are checked when they are used
+    bool valid = _fileSize >= sizeof(FileHeader);
+    if (valid)
+    {
+        FileHeader header;
+        memcpy(&header, _fileData, sizeof(header));
+        uint32_t glyphCount = header.glyphCount;
+        header.glyphCount = 0;
+        valid = memcmp(&header, &_header, sizeof(header)) == 0
+            && (_fileSize - sizeof(FileHeader)) / sizeof(FileGlyph) >= glyphCount;
+        if (valid)
+        {
+            _header.glyphCount = glyphCount;
+        }
+    }
+    if (!valid)
+    {
+        CCLOG("FontGlyphCache: ignoring outdated cache file %s", _filePath.c_str());
+        unmapFile();
+        return false;
+    }
+    return true;
+}
+
+void FontGlyphCache::unmapFile()
+{
+    if (_fileData)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        UnmapViewOfFile(_fileData);
+        CloseHandle((HANDLE)_mapping);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
+        delete static_cast<Data*>(_mapping);
+#else
+        munmap((void*)_fileData, _fileSize);
+#endif
+    }
+    _fileData = nullptr;
+    _fileSize = 0;
+    _mapping = nullptr;
+    _header.glyphCount = 0;
+}
+
+const FontGlyphCache::FileGlyph* FontGlyphCache::findFileGlyph(unsigned short charCode) const
+{
+    if (_header.glyphCount == 0)
+        return nullptr;
+
+    // the table is at a 4 bytes aligned offset of a page aligned mapping
+    auto begin = reinterpret_cast<const FileGlyph*>(_fileData + sizeof(FileHeader));
+    auto end = begin + _header.glyphCount;
+    auto it = std::lower_bound(begin, end, (uint32_t)charCode, [](const FileGlyph& fileGlyph, uint32_t code) {
+        return fileGlyph.charCode < code;
+    });
+    if (it != end && it->charCode == charCode)
+        return it;
+    return nullptr;
+}
+
+bool FontGlyphCache::toGlyph(const FileGlyph& fileGlyph, const unsigned char* images, size_t imagesSize, Glyph& glyph) const
+{
+    glyph.rect.setRect(fileGlyph.rectX, fileGlyph.rectY, fileGlyph.rectWidth, fileGlyph.rectHeight);
+    glyph.xAdvance = fileGlyph.xAdvance;
+    glyph.bitmapWidth = fileGlyph.bitmapWidth;
+    glyph.bitmapHeight = fileGlyph.bitmapHeight;
+    glyph.imageWidth = fileGlyph.imageWidth;
+    glyph.imageHeight = fileGlyph.imageHeight;
+    glyph.image = nullptr;
+
+    size_t imageSize = (size_t)fileGlyph.imageWidth * fileGlyph.imageHeight * _bytesPerPixel;
+    if (imageSize > 0)
+    {
+        if (fileGlyph.imageOffset > imagesSize || imageSize > imagesSize - fileGlyph.imageOffset)
+            return false;
+        glyph.image = images + fileGlyph.imageOffset;
+    }
+    return true;
+}
+
+bool FontGlyphCache::findGlyph(unsigned short charCode, Glyph& glyph) const
+{
+    auto added = _addedIndices.find(charCode);
+    if (added != _addedIndices.end())
+    {
+        return toGlyph(_addedGlyphs[added->second], _addedImages.data(), _addedImages.size(), glyph);
+    }
+
+    auto fileGlyph = findFileGlyph(charCode);
+    return fileGlyph && toGlyph(*fileGlyph, _fileData, _fileSize, glyph);
+}
+
+void FontGlyphCache::addGlyph(unsigned short charCode, const Glyph& glyph)
+{
+    if (glyph.imageWidth > 0xffff || glyph.imageHeight > 0xffff)
+        return;
+
+    FileGlyph fileGlyph;
+    fileGlyph.charCode = charCode;
+    fileGlyph.rectX = glyph.rect.origin.x;
+    fileGlyph.rectY = glyph.rect.origin.y;
+    fileGlyph.rectWidth = glyph.rect.size.width;
+    fileGlyph.rectHeight = glyph.rect.size.height;
+    fileGlyph.xAdvance = glyph.xAdvance;
+    fileGlyph.bitmapWidth = (uint16_t)glyph.bitmapWidth;
+    fileGlyph.bitmapHeight = (uint16_t)glyph.bitmapHeight;
+    fileGlyph.imageWidth = 0;
+    fileGlyph.imageHeight = 0;
+    fileGlyph.imageOffset = (uint32_t)_addedImages.size();
+
+    if (glyph.image && glyph.imageWidth > 0 && glyph.imageHeight > 0)
+    {
+        fileGlyph.imageWidth = (uint16_t)glyph.imageWidth;
+        fileGlyph.imageHeight = (uint16_t)glyph.imageHeight;
+        _addedImages.insert(_addedImages.end(), glyph.image,
+            glyph.image + (size_t)glyph.imageWidth * glyph.imageHeight * _bytesPerPixel);
+    }
+
+    auto added = _addedIndices.find(charCode);
+    if (added != _addedIndices.end())
+    {
+        _addedGlyphs[added->second] = fileGlyph;
+    }
+    else
+    {
+        _addedIndices[charCode] = _addedGlyphs.size();
+        _addedGlyphs.push_back(fileGlyph);
+    }
+}
+
+bool FontGlyphCache::save()
+{
+    if (_addedGlyphs.empty())
+        return true;
+
+    // merge the glyphs of the file with the added ones, the added ones replace those with the same code
+    std::vector<const FileGlyph*> glyphs;
+    glyphs.reserve(_header.glyphCount + _addedGlyphs.size());
+    for (auto& added : _addedGlyphs)
+    {
+        glyphs.push_back(&added);
+    }
+    auto fileGlyphs = reinterpret_cast<const FileGlyph*>(_fileData + sizeof(FileHeader));
+    for (uint32_t i = 0; i < _header.glyphCount; ++i)
+    {
+        if (_addedIndices.find((unsigned short)fileGlyphs[i].charCode) == _addedIndices.end())
+        {
+            glyphs.push_back(fileGlyphs + i);
+        }
+    }
+    std::sort(glyphs.begin(), glyphs.end(), [](const FileGlyph* a, const FileGlyph* b) {
+        return a->charCode < b->charCode;
+    });
+
+    size_t tableSize = sizeof(FileHeader) + glyphs.size() * sizeof(FileGlyph);
+    std::vector<unsigned char> buffer(tableSize);
+    FileHeader header = _header;
+    header.glyphCount = (uint32_t)glyphs.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    auto table = reinterpret_cast<FileGlyph*>(buffer.data() + sizeof(FileHeader));
+    auto addedBegin = _addedGlyphs.data();
+    auto addedEnd = addedBegin + _addedGlyphs.size();
+    for (size_t i = 0; i < glyphs.size(); ++i)
+    {
+        Glyph glyph;
+        bool isAdded = glyphs[i] >= addedBegin && glyphs[i] < addedEnd;
+        bool valid = isAdded
+            ? toGlyph(*glyphs[i], _addedImages.data(), _addedImages.size(), glyph)
+            : toGlyph(*glyphs[i], _fileData, _fileSize, glyph);
+
+        table[i] = *glyphs[i];
+        table[i].imageOffset = (uint32_t)buffer.size();
+        size_t imageSize = valid && glyph.image ? (size_t)glyph.imageWidth * glyph.imageHeight * _bytesPerPixel : 0;
+        if (!valid || buffer.size() + imageSize > 0xffffffff)
+        {
+            // the image was outside of the file, or doesn't fit in it: keep the metrics only
+            table[i].imageWidth = 0;
+            table[i].imageHeight = 0;
+        }
+        else if (imageSize > 0)
+        {
+            buffer.insert(buffer.end(), glyph.image, glyph.image + imageSize);
+            // the table moves when the buffer grows
+            table = reinterpret_cast<FileGlyph*>(buffer.data() + sizeof(FileHeader));
+        }
+    }
+
+    // the file can't be replaced while it is mapped on Windows
+    unmapFile();
+    _addedGlyphs.clear();
+    _addedIndices.clear();
+    _addedImages.clear();
+
+    auto fileUtils = FileUtils::getInstance();
+    auto& directory = getCacheDirectory();
+    if (!fileUtils->isDirectoryExist(directory) && !fileUtils->createDirectory(directory))
+    {
+        CCLOG("FontGlyphCache: can't create directory %s", directory.c_str());
+        return false;
+    }
+
+    Data data;
+    data.fastSet(buffer.data(), buffer.size());
+    auto tempPath = _filePath + ".tmp";
+    bool written = fileUtils->writeDataToFile(data, tempPath) && fileUtils->renameFile(tempPath, _filePath);
+    // the buffer is owned by the vector
+    data.takeBuffer(nullptr);
+
+    if (!written)
+    {
+        CCLOG("FontGlyphCache: can't write %s", _filePath.c_str());
+        fileUtils->removeFile(tempPath);
+        return false;
+    }
+
+    mapFile();
+    return true;
+}
+
+NS_CC_END
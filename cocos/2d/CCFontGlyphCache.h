@@ -0,0 +1,153 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _CCFontGlyphCache_h_
+#define _CCFontGlyphCache_h_
+
+/// @cond DO_NOT_SHOW
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "platform/CCPlatformMacros.h"
+#include "math/CCGeometry.h"
+
+NS_CC_BEGIN
+
+class FontFreeType;
+
+/**
+ * A persistent cache of the glyph images FontAtlas writes into its pages.
+ *
+ * There is one cache file per font file, font size, outline size and distance field spread. A font file is told apart
+ * by its full path, its size and the hash of its table directory, which holds the checksums of its tables,
+ * in the "glyphcache" directory of the writable path. The file is memory mapped when the cache is created,
+ * so glyphs rendered by a previous launch, including their distance field, are copied into the atlas
+ * without loading them with FreeType. Glyphs rendered during this launch are kept in memory
+ * and written out by save().
+ *
+ * The file is stored in the byte order of the device, a file written by a device of another byte order
+ * or by another version of the format is ignored and rewritten.
+ * @since v3.15
+ */
+class CC_DLL FontGlyphCache
+{
+public:
+    struct Glyph
+    {
+        // metrics returned by FontFreeType::getGlyphBitmap
+        Rect rect;
+        int xAdvance;
+        long bitmapWidth;
+        long bitmapHeight;
+        // image written into the atlas page, rows of imageWidth pixels, nullptr for glyphs without pixels
+        int imageWidth;
+        int imageHeight;
+        const unsigned char* image;
+    };
+
+    /** Opens the cache of a font, returns nullptr if there is no writable path. */
+    static FontGlyphCache* create(FontFreeType* font);
+
+    /** Sets the directory of the cache files, the default is "glyphcache/" in the writable path. */
+    static void setCacheDirectory(const std::string& directory);
+    static const std::string& getCacheDirectory();
+
+    ~FontGlyphCache();
+
+    /** Looks up the glyph of a character code, as passed to FontFreeType::getGlyphBitmap. */
+    bool findGlyph(unsigned short charCode, Glyph& glyph) const;
+
+    /** Adds a glyph, its image is copied. */
+    void addGlyph(unsigned short charCode, const Glyph& glyph);
+
+    /** Bytes per pixel of the glyph images. */
+    int getBytesPerPixel() const { return _bytesPerPixel; }
+
+    /** Writes the glyphs added since the cache was opened, returns false if the file could not be written. */
+    bool save();
+
+protected:
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t pathHash;
+        uint32_t fontHash;
+        uint32_t fontDataSize;
+        int32_t fontSize;
+        int32_t outlineSize;
+        int32_t distanceFieldSpread;
+        int32_t encoding;
+        uint32_t bytesPerPixel;
+        uint32_t glyphCount;
+    };
+
+    // sorted by charCode in the file
+    struct FileGlyph
+    {
+        uint32_t charCode;
+        float rectX;
+        float rectY;
+        float rectWidth;
+        float rectHeight;
+        int32_t xAdvance;
+        uint16_t bitmapWidth;
+        uint16_t bitmapHeight;
+        uint16_t imageWidth;
+        uint16_t imageHeight;
+        // offset of the image from the start of the file
+        uint32_t imageOffset;
+    };
+
+    FontGlyphCache();
+
+    bool init(FontFreeType* font);
+    bool mapFile();
+    void unmapFile();
+    const FileGlyph* findFileGlyph(unsigned short charCode) const;
+    bool toGlyph(const FileGlyph& fileGlyph, const unsigned char* images, size_t imagesSize, Glyph& glyph) const;
+
+    FileHeader _header;
+    std::string _filePath;
+    int _bytesPerPixel;
+
+    // mapped file
+    const unsigned char* _fileData;
+    size_t _fileSize;
+    void* _mapping;
+
+    // glyphs added since the file was mapped, imageOffset is relative to _addedImages
+    std::vector<FileGlyph> _addedGlyphs;
+    std::unordered_map<unsigned short, size_t> _addedIndices;
+    std::vector<unsigned char> _addedImages;
+
+    static std::string s_cacheDirectory;
+};
+
+NS_CC_END
+
+/// @endcond
+#endif /* defined(_CCFontGlyphCache_h_) */
@@ -43,9 +43,12 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventCustom.h"
 #include "2d/CCFontFNT.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(Label, 32)
+
 /**
  * LabelLetter used to update the quad in texture atlas without SpriteBatchNode.
  */
@@ -166,6 +169,12 @@ private:
     bool _letterVisible;
 };
 
+std::list<Label::CachedLayout> Label::s_layoutCache;
+int Label::s_layoutCacheCapacity = 64;
+
+// longer texts are not cached
+static const int LAYOUT_CACHE_MAX_LENGTH = 256;
+
 Label* Label::create()
 {
     auto ret = new (std::nothrow) Label;
@@ -381,6 +390,7 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
 , _fontAtlas(nullptr)
 , _reusedLetter(nullptr)
 , _horizontalKernings(nullptr)
+, _layoutValid(false)
 , _boldEnabled(false)
 , _underlineNode(nullptr)
 , _strikethroughEnabled(false)
@@ -403,9 +413,11 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
                 it.second->setTexture(nullptr);
             }
             _batchNodes.clear();
+            _layoutValid = false;
 
             if (_fontAtlas)
             {
+                releaseUsedLetters();
                 FontAtlasCache::releaseFontAtlas(_fontAtlas);
             }
         }
@@ -424,6 +436,17 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
         }
     });
     _eventDispatcher->addEventListenerWithFixedPriority(_resetTextureListener, 2);
+
+    // glyphs rasterized in the background were added to the atlas
+    _updateTextureListener = EventListenerCustom::create(FontAtlas::CMD_UPDATE_FONTATLAS, [this](EventCustom* event){
+        if (_fontAtlas && _currentLabelType == LabelType::TTF && event->getUserData() == _fontAtlas)
+        {
+            // letters laid out as placeholders may have a definition now
+            _layoutValid = false;
+            _contentDirty = true;
+        }
+    });
+    _eventDispatcher->addEventListenerWithFixedPriority(_updateTextureListener, 1);
 }
 
 Label::~Label()
@@ -435,10 +458,12 @@ Label::~Label()
         Node::removeAllChildrenWithCleanup(true);
         CC_SAFE_RELEASE_NULL(_reusedLetter);
         _batchNodes.clear();
+        releaseUsedLetters();
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
     }
     _eventDispatcher->removeEventListener(_purgeTextureListener);
     _eventDispatcher->removeEventListener(_resetTextureListener);
+    _eventDispatcher->removeEventListener(_updateTextureListener);
 
     CC_SAFE_RELEASE_NULL(_textSprite);
     CC_SAFE_RELEASE_NULL(_shadowNode);
@@ -453,8 +478,10 @@ void Label::reset()
     _letters.clear();
     _batchNodes.clear();
     _lettersInfo.clear();
+    _layoutValid = false;
     if (_fontAtlas)
     {
+        releaseUsedLetters();
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
         _fontAtlas = nullptr;
     }
@@ -590,6 +617,8 @@ void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false *
     if (_fontAtlas)
     {
         _batchNodes.clear();
+        _layoutValid = false;
+        releaseUsedLetters();
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
         _fontAtlas = nullptr;
     }
@@ -766,7 +795,7 @@ void Label::updateLabelLetters()
                 auto batchNode = _batchNodes.at(letterDef.textureID);
                 letterSprite->setTextureAtlas(batchNode->getTextureAtlas());
                 letterSprite->setTexture(_fontAtlas->getTexture(letterDef.textureID));
-                if (letterDef.width <= 0.f || letterDef.height <= 0.f)
+                if (letterDef.width <= 0.f || letterDef.height <= 0.f || letterInfo.atlasIndex < 0)
                 {
                     letterSprite->setTextureAtlas(nullptr);
                 }
@@ -788,16 +817,43 @@ void Label::updateLabelLetters()
     }
 }
 
+void Label::retainUsedLetters()
+{
+    std::u16string letters;
+    letters.append(_utf16Text);
+    std::sort(letters.begin(), letters.end());
+    letters.erase(std::unique(letters.begin(), letters.end()), letters.end());
+
+    if (letters != _usedLetters)
+    {
+        // retained first, letters of both texts keep their glyphs
+        _fontAtlas->retainLetters(letters);
+        _fontAtlas->releaseLetters(_usedLetters);
+        _usedLetters.swap(letters);
+    }
+}
+
+void Label::releaseUsedLetters()
+{
+    if (_fontAtlas && !_usedLetters.empty())
+    {
+        _fontAtlas->releaseLetters(_usedLetters);
+    }
+    _usedLetters.clear();
+}
+
 bool Label::alignText()
 {
     if (_fontAtlas == nullptr || _utf16Text.empty())
     {
         setContentSize(Size::ZERO);
+        _layoutValid = false;
         return true;
     }
 
     bool ret = true;
     do {
+        retainUsedLetters();
         _fontAtlas->prepareLetterDefinitions(_utf16Text);
         auto& textures = _fontAtlas->getTextures();
         auto size = textures.size();
@@ -827,19 +883,64 @@ bool Label::alignText()
             _batchNodes.at(0)->reserveCapacity(_utf16Text.size());
 
         _reusedLetter->setBatchNode(_batchNodes.at(0));
-        
-        _lengthOfString = 0;
-        _textDesiredHeight = 0.f;
-        _linesWidth.clear();
-        if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
-        {
-            multilineTextWrapByWord();
-        }
-        else
+
+        auto params = getLayoutParams();
+        bool layoutReusable = _layoutValid && _overflow != Overflow::SHRINK && params == _layoutParams;
+        _layoutValid = false;
+
+        // the quads of the letters before firstQuadLetter are still right
+        int firstQuadLetter = 0;
+        if (!loadCachedLayout(params))
         {
-            multilineTextWrapByChar();
+            int resumeState = layoutReusable ? getResumeState() : 0;
+            Size previousContentSize = _contentSize;
+            float previousLetterOffsetY = _letterOffsetY;
+            float previousTailoredTopY = _tailoredTopY;
+            float previousTailoredBottomY = _tailoredBottomY;
+            std::vector<float> previousLinesWidth;
+            std::vector<float> previousLinesOffsetX;
+            if (resumeState > 0)
+            {
+                previousLinesWidth = _linesWidth;
+                previousLinesOffsetX.swap(_linesOffsetX);
+            }
+            else
+            {
+                _lengthOfString = 0;
+                _textDesiredHeight = 0.f;
+                _linesWidth.clear();
+            }
+
+            if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
+            {
+                multilineTextWrapByWord(resumeState);
+            }
+            else
+            {
+                multilineTextWrapByChar(resumeState);
+            }
+            computeAlignmentOffset();
+
+            if (resumeState > 0 && _contentSize.equals(previousContentSize) && _letterOffsetY == previousLetterOffsetY
+                && _tailoredTopY == previousTailoredTopY && _tailoredBottomY == previousTailoredBottomY)
+            {
+                // the letters laid out again start in the line of the resumed state, the previous lines may have moved
+                // if the alignment or the clamping of a line depends on its new width
+                firstQuadLetter = _layoutStates[resumeState].letterIndex;
+                for (int stateIndex = 0; stateIndex <= resumeState; ++stateIndex)
+                {
+                    auto lineIndex = _layoutStates[stateIndex].lineIndex;
+                    if (_linesOffsetX[lineIndex] != previousLinesOffsetX[lineIndex]
+                        || (_labelWidth > 0.f && _linesWidth[lineIndex] != previousLinesWidth[lineIndex]))
+                    {
+                        firstQuadLetter = _layoutStates[stateIndex].letterIndex;
+                        break;
+                    }
+                }
+            }
+
+            storeCachedLayout(params);
         }
-        computeAlignmentOffset();
 
         if(_overflow == Overflow::SHRINK){
             float fontSize = this->getRenderingFontSize();
@@ -849,7 +950,7 @@ bool Label::alignText()
             }
         }
 
-        if(!updateQuads()){
+        if(!updateQuads(firstQuadLetter)){
             ret = false;
             if(_overflow == Overflow::SHRINK){
                 this->shrinkLabelToContentSize(CC_CALLBACK_0(Label::isHorizontalClamp, this));
@@ -860,11 +961,163 @@ bool Label::alignText()
         updateLabelLetters();
         
         updateColor();
+
+        _layoutText = _utf16Text;
+        _layoutParams = params;
+        _layoutValid = true;
     }while (0);
 
     return ret;
 }
 
+bool Label::LayoutParams::operator==(const LayoutParams& other) const
+{
+    return fontAtlasID == other.fontAtlasID
+        && bmfontScale == other.bmfontScale
+        && lineHeight == other.lineHeight
+        && lineSpacing == other.lineSpacing
+        && additionalKerning == other.additionalKerning
+        && maxLineWidth == other.maxLineWidth
+        && labelWidth == other.labelWidth
+        && labelHeight == other.labelHeight
+        && contentScaleFactor == other.contentScaleFactor
+        && hAlignment == other.hAlignment
+        && vAlignment == other.vAlignment
+        && overflow == other.overflow
+        && enableWrap == other.enableWrap
+        && lineBreakWithoutSpaces == other.lineBreakWithoutSpaces;
+}
+
+Label::LayoutParams Label::getLayoutParams()
+{
+    updateBMFontScale();
+
+    LayoutParams params;
+    params.fontAtlasID = _fontAtlas->getUniqueID();
+    params.bmfontScale = _bmfontScale;
+    params.lineHeight = _lineHeight;
+    params.lineSpacing = _lineSpacing;
+    params.additionalKerning = _additionalKerning;
+    params.maxLineWidth = _maxLineWidth;
+    params.labelWidth = _labelWidth;
+    params.labelHeight = _labelHeight;
+    params.contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+    params.hAlignment = _hAlignment;
+    params.vAlignment = _vAlignment;
+    params.overflow = _overflow;
+    params.enableWrap = _enableWrap;
+    params.lineBreakWithoutSpaces = _lineBreakWithoutSpaces;
+    return params;
+}
+
+int Label::getResumeState() const
+{
+    auto length = std::min(_layoutText.length(), _utf16Text.length());
+    int changedIndex = 0;
+    while (changedIndex < static_cast<int>(length) && _layoutText[changedIndex] == _utf16Text[changedIndex])
+    {
+        ++changedIndex;
+    }
+    if (changedIndex == 0)
+    {
+        return 0;
+    }
+
+    // The letter before the first changed one is laid out again, as its kerning and the length of its token
+    // depend on the changed letter. A token pushed to the next line has a state in both lines, the first one is resumed.
+    auto it = std::upper_bound(_layoutStates.begin(), _layoutStates.end(), changedIndex - 1,
+        [](int letterIndex, const LayoutState& state) { return letterIndex < state.letterIndex; });
+    if (it == _layoutStates.begin())
+    {
+        return 0;
+    }
+    --it;
+    while (it != _layoutStates.begin() && (it - 1)->letterIndex == it->letterIndex)
+    {
+        --it;
+    }
+    return static_cast<int>(it - _layoutStates.begin());
+}
+
+bool Label::loadCachedLayout(const LayoutParams& params)
+{
+    // a cached letter may have been evicted from the atlas and be rasterized again
+    if (s_layoutCacheCapacity <= 0 || params.overflow == Overflow::SHRINK || !_fontAtlas->_pendingLetters.empty())
+    {
+        return false;
+    }
+
+    for (auto it = s_layoutCache.begin(); it != s_layoutCache.end(); ++it)
+    {
+        if (it->params == params && it->text == _utf16Text)
+        {
+            if (_lettersInfo.size() < it->lettersInfo.size())
+            {
+                _lettersInfo.resize(it->lettersInfo.size());
+            }
+            std::copy(it->lettersInfo.begin(), it->lettersInfo.end(), _lettersInfo.begin());
+            _layoutStates = it->layoutStates;
+            _linesWidth = it->linesWidth;
+            _linesOffsetX = it->linesOffsetX;
+            _lengthOfString = static_cast<int>(_utf16Text.length());
+            _numberOfLines = it->numberOfLines;
+            _textDesiredHeight = it->textDesiredHeight;
+            setContentSize(it->contentSize);
+            _letterOffsetY = it->letterOffsetY;
+            _tailoredTopY = it->tailoredTopY;
+            _tailoredBottomY = it->tailoredBottomY;
+
+            s_layoutCache.splice(s_layoutCache.begin(), s_layoutCache, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Label::storeCachedLayout(const LayoutParams& params)
+{
+    // letters still being rasterized are laid out as placeholders
+    if (s_layoutCacheCapacity <= 0 || params.overflow == Overflow::SHRINK || _lengthOfString > LAYOUT_CACHE_MAX_LENGTH
+        || !_fontAtlas->_pendingLetters.empty())
+    {
+        return;
+    }
+
+    if (static_cast<int>(s_layoutCache.size()) >= s_layoutCacheCapacity)
+    {
+        s_layoutCache.pop_back();
+    }
+
+    CachedLayout layout;
+    layout.params = params;
+    layout.text = _utf16Text;
+    layout.lettersInfo.assign(_lettersInfo.begin(), _lettersInfo.begin() + _lengthOfString);
+    layout.layoutStates = _layoutStates;
+    layout.linesWidth = _linesWidth;
+    layout.linesOffsetX = _linesOffsetX;
+    layout.numberOfLines = _numberOfLines;
+    layout.textDesiredHeight = _textDesiredHeight;
+    layout.contentSize = _contentSize;
+    layout.letterOffsetY = _letterOffsetY;
+    layout.tailoredTopY = _tailoredTopY;
+    layout.tailoredBottomY = _tailoredBottomY;
+    s_layoutCache.push_front(std::move(layout));
+}
+
+void Label::setLayoutCacheCapacity(int capacity)
+{
+    s_layoutCacheCapacity = capacity;
+    while (static_cast<int>(s_layoutCache.size()) > std::max(capacity, 0))
+    {
+        s_layoutCache.pop_back();
+    }
+}
+
+void Label::purgeLayoutCache()
+{
+    s_layoutCache.clear();
+}
+
 bool Label::computeHorizontalKernings(const std::u16string& stringToRender)
 {
     if (_horizontalKernings)
@@ -893,16 +1146,23 @@ bool Label::isHorizontalClamped(float letterPositionX, int lineIndex)
     }
 }
 
-bool Label::updateQuads()
+bool Label::updateQuads(int firstLetter)
 {
     bool ret = true;
-    for (auto&& batchNode : _batchNodes)
+    // number of quads of each batch node, the quads are written in place and the ones left over are removed
+    std::vector<ssize_t> quadCounts(_batchNodes.size(), 0);
+    for (int ctr = 0; ctr < firstLetter; ++ctr)
     {
-        batchNode->getTextureAtlas()->removeAllQuads();
+        if (_lettersInfo[ctr].valid && _lettersInfo[ctr].atlasIndex >= 0)
+        {
+            auto textureID = _fontAtlas->_letterDefinitions[_lettersInfo[ctr].utf16Char].textureID;
+            quadCounts[textureID] = std::max(quadCounts[textureID], static_cast<ssize_t>(_lettersInfo[ctr].atlasIndex) + 1);
+        }
     }
     
-    for (int ctr = 0; ctr < _lengthOfString; ++ctr)
+    for (int ctr = firstLetter; ctr < _lengthOfString; ++ctr)
     {
+        _lettersInfo[ctr].atlasIndex = -1;
         if (_lettersInfo[ctr].valid)
         {
             auto& letterDef = _fontAtlas->_letterDefinitions[_lettersInfo[ctr].utf16Char];
@@ -952,16 +1212,25 @@ bool Label::updateQuads()
                 _reusedLetter->setTextureRect(_reusedRect, false, _reusedRect.size);
                 float letterPositionX = _lettersInfo[ctr].positionX + _linesOffsetX[_lettersInfo[ctr].lineIndex];
                 _reusedLetter->setPosition(letterPositionX, py);
-                auto index = static_cast<int>(_batchNodes.at(letterDef.textureID)->getTextureAtlas()->getTotalQuads());
-                _lettersInfo[ctr].atlasIndex = index;
+                auto index = quadCounts[letterDef.textureID]++;
+                _lettersInfo[ctr].atlasIndex = static_cast<int>(index);
 
                 this->updateLetterSpriteScale(_reusedLetter);
 
-                _batchNodes.at(letterDef.textureID)->insertQuadFromSprite(_reusedLetter, index);
+                _batchNodes.at(letterDef.textureID)->updateQuadFromSprite(_reusedLetter, index);
             }
         }     
     }
 
+    for (size_t textureID = 0; textureID < quadCounts.size(); ++textureID)
+    {
+        auto textureAtlas = _batchNodes.at(textureID)->getTextureAtlas();
+        auto totalQuads = textureAtlas->getTotalQuads();
+        if (totalQuads > quadCounts[textureID])
+        {
+            textureAtlas->removeQuadsAtIndex(quadCounts[textureID], totalQuads - quadCounts[textureID]);
+        }
+    }
 
     return ret;
 }
@@ -1368,7 +1637,9 @@ void Label::updateContent()
         if (_fontAtlas)
         {
             _batchNodes.clear();
+            _layoutValid = false;
 
+            releaseUsedLetters();
             FontAtlasCache::releaseFontAtlas(_fontAtlas);
             _fontAtlas = nullptr;
         }
@@ -1775,8 +2046,12 @@ Sprite* Label::getLetter(int letterIndex)
                 else
                 {
                     letter = LabelLetter::createWithTexture(_fontAtlas->getTexture(textureID), uvRect);
-                    letter->setTextureAtlas(_batchNodes.at(textureID)->getTextureAtlas());
-                    letter->setAtlasIndex(letterInfo.atlasIndex);
+                    // a letter clipped by the label has no quad
+                    if (letterInfo.atlasIndex >= 0)
+                    {
+                        letter->setTextureAtlas(_batchNodes.at(textureID)->getTextureAtlas());
+                        letter->setAtlasIndex(letterInfo.atlasIndex);
+                    }
                     auto px = letterInfo.positionX + uvRect.size.width / 2 + _linesOffsetX[letterInfo.lineIndex];
                     auto py = letterInfo.positionY - uvRect.size.height / 2 + _letterOffsetY;
                     letter->setPosition(px,py);
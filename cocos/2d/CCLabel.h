@@ -26,6 +26,8 @@
 #ifndef _COCOS2D_CCLABEL_H_
 #define _COCOS2D_CCLABEL_H_
 
+#include <list>
+
 #include "2d/CCNode.h"
 #include "renderer/CCCustomCommand.h"
 #include "renderer/CCQuadCommand.h"
@@ -112,6 +114,8 @@ class EventListenerCustom;
 class CC_DLL Label : public Node, public LabelProtocol, public BlendProtocol
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(Label)
+
     enum class Overflow
     {
         //In NONE mode, the dimensions is (0,0) and the content size will change dynamically to fit the label.
@@ -569,6 +573,28 @@ public:
 
     FontAtlas* getFontAtlas() { return _fontAtlas; }
 
+    /**
+     * Sets the number of layouts kept by the layout cache shared by all labels, 0 disables the cache.
+     * A label whose text, font, dimensions, alignment and overflow match a cached layout reuses its letter positions
+     * instead of laying out the text again. Labels with the SHRINK overflow are not cached. The default capacity is 64.
+     *
+     * @warning Not support system font.
+     * @since v3.15
+     */
+    static void setLayoutCacheCapacity(int capacity);
+
+    /**
+     * Returns the number of layouts kept by the layout cache.
+     * @since v3.15
+     */
+    static int getLayoutCacheCapacity() { return s_layoutCacheCapacity; }
+
+    /**
+     * Removes all the layouts from the layout cache.
+     * @since v3.15
+     */
+    static void purgeLayoutCache();
+
     virtual const BlendFunc& getBlendFunc() const override { return _blendFunc; }
     virtual void setBlendFunc(const BlendFunc &blendFunc) override;
 
@@ -631,6 +657,59 @@ protected:
         int lineIndex;
     };
 
+    // state of multilineTextWrap before a token, the layout can be resumed from there
+    struct LayoutState
+    {
+        int letterIndex;
+        int lineIndex;
+        float nextTokenX;
+        float nextTokenY;
+        float letterRight;
+        float highestY;
+        float lowestY;
+        float longestLine;
+        bool nextChangeSize;
+    };
+
+    // everything the layout of a text depends on, besides the text
+    struct LayoutParams
+    {
+        unsigned int fontAtlasID;
+        float bmfontScale;
+        float lineHeight;
+        float lineSpacing;
+        float additionalKerning;
+        float maxLineWidth;
+        float labelWidth;
+        float labelHeight;
+        float contentScaleFactor;
+        TextHAlignment hAlignment;
+        TextVAlignment vAlignment;
+        Overflow overflow;
+        bool enableWrap;
+        bool lineBreakWithoutSpaces;
+
+        bool operator==(const LayoutParams& other) const;
+        bool operator!=(const LayoutParams& other) const { return !(*this == other); }
+    };
+
+    // results of multilineTextWrap and computeAlignmentOffset
+    struct CachedLayout
+    {
+        LayoutParams params;
+        std::u16string text;
+        std::vector<LetterInfo> lettersInfo;
+        std::vector<LayoutState> layoutStates;
+        std::vector<float> linesWidth;
+        std::vector<float> linesOffsetX;
+        int numberOfLines;
+        float textDesiredHeight;
+        Size contentSize;
+        float letterOffsetY;
+        float tailoredTopY;
+        float tailoredBottomY;
+    };
+
     enum class LabelType {
         TTF,
         BMFONT,
@@ -646,9 +725,10 @@ protected:
     void onDrawShadow(GLProgram* glProgram, const Color4F& shadowColor);
     void drawSelf(bool visibleByCamera, Renderer* renderer, uint32_t flags);
 
-    bool multilineTextWrapByChar();
-    bool multilineTextWrapByWord();
-    bool multilineTextWrap(const std::function<int(const std::u16string&, int, int)>& lambda);
+    bool multilineTextWrapByChar(int resumeState = 0);
+    bool multilineTextWrapByWord(int resumeState = 0);
+    /** Lays out the letters from _layoutStates[resumeState] on, the letters before it are kept. */
+    bool multilineTextWrap(const std::function<int(const std::u16string&, int, int)>& lambda, int resumeState = 0);
     void shrinkLabelToContentSize(const std::function<bool(void)>& lambda);
     bool isHorizontalClamp();
     bool isVerticalClamp();
@@ -660,10 +740,22 @@ protected:
     void computeAlignmentOffset();
     bool computeHorizontalKernings(const std::u16string& stringToRender);
 
+    /** Retains the letters of the text in the font atlas, so that their glyphs are not evicted, and releases the previous ones. */
+    void retainUsedLetters();
+    /** Releases the letters retained in the font atlas, before the atlas is released. */
+    void releaseUsedLetters();
+
     void recordLetterInfo(const cocos2d::Vec2& point, char16_t utf16Char, int letterIndex, int lineIndex);
     void recordPlaceholderInfo(int letterIndex, char16_t utf16Char);
     
-    bool updateQuads();
+    /** Writes the quads of the letters from firstLetter on, the quads of the previous letters are kept. */
+    bool updateQuads(int firstLetter = 0);
+
+    LayoutParams getLayoutParams();
+    /** Returns the index of the layout state to resume from after the text changed from _layoutText, 0 for the whole text. */
+    int getResumeState() const;
+    bool loadCachedLayout(const LayoutParams& params);
+    void storeCachedLayout(const LayoutParams& params);
 
     void createSpriteForSystemFont(const FontDefinition& fontDef);
     void createShadowSpriteForSystemFont(const FontDefinition& fontDef);
@@ -688,6 +780,8 @@ protected:
     LabelType _currentLabelType;
     bool _contentDirty;
     std::u16string _utf16Text;
+    // distinct letters retained in the font atlas, sorted
+    std::u16string _usedLetters;
     std::string _utf8Text;
     int _numberOfLines;
 
@@ -729,6 +823,16 @@ protected:
     float _letterOffsetY;
     float _tailoredTopY;
     float _tailoredBottomY;
+    std::vector<LayoutState> _layoutStates;
+
+    // text and parameters of the layout written in the batch nodes, when _layoutValid is true
+    std::u16string _layoutText;
+    LayoutParams _layoutParams;
+    bool _layoutValid;
+
+    // most recently used first
+    static std::list<CachedLayout> s_layoutCache;
+    static int s_layoutCacheCapacity;
 
     LabelEffect _currLabelEffect;
     Color4F _effectColorF;
@@ -766,6 +870,7 @@ protected:
 
     EventListenerCustom* _purgeTextureListener;
     EventListenerCustom* _resetTextureListener;
+    EventListenerCustom* _updateTextureListener;
 
 #if CC_LABEL_DEBUG_DRAW
     DrawNode* _debugDrawNode;
@@ -130,7 +130,7 @@ void Label::updateBMFontScale()
     }
 }
 
-bool Label::multilineTextWrap(const std::function<int(const std::u16string&, int, int)>& nextTokenLen)
+bool Label::multilineTextWrap(const std::function<int(const std::u16string&, int, int)>& nextTokenLen, int resumeState)
 {
     int textLen = getStringLength();
     int lineIndex = 0;
@@ -149,8 +149,32 @@ bool Label::multilineTextWrap(const std::function<int(const std::u16string&, int
 
     this->updateBMFontScale();
 
-    for (int index = 0; index < textLen; )
+    int index = 0;
+    if (resumeState > 0)
     {
+        auto& state = _layoutStates[resumeState];
+        index = state.letterIndex;
+        lineIndex = state.lineIndex;
+        nextTokenX = state.nextTokenX;
+        nextTokenY = state.nextTokenY;
+        letterRight = state.letterRight;
+        highestY = state.highestY;
+        lowestY = state.lowestY;
+        longestLine = state.longestLine;
+        nextChangeSize = state.nextChangeSize;
+        _linesWidth.resize(lineIndex);
+        _layoutStates.resize(resumeState);
+    }
+    else
+    {
+        _layoutStates.clear();
+    }
+
+    while (index < textLen)
+    {
+        LayoutState state = { index, lineIndex, nextTokenX, nextTokenY, letterRight, highestY, lowestY, longestLine, nextChangeSize };
+        _layoutStates.push_back(state);
+
         auto character = _utf16Text[index];
         if (character == (char16_t)TextFormatter::NewLine)
         {
@@ -189,7 +213,10 @@ bool Label::multilineTextWrap(const std::function<int(const std::u16string&, int
             if (_fontAtlas->getLetterDefinitionForChar(character, letterDef) == false)
             {
                 recordPlaceholderInfo(letterIndex, character);
-                CCLOG("LabelTextFormatter error:can't find letter definition in font file for letter: %c", character);
+                if (!_fontAtlas->isLetterPending(character))
+                {
+                    CCLOG("LabelTextFormatter error:can't find letter definition in font file for letter: %c", character);
+                }
                 continue;
             }
 
@@ -268,14 +295,14 @@ bool Label::multilineTextWrap(const std::function<int(const std::u16string&, int
     return true;
 }
 
-bool Label::multilineTextWrapByWord()
+bool Label::multilineTextWrapByWord(int resumeState)
 {
-    return multilineTextWrap(CC_CALLBACK_3(Label::getFirstWordLen, this));
+    return multilineTextWrap(CC_CALLBACK_3(Label::getFirstWordLen, this), resumeState);
 }
 
-bool Label::multilineTextWrapByChar()
+bool Label::multilineTextWrapByChar(int resumeState)
 {
-    return multilineTextWrap(CC_CALLBACK_3(Label::getFirstCharLen, this));
+    return multilineTextWrap(CC_CALLBACK_3(Label::getFirstCharLen, this), resumeState);
 }
 
 bool Label::isVerticalClamp()
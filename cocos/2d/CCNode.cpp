@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "renderer/CCGLProgramState.h"
 #include "renderer/CCMaterial.h"
 #include "math/TransformUtils.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 
 #if CC_NODE_RENDER_SUBPIXEL
@@ -55,8 +56,11 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(Node, 64)
+
 // FIXME:: Yes, nodes might have a sort problem once every 30 days if the game runs at 60 FPS and each frame sprites are reordered.
 unsigned int Node::s_globalOrderOfArrival = 0;
+unsigned int Node::s_frozenNodeCount = 0;
 
 // MARK: Constructor, Destructor, Init
 
@@ -80,6 +84,8 @@ Node::Node()
 , _additionalTransform(nullptr)
 , _additionalTransformDirty(false)
 , _transformUpdated(true)
+, _transformFrozen(false)
+, _frozenSubtreeDirty(false)
 // children (lazy allocs)
 // lazy alloc
 , _localZOrderAndArrival(0)
@@ -186,6 +192,11 @@ Node::~Node()
     CC_SAFE_RELEASE(_eventDispatcher);
 
     delete[] _additionalTransform;
+
+    if (_transformFrozen)
+    {
+        --s_frozenNodeCount;
+    }
 }
 
 bool Node::init()
@@ -235,6 +246,7 @@ void Node::setSkewX(float skewX)
     
     _skewX = skewX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 float Node::getSkewY() const
@@ -249,6 +261,7 @@ void Node::setSkewY(float skewY)
     
     _skewY = skewY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 void Node::setLocalZOrder(int z)
@@ -302,6 +315,7 @@ void Node::setRotation(float rotation)
     
     _rotationZ_X = _rotationZ_Y = rotation;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
     
     updateRotationQuat();
 }
@@ -319,6 +333,7 @@ void Node::setRotation3D(const Vec3& rotation)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 
     _rotationX = rotation.x;
     _rotationY = rotation.y;
@@ -370,6 +385,7 @@ void Node::setRotationQuat(const Quaternion& quat)
     _rotationQuat = quat;
     updateRotation3D();
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 Quaternion Node::getRotationQuat() const
@@ -384,6 +400,7 @@ void Node::setRotationSkewX(float rotationX)
     
     _rotationZ_X = rotationX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
     
     updateRotationQuat();
 }
@@ -400,6 +417,7 @@ void Node::setRotationSkewY(float rotationY)
     
     _rotationZ_Y = rotationY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
     
     updateRotationQuat();
 }
@@ -419,6 +437,7 @@ void Node::setScale(float scale)
     
     _scaleX = _scaleY = _scaleZ = scale;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 /// scaleX getter
@@ -436,6 +455,7 @@ void Node::setScale(float scaleX,float scaleY)
     _scaleX = scaleX;
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 /// scaleX setter
@@ -446,6 +466,7 @@ void Node::setScaleX(float scaleX)
     
     _scaleX = scaleX;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 /// scaleY getter
@@ -462,6 +483,7 @@ void Node::setScaleZ(float scaleZ)
     
     _scaleZ = scaleZ;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 /// scaleY getter
@@ -478,6 +500,7 @@ void Node::setScaleY(float scaleY)
     
     _scaleY = scaleY;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 
@@ -508,6 +531,7 @@ void Node::setPosition(float x, float y)
     _position.y = y;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
     _usingNormalizedPosition = false;
 }
 
@@ -553,6 +577,7 @@ void Node::setPositionZ(float positionZ)
         return;
     
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 
     _positionZ = positionZ;
 }
@@ -573,6 +598,7 @@ void Node::setPositionNormalized(const Vec2& position)
     _usingNormalizedPosition = true;
     _normalizedPositionDirty = true;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 ssize_t Node::getChildrenCount() const
@@ -586,6 +612,19 @@ bool Node::isVisible() const
     return _visible;
 }
 
+void Node::setTransformFrozen(bool frozen)
+{
+    if (frozen != _transformFrozen)
+    {
+        _transformFrozen = frozen;
+        _frozenSubtreeDirty = true;
+        if (frozen)
+            ++s_frozenNodeCount;
+        else
+            --s_frozenNodeCount;
+    }
+}
+
 /// isVisible setter
 void Node::setVisible(bool visible)
 {
@@ -593,7 +632,10 @@ void Node::setVisible(bool visible)
     {
         _visible = visible;
         if(_visible)
+        {
             _transformUpdated = _transformDirty = _inverseDirty = true;
+            markFrozenParentsDirty();
+        }
     }
 }
 
@@ -615,6 +657,7 @@ void Node::setAnchorPoint(const Vec2& point)
         _anchorPoint = point;
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        markFrozenParentsDirty();
     }
 }
 
@@ -632,6 +675,7 @@ void Node::setContentSize(const Size & size)
 
         _anchorPointInPoints.set(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y);
         _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+        markFrozenParentsDirty();
     }
 }
 
@@ -646,6 +690,7 @@ void Node::setParent(Node * parent)
 {
     _parent = parent;
     _transformUpdated = _transformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 /// isRelativeAnchorPoint getter
@@ -661,6 +706,7 @@ void Node::setIgnoreAnchorPointForPosition(bool newValue)
     {
         _ignoreAnchorPointForPosition = newValue;
         _transformUpdated = _transformDirty = _inverseDirty = true;
+        markFrozenParentsDirty();
     }
 }
 
@@ -1131,6 +1177,7 @@ void Node::insertChild(Node* child, int z)
     }
 #endif // CC_ENABLE_GC_FOR_NATIVE_OBJECTS
     _transformUpdated = true;
+    markFrozenParentsDirty();
     _reorderChildDirty = true;
     _children.pushBack(child);
     child->_setLocalZOrder(z);
@@ -1174,6 +1221,10 @@ void Node::visit()
 
 uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFlags)
 {
+    // Nothing changed inside the frozen subtree: the cached transform is still valid
+    if (parentFlags & FLAGS_TRANSFORM_FROZEN)
+        return parentFlags;
+
     if(_usingNormalizedPosition)
     {
         CCASSERT(_parent, "setPositionNormalized() doesn't work with orphan nodes");
@@ -1190,7 +1241,12 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
     // Fixes Github issue #16100. Basically when having two cameras, one camera might set as dirty the
     // node that is not visited by it, and might affect certain calculations. Besides, it is faster to do this.
     if (!isVisitableByVisitingCamera())
+    {
+        // The update is still pending, frozen ancestors must not skip it for the other cameras
+        if (_transformUpdated || _contentSizeDirty)
+            markFrozenParentsDirty();
         return parentFlags;
+    }
 
     uint32_t flags = parentFlags;
     flags |= (_transformUpdated ? FLAGS_TRANSFORM_DIRTY : 0);
@@ -1203,9 +1259,28 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
     _transformUpdated = false;
     _contentSizeDirty = false;
 
+    if (_transformFrozen)
+    {
+        if (!(flags & FLAGS_DIRTY_MASK) && !_frozenSubtreeDirty)
+            flags |= FLAGS_TRANSFORM_FROZEN;
+        _frozenSubtreeDirty = false;
+    }
+
     return flags;
 }
 
+void Node::markFrozenParentsDirty()
+{
+    if (s_frozenNodeCount == 0)
+        return;
+
+    for (Node *node = this; node != nullptr; node = node->_parent)
+    {
+        if (node->_transformFrozen)
+            node->_frozenSubtreeDirty = true;
+    }
+}
+
 bool Node::isVisitableByVisitingCamera() const
 {
     auto camera = Camera::getVisitingCamera();
@@ -1769,6 +1844,7 @@ void Node::setNodeToParentTransform(const Mat4& transform)
     _transform = transform;
     _transformDirty = false;
     _transformUpdated = true;
+    markFrozenParentsDirty();
 
     if (_additionalTransform)
         // _additionalTransform[1] has a copy of lastest transform
@@ -1801,6 +1877,7 @@ void Node::setAdditionalTransform(const Mat4* additionalTransform)
         _additionalTransform[0] = *additionalTransform;
     }
     _transformUpdated = _additionalTransformDirty = _inverseDirty = true;
+    markFrozenParentsDirty();
 }
 
 void Node::setAdditionalTransform(const Mat4& additionalTransform)
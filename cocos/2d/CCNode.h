@@ -31,6 +31,7 @@
 
 #include <cstdint>
 #include "base/ccMacros.h"
+#include "base/allocator/CCAllocatorMacros.h"
 #include "base/CCVector.h"
 #include "base/CCProtocols.h"
 #include "base/CCScriptSupport.h"
@@ -108,6 +109,8 @@ class EventListener;
 class CC_DLL Node : public Ref
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(Node)
+
     /** Default tag used for all the nodes */
     static const int INVALID_TAG = -1;
 
@@ -115,6 +118,7 @@ public:
         FLAGS_TRANSFORM_DIRTY = (1 << 0),
         FLAGS_CONTENT_SIZE_DIRTY = (1 << 1),
         FLAGS_RENDER_AS_3D = (1 << 3),
+        FLAGS_TRANSFORM_FROZEN = (1 << 4),
 
         FLAGS_DIRTY_MASK = (FLAGS_TRANSFORM_DIRTY | FLAGS_CONTENT_SIZE_DIRTY),
     };
@@ -575,6 +579,29 @@ public:
      */
     virtual bool isVisible() const;
 
+    /**
+     * Sets whether the transforms of the node's descendants are frozen.
+     *
+     * While nothing changes in a frozen subtree, visiting it skips the transform checks and computations of every descendant.
+     * Changes made through Node's setters (position, rotation, scale, content size, visibility, children...)
+     * still mark the subtree as dirty, so it is updated in the next frame.
+     * The transform of the frozen node itself is always updated.
+     * Use it for large static hierarchies, like backgrounds or tile based decorations.
+     *
+     * @param frozen   true to freeze the subtree, false otherwise. The default value is false.
+     * @since v3.15
+     */
+    void setTransformFrozen(bool frozen);
+    /**
+     * Determines if the transforms of the node's descendants are frozen.
+     *
+     * @see `setTransformFrozen(bool)`
+     *
+     * @return true if the subtree is frozen.
+     * @since v3.15
+     */
+    bool isTransformFrozen() const { return _transformFrozen; }
+
 
     /**
      * Sets the rotation (angle) of the node in degrees.
@@ -1873,6 +1900,9 @@ protected:
     Mat4 transform(const Mat4 &parentTransform);
     uint32_t processParentFlags(const Mat4& parentTransform, uint32_t parentFlags);
 
+    /// Marks the frozen ancestors of the node as dirty. Must be called when _transformUpdated or _contentSizeDirty is set.
+    void markFrozenParentsDirty();
+
     virtual void updateCascadeOpacity();
     virtual void disableCascadeOpacity();
     virtual void updateCascadeColor();
@@ -1933,6 +1963,8 @@ protected:
     mutable Mat4* _additionalTransform; ///< two transforms needed by additional transforms
     mutable bool _additionalTransformDirty; ///< transform dirty ?
     bool _transformUpdated;         ///< Whether or not the Transform object was updated since the last frame
+    bool _transformFrozen;          ///< Whether or not the transforms of the descendants are frozen
+    bool _frozenSubtreeDirty;       ///< Whether or not a descendant of a frozen node has a pending transform update
 
     std::int64_t _localZOrderAndArrival; /// cache, for 64bits compress optimize.
     int _localZOrder; /// < Local order (relative to its siblings) used to sort the node
@@ -1940,6 +1972,7 @@ protected:
     float _globalZOrder;            ///< Global order used to sort the node
 
     static unsigned int s_globalOrderOfArrival;
+    static unsigned int s_frozenNodeCount;
 
     Vector<Node*> _children;        ///< array of children nodes
     Node *_parent;                  ///< weak reference to parent node
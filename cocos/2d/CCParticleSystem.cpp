@@ -45,6 +45,8 @@ THE SOFTWARE.
 #include "2d/CCParticleSystem.h"
 
 #include <string>
+#include <algorithm>
+#include <float.h>
 
 #include "2d/CCParticleBatchNode.h"
 #include "renderer/CCTextureAtlas.h"
@@ -52,12 +54,17 @@ THE SOFTWARE.
 #include "base/ZipUtils.h"
 #include "base/CCDirector.h"
 #include "base/CCProfiling.h"
+#include "base/CCParallelTaskPool.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
 #include "base/ccUTF8.h"
 #include "renderer/CCTextureCache.h"
 #include "platform/CCFileUtils.h"
 
 using namespace std;
 
+#include "2d/CCParticleSystemKernels.inl"
+
 NS_CC_BEGIN
 
 // ideas taken from:
@@ -78,34 +85,41 @@ NS_CC_BEGIN
 //
 
 
-inline void nomalize_point(float x, float y, particle_point* out)
+// systems being updated on worker threads, retained until finishParallelUpdates
+static bool s_parallelUpdateEnabled = false;
+static std::vector<ParticleSystem*> s_parallelUpdates;
+static ParallelTaskPool::TaskGroup s_parallelTaskGroup;
+// registered while parallel updates are enabled
+static EventListenerCustom* s_afterDrawListener = nullptr;
+static EventListenerCustom* s_resetListener = nullptr;
+
+static void addParallelUpdateListeners()
 {
-    float n = x * x + y * y;
-    // Already normalized.
-    if (n == 1.0f)
+    if (s_afterDrawListener)
         return;
-    
-    n = sqrt(n);
-    // Too close to zero.
-    if (n < MATH_TOLERANCE)
-        return;
-    
-    n = 1.0f / n;
-    out->x = x * n;
-    out->y = y * n;
+
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    s_afterDrawListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_DRAW, [](EventCustom*){
+        ParticleSystem::finishParallelUpdates();
+    });
+    s_resetListener = dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom*){
+        ParticleSystem::finishParallelUpdates();
+        // the director removes every listener after this event, they are added again by the next parallel update
+        s_afterDrawListener = nullptr;
+        s_resetListener = nullptr;
+    });
 }
 
-/**
- A more effect random number getter function, get from ejoy2d.
- */
-inline static float RANDOM_M11(unsigned int *seed) {
-    *seed = *seed * 134775813 + 1;
-    union {
-        uint32_t d;                                     
-        float f;
-    } u;
-    u.d = (((uint32_t)(*seed) & 0x7fff) << 8) | 0x40000000;
-    return u.f - 3.0f;
+static void removeParallelUpdateListeners()
+{
+    if (!s_afterDrawListener)
+        return;
+
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    dispatcher->removeEventListener(s_afterDrawListener);
+    dispatcher->removeEventListener(s_resetListener);
+    s_afterDrawListener = nullptr;
+    s_resetListener = nullptr;
 }
 
 ParticleData::ParticleData()
@@ -220,6 +234,7 @@ ParticleSystem::ParticleSystem()
 , _yCoordFlipped(1)
 , _positionType(PositionType::FREE)
 , _paused(false)
+, _parallelUpdatePending(false)
 {
     modeA.gravity.setZero();
     modeA.speed = 0;
@@ -591,35 +606,22 @@ void ParticleSystem::addParticles(int count)
 {
     if (_paused)
         return;
+    waitForParallelUpdate();
     uint32_t RANDSEED = rand();
 
     int start = _particleCount;
     _particleCount += count;
     
     //life
-    for (int i = start; i < _particleCount ; ++i)
-    {
-        float theLife = _life + _lifeVar * RANDOM_M11(&RANDSEED);
-        _particleData.timeToLive[i] = MAX(0, theLife);
-    }
+    particleRandomFill(_particleData.timeToLive + start, _life, _lifeVar, 0, FLT_MAX, &RANDSEED, count);
     
     //position
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.posx[i] = _sourcePosition.x + _posVar.x * RANDOM_M11(&RANDSEED);
-    }
-    
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.posy[i] = _sourcePosition.y + _posVar.y * RANDOM_M11(&RANDSEED);
-    }
+    particleRandomFill(_particleData.posx + start, _sourcePosition.x, _posVar.x, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+    particleRandomFill(_particleData.posy + start, _sourcePosition.y, _posVar.y, -FLT_MAX, FLT_MAX, &RANDSEED, count);
     
     //color
 #define SET_COLOR(c, b, v)\
-for (int i = start; i < _particleCount; ++i)\
-{\
-c[i] = clampf( b + v * RANDOM_M11(&RANDSEED) , 0 , 1 );\
-}
+particleRandomFill(c + start, b, v, 0, 1, &RANDSEED, count);
     
     SET_COLOR(_particleData.colorR, _startColor.r, _startColorVar.r);
     SET_COLOR(_particleData.colorG, _startColor.g, _startColorVar.g);
@@ -632,10 +634,7 @@ c[i] = clampf( b + v * RANDOM_M11(&RANDSEED) , 0 , 1 );\
     SET_COLOR(_particleData.deltaColorA, _endColor.a, _endColorVar.a);
     
 #define SET_DELTA_COLOR(c, dc)\
-for (int i = start; i < _particleCount; ++i)\
-{\
-dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
-}
+particleDelta(dc + start, c + start, _particleData.timeToLive + start, count);
     
     SET_DELTA_COLOR(_particleData.colorR, _particleData.deltaColorR);
     SET_DELTA_COLOR(_particleData.colorG, _particleData.deltaColorG);
@@ -643,39 +642,22 @@ dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
     SET_DELTA_COLOR(_particleData.colorA, _particleData.deltaColorA);
     
     //size
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.size[i] = _startSize + _startSizeVar * RANDOM_M11(&RANDSEED);
-        _particleData.size[i] = MAX(0, _particleData.size[i]);
-    }
+    particleRandomFill(_particleData.size + start, _startSize, _startSizeVar, 0, FLT_MAX, &RANDSEED, count);
     
     if (_endSize != START_SIZE_EQUAL_TO_END_SIZE)
     {
-        for (int i = start; i < _particleCount; ++i)
-        {
-            float endSize = _endSize + _endSizeVar * RANDOM_M11(&RANDSEED);
-            endSize = MAX(0, endSize);
-            _particleData.deltaSize[i] = (endSize - _particleData.size[i]) / _particleData.timeToLive[i];
-        }
+        particleRandomFill(_particleData.deltaSize + start, _endSize, _endSizeVar, 0, FLT_MAX, &RANDSEED, count);
+        particleDelta(_particleData.deltaSize + start, _particleData.size + start, _particleData.timeToLive + start, count);
     }
     else
     {
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.deltaSize[i] = 0.0f;
-        }
+        std::fill_n(_particleData.deltaSize + start, count, 0.0f);
     }
     
     // rotation
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.rotation[i] = _startSpin + _startSpinVar * RANDOM_M11(&RANDSEED);
-    }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        float endA = _endSpin + _endSpinVar * RANDOM_M11(&RANDSEED);
-        _particleData.deltaRotation[i] = (endA - _particleData.rotation[i]) / _particleData.timeToLive[i];
-    }
+    particleRandomFill(_particleData.rotation + start, _startSpin, _startSpinVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+    particleRandomFill(_particleData.deltaRotation + start, _endSpin, _endSpinVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+    particleDelta(_particleData.deltaRotation + start, _particleData.rotation + start, _particleData.timeToLive + start, count);
     
     // position
     Vec2 pos;
@@ -687,58 +669,32 @@ dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
     {
         pos = _position;
     }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.startPosX[i] = pos.x;
-    }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.startPosY[i] = pos.y;
-    }
+    std::fill_n(_particleData.startPosX + start, count, pos.x);
+    std::fill_n(_particleData.startPosY + start, count, pos.y);
     
     // Mode Gravity: A
     if (_emitterMode == Mode::GRAVITY)
     {
         
         // radial accel
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeA.radialAccel[i] = modeA.radialAccel + modeA.radialAccelVar * RANDOM_M11(&RANDSEED);
-        }
+        particleRandomFill(_particleData.modeA.radialAccel + start, modeA.radialAccel, modeA.radialAccelVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
         
         // tangential accel
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeA.tangentialAccel[i] = modeA.tangentialAccel + modeA.tangentialAccelVar * RANDOM_M11(&RANDSEED);
-        }
+        particleRandomFill(_particleData.modeA.tangentialAccel + start, modeA.tangentialAccel, modeA.tangentialAccelVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+        
+        // direction: dirX receives the angle and dirY the speed, then both are turned into a velocity
+        particleRandomFill(_particleData.modeA.dirX + start, CC_DEGREES_TO_RADIANS(_angle), CC_DEGREES_TO_RADIANS(_angleVar), -FLT_MAX, FLT_MAX, &RANDSEED, count);
+        particleRandomFill(_particleData.modeA.dirY + start, modeA.speed, modeA.speedVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+        particleAngleSpeedToDirection(_particleData.modeA.dirX + start, _particleData.modeA.dirY + start, count);
         
         // rotation is dir
         if( modeA.rotationIsDir )
         {
             for (int i = start; i < _particleCount; ++i)
             {
-                float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED) );
-                Vec2 v(cosf( a ), sinf( a ));
-                float s = modeA.speed + modeA.speedVar * RANDOM_M11(&RANDSEED);
-                Vec2 dir = v * s;
-                _particleData.modeA.dirX[i] = dir.x;//v * s ;
-                _particleData.modeA.dirY[i] = dir.y;
-                _particleData.rotation[i] = -CC_RADIANS_TO_DEGREES(dir.getAngle());
+                _particleData.rotation[i] = -CC_RADIANS_TO_DEGREES(atan2f(_particleData.modeA.dirY[i], _particleData.modeA.dirX[i]));
             }
         }
-        else
-        {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED) );
-                Vec2 v(cosf( a ), sinf( a ));
-                float s = modeA.speed + modeA.speedVar * RANDOM_M11(&RANDSEED);
-                Vec2 dir = v * s;
-                _particleData.modeA.dirX[i] = dir.x;//v * s ;
-                _particleData.modeA.dirY[i] = dir.y;
-            }
-        }
-        
     }
     
     // Mode Radius: B
@@ -746,37 +702,22 @@ dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
     {
         //Need to check by Jacky
         // Set the default diameter of the particle from the source position
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.radius[i] = modeB.startRadius + modeB.startRadiusVar * RANDOM_M11(&RANDSEED);
-        }
-
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.angle[i] = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED));
-        }
-        
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.degreesPerSecond[i] = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * RANDOM_M11(&RANDSEED));
-        }
+        particleRandomFill(_particleData.modeB.radius + start, modeB.startRadius, modeB.startRadiusVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+        particleRandomFill(_particleData.modeB.angle + start, CC_DEGREES_TO_RADIANS(_angle), CC_DEGREES_TO_RADIANS(_angleVar), -FLT_MAX, FLT_MAX, &RANDSEED, count);
+        particleRandomFill(_particleData.modeB.degreesPerSecond + start, CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond), CC_DEGREES_TO_RADIANS(modeB.rotatePerSecondVar), -FLT_MAX, FLT_MAX, &RANDSEED, count);
         
         if(modeB.endRadius == START_RADIUS_EQUAL_TO_END_RADIUS)
         {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                _particleData.modeB.deltaRadius[i] = 0.0f;
-            }
+            std::fill_n(_particleData.modeB.deltaRadius + start, count, 0.0f);
         }
         else
         {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                float endRadius = modeB.endRadius + modeB.endRadiusVar * RANDOM_M11(&RANDSEED);
-                _particleData.modeB.deltaRadius[i] = (endRadius - _particleData.modeB.radius[i]) / _particleData.timeToLive[i];
-            }
+            particleRandomFill(_particleData.modeB.deltaRadius + start, modeB.endRadius, modeB.endRadiusVar, -FLT_MAX, FLT_MAX, &RANDSEED, count);
+            particleDelta(_particleData.modeB.deltaRadius + start, _particleData.modeB.radius + start, _particleData.timeToLive + start, count);
         }
     }
+#undef SET_COLOR
+#undef SET_DELTA_COLOR
 }
 
 void ParticleSystem::onEnter()
@@ -818,6 +759,7 @@ void ParticleSystem::stopSystem()
 
 void ParticleSystem::resetSystem()
 {
+    waitForParallelUpdate();
     _isActive = true;
     _elapsed = 0;
     for (int i = 0; i < _particleCount; ++i)
@@ -836,6 +778,8 @@ void ParticleSystem::update(float dt)
 {
     CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 
+    waitForParallelUpdate();
+
     if (_isActive && _emissionRate)
     {
         float rate = 1.0f / _emissionRate;
@@ -861,10 +805,7 @@ void ParticleSystem::update(float dt)
     }
     
     {
-        for (int i = 0; i < _particleCount; ++i)
-        {
-            _particleData.timeToLive[i] -= dt;
-        }
+        particleAdd(_particleData.timeToLive, -dt, _particleCount);
         
         for (int i = 0; i < _particleCount; ++i)
         {
@@ -895,105 +836,24 @@ void ParticleSystem::update(float dt)
             }
         }
         
-        if (_emitterMode == Mode::GRAVITY)
-        {
-            for (int i = 0 ; i < _particleCount; ++i)
-            {
-                particle_point tmp, radial = {0.0f, 0.0f}, tangential;
-                
-                // radial acceleration
-                if (_particleData.posx[i] || _particleData.posy[i])
-                {
-                    nomalize_point(_particleData.posx[i], _particleData.posy[i], &radial);
-                }
-                tangential = radial;
-                radial.x *= _particleData.modeA.radialAccel[i];
-                radial.y *= _particleData.modeA.radialAccel[i];
-                
-                // tangential acceleration
-                std::swap(tangential.x, tangential.y);
-                tangential.x *= - _particleData.modeA.tangentialAccel[i];
-                tangential.y *= _particleData.modeA.tangentialAccel[i];
-                
-                // (gravity + radial + tangential) * dt
-                tmp.x = radial.x + tangential.x + modeA.gravity.x;
-                tmp.y = radial.y + tangential.y + modeA.gravity.y;
-                tmp.x *= dt;
-                tmp.y *= dt;
-                
-                _particleData.modeA.dirX[i] += tmp.x;
-                _particleData.modeA.dirY[i] += tmp.y;
-                
-                // this is cocos2d-x v3.0
-                // if (_configName.length()>0 && _yCoordFlipped != -1)
-                
-                // this is cocos2d-x v3.0
-                tmp.x = _particleData.modeA.dirX[i] * dt * _yCoordFlipped;
-                tmp.y = _particleData.modeA.dirY[i] * dt * _yCoordFlipped;
-                _particleData.posx[i] += tmp.x;
-                _particleData.posy[i] += tmp.y;
-            }
-        }
-        else
-        {
-            //Why use so many for-loop separately instead of putting them together?
-            //When the processor needs to read from or write to a location in memory,
-            //it first checks whether a copy of that data is in the cache.
-            //And every property's memory of the particle system is continuous,
-            //for the purpose of improving cache hit rate, we should process only one property in one for-loop AFAP.
-            //It was proved to be effective especially for low-end machine. 
-            for (int i = 0; i < _particleCount; ++i)
-            {
-                _particleData.modeB.angle[i] += _particleData.modeB.degreesPerSecond[i] * dt;
-            }
-            
-            for (int i = 0; i < _particleCount; ++i)
-            {
-                _particleData.modeB.radius[i] += _particleData.modeB.deltaRadius[i] * dt;
-            }
-            
-            for (int i = 0; i < _particleCount; ++i)
-            {
-                _particleData.posx[i] = - cosf(_particleData.modeB.angle[i]) * _particleData.modeB.radius[i];
-            }
-            for (int i = 0; i < _particleCount; ++i)
-            {
-                _particleData.posy[i] = - sinf(_particleData.modeB.angle[i]) * _particleData.modeB.radius[i] * _yCoordFlipped;
-            }
-        }
-        
-        //color r,g,b,a
-        for (int i = 0 ; i < _particleCount; ++i)
+        if (s_parallelUpdateEnabled && !_batchNode && beginParallelUpdate())
         {
-            _particleData.colorR[i] += _particleData.deltaColorR[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorG[i] += _particleData.deltaColorG[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorB[i] += _particleData.deltaColorB[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorA[i] += _particleData.deltaColorA[i] * dt;
-        }
-        //size
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.size[i] += (_particleData.deltaSize[i] * dt);
-            _particleData.size[i] = MAX(0, _particleData.size[i]);
-        }
-        //angle
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.rotation[i] += _particleData.deltaRotation[i] * dt;
+            addParallelUpdateListeners();
+            this->retain();
+            s_parallelUpdates.push_back(this);
+            _parallelUpdatePending = true;
+            _parallelUpdateParameters = getUpdateParameters();
+            _transformSystemDirty = false;
+
+            ParallelTaskPool::getInstance()->enqueue(s_parallelTaskGroup, [this, dt]{
+                this->updateInParallel(dt);
+            });
+
+            CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
+            return;
         }
-        
+
+        updateParticles(dt);
         updateParticleQuads();
         _transformSystemDirty = false;
     }
@@ -1007,6 +867,86 @@ void ParticleSystem::update(float dt)
     CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 }
 
+ParticleSystem::UpdateParameters ParticleSystem::getUpdateParameters() const
+{
+    UpdateParameters parameters;
+    parameters.emitterMode = _emitterMode;
+    parameters.gravity = modeA.gravity;
+    parameters.yCoordFlipped = _yCoordFlipped;
+    return parameters;
+}
+
+void ParticleSystem::updateParticles(float dt, const UpdateParameters& parameters)
+{
+    if (parameters.emitterMode == Mode::GRAVITY)
+    {
+        particleUpdateGravity(_particleData, _particleCount, parameters.gravity, dt, parameters.yCoordFlipped);
+    }
+    else
+    {
+        //Why use so many for-loop separately instead of putting them together?
+        //When the processor needs to read from or write to a location in memory,
+        //it first checks whether a copy of that data is in the cache.
+        //And every property's memory of the particle system is continuous,
+        //for the purpose of improving cache hit rate, we should process only one property in one for-loop AFAP.
+        //It was proved to be effective especially for low-end machine. 
+        particleUpdateRadius(_particleData, _particleCount, dt, parameters.yCoordFlipped);
+    }
+    
+    //color r,g,b,a
+    particleMulAdd(_particleData.colorR, _particleData.deltaColorR, dt, _particleCount);
+    particleMulAdd(_particleData.colorG, _particleData.deltaColorG, dt, _particleCount);
+    particleMulAdd(_particleData.colorB, _particleData.deltaColorB, dt, _particleCount);
+    particleMulAdd(_particleData.colorA, _particleData.deltaColorA, dt, _particleCount);
+    //size
+    particleMulAddPositive(_particleData.size, _particleData.deltaSize, dt, _particleCount);
+    //angle
+    particleMulAdd(_particleData.rotation, _particleData.deltaRotation, dt, _particleCount);
+}
+
+void ParticleSystem::updateInParallel(float dt)
+{
+    updateParticles(dt, _parallelUpdateParameters);
+}
+
+void ParticleSystem::setParallelUpdateEnabled(bool enabled)
+{
+    if (enabled)
+    {
+        addParallelUpdateListeners();
+    }
+    else
+    {
+        finishParallelUpdates();
+        removeParallelUpdateListeners();
+    }
+    s_parallelUpdateEnabled = enabled;
+}
+
+bool ParticleSystem::isParallelUpdateEnabled()
+{
+    return s_parallelUpdateEnabled;
+}
+
+void ParticleSystem::finishParallelUpdates()
+{
+    if (s_parallelUpdates.empty())
+        return;
+
+    ParallelTaskPool::getInstance()->wait(s_parallelTaskGroup);
+
+    // endParallelUpdate may release the last reference of a system, work on a copy
+    std::vector<ParticleSystem*> systems;
+    systems.swap(s_parallelUpdates);
+
+    for (auto system : systems)
+    {
+        system->_parallelUpdatePending = false;
+        system->endParallelUpdate();
+        system->release();
+    }
+}
+
 void ParticleSystem::updateWithNoTime(void)
 {
     this->update(0.0f);
@@ -256,7 +256,7 @@ public:
     void stopSystem();
     /** Kill all living particles.
      */
-    void resetSystem();
+    virtual void resetSystem();
     /** Whether or not the system is full.
      *
      * @return True if the system is full.
@@ -275,6 +275,30 @@ public:
      */
     virtual void updateWithNoTime();
 
+    /** Sets whether particle systems are simulated on the worker threads of ParallelTaskPool.
+     * When enabled, update() only emits and retires particles on the cocos thread. The particles are then
+     * moved and their quads written on a worker thread while the frame is drawn, and the results are
+     * published once the frame has been drawn: what is rendered lags the simulation by one frame.
+     * Systems rendered by a ParticleBatchNode are always updated on the cocos thread.
+     * Disabled by default.
+     * @since v3.15
+     * @js NA
+     */
+    static void setParallelUpdateEnabled(bool enabled);
+
+    /** Whether or not particle systems are simulated on worker threads.
+     * @since v3.15
+     * @js NA
+     */
+    static bool isParallelUpdateEnabled();
+
+    /** Waits for the particle systems being updated on worker threads and publishes their results.
+     * It is called after each frame is drawn.
+     * @since v3.15
+     * @js NA
+     */
+    static void finishParallelUpdates();
+
     /** Whether or not the particle system removed self on finish.
      *
      * @return True if the particle system removed self on finish.
@@ -816,6 +840,38 @@ CC_CONSTRUCTOR_ACCESS:
 protected:
     virtual void updateBlendFunc();
 
+    /** The emitter parameters read while moving the particles. They are copied before a worker thread
+     update, so that the setters may be called while the update is running. */
+    struct UpdateParameters
+    {
+        Mode emitterMode;
+        Vec2 gravity;
+        int yCoordFlipped;
+    };
+
+    UpdateParameters getUpdateParameters() const;
+
+    /** Moves the living particles forward by dt. */
+    void updateParticles(float dt) { updateParticles(dt, getUpdateParameters()); }
+    /** Moves the living particles forward by dt.
+     Only reads and writes _particleData and the given parameters, it is safe to call on a worker thread. */
+    void updateParticles(float dt, const UpdateParameters& parameters);
+
+    /** Called on the cocos thread before this system is updated on a worker thread,
+     anything updateInParallel needs from the node must be captured here.
+     Returns false if the system has to be updated on the cocos thread. */
+    virtual bool beginParallelUpdate() { return false; }
+
+    /** Called on a worker thread, updates the particles and writes what will be rendered. */
+    virtual void updateInParallel(float dt);
+
+    /** Called on the cocos thread once updateInParallel has finished. */
+    virtual void endParallelUpdate() {}
+
+    /** Waits for the worker thread update of this system, if one is running.
+     Must be called before touching the particles outside of update(). */
+    void waitForParallelUpdate() { if (_parallelUpdatePending) finishParallelUpdates(); }
+
     /** whether or not the particles are using blend additive.
      If enabled, the following blending function will be used.
      @code
@@ -971,6 +1027,11 @@ protected:
     /** is the emitter paused */
     bool _paused;
 
+    /** is the system being updated on a worker thread */
+    bool _parallelUpdatePending;
+    /** the parameters of the worker thread update, copied when it was queued */
+    UpdateParameters _parallelUpdateParameters;
+
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(ParticleSystem);
 };
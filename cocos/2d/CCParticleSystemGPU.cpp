@@ -0,0 +1,964 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCParticleSystemGPU.h"
+
+#include <algorithm>
+
+#include "renderer/CCGLProgram.h"
+#include "renderer/CCGLProgramState.h"
+#include "renderer/ccGLStateCache.h"
+#include "renderer/CCRenderer.h"
+#include "renderer/CCTexture2D.h"
+#include "renderer/ccShaders.h"
+#include "base/CCDirector.h"
+#include "base/CCConfiguration.h"
+#include "base/CCEventType.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCParallelTaskPool.h"
+#include "base/CCProfiling.h"
+#include "base/ccUTF8.h"
+
+// desktop OpenGL needs a sized internal format, OpenGL ES 2 with GL_OES_texture_float is given the type instead
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32 || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+#define CC_PARTICLE_FLOAT_FORMAT GL_RGBA32F_ARB
+#else
+#define CC_PARTICLE_FLOAT_FORMAT GL_RGBA
+#endif
+
+NS_CC_BEGIN
+
+// number of particles staged in _particleData at once
+static const int kEmitBatch = 1024;
+// quads drawn by one glDrawElements, limited by the 16 bit indices
+static const int kQuadsPerDraw = 65536 / 4;
+
+static int s_gpuSupported = -1;
+
+static GLuint createFloatTexture(int width, int height, const GLfloat* data)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GL::bindTexture2D(texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, CC_PARTICLE_FLOAT_FORMAT, width, height, 0, GL_RGBA, GL_FLOAT, data);
+    return texture;
+}
+
+static GLint getUniformLocation(GLProgram* program, const char* name)
+{
+    auto uniform = program->getUniform(name);
+    return uniform ? uniform->location : -1;
+}
+
+// texture coordinates of the bottom left and top right corners of a quad showing the whole texture,
+// as ParticleSystemQuad::initTexCoordsWithRect computes them
+static void getTexCoordRect(Texture2D* texture, GLfloat rect[4])
+{
+    const Size& size = texture->getContentSizeInPixels();
+    GLfloat wide = (GLfloat)texture->getPixelsWide();
+    GLfloat high = (GLfloat)texture->getPixelsHigh();
+
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+    GLfloat left = 1 / (wide*2);
+    GLfloat bottom = 1 / (high*2);
+    GLfloat right = left + (size.width*2-2) / (wide*2);
+    GLfloat top = bottom + (size.height*2-2) / (high*2);
+#else
+    GLfloat left = 0;
+    GLfloat bottom = 0;
+    GLfloat right = size.width / wide;
+    GLfloat top = size.height / high;
+#endif // ! CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+
+    // Important. Texture in cocos2d are inverted, so the Y component should be inverted
+    rect[0] = left;
+    rect[1] = top;
+    rect[2] = right;
+    rect[3] = bottom;
+}
+
+ParticleSystemGPU::ParticleSystemGPU()
+: _textureWidth(0)
+, _textureHeight(0)
+, _time(0)
+, _usedSlots(0)
+, _slotCursor(0)
+, _cpuSimulation(true)
+, _currentState(0)
+, _simulateProgram(nullptr)
+, _renderProgram(nullptr)
+, _quads(nullptr)
+{
+    memset(_attribTextures, 0, sizeof(_attribTextures));
+    memset(_stateTextures, 0, sizeof(_stateTextures));
+    memset(_stateFBOs, 0, sizeof(_stateFBOs));
+    memset(_buffersVBO, 0, sizeof(_buffersVBO));
+}
+
+ParticleSystemGPU::~ParticleSystemGPU()
+{
+    releaseGLResources(false);
+    CC_SAFE_FREE(_quads);
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create()
+{
+    ParticleSystemGPU *ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->init())
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::createWithTotalParticles(int numberOfParticles)
+{
+    ParticleSystemGPU *ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithTotalParticles(numberOfParticles))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create(const std::string& filename)
+{
+    ParticleSystemGPU *ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithFile(filename))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create(ValueMap& dictionary)
+{
+    ParticleSystemGPU *ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithDictionary(dictionary))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+bool ParticleSystemGPU::initWithTotalParticles(int numberOfParticles)
+{
+    if (!ParticleSystem::initWithTotalParticles(numberOfParticles))
+        return false;
+
+    // the particles live in the slots, _particleData only stages the particles being emitted
+    _particleData.release();
+    if (!_particleData.init(MIN(numberOfParticles, kEmitBatch)) || !allocSlots(numberOfParticles))
+    {
+        CCLOG("Particle system: not enough memory");
+        return false;
+    }
+
+    _cpuSimulation = !isSupported();
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    auto listener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, CC_CALLBACK_1(ParticleSystemGPU::listenRendererRecreated, this));
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+#endif
+
+    return true;
+}
+
+bool ParticleSystemGPU::isSupported()
+{
+    if (s_gpuSupported < 0)
+    {
+        if (nullptr == Director::getInstance()->getOpenGLView())
+            return false;
+
+        auto conf = Configuration::getInstance();
+        // the vertex shader reads the state, life, size, color and delta color textures
+        bool supported = conf->supportsFloatTexture() && conf->getMaxVertexTextureUnits() >= 5;
+        if (supported)
+        {
+            // rendering into float textures is an extension of its own on OpenGL ES, ask the driver
+            GLint oldFBO = 0;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+
+            GLuint texture = createFloatTexture(1, 1, nullptr);
+            GLuint fbo = 0;
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+            supported = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+            glDeleteFramebuffers(1, &fbo);
+            GL::deleteTexture(texture);
+        }
+        s_gpuSupported = supported ? 1 : 0;
+    }
+    return s_gpuSupported == 1;
+}
+
+void ParticleSystemGPU::setCPUSimulationEnabled(bool enabled)
+{
+    if (enabled == _cpuSimulation)
+        return;
+
+    if (enabled)
+    {
+        fallBackToCPU();
+    }
+    else if (isSupported())
+    {
+        // the state textures start from the CPU state
+        _cpuSimulation = false;
+        if (!setupGLResources())
+        {
+            _cpuSimulation = true;
+        }
+    }
+}
+
+bool ParticleSystemGPU::readParticleStates(std::vector<Vec4>& states)
+{
+    states.resize(_totalParticles);
+    if (_totalParticles == 0)
+        return true;
+
+    // a state is 4 floats, laid out like a Vec4
+    if (_cpuSimulation)
+    {
+        std::copy(_states.begin(), _states.begin() + (size_t)_totalParticles * 4, &states[0].x);
+        return true;
+    }
+
+    std::vector<float> data(_states.size());
+    if (0 == _stateFBOs[0] || !readStateTexture(data.data()))
+        return false;
+
+    std::copy(data.begin(), data.begin() + (size_t)_totalParticles * 4, &states[0].x);
+    return true;
+}
+
+bool ParticleSystemGPU::allocSlots(int totalParticles)
+{
+    // a square-ish texture, a power of two wide
+    int width = 1;
+    while (width * width < totalParticles)
+    {
+        width *= 2;
+    }
+    int height = (totalParticles + width - 1) / width;
+
+    int maxTextureSize = Configuration::getInstance()->getMaxTextureSize();
+    if (maxTextureSize > 0 && (width > maxTextureSize || height > maxTextureSize))
+    {
+        CCLOG("Particle system: %d particles don't fit in a texture", totalParticles);
+        return false;
+    }
+
+    _textureWidth = width;
+    _textureHeight = height;
+
+    size_t floatCount = (size_t)width * height * 4;
+    for (int i = 0; i < ATTRIB_COUNT; ++i)
+    {
+        _attributes[i].assign(floatCount, 0.0f);
+    }
+    _states.assign(floatCount, 0.0f);
+    _deathTimes.assign(totalParticles, 0.0f);
+    CC_SAFE_FREE(_quads);
+
+    clearSlots();
+    return true;
+}
+
+void ParticleSystemGPU::clearSlots()
+{
+    std::fill(_deathTimes.begin(), _deathTimes.end(), 0.0f);
+    _deathQueue = decltype(_deathQueue)();
+    _time = 0;
+    _usedSlots = 0;
+    _slotCursor = 0;
+    _particleCount = 0;
+}
+
+void ParticleSystemGPU::resetSystem()
+{
+    _isActive = true;
+    _elapsed = 0;
+    clearSlots();
+}
+
+void ParticleSystemGPU::setTotalParticles(int totalParticles)
+{
+    if (totalParticles == _totalParticles)
+        return;
+
+    if (!allocSlots(totalParticles))
+        return;
+
+    _totalParticles = totalParticles;
+    _allocatedParticles = totalParticles;
+
+    // the vertices and the textures depend on the number of slots
+    if (!_cpuSimulation && _stateFBOs[0] && !setupGLResources())
+    {
+        fallBackToCPU();
+    }
+}
+
+void ParticleSystemGPU::setBatchNode(ParticleBatchNode* batchNode)
+{
+    CCASSERT(nullptr == batchNode, "ParticleSystemGPU can't be rendered by a ParticleBatchNode");
+    CC_UNUSED_PARAM(batchNode);
+}
+
+void ParticleSystemGPU::update(float dt)
+{
+    CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystemGPU - update");
+
+    if (!_cpuSimulation && 0 == _stateFBOs[0] && !setupGLResources())
+    {
+        CCLOG("Particle system: can't simulate on the GPU, falling back to the CPU");
+        fallBackToCPU();
+    }
+
+    float time = _time;
+    _time += dt;
+
+    if (_isActive && _emissionRate)
+    {
+        float rate = 1.0f / _emissionRate;
+        //issue #1201, prevent bursts of particles, due to too high emitCounter
+        if (_particleCount < _totalParticles)
+        {
+            _emitCounter += dt;
+            if (_emitCounter < 0.f)
+                _emitCounter = 0.f;
+        }
+
+        int emitCount = MIN(_totalParticles - _particleCount, _emitCounter / rate);
+        emitParticles(emitCount, time);
+        _emitCounter -= rate * emitCount;
+
+        _elapsed += dt;
+        if (_elapsed < 0.f)
+            _elapsed = 0.f;
+        if (_duration != DURATION_INFINITY && _duration < _elapsed)
+        {
+            this->stopSystem();
+        }
+    }
+
+    while (!_deathQueue.empty() && _deathQueue.top() <= _time)
+    {
+        _deathQueue.pop();
+    }
+    int livingCount = (int)_deathQueue.size();
+    bool finished = livingCount == 0 && _particleCount > 0;
+    _particleCount = livingCount;
+
+    if (livingCount == 0)
+    {
+        // nothing to simulate, restart the clock while it is free to keep its precision
+        if (_usedSlots > 0)
+        {
+            clearSlots();
+        }
+        if (finished && _isAutoRemoveOnFinish)
+        {
+            this->unscheduleUpdate();
+            _parent->removeChild(this, true);
+            return;
+        }
+    }
+    else if (_cpuSimulation)
+    {
+        simulateOnCPU(time, dt);
+    }
+    else
+    {
+        simulateOnGPU(time, dt);
+    }
+
+    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystemGPU - update");
+}
+
+void ParticleSystemGPU::emitParticles(int count, float time)
+{
+    if (_paused || count <= 0)
+        return;
+
+    int firstSlot = _slotCursor;
+    int visitedSlots = 0;
+
+    while (count > 0)
+    {
+        int batchCount = MIN(count, (int)_particleData.getMaxCount());
+
+        // addParticles appends to _particleData, start from an empty one
+        int livingCount = _particleCount;
+        _particleCount = 0;
+        addParticles(batchCount);
+        _particleCount = livingCount;
+
+        for (int i = 0; i < batchCount; ++i)
+        {
+            // there are at least count free slots, the system was not full
+            while (_deathTimes[_slotCursor] > time)
+            {
+                _slotCursor = (_slotCursor + 1) % _totalParticles;
+                ++visitedSlots;
+            }
+
+            int slot = _slotCursor;
+            float* life = &_attributes[ATTRIB_LIFE][slot * 4];
+            life[0] = time;
+            life[1] = _particleData.timeToLive[i];
+            life[2] = _particleData.startPosX[i];
+            life[3] = _particleData.startPosY[i];
+
+            float* size = &_attributes[ATTRIB_SIZE][slot * 4];
+            size[0] = _particleData.size[i];
+            size[1] = _particleData.deltaSize[i];
+            size[2] = _particleData.rotation[i];
+            size[3] = _particleData.deltaRotation[i];
+
+            float* color = &_attributes[ATTRIB_COLOR][slot * 4];
+            color[0] = _particleData.colorR[i];
+            color[1] = _particleData.colorG[i];
+            color[2] = _particleData.colorB[i];
+            color[3] = _particleData.colorA[i];
+
+            float* deltaColor = &_attributes[ATTRIB_DELTA_COLOR][slot * 4];
+            deltaColor[0] = _particleData.deltaColorR[i];
+            deltaColor[1] = _particleData.deltaColorG[i];
+            deltaColor[2] = _particleData.deltaColorB[i];
+            deltaColor[3] = _particleData.deltaColorA[i];
+
+            float* motion = &_attributes[ATTRIB_MOTION][slot * 4];
+            float* accel = &_attributes[ATTRIB_ACCEL][slot * 4];
+            if (_emitterMode == Mode::GRAVITY)
+            {
+                motion[0] = _particleData.posx[i];
+                motion[1] = _particleData.posy[i];
+                motion[2] = _particleData.modeA.dirX[i];
+                motion[3] = _particleData.modeA.dirY[i];
+                accel[0] = _particleData.modeA.radialAccel[i];
+                accel[1] = _particleData.modeA.tangentialAccel[i];
+            }
+            else
+            {
+                motion[0] = _particleData.modeB.radius[i];
+                motion[1] = _particleData.modeB.deltaRadius[i];
+                motion[2] = _particleData.modeB.angle[i];
+                motion[3] = _particleData.modeB.degreesPerSecond[i];
+                accel[0] = 0;
+                accel[1] = 0;
+            }
+
+            _deathTimes[slot] = time + life[1];
+            _deathQueue.push(_deathTimes[slot]);
+            _usedSlots = MAX(_usedSlots, slot + 1);
+
+            _slotCursor = (_slotCursor + 1) % _totalParticles;
+            ++visitedSlots;
+        }
+        count -= batchCount;
+    }
+
+    if (!_cpuSimulation && _stateFBOs[0])
+    {
+        // the visited slots are consecutive, possibly wrapping around
+        if (visitedSlots >= _totalParticles)
+        {
+            uploadAttributes(0, _totalParticles - 1);
+        }
+        else if (firstSlot + visitedSlots <= _totalParticles)
+        {
+            uploadAttributes(firstSlot, firstSlot + visitedSlots - 1);
+        }
+        else
+        {
+            uploadAttributes(firstSlot, _totalParticles - 1);
+            uploadAttributes(0, firstSlot + visitedSlots - _totalParticles - 1);
+        }
+    }
+}
+
+void ParticleSystemGPU::simulateOnCPU(float time, float dt)
+{
+    // the same equations as ccShader_ParticleGPU_Simulate.frag
+    const bool radiusMode = _emitterMode == Mode::RADIUS;
+    const float yCoordFlipped = (float)_yCoordFlipped;
+    const Vec2 gravity = modeA.gravity;
+
+    ParallelTaskPool::getInstance()->parallelFor(_usedSlots, 4096, [&](int begin, int end){
+        for (int i = begin; i < end; ++i)
+        {
+            const float* life = &_attributes[ATTRIB_LIFE][i * 4];
+            const float* motion = &_attributes[ATTRIB_MOTION][i * 4];
+            float* state = &_states[i * 4];
+
+            if (radiusMode)
+            {
+                float age = time + dt - life[0];
+                float angle = motion[2] + motion[3] * age;
+                float radius = motion[0] + motion[1] * age;
+                state[0] = -cosf(angle) * radius;
+                state[1] = -sinf(angle) * radius * yCoordFlipped;
+                state[2] = angle;
+                state[3] = radius;
+                continue;
+            }
+
+            if (life[0] >= time)
+            {
+                memcpy(state, motion, sizeof(float) * 4);
+            }
+            const float* accel = &_attributes[ATTRIB_ACCEL][i * 4];
+
+            float x = state[0];
+            float y = state[1];
+            float len2 = x * x + y * y;
+            float inv = len2 > 0.0f ? 1.0f / sqrtf(len2) : 0.0f;
+            float radialX = x * inv;
+            float radialY = y * inv;
+
+            float dirX = state[2] + (radialX * accel[0] - radialY * accel[1] + gravity.x) * dt;
+            float dirY = state[3] + (radialY * accel[0] + radialX * accel[1] + gravity.y) * dt;
+            state[0] = x + dirX * dt * yCoordFlipped;
+            state[1] = y + dirY * dt * yCoordFlipped;
+            state[2] = dirX;
+            state[3] = dirY;
+        }
+    });
+}
+
+void ParticleSystemGPU::simulateOnGPU(float time, float dt)
+{
+    int target = 1 - _currentState;
+
+    GLint oldFBO = 0;
+    GLint oldViewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+    glGetIntegerv(GL_VIEWPORT, oldViewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    GLint oldScissor[4];
+    glGetIntegerv(GL_SCISSOR_BOX, oldScissor);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _stateFBOs[target]);
+    glViewport(0, 0, _textureWidth, _textureHeight);
+    glDisable(GL_DEPTH_TEST);
+    // only the rows holding used slots are simulated
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, _textureWidth, (_usedSlots + _textureWidth - 1) / _textureWidth);
+
+    _simulateProgram->use();
+    _simulateProgram->setUniformLocationWith4f(getUniformLocation(_simulateProgram, "u_step"),
+        time, dt, (float)_yCoordFlipped, _emitterMode == Mode::RADIUS ? 1.0f : 0.0f);
+    _simulateProgram->setUniformLocationWith2f(getUniformLocation(_simulateProgram, "u_gravity"), modeA.gravity.x, modeA.gravity.y);
+
+    GL::bindTexture2DN(0, _stateTextures[_currentState]);
+    GL::bindTexture2DN(1, _attribTextures[ATTRIB_LIFE]);
+    GL::bindTexture2DN(2, _attribTextures[ATTRIB_MOTION]);
+    GL::bindTexture2DN(3, _attribTextures[ATTRIB_ACCEL]);
+    GL::blendFunc(GL_ONE, GL_ZERO);
+
+    static const GLfloat vertices[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+    GL::bindVAO(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POSITION);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, 4);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+    glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+    glScissor(oldScissor[0], oldScissor[1], oldScissor[2], oldScissor[3]);
+    if (!scissorTest)
+        glDisable(GL_SCISSOR_TEST);
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+
+    _currentState = target;
+    CHECK_GL_ERROR_DEBUG();
+}
+
+int ParticleSystemGPU::writeQuads()
+{
+    if (nullptr == _quads)
+    {
+        _quads = (V3F_C4B_T2F_Quad*)malloc(sizeof(_quads[0]) * _totalParticles);
+        if (nullptr == _quads)
+            return 0;
+    }
+
+    GLfloat texRect[4];
+    getTexCoordRect(_texture, texRect);
+
+    // the same equations as ccShader_ParticleGPU.vert
+    int count = 0;
+    for (int i = 0; i < _usedSlots; ++i)
+    {
+        const float* life = &_attributes[ATTRIB_LIFE][i * 4];
+        float age = _time - life[0];
+        if (age < 0 || age >= life[1])
+            continue;
+
+        const float* size = &_attributes[ATTRIB_SIZE][i * 4];
+        const float* color = &_attributes[ATTRIB_COLOR][i * 4];
+        const float* deltaColor = &_attributes[ATTRIB_DELTA_COLOR][i * 4];
+        const float* state = &_states[i * 4];
+
+        Vec3 start(life[2], life[3], 0);
+        _startToNode.transformPoint(&start);
+        float x = state[0] + start.x - _origin.x;
+        float y = state[1] + start.y - _origin.y;
+
+        float size_2 = MAX(size[0] + size[1] * age, 0.0f) / 2;
+        float r = -CC_DEGREES_TO_RADIANS(size[2] + size[3] * age);
+        float cr = cosf(r);
+        float sr = sinf(r);
+
+        V3F_C4B_T2F_Quad& quad = _quads[count++];
+        quad.bl.vertices.set(-size_2 * cr + size_2 * sr + x, -size_2 * sr - size_2 * cr + y, 0);
+        quad.br.vertices.set(size_2 * cr + size_2 * sr + x, size_2 * sr - size_2 * cr + y, 0);
+        quad.tl.vertices.set(-size_2 * cr - size_2 * sr + x, -size_2 * sr + size_2 * cr + y, 0);
+        quad.tr.vertices.set(size_2 * cr - size_2 * sr + x, size_2 * sr + size_2 * cr + y, 0);
+
+        float red = clampf(color[0] + deltaColor[0] * age, 0, 1);
+        float green = clampf(color[1] + deltaColor[1] * age, 0, 1);
+        float blue = clampf(color[2] + deltaColor[2] * age, 0, 1);
+        float alpha = clampf(color[3] + deltaColor[3] * age, 0, 1);
+        if (_opacityModifyRGB)
+        {
+            red *= alpha;
+            green *= alpha;
+            blue *= alpha;
+        }
+        Color4B color4B((GLubyte)(red * 255), (GLubyte)(green * 255), (GLubyte)(blue * 255), (GLubyte)(alpha * 255));
+        quad.bl.colors = color4B;
+        quad.br.colors = color4B;
+        quad.tl.colors = color4B;
+        quad.tr.colors = color4B;
+
+        quad.bl.texCoords.u = texRect[0];
+        quad.bl.texCoords.v = texRect[1];
+        quad.br.texCoords.u = texRect[2];
+        quad.br.texCoords.v = texRect[1];
+        quad.tl.texCoords.u = texRect[0];
+        quad.tl.texCoords.v = texRect[3];
+        quad.tr.texCoords.u = texRect[2];
+        quad.tr.texCoords.v = texRect[3];
+    }
+    return count;
+}
+
+void ParticleSystemGPU::draw(Renderer* renderer, const Mat4& transform, uint32_t flags)
+{
+    if (_particleCount <= 0 || nullptr == _texture)
+        return;
+
+    // the start positions are brought into node space like ParticleSystemQuad does
+    if (_positionType == PositionType::FREE)
+    {
+        _startToNode = getWorldToNodeTransform();
+        Vec2 currentPosition = this->convertToWorldSpace(Vec2::ZERO);
+        Vec3 origin(currentPosition.x, currentPosition.y, 0);
+        _startToNode.transformPoint(&origin);
+        _origin.set(origin.x, origin.y);
+    }
+    else if (_positionType == PositionType::RELATIVE)
+    {
+        _startToNode = Mat4::IDENTITY;
+        _origin = _position;
+    }
+    else
+    {
+        _startToNode = Mat4::IDENTITY;
+        _origin = Vec2::ZERO;
+    }
+
+    if (_cpuSimulation)
+    {
+        int count = writeQuads();
+        if (count > 0)
+        {
+            if (nullptr == getGLProgramState())
+            {
+                setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP));
+            }
+            _quadCommand.init(_globalZOrder, _texture, getGLProgramState(), _blendFunc, _quads, count, transform, flags);
+            renderer->addCommand(&_quadCommand);
+        }
+    }
+    else
+    {
+        _customCommand.init(_globalZOrder, transform, flags);
+        _customCommand.func = CC_CALLBACK_0(ParticleSystemGPU::onDraw, this, transform, flags);
+        renderer->addCommand(&_customCommand);
+    }
+}
+
+void ParticleSystemGPU::onDraw(const Mat4& transform, uint32_t /*flags*/)
+{
+    GLfloat texRect[4];
+    getTexCoordRect(_texture, texRect);
+
+    _renderProgram->use();
+    _renderProgram->setUniformsForBuiltins(transform);
+    _renderProgram->setUniformLocationWith1f(getUniformLocation(_renderProgram, "u_time"), _time);
+    _renderProgram->setUniformLocationWith1f(getUniformLocation(_renderProgram, "u_opacityModifyRGB"), _opacityModifyRGB ? 1.0f : 0.0f);
+    _renderProgram->setUniformLocationWithMatrix4fv(getUniformLocation(_renderProgram, "u_startToNode"), _startToNode.m, 1);
+    _renderProgram->setUniformLocationWith2f(getUniformLocation(_renderProgram, "u_origin"), _origin.x, _origin.y);
+    _renderProgram->setUniformLocationWith4fv(getUniformLocation(_renderProgram, "u_texRect"), texRect, 1);
+
+    GL::bindTexture2DN(0, _texture->getName());
+    GL::bindTexture2DN(1, _stateTextures[_currentState]);
+    GL::bindTexture2DN(2, _attribTextures[ATTRIB_LIFE]);
+    GL::bindTexture2DN(3, _attribTextures[ATTRIB_SIZE]);
+    GL::bindTexture2DN(4, _attribTextures[ATTRIB_COLOR]);
+    GL::bindTexture2DN(5, _attribTextures[ATTRIB_DELTA_COLOR]);
+    GL::blendFunc(_blendFunc.src, _blendFunc.dst);
+
+    GL::bindVAO(0);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+    GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POSITION);
+
+    int batchCount = 0;
+    for (int first = 0; first < _usedSlots; first += kQuadsPerDraw)
+    {
+        int count = MIN(_usedSlots - first, kQuadsPerDraw);
+        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(GLfloat) * 16 * first));
+        glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, 0);
+        ++batchCount;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(batchCount, _usedSlots * 4);
+    CHECK_GL_ERROR_DEBUG();
+}
+
+bool ParticleSystemGPU::setupGLResources()
+{
+    releaseGLResources(false);
+
+    _simulateProgram = GLProgram::createWithByteArrays(ccParticleGPU_Simulate_vert, ccParticleGPU_Simulate_frag);
+    _renderProgram = GLProgram::createWithByteArrays(ccParticleGPU_vert, ccPositionTextureColor_frag);
+    CC_SAFE_RETAIN(_simulateProgram);
+    CC_SAFE_RETAIN(_renderProgram);
+    if (nullptr == _simulateProgram || nullptr == _renderProgram)
+    {
+        releaseGLResources(false);
+        return false;
+    }
+
+    // the texture units never change
+    _simulateProgram->use();
+    _simulateProgram->setUniformLocationWith1i(getUniformLocation(_simulateProgram, "u_state"), 0);
+    _simulateProgram->setUniformLocationWith1i(getUniformLocation(_simulateProgram, "u_life"), 1);
+    _simulateProgram->setUniformLocationWith1i(getUniformLocation(_simulateProgram, "u_motion"), 2);
+    _simulateProgram->setUniformLocationWith1i(getUniformLocation(_simulateProgram, "u_accel"), 3);
+    _renderProgram->use();
+    _renderProgram->setUniformLocationWith1i(getUniformLocation(_renderProgram, "u_state"), 1);
+    _renderProgram->setUniformLocationWith1i(getUniformLocation(_renderProgram, "u_life"), 2);
+    _renderProgram->setUniformLocationWith1i(getUniformLocation(_renderProgram, "u_size"), 3);
+    _renderProgram->setUniformLocationWith1i(getUniformLocation(_renderProgram, "u_color"), 4);
+    _renderProgram->setUniformLocationWith1i(getUniformLocation(_renderProgram, "u_deltaColor"), 5);
+
+    for (int i = 0; i < ATTRIB_COUNT; ++i)
+    {
+        _attribTextures[i] = createFloatTexture(_textureWidth, _textureHeight, _attributes[i].data());
+    }
+
+    GLint oldFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+    glGenFramebuffers(2, _stateFBOs);
+    bool complete = true;
+    for (int i = 0; i < 2; ++i)
+    {
+        // both states start from the CPU state, the particles keep moving when switching to the GPU
+        _stateTextures[i] = createFloatTexture(_textureWidth, _textureHeight, _states.data());
+        glBindFramebuffer(GL_FRAMEBUFFER, _stateFBOs[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _stateTextures[i], 0);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+    _currentState = 0;
+
+    if (!complete)
+    {
+        releaseGLResources(false);
+        return false;
+    }
+
+    // 4 vertices per slot: the corner of the quad and the texel of the slot
+    std::vector<GLfloat> vertices((size_t)_totalParticles * 16);
+    for (int i = 0; i < _totalParticles; ++i)
+    {
+        GLfloat u = ((i % _textureWidth) + 0.5f) / _textureWidth;
+        GLfloat v = ((i / _textureWidth) + 0.5f) / _textureHeight;
+        const GLfloat quad[16] = {
+            -0.5f, -0.5f, u, v,
+             0.5f, -0.5f, u, v,
+            -0.5f,  0.5f, u, v,
+             0.5f,  0.5f, u, v,
+        };
+        memcpy(&vertices[(size_t)i * 16], quad, sizeof(quad));
+    }
+
+    // the same indices serve every batch of kQuadsPerDraw quads
+    std::vector<GLushort> indices(kQuadsPerDraw * 6);
+    for (int i = 0; i < kQuadsPerDraw; ++i)
+    {
+        const unsigned int i6 = i*6;
+        const unsigned int i4 = i*4;
+        indices[i6+0] = (GLushort) i4+0;
+        indices[i6+1] = (GLushort) i4+1;
+        indices[i6+2] = (GLushort) i4+2;
+
+        indices[i6+5] = (GLushort) i4+1;
+        indices[i6+4] = (GLushort) i4+2;
+        indices[i6+3] = (GLushort) i4+3;
+    }
+
+    glGenBuffers(2, &_buffersVBO[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * indices.size(), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+    return true;
+}
+
+void ParticleSystemGPU::releaseGLResources(bool contextLost)
+{
+    if (!contextLost)
+    {
+        for (int i = 0; i < ATTRIB_COUNT; ++i)
+        {
+            if (_attribTextures[i])
+                GL::deleteTexture(_attribTextures[i]);
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            if (_stateTextures[i])
+                GL::deleteTexture(_stateTextures[i]);
+        }
+        if (_stateFBOs[0])
+            glDeleteFramebuffers(2, _stateFBOs);
+        if (_buffersVBO[0])
+            glDeleteBuffers(2, _buffersVBO);
+    }
+    else
+    {
+        // the programs were deallocated with the context
+        if (_simulateProgram)
+            _simulateProgram->reset();
+        if (_renderProgram)
+            _renderProgram->reset();
+    }
+
+    memset(_attribTextures, 0, sizeof(_attribTextures));
+    memset(_stateTextures, 0, sizeof(_stateTextures));
+    memset(_stateFBOs, 0, sizeof(_stateFBOs));
+    memset(_buffersVBO, 0, sizeof(_buffersVBO));
+    CC_SAFE_RELEASE_NULL(_simulateProgram);
+    CC_SAFE_RELEASE_NULL(_renderProgram);
+}
+
+void ParticleSystemGPU::uploadAttributes(int first, int last)
+{
+    int firstRow = first / _textureWidth;
+    int rowCount = last / _textureWidth - firstRow + 1;
+    for (int i = 0; i < ATTRIB_COUNT; ++i)
+    {
+        GL::bindTexture2D(_attribTextures[i]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, _textureWidth, rowCount, GL_RGBA, GL_FLOAT,
+                        &_attributes[i][(size_t)firstRow * _textureWidth * 4]);
+    }
+    CHECK_GL_ERROR_DEBUG();
+}
+
+bool ParticleSystemGPU::readStateTexture(float* data)
+{
+    GLint oldFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, _stateFBOs[_currentState]);
+    glReadPixels(0, 0, _textureWidth, _textureHeight, GL_RGBA, GL_FLOAT, data);
+    bool succeeded = glGetError() == GL_NO_ERROR;
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+    return succeeded;
+}
+
+void ParticleSystemGPU::fallBackToCPU()
+{
+    if (_particleCount > 0 && !(_stateFBOs[0] && readStateTexture(_states.data())))
+    {
+        clearSlots();
+    }
+    releaseGLResources(false);
+    _cpuSimulation = true;
+}
+
+void ParticleSystemGPU::listenRendererRecreated(EventCustom* /*event*/)
+{
+    //when comes to foreground in android, the textures, framebuffers and buffers are wild handles
+    releaseGLResources(true);
+    if (!_cpuSimulation)
+    {
+        // the state was lost with the context
+        clearSlots();
+        if (!setupGLResources())
+        {
+            fallBackToCPU();
+        }
+    }
+}
+
+std::string ParticleSystemGPU::getDescription() const
+{
+    return StringUtils::format("<ParticleSystemGPU | Tag = %d, Total Particles = %d>", _tag, _totalParticles);
+}
+
+NS_CC_END
@@ -0,0 +1,222 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARTICLE_SYSTEM_GPU_H__
+#define __CC_PARTICLE_SYSTEM_GPU_H__
+
+#include <vector>
+#include <queue>
+#include <functional>
+
+#include "2d/CCParticleSystem.h"
+#include "renderer/CCQuadCommand.h"
+#include "renderer/CCCustomCommand.h"
+
+NS_CC_BEGIN
+
+class GLProgram;
+class EventCustom;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** @class ParticleSystemGPU
+ * @brief A particle system simulated on the GPU, for effects with a very large number of particles.
+
+It reads the same emitter parameters as ParticleSystem, and is created from the same plist files.
+Particles are emitted on the CPU and live in fixed slots: their emission attributes are stored in float textures,
+and the moving state (position and direction, or angle and radius) is advanced every update
+by a fragment shader rendering from one state texture into the other.
+The quads are expanded in the vertex shader, which reads the particle textures.
+
+A CPU reference path runs the same equations on the same slots. It is used when the GPU path is not supported
+(no float render target, or fewer than five texture units readable from the vertex shader), when there is no OpenGL view,
+or when it is requested with setCPUSimulationEnabled, e.g. for headless tests.
+
+Limitations:
+- It can't be rendered by a ParticleBatchNode.
+- The texture is always used as a whole, there is no support for subrects.
+- When the OpenGL context is lost, the living particles are killed.
+@since v3.15
+@js NA
+*/
+class CC_DLL ParticleSystemGPU : public ParticleSystem
+{
+public:
+    /** Creates a GPU particle system.
+     *
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create();
+    /** Creates a GPU particle system with a number of particles.
+     *
+     * @param numberOfParticles A given number of particles.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* createWithTotalParticles(int numberOfParticles);
+    /** Creates and initializes a GPU particle system from a plist file.
+     *
+     * @param filename Particle plist file name.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create(const std::string& filename);
+    /** Creates a GPU particle system with a dictionary.
+     *
+     * @param dictionary Particle dictionary.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create(ValueMap& dictionary);
+
+    /** Whether or not the particles can be simulated on the GPU.
+     * The result is computed once, the first time it is called with an OpenGL view.
+     *
+     * @return True if float textures can be rendered into and read from the vertex shader.
+     */
+    static bool isSupported();
+
+    /** Forces the simulation to run on the CPU, with the same equations and the same slots as on the GPU.
+     * Switching back to the GPU is ignored when the GPU path is not supported.
+     *
+     * @param enabled True to simulate on the CPU.
+     */
+    void setCPUSimulationEnabled(bool enabled);
+    /** Whether or not the simulation runs on the CPU.
+     *
+     * @return True if the simulation runs on the CPU.
+     */
+    bool isCPUSimulationEnabled() const { return _cpuSimulation; }
+
+    /** Reads the simulated state of every particle slot.
+     * Each state is (x, y, dirX, dirY) in gravity mode and (x, y, angle, radius) in radius mode,
+     * positions are relative to the emission start position. Slots of dead particles hold stale values.
+     * On the GPU path the state texture is read back, which stalls the pipeline and may not be supported by OpenGL ES drivers.
+     *
+     * @param states Receives getTotalParticles() states.
+     * @return False if the states could not be read.
+     */
+    bool readParticleStates(std::vector<Vec4>& states);
+
+    /** Listen the event that renderer was recreated on Android.
+     *
+     * @param event the event that renderer was recreated on Android.
+     */
+    void listenRendererRecreated(EventCustom* event);
+
+    // Overrides
+    virtual void update(float dt) override;
+    virtual void draw(Renderer* renderer, const Mat4& transform, uint32_t flags) override;
+    virtual void setBatchNode(ParticleBatchNode* batchNode) override;
+    virtual void setTotalParticles(int totalParticles) override;
+    virtual void resetSystem() override;
+    virtual std::string getDescription() const override;
+
+CC_CONSTRUCTOR_ACCESS:
+    ParticleSystemGPU();
+    virtual ~ParticleSystemGPU();
+
+    virtual bool initWithTotalParticles(int numberOfParticles) override;
+
+protected:
+    /** The attribute textures, written when particles are emitted. */
+    enum
+    {
+        ATTRIB_LIFE,        // birth time, life, start position
+        ATTRIB_SIZE,        // size, delta size, rotation, delta rotation
+        ATTRIB_COLOR,       // color
+        ATTRIB_DELTA_COLOR, // delta color
+        ATTRIB_MOTION,      // gravity: position, direction. radius: radius, delta radius, angle, degrees per second
+        ATTRIB_ACCEL,       // radial accel, tangential accel
+        ATTRIB_COUNT
+    };
+
+    /** Allocates the slots of totalParticles particles, killing the living ones. */
+    bool allocSlots(int totalParticles);
+    /** Kills the living particles and restarts the clock. */
+    void clearSlots();
+    /** Emits count particles born at time into free slots. */
+    void emitParticles(int count, float time);
+    /** Advances the state of every used slot from time to time + dt. */
+    void simulateOnCPU(float time, float dt);
+    void simulateOnGPU(float time, float dt);
+    /** Writes the living particles into _quads, returns their number. */
+    int writeQuads();
+    void onDraw(const Mat4& transform, uint32_t flags);
+
+    bool setupGLResources();
+    /** Deletes the OpenGL objects, or just forgets them when the context was lost. */
+    void releaseGLResources(bool contextLost);
+    /** Uploads the attribute rows holding the slots in [first, last]. */
+    void uploadAttributes(int first, int last);
+    /** Reads the current state texture back into data. */
+    bool readStateTexture(float* data);
+    /** Switches to the CPU path, keeping the state when it can be read back. */
+    void fallBackToCPU();
+
+    int _textureWidth;
+    int _textureHeight;
+
+    // CPU copies of the attribute textures, 4 floats per slot
+    std::vector<float> _attributes[ATTRIB_COUNT];
+    // time at which the particle of each slot dies
+    std::vector<float> _deathTimes;
+    // death times of the living particles, the next one first, so particles are counted at emission and death only
+    std::priority_queue<float, std::vector<float>, std::greater<float>> _deathQueue;
+    // CPU reference state, 4 floats per slot
+    std::vector<float> _states;
+
+    // time since the system was started or was last empty
+    float _time;
+    // slots [0, _usedSlots) may hold a living particle
+    int _usedSlots;
+    int _slotCursor;
+    bool _cpuSimulation;
+
+    GLuint _attribTextures[ATTRIB_COUNT];
+    GLuint _stateTextures[2];
+    GLuint _stateFBOs[2];
+    int _currentState;
+    GLuint _buffersVBO[2]; //0: vertex  1: indices
+    GLProgram* _simulateProgram;
+    GLProgram* _renderProgram;
+
+    // captured by draw for onDraw
+    Mat4 _startToNode;
+    Vec2 _origin;
+
+    V3F_C4B_T2F_Quad* _quads;
+    QuadCommand _quadCommand;
+    CustomCommand _customCommand;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(ParticleSystemGPU);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_SYSTEM_GPU_H__
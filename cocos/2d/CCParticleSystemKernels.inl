@@ -0,0 +1,441 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+// Simulation kernels working on the structure of arrays in ParticleData.
+// This file is only meant to be included by CCParticleSystem.cpp.
+//
+// Every kernel processes 4 particles at a time with SSE2 or NEON when they are
+// available at compile time, and finishes the remaining particles (or all of them
+// when no SIMD instruction set is available) with the equivalent scalar code.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CC_PARTICLE_USE_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+    #define CC_PARTICLE_USE_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(CC_PARTICLE_USE_SSE) || defined(CC_PARTICLE_USE_NEON)
+    #define CC_PARTICLE_USE_SIMD
+#endif
+
+NS_CC_BEGIN
+
+// constants of the random number generator, see particleRandom
+#define PARTICLE_RAND_A     134775813u
+#define PARTICLE_RAND_C     1u
+// the generator advanced by 4 steps: A^4 and C * (A^3 + A^2 + A + 1), modulo 2^32
+#define PARTICLE_RAND_A4    (PARTICLE_RAND_A * PARTICLE_RAND_A * PARTICLE_RAND_A * PARTICLE_RAND_A)
+#define PARTICLE_RAND_C4    (PARTICLE_RAND_C * (PARTICLE_RAND_A * PARTICLE_RAND_A * PARTICLE_RAND_A + PARTICLE_RAND_A * PARTICLE_RAND_A + PARTICLE_RAND_A + 1u))
+
+/**
+ A more effect random number getter function, get from ejoy2d.
+ Returns a number in [-1, 1).
+ */
+static inline float particleRandom(uint32_t *seed)
+{
+    *seed = *seed * PARTICLE_RAND_A + PARTICLE_RAND_C;
+    union {
+        uint32_t d;
+        float f;
+    } u;
+    u.d = (((uint32_t)(*seed) & 0x7fff) << 8) | 0x40000000;
+    return u.f - 3.0f;
+}
+
+#ifdef CC_PARTICLE_USE_SIMD
+
+// Minimal 4 wide float/int abstraction over SSE2 and NEON.
+#ifdef CC_PARTICLE_USE_SSE
+
+typedef __m128 float4;
+typedef __m128i int4;
+
+static inline float4 f4Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void f4Store(float* p, float4 v) { _mm_storeu_ps(p, v); }
+static inline float4 f4Set(float f) { return _mm_set1_ps(f); }
+static inline float4 f4Add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 f4Sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+static inline float4 f4Mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static inline float4 f4Div(float4 a, float4 b) { return _mm_div_ps(a, b); }
+static inline float4 f4Min(float4 a, float4 b) { return _mm_min_ps(a, b); }
+static inline float4 f4Max(float4 a, float4 b) { return _mm_max_ps(a, b); }
+static inline float4 f4Rsqrt(float4 a) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a)); }
+// lanes of a where mask is set, lanes of b otherwise
+static inline float4 f4Select(float4 mask, float4 a, float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline float4 f4GreaterThan(float4 a, float4 b) { return _mm_cmpgt_ps(a, b); }
+static inline float4 f4FromInt(int4 v) { return _mm_cvtepi32_ps(v); }
+static inline float4 f4XorBits(float4 a, int4 bits) { return _mm_xor_ps(a, _mm_castsi128_ps(bits)); }
+static inline float4 f4AsFloat(int4 v) { return _mm_castsi128_ps(v); }
+
+static inline int4 i4Set(uint32_t i) { return _mm_set1_epi32((int)i); }
+static inline int4 i4Round(float4 v) { return _mm_cvtps_epi32(v); }
+static inline int4 i4Add(int4 a, int4 b) { return _mm_add_epi32(a, b); }
+static inline int4 i4And(int4 a, int4 b) { return _mm_and_si128(a, b); }
+static inline int4 i4Or(int4 a, int4 b) { return _mm_or_si128(a, b); }
+static inline float4 i4Equal(int4 a, int4 b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+template <int N> static inline int4 i4ShiftLeft(int4 a) { return _mm_slli_epi32(a, N); }
+// low 32 bits of a 32x32 multiply, SSE2 has no _mm_mullo_epi32
+static inline int4 i4Mul(int4 a, int4 b)
+{
+    int4 even = _mm_mul_epu32(a, b);
+    int4 odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+static inline int4 i4Load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void i4Store(uint32_t* p, int4 v) { _mm_storeu_si128((__m128i*)p, v); }
+
+#else // CC_PARTICLE_USE_NEON
+
+typedef float32x4_t float4;
+typedef uint32x4_t int4;
+
+static inline float4 f4Load(const float* p) { return vld1q_f32(p); }
+static inline void f4Store(float* p, float4 v) { vst1q_f32(p, v); }
+static inline float4 f4Set(float f) { return vdupq_n_f32(f); }
+static inline float4 f4Add(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 f4Sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+static inline float4 f4Mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+static inline float4 f4Min(float4 a, float4 b) { return vminq_f32(a, b); }
+static inline float4 f4Max(float4 a, float4 b) { return vmaxq_f32(a, b); }
+#ifdef __aarch64__
+static inline float4 f4Div(float4 a, float4 b) { return vdivq_f32(a, b); }
+#else
+static inline float4 f4Div(float4 a, float4 b)
+{
+    // reciprocal estimate refined with two Newton-Raphson steps
+    float4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+#endif
+static inline float4 f4Rsqrt(float4 a)
+{
+    float4 r = vrsqrteq_f32(a);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    return r;
+}
+static inline float4 f4Select(float4 mask, float4 a, float4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+static inline float4 f4GreaterThan(float4 a, float4 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+static inline float4 f4FromInt(int4 v) { return vcvtq_f32_s32(vreinterpretq_s32_u32(v)); }
+static inline float4 f4XorBits(float4 a, int4 bits) { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), bits)); }
+static inline float4 f4AsFloat(int4 v) { return vreinterpretq_f32_u32(v); }
+
+static inline int4 i4Set(uint32_t i) { return vdupq_n_u32(i); }
+static inline int4 i4Round(float4 v)
+{
+#ifdef __aarch64__
+    return vreinterpretq_u32_s32(vcvtnq_s32_f32(v));
+#else
+    // round half away from zero, then truncate
+    uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000));
+    float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    return vreinterpretq_u32_s32(vcvtq_s32_f32(vaddq_f32(v, half)));
+#endif
+}
+static inline int4 i4Add(int4 a, int4 b) { return vaddq_u32(a, b); }
+static inline int4 i4And(int4 a, int4 b) { return vandq_u32(a, b); }
+static inline int4 i4Or(int4 a, int4 b) { return vorrq_u32(a, b); }
+static inline float4 i4Equal(int4 a, int4 b) { return vreinterpretq_f32_u32(vceqq_u32(a, b)); }
+template <int N> static inline int4 i4ShiftLeft(int4 a) { return vshlq_n_u32(a, N); }
+static inline int4 i4Mul(int4 a, int4 b) { return vmulq_u32(a, b); }
+static inline int4 i4Load(const uint32_t* p) { return vld1q_u32(p); }
+static inline void i4Store(uint32_t* p, int4 v) { vst1q_u32(p, v); }
+
+#endif // CC_PARTICLE_USE_NEON
+
+// Sine and cosine of 4 angles in radians.
+// The angle is reduced to [-pi/4, pi/4] and evaluated with the minimax polynomials from cephes,
+// the result is within a couple of ulps of sinf/cosf for the angles a particle system produces.
+static inline void f4SinCos(float4 x, float4* outSin, float4* outCos)
+{
+    int4 q = i4Round(f4Mul(x, f4Set(0.636619772367581343f)));
+    float4 j = f4FromInt(q);
+
+    // extended precision modular arithmetic: x - j * pi/2
+    float4 r = f4Sub(x, f4Mul(j, f4Set(1.5703125f)));
+    r = f4Sub(r, f4Mul(j, f4Set(4.837512969970703125e-4f)));
+    r = f4Sub(r, f4Mul(j, f4Set(7.54978995489188216e-8f)));
+    float4 z = f4Mul(r, r);
+
+    float4 s = f4Add(f4Mul(f4Set(-1.9515295891e-4f), z), f4Set(8.3321608736e-3f));
+    s = f4Add(f4Mul(s, z), f4Set(-1.6666654611e-1f));
+    s = f4Add(f4Mul(f4Mul(s, z), r), r);
+
+    float4 c = f4Add(f4Mul(f4Set(2.443315711809948e-5f), z), f4Set(-1.388731625493765e-3f));
+    c = f4Add(f4Mul(c, z), f4Set(4.166664568298827e-2f));
+    c = f4Add(f4Sub(f4Mul(f4Mul(c, z), z), f4Mul(f4Set(0.5f), z)), f4Set(1.0f));
+
+    // odd quadrants swap sine and cosine, quadrants 2,3 negate sine, quadrants 1,2 negate cosine
+    float4 swap = i4Equal(i4And(q, i4Set(1)), i4Set(1));
+    int4 sinSign = i4ShiftLeft<30>(i4And(q, i4Set(2)));
+    int4 cosSign = i4ShiftLeft<30>(i4And(i4Add(q, i4Set(1)), i4Set(2)));
+
+    *outSin = f4XorBits(f4Select(swap, c, s), sinSign);
+    *outCos = f4XorBits(f4Select(swap, s, c), cosSign);
+}
+
+// Next 4 random numbers in [-1, 1) from 4 interleaved generator lanes,
+// each lane being 4 steps ahead of the previous vector.
+static inline float4 f4Random(int4 lanes)
+{
+    int4 bits = i4Or(i4ShiftLeft<8>(i4And(lanes, i4Set(0x7fff))), i4Set(0x40000000));
+    return f4Sub(f4AsFloat(bits), f4Set(3.0f));
+}
+
+#endif // CC_PARTICLE_USE_SIMD
+
+// a[i] += s
+static void particleAdd(float* a, float s, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    float4 vs = f4Set(s);
+    for (; i + 4 <= count; i += 4)
+    {
+        f4Store(a + i, f4Add(f4Load(a + i), vs));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        a[i] += s;
+    }
+}
+
+// a[i] += b[i] * s
+static void particleMulAdd(float* a, const float* b, float s, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    float4 vs = f4Set(s);
+    for (; i + 4 <= count; i += 4)
+    {
+        f4Store(a + i, f4Add(f4Load(a + i), f4Mul(f4Load(b + i), vs)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        a[i] += b[i] * s;
+    }
+}
+
+// a[i] = max(0, a[i] + b[i] * s)
+static void particleMulAddPositive(float* a, const float* b, float s, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    float4 vs = f4Set(s);
+    float4 zero = f4Set(0.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        f4Store(a + i, f4Max(zero, f4Add(f4Load(a + i), f4Mul(f4Load(b + i), vs))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        a[i] = MAX(0, a[i] + b[i] * s);
+    }
+}
+
+// delta[i] = (delta[i] - start[i]) / time[i], turns an end value into a rate of change
+static void particleDelta(float* delta, const float* start, const float* time, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    for (; i + 4 <= count; i += 4)
+    {
+        f4Store(delta + i, f4Div(f4Sub(f4Load(delta + i), f4Load(start + i)), f4Load(time + i)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        delta[i] = (delta[i] - start[i]) / time[i];
+    }
+}
+
+// out[i] = clamp(base + variance * random, low, high)
+// Produces exactly the same sequence as calling particleRandom count times.
+static void particleRandomFill(float* out, float base, float variance, float low, float high, uint32_t* seed, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    if (count >= 4)
+    {
+        uint32_t state[4];
+        uint32_t s = *seed;
+        for (int k = 0; k < 4; ++k)
+        {
+            s = s * PARTICLE_RAND_A + PARTICLE_RAND_C;
+            state[k] = s;
+        }
+
+        int4 lanes = i4Load(state);
+        const int4 a4 = i4Set(PARTICLE_RAND_A4);
+        const int4 c4 = i4Set(PARTICLE_RAND_C4);
+        float4 vbase = f4Set(base);
+        float4 vvar = f4Set(variance);
+        float4 vlow = f4Set(low);
+        float4 vhigh = f4Set(high);
+        for (;;)
+        {
+            float4 v = f4Add(vbase, f4Mul(vvar, f4Random(lanes)));
+            f4Store(out + i, f4Min(vhigh, f4Max(vlow, v)));
+            i += 4;
+            if (i + 4 > count)
+                break;
+            lanes = i4Add(i4Mul(lanes, a4), c4);
+        }
+
+        // the last lane holds the generator state after the last number used
+        i4Store(state, lanes);
+        *seed = state[3];
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = clampf(base + variance * particleRandom(seed), low, high);
+    }
+}
+
+// gravity mode: radial and tangential acceleration plus gravity integrated into the direction,
+// then the direction integrated into the position.
+static void particleUpdateGravity(ParticleData& data, int count, const Vec2& gravity, float dt, float yCoordFlipped)
+{
+    float* posx = data.posx;
+    float* posy = data.posy;
+    float* dirX = data.modeA.dirX;
+    float* dirY = data.modeA.dirY;
+    const float* radialAccel = data.modeA.radialAccel;
+    const float* tangentialAccel = data.modeA.tangentialAccel;
+    const float posDt = dt * yCoordFlipped;
+
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    const float4 vgx = f4Set(gravity.x);
+    const float4 vgy = f4Set(gravity.y);
+    const float4 vdt = f4Set(dt);
+    const float4 vposDt = f4Set(posDt);
+    const float4 zero = f4Set(0.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        float4 x = f4Load(posx + i);
+        float4 y = f4Load(posy + i);
+
+        // normalized position, zero for particles sitting on the emitter
+        float4 len2 = f4Add(f4Mul(x, x), f4Mul(y, y));
+        float4 valid = f4GreaterThan(len2, zero);
+        float4 inv = f4Select(valid, f4Rsqrt(f4Select(valid, len2, f4Set(1.0f))), zero);
+        float4 nx = f4Mul(x, inv);
+        float4 ny = f4Mul(y, inv);
+
+        float4 radial = f4Load(radialAccel + i);
+        float4 tangential = f4Load(tangentialAccel + i);
+        float4 ax = f4Add(f4Sub(f4Mul(nx, radial), f4Mul(ny, tangential)), vgx);
+        float4 ay = f4Add(f4Add(f4Mul(ny, radial), f4Mul(nx, tangential)), vgy);
+
+        float4 dx = f4Add(f4Load(dirX + i), f4Mul(ax, vdt));
+        float4 dy = f4Add(f4Load(dirY + i), f4Mul(ay, vdt));
+        f4Store(dirX + i, dx);
+        f4Store(dirY + i, dy);
+        f4Store(posx + i, f4Add(x, f4Mul(dx, vposDt)));
+        f4Store(posy + i, f4Add(y, f4Mul(dy, vposDt)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float x = posx[i];
+        float y = posy[i];
+        float len2 = x * x + y * y;
+        float inv = len2 > 0.0f ? 1.0f / sqrtf(len2) : 0.0f;
+        float nx = x * inv;
+        float ny = y * inv;
+
+        float ax = nx * radialAccel[i] - ny * tangentialAccel[i] + gravity.x;
+        float ay = ny * radialAccel[i] + nx * tangentialAccel[i] + gravity.y;
+
+        dirX[i] += ax * dt;
+        dirY[i] += ay * dt;
+        posx[i] += dirX[i] * posDt;
+        posy[i] += dirY[i] * posDt;
+    }
+}
+
+// radius mode: the position is computed from the angle and radius around the emitter.
+static void particleUpdateRadius(ParticleData& data, int count, float dt, float yCoordFlipped)
+{
+    particleMulAdd(data.modeB.angle, data.modeB.degreesPerSecond, dt, count);
+    particleMulAdd(data.modeB.radius, data.modeB.deltaRadius, dt, count);
+
+    float* posx = data.posx;
+    float* posy = data.posy;
+    const float* angle = data.modeB.angle;
+    const float* radius = data.modeB.radius;
+
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    const float4 flipX = f4Set(-1.0f);
+    const float4 flipY = f4Set(-yCoordFlipped);
+    for (; i + 4 <= count; i += 4)
+    {
+        float4 s, c;
+        f4SinCos(f4Load(angle + i), &s, &c);
+        float4 r = f4Load(radius + i);
+        f4Store(posx + i, f4Mul(f4Mul(c, r), flipX));
+        f4Store(posy + i, f4Mul(f4Mul(s, r), flipY));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        posx[i] = - cosf(angle[i]) * radius[i];
+        posy[i] = - sinf(angle[i]) * radius[i] * yCoordFlipped;
+    }
+}
+
+// dirX/dirY hold an angle in radians and a speed, they are turned into a velocity.
+static void particleAngleSpeedToDirection(float* dirX, float* dirY, int count)
+{
+    int i = 0;
+#ifdef CC_PARTICLE_USE_SIMD
+    for (; i + 4 <= count; i += 4)
+    {
+        float4 s, c;
+        f4SinCos(f4Load(dirX + i), &s, &c);
+        float4 speed = f4Load(dirY + i);
+        f4Store(dirX + i, f4Mul(c, speed));
+        f4Store(dirY + i, f4Mul(s, speed));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float a = dirX[i];
+        float speed = dirY[i];
+        dirX[i] = cosf(a) * speed;
+        dirY[i] = sinf(a) * speed;
+    }
+}
+
+NS_CC_END
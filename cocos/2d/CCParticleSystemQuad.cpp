@@ -47,24 +47,22 @@ NS_CC_BEGIN
 
 ParticleSystemQuad::ParticleSystemQuad()
 :_quads(nullptr)
+,_backQuads(nullptr)
+,_quadCount(0)
 ,_indices(nullptr)
-,_VAOname(0)
+,_quadTarget(nullptr)
+,_quadPositionType(PositionType::FREE)
+,_quadOpacityModifyRGB(false)
 {
-    memset(_buffersVBO, 0, sizeof(_buffersVBO));
 }
 
 ParticleSystemQuad::~ParticleSystemQuad()
 {
+    CC_SAFE_FREE(_backQuads);
     if (nullptr == _batchNode)
     {
         CC_SAFE_FREE(_quads);
         CC_SAFE_FREE(_indices);
-        glDeleteBuffers(2, &_buffersVBO[0]);
-        if (Configuration::getInstance()->supportsShareableVAO())
-        {
-            glDeleteVertexArrays(1, &_VAOname);
-            GL::bindVAO(0);
-        }
     }
 }
 
@@ -119,23 +117,9 @@ bool ParticleSystemQuad::initWithTotalParticles(int numberOfParticles)
         }
 
         initIndices();
-        if (Configuration::getInstance()->supportsShareableVAO())
-        {
-            setupVBOandVAO();
-        }
-        else
-        {
-            setupVBO();
-        }
 
         setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP));
 
-#if CC_ENABLE_CACHE_TEXTURE_DATA
-        // Need to listen the event only when not use batchnode, because it will use VBO
-        auto listener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, CC_CALLBACK_1(ParticleSystemQuad::listenRendererRecreated, this));
-        _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
-#endif
-
         return true;
     }
     return false;
@@ -144,6 +128,10 @@ bool ParticleSystemQuad::initWithTotalParticles(int numberOfParticles)
 // pointRect should be in Texture coordinates, not pixel coordinates
 void ParticleSystemQuad::initTexCoordsWithRect(const Rect& pointRect)
 {
+    // the double buffer is rebuilt from _quads by the next parallel update
+    waitForParallelUpdate();
+    CC_SAFE_FREE(_backQuads);
+
     // convert to Tex coords
 
     Rect rect = Rect(
@@ -305,37 +293,55 @@ inline void updatePosWithParticle(V3F_C4B_T2F_Quad *quad, const Vec2& newPositio
 
 void ParticleSystemQuad::updateParticleQuads()
 {
+    _quadCount = _particleCount;
     if (_particleCount <= 0) {
         return;
     }
- 
-    Vec2 currentPosition;
-    if (_positionType == PositionType::FREE)
+
+    if (_batchNode)
     {
-        currentPosition = this->convertToWorldSpace(Vec2::ZERO);
+        V3F_C4B_T2F_Quad *batchQuads = _batchNode->getTextureAtlas()->getQuads();
+        prepareParticleQuads(&(batchQuads[_atlasIndex]));
     }
-    else if (_positionType == PositionType::RELATIVE)
+    else
     {
-        currentPosition = _position;
+        prepareParticleQuads(&(_quads[0]));
     }
-    
-    V3F_C4B_T2F_Quad *startQuad;
-    Vec2 pos = Vec2::ZERO;
-    if (_batchNode)
+    writeParticleQuads();
+}
+
+void ParticleSystemQuad::prepareParticleQuads(V3F_C4B_T2F_Quad* target)
+{
+    _quadTarget = target;
+    _quadOffset = _batchNode ? _position : Vec2::ZERO;
+    _quadPositionType = _positionType;
+    _quadOpacityModifyRGB = _opacityModifyRGB;
+
+    if (_positionType == PositionType::FREE)
     {
-        V3F_C4B_T2F_Quad *batchQuads = _batchNode->getTextureAtlas()->getQuads();
-        startQuad = &(batchQuads[_atlasIndex]);
-        pos = _position;
+        _quadCurrentPosition = this->convertToWorldSpace(Vec2::ZERO);
+        _quadWorldToNode = getWorldToNodeTransform();
+    }
+    else if (_positionType == PositionType::RELATIVE)
+    {
+        _quadCurrentPosition = _position;
     }
     else
     {
-        startQuad = &(_quads[0]);
+        _quadCurrentPosition = Vec2::ZERO;
     }
+}
+
+void ParticleSystemQuad::writeParticleQuads()
+{
+    V3F_C4B_T2F_Quad *startQuad = _quadTarget;
+    const Vec2& currentPosition = _quadCurrentPosition;
+    const Vec2& pos = _quadOffset;
     
-    if( _positionType == PositionType::FREE )
+    if( _quadPositionType == PositionType::FREE )
     {
         Vec3 p1(currentPosition.x, currentPosition.y, 0);
-        Mat4 worldToNodeTM = getWorldToNodeTransform();
+        const Mat4& worldToNodeTM = _quadWorldToNode;
         worldToNodeTM.transformPoint(&p1);
         Vec3 p2;
         Vec2 newPos;
@@ -357,7 +363,7 @@ void ParticleSystemQuad::updateParticleQuads()
             updatePosWithParticle(quadStart, newPos, *s, *r);
         }
     }
-    else if( _positionType == PositionType::RELATIVE )
+    else if( _quadPositionType == PositionType::RELATIVE )
     {
         Vec2 newPos;
         float* startX = _particleData.startPosX;
@@ -394,7 +400,7 @@ void ParticleSystemQuad::updateParticleQuads()
     }
     
     //set color
-    if(_opacityModifyRGB)
+    if(_quadOpacityModifyRGB)
     {
         V3F_C4B_T2F_Quad* quad = startQuad;
         float* r = _particleData.colorR;
@@ -436,40 +442,61 @@ void ParticleSystemQuad::updateParticleQuads()
     }
 }
 
-void ParticleSystemQuad::postStep()
+bool ParticleSystemQuad::beginParallelUpdate()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-    
-    // Option 1: Sub Data
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(_quads[0])*_totalParticles, _quads);
-    
-    // Option 2: Data
-    //  glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * particleCount, quads_, GL_DYNAMIC_DRAW);
-    
-    // Option 3: Orphaning + glMapBuffer
-    // glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0])*_totalParticles, nullptr, GL_STREAM_DRAW);
-    // void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    // memcpy(buf, _quads, sizeof(_quads[0])*_totalParticles);
-    // glUnmapBuffer(GL_ARRAY_BUFFER);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    
-    CHECK_GL_ERROR_DEBUG();
+    if (nullptr == _backQuads)
+    {
+        // texture coordinates are only written once, start from a copy of the quads being rendered
+        _backQuads = (V3F_C4B_T2F_Quad*)malloc(sizeof(_quads[0]) * _allocatedParticles);
+        if (nullptr == _backQuads)
+            return false;
+        std::copy(_quads, _quads + _allocatedParticles, _backQuads);
+    }
+
+    prepareParticleQuads(_backQuads);
+    return true;
+}
+
+void ParticleSystemQuad::updateInParallel(float dt)
+{
+    updateParticles(dt, _parallelUpdateParameters);
+    if (_particleCount > 0)
+    {
+        writeParticleQuads();
+    }
+}
+
+void ParticleSystemQuad::endParallelUpdate()
+{
+    std::swap(_quads, _backQuads);
+    _quadCount = _particleCount;
+
+    if (_visible)
+    {
+        postStep();
+    }
 }
 
 // overriding draw method
 void ParticleSystemQuad::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
+    // when double buffered _quads holds the particles of the previous update
+    int count = _backQuads ? _quadCount : _particleCount;
+
     //quad command
-    if(_particleCount > 0)
+    if(count > 0)
     {
-        _quadCommand.init(_globalZOrder, _texture, getGLProgramState(), _blendFunc, _quads, _particleCount, transform, flags);
+        _quadCommand.init(_globalZOrder, _texture, getGLProgramState(), _blendFunc, _quads, count, transform, flags);
         renderer->addCommand(&_quadCommand);
     }
 }
 
 void ParticleSystemQuad::setTotalParticles(int tp)
 {
+    // the double buffer is rebuilt from _quads by the next parallel update
+    waitForParallelUpdate();
+    CC_SAFE_FREE(_backQuads);
+
     // If we are setting the total number of particles to a number higher
     // than what is allocated, we need to allocate new arrays
     if( tp > _allocatedParticles )
@@ -521,14 +548,6 @@ void ParticleSystemQuad::setTotalParticles(int tp)
         }
 
         initIndices();
-        if (Configuration::getInstance()->supportsShareableVAO())
-        {
-            setupVBOandVAO();
-        }
-        else
-        {
-            setupVBO();
-        }
         
         // fixed http://www.cocos2d-x.org/issues/3990
         // Updates texture coords.
@@ -546,77 +565,9 @@ void ParticleSystemQuad::setTotalParticles(int tp)
     resetSystem();
 }
 
-void ParticleSystemQuad::setupVBOandVAO()
-{
-    // clean VAO
-    glDeleteBuffers(2, &_buffersVBO[0]);
-    glDeleteVertexArrays(1, &_VAOname);
-    GL::bindVAO(0);
-    
-    glGenVertexArrays(1, &_VAOname);
-    GL::bindVAO(_VAOname);
-
-#define kQuadSize sizeof(_quads[0].bl)
-
-    glGenBuffers(2, &_buffersVBO[0]);
-
-    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _totalParticles, _quads, GL_DYNAMIC_DRAW);
-
-    // vertices
-    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_POSITION);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( V3F_C4B_T2F, vertices));
-
-    // colors
-    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_COLOR);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) offsetof( V3F_C4B_T2F, colors));
-
-    // tex coords
-    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_TEX_COORD);
-    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( V3F_C4B_T2F, texCoords));
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * _totalParticles * 6, _indices, GL_STATIC_DRAW);
-
-    // Must unbind the VAO before changing the element buffer.
-    GL::bindVAO(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    CHECK_GL_ERROR_DEBUG();
-}
-
-void ParticleSystemQuad::setupVBO()
-{
-    glDeleteBuffers(2, &_buffersVBO[0]);
-    
-    glGenBuffers(2, &_buffersVBO[0]);
-
-    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _totalParticles, _quads, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * _totalParticles * 6, _indices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    CHECK_GL_ERROR_DEBUG();
-}
-
 void ParticleSystemQuad::listenRendererRecreated(EventCustom* /*event*/)
 {
-    //when comes to foreground in android, _buffersVBO and _VAOname is a wild handle
-    //before recreating, we need to reset them to 0
-    memset(_buffersVBO, 0, sizeof(_buffersVBO));
-    if (Configuration::getInstance()->supportsShareableVAO())
-    {
-        _VAOname = 0;
-        setupVBOandVAO();
-    }
-    else
-    {
-        setupVBO();
-    }
+    // the quads are submitted by the QuadCommand, there is no GL object to recreate
 }
 
 bool ParticleSystemQuad::allocMemory()
@@ -646,6 +597,10 @@ bool ParticleSystemQuad::allocMemory()
 
 void ParticleSystemQuad::setBatchNode(ParticleBatchNode * batchNode)
 {
+    // the double buffer is rebuilt from _quads by the next parallel update
+    waitForParallelUpdate();
+    CC_SAFE_FREE(_backQuads);
+
     if( _batchNode != batchNode ) 
     {
         ParticleBatchNode* oldBatch = _batchNode;
@@ -658,14 +613,6 @@ void ParticleSystemQuad::setBatchNode(ParticleBatchNode * batchNode)
             allocMemory();
             initIndices();
             setTexture(oldBatch->getTexture());
-            if (Configuration::getInstance()->supportsShareableVAO())
-            {
-                setupVBOandVAO();
-            }
-            else
-            {
-                setupVBO();
-            }
         }
         // OLD: was it self render ? cleanup
         else if( !oldBatch )
@@ -677,15 +624,6 @@ void ParticleSystemQuad::setBatchNode(ParticleBatchNode * batchNode)
 
             CC_SAFE_FREE(_quads);
             CC_SAFE_FREE(_indices);
-
-            glDeleteBuffers(2, &_buffersVBO[0]);
-            memset(_buffersVBO, 0, sizeof(_buffersVBO));
-            if (Configuration::getInstance()->supportsShareableVAO())
-            {
-                glDeleteVertexArrays(1, &_VAOname);
-                GL::bindVAO(0);
-                _VAOname = 0;
-            }
         }
     }
 }
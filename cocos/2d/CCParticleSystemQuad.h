@@ -107,6 +107,7 @@ public:
      * @lua NA
      *
      * @param event the event that renderer was recreated on Android/WP8.
+     * @deprecated The particles no longer own GL buffers, nothing is recreated.
      */
     void listenRendererRecreated(EventCustom* event);
 
@@ -120,11 +121,6 @@ public:
      * @lua NA
      */    
     virtual void updateParticleQuads() override;
-    /**
-     * @js NA
-     * @lua NA
-     */
-    virtual void postStep() override;
     /**
      * @js NA
      * @lua NA
@@ -174,16 +170,32 @@ protected:
     /** Updates texture coords */
     void updateTexCoords();
 
-    void setupVBOandVAO();
-    void setupVBO();
     bool allocMemory();
 
+    /** Captures on the cocos thread what writeParticleQuads needs from the node. */
+    void prepareParticleQuads(V3F_C4B_T2F_Quad* target);
+    /** Writes the particles into the quads given to prepareParticleQuads, safe on a worker thread. */
+    void writeParticleQuads();
+
+    // Overrides
+    virtual bool beginParallelUpdate() override;
+    virtual void updateInParallel(float dt) override;
+    virtual void endParallelUpdate() override;
+
     V3F_C4B_T2F_Quad    *_quads;        // quads to be rendered
+    V3F_C4B_T2F_Quad    *_backQuads;    // quads written on a worker thread while _quads are rendered
+    int                 _quadCount;     // number of particles in _quads when double buffered
     GLushort            *_indices;      // indices
-    GLuint              _VAOname;
-    GLuint              _buffersVBO[2]; //0: vertex  1: indices
 
     QuadCommand _quadCommand;           // quad command
+
+    // state captured by prepareParticleQuads
+    V3F_C4B_T2F_Quad*   _quadTarget;
+    Vec2                _quadCurrentPosition;
+    Vec2                _quadOffset;
+    Mat4                _quadWorldToNode;
+    PositionType        _quadPositionType;
+    bool                _quadOpacityModifyRGB;
     
 
 
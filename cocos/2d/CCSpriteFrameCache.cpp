@@ -34,6 +34,7 @@ THE SOFTWARE.
 
 #include "2d/CCSprite.h"
 #include "2d/CCAutoPolygon.h"
+#include "2d/CCSpriteSheetReader.h"
 #include "platform/CCFileUtils.h"
 #include "base/CCNS.h"
 #include "base/ccMacros.h"
@@ -146,139 +147,30 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dictionary, Textu
     ZWTCoordinatesFormatOptionXML1_2 = 3, // Desktop Version 1.0.2+
 
     Version 3 with TexturePacker 4.0 polygon mesh packing
-    */
-
-    if (dictionary["frames"].getType() != cocos2d::Value::Type::MAP)
-        return;
-
-    ValueMap& framesDict = dictionary["frames"].asValueMap();
-    int format = 0;
-
-    Size textureSize;
 
-    // get the format
-    if (dictionary.find("metadata") != dictionary.end())
-    {
-        ValueMap& metadataDict = dictionary["metadata"].asValueMap();
-        format = metadataDict["format"].asInt();
-
-        if(metadataDict.find("size") != metadataDict.end())
-        {
-            textureSize = SizeFromString(metadataDict["size"].asString());
-        }
-    }
+    The formats are converted by SpriteSheetReader.
+    */
 
-    // check the format
-    CCASSERT(format >=0 && format <= 3, "format is not supported for SpriteFrameCache addSpriteFramesWithDictionary:textureFilename:");
+    SpriteSheet sheet;
+    SpriteSheetReader::readValueMap(dictionary, &sheet);
+    addSpriteFramesWithSheet(sheet, texture);
+}
 
+void SpriteFrameCache::addSpriteFramesWithSheet(const SpriteSheet& sheet, Texture2D* texture)
+{
     auto textureFileName = Director::getInstance()->getTextureCache()->getTextureFilePath(texture);
     Image* image = nullptr;
     NinePatchImageParser parser;
-    for (auto& iter : framesDict)
+    for (const auto& frame : sheet.frames)
     {
-        ValueMap& frameDict = iter.second.asValueMap();
-        std::string spriteFrameName = iter.first;
+        const std::string& spriteFrameName = frame.name;
         SpriteFrame* spriteFrame = _spriteFrames.at(spriteFrameName);
         if (spriteFrame)
         {
             continue;
         }
-        
-        if(format == 0) 
-        {
-            float x = frameDict["x"].asFloat();
-            float y = frameDict["y"].asFloat();
-            float w = frameDict["width"].asFloat();
-            float h = frameDict["height"].asFloat();
-            float ox = frameDict["offsetX"].asFloat();
-            float oy = frameDict["offsetY"].asFloat();
-            int ow = frameDict["originalWidth"].asInt();
-            int oh = frameDict["originalHeight"].asInt();
-            // check ow/oh
-            if(!ow || !oh)
-            {
-                CCLOGWARN("cocos2d: WARNING: originalWidth/Height not found on the SpriteFrame. AnchorPoint won't work as expected. Regenerate the .plist");
-            }
-            // abs ow/oh
-            ow = std::abs(ow);
-            oh = std::abs(oh);
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                                                         Rect(x, y, w, h),
-                                                         false,
-                                                         Vec2(ox, oy),
-                                                         Size((float)ow, (float)oh)
-                                                         );
-        } 
-        else if(format == 1 || format == 2) 
-        {
-            Rect frame = RectFromString(frameDict["frame"].asString());
-            bool rotated = false;
 
-            // rotation
-            if (format == 2)
-            {
-                rotated = frameDict["rotated"].asBool();
-            }
-
-            Vec2 offset = PointFromString(frameDict["offset"].asString());
-            Size sourceSize = SizeFromString(frameDict["sourceSize"].asString());
-
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                                                         frame,
-                                                         rotated,
-                                                         offset,
-                                                         sourceSize
-                                                         );
-        } 
-        else if (format == 3)
-        {
-            // get values
-            Size spriteSize = SizeFromString(frameDict["spriteSize"].asString());
-            Vec2 spriteOffset = PointFromString(frameDict["spriteOffset"].asString());
-            Size spriteSourceSize = SizeFromString(frameDict["spriteSourceSize"].asString());
-            Rect textureRect = RectFromString(frameDict["textureRect"].asString());
-            bool textureRotated = frameDict["textureRotated"].asBool();
-
-            // get aliases
-            ValueVector& aliases = frameDict["aliases"].asValueVector();
-
-            for(const auto &value : aliases) {
-                std::string oneAlias = value.asString();
-                if (_spriteFramesAliases.find(oneAlias) != _spriteFramesAliases.end())
-                {
-                    CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", oneAlias.c_str());
-                }
-
-                _spriteFramesAliases[oneAlias] = Value(spriteFrameName);
-            }
-
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                                                         Rect(textureRect.origin.x, textureRect.origin.y, spriteSize.width, spriteSize.height),
-                                                         textureRotated,
-                                                         spriteOffset,
-                                                         spriteSourceSize);
-
-            if(frameDict.find("vertices") != frameDict.end())
-            {
-                std::vector<int> vertices;
-                parseIntegerList(frameDict["vertices"].asString(), vertices);
-                std::vector<int> verticesUV;
-                parseIntegerList(frameDict["verticesUV"].asString(), verticesUV);
-                std::vector<int> indices;
-                parseIntegerList(frameDict["triangles"].asString(), indices);
-
-                PolygonInfo info;
-                initializePolygonInfo(textureSize, spriteSourceSize, vertices, verticesUV, indices, info);
-                spriteFrame->setPolygonInfo(info);
-            }
-            if (frameDict.find("anchor") != frameDict.end())
-            {
-                spriteFrame->setAnchorPoint(PointFromString(frameDict["anchor"].asString()));
-            }
-        }
+        spriteFrame = createSpriteFrame(sheet, frame, texture);
 
         bool flag = NinePatchImageParser::isNinePatchImage(spriteFrameName);
         if(flag)
@@ -296,18 +188,47 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dictionary, Textu
     CC_SAFE_DELETE(image);
 }
 
-void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::string &texturePath)
+SpriteFrame* SpriteFrameCache::createSpriteFrame(const SpriteSheet& sheet, const SpriteSheetFrame& frame, Texture2D* texture)
 {
-    std::string pixelFormatName;
-    if (dict.find("metadata") != dict.end())
+    for (const auto& alias : frame.aliases)
     {
-        ValueMap& metadataDict = dict.at("metadata").asValueMap();
-        if (metadataDict.find("pixelFormat") != metadataDict.end())
+        if (_spriteFramesAliases.find(alias) != _spriteFramesAliases.end())
         {
-            pixelFormatName = metadataDict.at("pixelFormat").asString();
+            CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", alias.c_str());
         }
+
+        _spriteFramesAliases[alias] = Value(frame.name);
     }
-    
+
+    // create frame
+    SpriteFrame* spriteFrame = SpriteFrame::createWithTexture(texture,
+                                                              frame.rect,
+                                                              frame.rotated,
+                                                              frame.offset,
+                                                              frame.sourceSize);
+
+    if (!frame.vertices.empty())
+    {
+        PolygonInfo info;
+        initializePolygonInfo(sheet.textureSize, frame.sourceSize, frame.vertices, frame.verticesUV, frame.triangles, info);
+        spriteFrame->setPolygonInfo(info);
+    }
+    if (frame.hasAnchor)
+    {
+        spriteFrame->setAnchorPoint(frame.anchor);
+    }
+    return spriteFrame;
+}
+
+void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::string &texturePath)
+{
+    SpriteSheet sheet;
+    SpriteSheetReader::readValueMap(dict, &sheet);
+    addSpriteFramesWithSheet(sheet, texturePath);
+}
+
+void SpriteFrameCache::addSpriteFramesWithSheet(const SpriteSheet& sheet, const std::string &texturePath)
+{
     Texture2D *texture = nullptr;
     static std::unordered_map<std::string, Texture2D::PixelFormat> pixelFormats = {
         {"RGBA8888", Texture2D::PixelFormat::RGBA8888},
@@ -324,7 +245,7 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::
         {"RGB888", Texture2D::PixelFormat::RGB888}
     };
 
-    auto pixelFormatIt = pixelFormats.find(pixelFormatName);
+    auto pixelFormatIt = pixelFormats.find(sheet.pixelFormat);
     if (pixelFormatIt != pixelFormats.end())
     {
         const Texture2D::PixelFormat pixelFormat = (*pixelFormatIt).second;
@@ -340,7 +261,7 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::
     
     if (texture)
     {
-        addSpriteFramesWithDictionary(dict, texture);
+        addSpriteFramesWithSheet(sheet, texture);
     }
     else
     {
@@ -348,6 +269,51 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::
     }
 }
 
+bool SpriteFrameCache::readSpriteSheet(const std::string& fullPath, SpriteSheet* sheet)
+{
+    Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+    if (data.isNull())
+    {
+        *sheet = SpriteSheet();
+        return false;
+    }
+    if (SpriteSheetReader::read(data.getBytes(), data.getSize(), sheet))
+    {
+        return true;
+    }
+
+    // plists SpriteSheetReader doesn't understand are parsed by FileUtils
+    ValueMap dict = FileUtils::getInstance()->getValueMapFromData(reinterpret_cast<const char*>(data.getBytes()), static_cast<int>(data.getSize()));
+    SpriteSheetReader::readValueMap(dict, sheet);
+    return !dict.empty();
+}
+
+std::string SpriteFrameCache::getSheetTexturePath(const SpriteSheet& sheet, const std::string& plist)
+{
+    string texturePath = sheet.textureFileName;
+
+    if (!texturePath.empty())
+    {
+        // build texture path relative to plist file
+        texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath, plist);
+    }
+    else
+    {
+        // build texture path by replacing file extension
+        texturePath = plist;
+
+        // remove .xxx
+        size_t startPos = texturePath.find_last_of("."); 
+        texturePath = texturePath.erase(startPos);
+
+        // append .png
+        texturePath = texturePath.append(".png");
+
+        CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
+    }
+    return texturePath;
+}
+
 void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, Texture2D *texture)
 {
     if (_loadedFileNames->find(plist) != _loadedFileNames->end())
@@ -356,16 +322,22 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, Texture
     }
     
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
+    SpriteSheet sheet;
+    readSpriteSheet(fullPath, &sheet);
 
-    addSpriteFramesWithDictionary(dict, texture);
+    addSpriteFramesWithSheet(sheet, texture);
     _loadedFileNames->insert(plist);
 }
 
 void SpriteFrameCache::addSpriteFramesWithFileContent(const std::string& plist_content, Texture2D *texture)
 {
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromData(plist_content.c_str(), static_cast<int>(plist_content.size()));
-    addSpriteFramesWithDictionary(dict, texture);
+    SpriteSheet sheet;
+    if (!SpriteSheetReader::read(reinterpret_cast<const unsigned char*>(plist_content.data()), static_cast<ssize_t>(plist_content.size()), &sheet))
+    {
+        ValueMap dict = FileUtils::getInstance()->getValueMapFromData(plist_content.c_str(), static_cast<int>(plist_content.size()));
+        SpriteSheetReader::readValueMap(dict, &sheet);
+    }
+    addSpriteFramesWithSheet(sheet, texture);
 }
 
 void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, const std::string& textureFileName)
@@ -377,8 +349,9 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, const s
     }
     
     const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
-    addSpriteFramesWithDictionary(dict, textureFileName);
+    SpriteSheet sheet;
+    readSpriteSheet(fullPath, &sheet);
+    addSpriteFramesWithSheet(sheet, textureFileName);
     _loadedFileNames->insert(plist);
 }
 
@@ -396,38 +369,10 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist)
 
     if (_loadedFileNames->find(plist) == _loadedFileNames->end())
     {
-        
-        ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
-
-        string texturePath("");
-
-        if (dict.find("metadata") != dict.end())
-        {
-            ValueMap& metadataDict = dict["metadata"].asValueMap();
-            // try to read  texture file name from meta data
-            texturePath = metadataDict["textureFileName"].asString();
-        }
+        SpriteSheet sheet;
+        readSpriteSheet(fullPath, &sheet);
 
-        if (!texturePath.empty())
-        {
-            // build texture path relative to plist file
-            texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath, plist);
-        }
-        else
-        {
-            // build texture path by replacing file extension
-            texturePath = plist;
-
-            // remove .xxx
-            size_t startPos = texturePath.find_last_of("."); 
-            texturePath = texturePath.erase(startPos);
-
-            // append .png
-            texturePath = texturePath.append(".png");
-
-            CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
-        }
-        addSpriteFramesWithDictionary(dict, texturePath);
+        addSpriteFramesWithSheet(sheet, getSheetTexturePath(sheet, plist));
         _loadedFileNames->insert(plist);
     }
 }
@@ -510,13 +455,13 @@ void SpriteFrameCache::removeSpriteFrameByName(const std::string& name)
 void SpriteFrameCache::removeSpriteFramesFromFile(const std::string& plist)
 {
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
-    if (dict.empty())
+    SpriteSheet sheet;
+    if (!readSpriteSheet(fullPath, &sheet))
     {
         CCLOG("cocos2d:SpriteFrameCache:removeSpriteFramesFromFile: create dict by %s fail.",plist.c_str());
         return;
     }
-    removeSpriteFramesFromDictionary(dict);
+    removeSpriteFramesFromSheet(sheet);
 
     // remove it from the cache
     set<string>::iterator ret = _loadedFileNames->find(plist);
@@ -528,28 +473,36 @@ void SpriteFrameCache::removeSpriteFramesFromFile(const std::string& plist)
 
 void SpriteFrameCache::removeSpriteFramesFromFileContent(const std::string& plist_content)
 {
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromData(plist_content.data(), static_cast<int>(plist_content.size()));
-    if (dict.empty())
+    SpriteSheet sheet;
+    if (!SpriteSheetReader::read(reinterpret_cast<const unsigned char*>(plist_content.data()), static_cast<ssize_t>(plist_content.size()), &sheet))
     {
-        CCLOG("cocos2d:SpriteFrameCache:removeSpriteFramesFromFileContent: create dict by fail.");
-        return;
+        ValueMap dict = FileUtils::getInstance()->getValueMapFromData(plist_content.data(), static_cast<int>(plist_content.size()));
+        if (dict.empty())
+        {
+            CCLOG("cocos2d:SpriteFrameCache:removeSpriteFramesFromFileContent: create dict by fail.");
+            return;
+        }
+        SpriteSheetReader::readValueMap(dict, &sheet);
     }
-    removeSpriteFramesFromDictionary(dict);
+    removeSpriteFramesFromSheet(sheet);
 }
 
 void SpriteFrameCache::removeSpriteFramesFromDictionary(ValueMap& dictionary)
 {
-    if (dictionary["frames"].getType() != cocos2d::Value::Type::MAP)
-        return;
+    SpriteSheet sheet;
+    SpriteSheetReader::readValueMap(dictionary, &sheet);
+    removeSpriteFramesFromSheet(sheet);
+}
 
-    ValueMap framesDict = dictionary["frames"].asValueMap();
+void SpriteFrameCache::removeSpriteFramesFromSheet(const SpriteSheet& sheet)
+{
     std::vector<std::string> keysToRemove;
 
-    for (const auto& iter : framesDict)
+    for (const auto& frame : sheet.frames)
     {
-        if (_spriteFrames.at(iter.first))
+        if (_spriteFrames.at(frame.name))
         {
-            keysToRemove.push_back(iter.first);
+            keysToRemove.push_back(frame.name);
         }
     }
 
@@ -594,112 +547,23 @@ SpriteFrame* SpriteFrameCache::getSpriteFrameByName(const std::string& name)
 
 void SpriteFrameCache::reloadSpriteFramesWithDictionary(ValueMap& dictionary, Texture2D *texture)
 {
-    ValueMap& framesDict = dictionary["frames"].asValueMap();
-    int format = 0;
-
-    // get the format
-    if (dictionary.find("metadata") != dictionary.end())
-    {
-        ValueMap& metadataDict = dictionary["metadata"].asValueMap();
-        format = metadataDict["format"].asInt();
-    }
-
-    // check the format
-    CCASSERT(format >= 0 && format <= 3, "format is not supported for SpriteFrameCache addSpriteFramesWithDictionary:textureFilename:");
+    SpriteSheet sheet;
+    SpriteSheetReader::readValueMap(dictionary, &sheet);
+    reloadSpriteFramesWithSheet(sheet, texture);
+}
 
-    for (auto& iter : framesDict)
+void SpriteFrameCache::reloadSpriteFramesWithSheet(const SpriteSheet& sheet, Texture2D *texture)
+{
+    for (const auto& frame : sheet.frames)
     {
-        ValueMap& frameDict = iter.second.asValueMap();
-        std::string spriteFrameName = iter.first;
-
-        auto it = _spriteFrames.find(spriteFrameName);
+        auto it = _spriteFrames.find(frame.name);
         if (it != _spriteFrames.end())
         {
             _spriteFrames.erase(it);
         }
 
-        SpriteFrame* spriteFrame = nullptr;
-
-        if (format == 0)
-        {
-            float x = frameDict["x"].asFloat();
-            float y = frameDict["y"].asFloat();
-            float w = frameDict["width"].asFloat();
-            float h = frameDict["height"].asFloat();
-            float ox = frameDict["offsetX"].asFloat();
-            float oy = frameDict["offsetY"].asFloat();
-            int ow = frameDict["originalWidth"].asInt();
-            int oh = frameDict["originalHeight"].asInt();
-            // check ow/oh
-            if (!ow || !oh)
-            {
-                CCLOGWARN("cocos2d: WARNING: originalWidth/Height not found on the SpriteFrame. AnchorPoint won't work as expected. Regenerate the .plist");
-            }
-            // abs ow/oh
-            ow = std::abs(ow);
-            oh = std::abs(oh);
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                Rect(x, y, w, h),
-                false,
-                Vec2(ox, oy),
-                Size((float)ow, (float)oh)
-                );
-        }
-        else if (format == 1 || format == 2)
-        {
-            Rect frame = RectFromString(frameDict["frame"].asString());
-            bool rotated = false;
-
-            // rotation
-            if (format == 2)
-            {
-                rotated = frameDict["rotated"].asBool();
-            }
-
-            Vec2 offset = PointFromString(frameDict["offset"].asString());
-            Size sourceSize = SizeFromString(frameDict["sourceSize"].asString());
-
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                frame,
-                rotated,
-                offset,
-                sourceSize
-                );
-        }
-        else if (format == 3)
-        {
-            // get values
-            Size spriteSize = SizeFromString(frameDict["spriteSize"].asString());
-            Vec2 spriteOffset = PointFromString(frameDict["spriteOffset"].asString());
-            Size spriteSourceSize = SizeFromString(frameDict["spriteSourceSize"].asString());
-            Rect textureRect = RectFromString(frameDict["textureRect"].asString());
-            bool textureRotated = frameDict["textureRotated"].asBool();
-
-            // get aliases
-            ValueVector& aliases = frameDict["aliases"].asValueVector();
-
-            for (const auto &value : aliases) {
-                std::string oneAlias = value.asString();
-                if (_spriteFramesAliases.find(oneAlias) != _spriteFramesAliases.end())
-                {
-                    CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", oneAlias.c_str());
-                }
-
-                _spriteFramesAliases[oneAlias] = Value(spriteFrameName);
-            }
-
-            // create frame
-            spriteFrame = SpriteFrame::createWithTexture(texture,
-                Rect(textureRect.origin.x, textureRect.origin.y, spriteSize.width, spriteSize.height),
-                textureRotated,
-                spriteOffset,
-                spriteSourceSize);
-        }
-
         // add sprite frame
-        _spriteFrames.insert(spriteFrameName, spriteFrame);
+        _spriteFrames.insert(frame.name, createSpriteFrame(sheet, frame, texture));
     }
 }
 
@@ -718,34 +582,10 @@ bool SpriteFrameCache::reloadTexture(const std::string& plist)
     }
 
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
-
-    string texturePath("");
-
-    if (dict.find("metadata") != dict.end())
-    {
-        ValueMap& metadataDict = dict["metadata"].asValueMap();
-        // try to read  texture file name from meta data
-        texturePath = metadataDict["textureFileName"].asString();
-    }
+    SpriteSheet sheet;
+    readSpriteSheet(fullPath, &sheet);
 
-    if (!texturePath.empty())
-    {
-        // build texture path relative to plist file
-        texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath, plist);
-    }
-    else
-    {
-        // build texture path by replacing file extension
-        texturePath = plist;
-
-        // remove .xxx
-        size_t startPos = texturePath.find_last_of(".");
-        texturePath = texturePath.erase(startPos);
-
-        // append .png
-        texturePath = texturePath.append(".png");
-    }
+    std::string texturePath = getSheetTexturePath(sheet, plist);
 
     Texture2D *texture = nullptr;
     if (Director::getInstance()->getTextureCache()->reloadTexture(texturePath))
@@ -753,7 +593,7 @@ bool SpriteFrameCache::reloadTexture(const std::string& plist)
 
     if (texture)
     {
-        reloadSpriteFramesWithDictionary(dict, texture);
+        reloadSpriteFramesWithSheet(sheet, texture);
         _loadedFileNames->insert(plist);
     }
     else
@@ -42,6 +42,8 @@ NS_CC_BEGIN
 class Sprite;
 class Texture2D;
 class PolygonInfo;
+struct SpriteSheet;
+struct SpriteSheetFrame;
 
 /**
  * @addtogroup _2d
@@ -77,6 +79,9 @@ class PolygonInfo;
      - `size`:            size of the texture (optional)
      - `textureFileName`: name of the texture's image file
  
+ The .plist file may be an XML or a binary plist. It can also be converted by SpriteSheetReader::convert
+ into a compact form which is read without parsing any text, and which is loaded like a .plist file.
+
  Use one of the following tools to create the .plist file and sprite sheet:
  - [TexturePacker](https://www.codeandweb.com/texturepacker/cocos2d)
  - [Zwoptex](https://zwopple.com/zwoptex/)
@@ -269,6 +274,23 @@ protected:
 
     void reloadSpriteFramesWithDictionary(ValueMap& dictionary, Texture2D *texture);
 
+    /** Adds the sprite frames of a sprite sheet read by SpriteSheetReader.
+     * @since v3.15
+     */
+    void addSpriteFramesWithSheet(const SpriteSheet& sheet, Texture2D *texture);
+    void addSpriteFramesWithSheet(const SpriteSheet& sheet, const std::string &texturePath);
+    void removeSpriteFramesFromSheet(const SpriteSheet& sheet);
+    void reloadSpriteFramesWithSheet(const SpriteSheet& sheet, Texture2D *texture);
+    /** Creates a sprite frame and registers its aliases. */
+    SpriteFrame* createSpriteFrame(const SpriteSheet& sheet, const SpriteSheetFrame& frame, Texture2D *texture);
+
+    /** Reads a sprite sheet file, plists which SpriteSheetReader can't read are parsed by FileUtils.
+     * @since v3.15
+     */
+    bool readSpriteSheet(const std::string& fullPath, SpriteSheet* sheet);
+    /** The texture of a sprite sheet, relative to its plist, or the plist with a .png extension. */
+    std::string getSheetTexturePath(const SpriteSheet& sheet, const std::string& plist);
+
     Map<std::string, SpriteFrame*> _spriteFrames;
     ValueMap _spriteFramesAliases;
     std::set<std::string>*  _loadedFileNames;
@@ -0,0 +1,754 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCSpriteSheetReader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "base/ccMacros.h"
+#include "base/CCData.h"
+#include "base/CCPlistParser.h"
+#include "platform/CCFileUtils.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char COMPACT_SHEET_MAGIC[4] = { 'C', 'C', 'S', 'S' };
+    const uint32_t COMPACT_SHEET_VERSION = 1;
+
+    // The compact form: a FileHeader, frameCount FileFrame, aliasCount FileString,
+    // intCount int32_t of the polygons, then stringsSize bytes of strings.
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t frameCount;
+        uint32_t aliasCount;
+        uint32_t intCount;
+        uint32_t stringsSize;
+        float textureWidth;
+        float textureHeight;
+        uint32_t textureFileNameOffset;
+        uint32_t textureFileNameSize;
+        uint32_t pixelFormatOffset;
+        uint32_t pixelFormatSize;
+    };
+
+    // offset in the strings
+    struct FileString
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    enum
+    {
+        FRAME_ROTATED = 1,
+        FRAME_HAS_ANCHOR = 2
+    };
+
+    struct FileFrame
+    {
+        FileString name;
+        float rect[4];
+        float offset[2];
+        float sourceSize[2];
+        float anchor[2];
+        uint32_t flags;
+        uint32_t aliasIndex;
+        uint32_t aliasCount;
+        // offsets in the ints
+        uint32_t verticesIndex;
+        uint32_t verticesCount;
+        uint32_t verticesUVIndex;
+        uint32_t verticesUVCount;
+        uint32_t trianglesIndex;
+        uint32_t trianglesCount;
+    };
+
+    // reads the numbers of a string like "{{1,2},{3,4}}"
+    int parseFloats(const std::string& string, float* values, int count)
+    {
+        const char* p = string.c_str();
+        int found = 0;
+        while (*p && found < count)
+        {
+            if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.')
+            {
+                char* end;
+                values[found++] = strtof(p, &end);
+                if (end == p)
+                    ++p;
+                else
+                    p = end;
+            }
+            else
+            {
+                ++p;
+            }
+        }
+        for (int i = found; i < count; ++i)
+        {
+            values[i] = 0;
+        }
+        return found;
+    }
+
+    Rect parseRect(const std::string& string)
+    {
+        float values[4];
+        parseFloats(string, values, 4);
+        return Rect(values[0], values[1], values[2], values[3]);
+    }
+
+    Vec2 parseVec2(const std::string& string)
+    {
+        float values[2];
+        parseFloats(string, values, 2);
+        return Vec2(values[0], values[1]);
+    }
+
+    Size parseSize(const std::string& string)
+    {
+        float values[2];
+        parseFloats(string, values, 2);
+        return Size(values[0], values[1]);
+    }
+
+    // reads a list of space separated integers
+    void parseIntegers(const std::string& string, std::vector<int>& values)
+    {
+        values.clear();
+        const char* p = string.c_str();
+        while (*p)
+        {
+            char* end;
+            long value = strtol(p, &end, 10);
+            if (end == p)
+            {
+                ++p;
+                continue;
+            }
+            values.push_back((int)value);
+            p = end;
+        }
+    }
+
+    // like Value::asBool for strings
+    bool parseBool(const std::string& string)
+    {
+        return string != "0" && string != "false";
+    }
+
+    /* Builds a SpriteSheet from the events of a plist parser.
+     * The fields of each frame are kept as they are in the plist, because the format of the
+     * sheet is in the metadata, which usually follows the frames. They are converted by finish().
+     */
+    class SheetBuilder : public PlistParser::Handler
+    {
+    public:
+        explicit SheetBuilder(SpriteSheet* sheet)
+        : _sheet(sheet)
+        , _format(0)
+        {
+            _contexts.push_back(Context::ROOT);
+        }
+
+        bool beginDict() override
+        {
+            Context context = Context::OTHER;
+            switch (_contexts.back())
+            {
+                case Context::ROOT:
+                    context = Context::TOP;
+                    break;
+                case Context::TOP:
+                    if (_key == "frames")
+                        context = Context::FRAMES;
+                    else if (_key == "metadata")
+                        context = Context::METADATA;
+                    break;
+                case Context::FRAMES:
+                    context = Context::FRAME;
+                    _frames.push_back(RawFrame());
+                    _frames.back().frame.name = _key;
+                    break;
+                default:
+                    break;
+            }
+            _contexts.push_back(context);
+            _key.clear();
+            return true;
+        }
+
+        bool endDict() override
+        {
+            _contexts.pop_back();
+            _key.clear();
+            return true;
+        }
+
+        bool beginArray() override
+        {
+            _contexts.push_back(_contexts.back() == Context::FRAME && _key == "aliases" ? Context::ALIASES : Context::OTHER);
+            _key.clear();
+            return true;
+        }
+
+        bool endArray() override
+        {
+            _contexts.pop_back();
+            _key.clear();
+            return true;
+        }
+
+        bool key(const char* text, size_t size, bool /*persistent*/) override
+        {
+            _key.assign(text, size);
+            return true;
+        }
+
+        bool string(const char* text, size_t size, bool /*persistent*/) override
+        {
+            std::string value(text, size);
+            switch (_contexts.back())
+            {
+                case Context::FRAME:
+                    setFrameString(_frames.back(), value);
+                    break;
+                case Context::ALIASES:
+                    _frames.back().frame.aliases.push_back(std::move(value));
+                    break;
+                case Context::METADATA:
+                    if (_key == "format")
+                        _format = atoi(value.c_str());
+                    else if (_key == "size")
+                        _sheet->textureSize = parseSize(value);
+                    else if (_key == "textureFileName")
+                        _sheet->textureFileName = std::move(value);
+                    else if (_key == "pixelFormat")
+                        _sheet->pixelFormat = std::move(value);
+                    break;
+                default:
+                    break;
+            }
+            _key.clear();
+            return true;
+        }
+
+        bool integer(int64_t value) override
+        {
+            return real((double)value);
+        }
+
+        bool real(double value) override
+        {
+            if (_contexts.back() == Context::FRAME)
+                setFrameNumber(_frames.back(), value);
+            else if (_contexts.back() == Context::METADATA && _key == "format")
+                _format = (int)value;
+            _key.clear();
+            return true;
+        }
+
+        bool boolean(bool value) override
+        {
+            if (_contexts.back() == Context::FRAME)
+                setFrameNumber(_frames.back(), value ? 1 : 0);
+            _key.clear();
+            return true;
+        }
+
+        // dates and data are not used by sprite sheets
+        bool unsupported() override
+        {
+            _key.clear();
+            return true;
+        }
+
+        // converts the frames, see SpriteFrameCache::addSpriteFramesWithDictionary for the formats
+        void finish()
+        {
+            CCASSERT(_format >= 0 && _format <= 3, "format is not supported for SpriteFrameCache addSpriteFramesWithDictionary:textureFilename:");
+
+            _sheet->frames.reserve(_frames.size());
+            for (auto& raw : _frames)
+            {
+                SpriteSheetFrame& frame = raw.frame;
+                if (_format == 0)
+                {
+                    if (!raw.originalWidth || !raw.originalHeight)
+                    {
+                        CCLOGWARN("cocos2d: WARNING: originalWidth/Height not found on the SpriteFrame. AnchorPoint won't work as expected. Regenerate the .plist");
+                    }
+                    frame.rect = Rect(raw.x, raw.y, raw.width, raw.height);
+                    frame.rotated = false;
+                    frame.offset = Vec2(raw.offsetX, raw.offsetY);
+                    frame.sourceSize = Size((float)std::abs(raw.originalWidth), (float)std::abs(raw.originalHeight));
+                }
+                else if (_format == 1 || _format == 2)
+                {
+                    frame.rect = raw.frameRect;
+                    frame.rotated = _format == 2 && raw.rotated;
+                    frame.offset = raw.offset;
+                    frame.sourceSize = raw.sourceSize;
+                }
+                else if (_format == 3)
+                {
+                    frame.rect = Rect(raw.textureRect.origin.x, raw.textureRect.origin.y, raw.spriteSize.width, raw.spriteSize.height);
+                    frame.rotated = raw.textureRotated;
+                    frame.offset = raw.spriteOffset;
+                    frame.sourceSize = raw.spriteSourceSize;
+                }
+                else
+                {
+                    continue;
+                }
+
+                if (_format != 3)
+                {
+                    // aliases, polygons and anchors only exist in format 3
+                    frame.aliases.clear();
+                    frame.vertices.clear();
+                    frame.verticesUV.clear();
+                    frame.triangles.clear();
+                    frame.hasAnchor = false;
+                }
+                _sheet->frames.push_back(std::move(frame));
+            }
+        }
+
+    private:
+        enum class Context
+        {
+            ROOT,
+            TOP,
+            FRAMES,
+            FRAME,
+            METADATA,
+            ALIASES,
+            OTHER
+        };
+
+        struct RawFrame
+        {
+            RawFrame()
+            : x(0), y(0), width(0), height(0), offsetX(0), offsetY(0)
+            , originalWidth(0), originalHeight(0)
+            , rotated(false), textureRotated(false)
+            {}
+
+            SpriteSheetFrame frame;
+            // format 0
+            float x, y, width, height, offsetX, offsetY;
+            int originalWidth, originalHeight;
+            // formats 1 and 2
+            Rect frameRect;
+            Vec2 offset;
+            Size sourceSize;
+            bool rotated;
+            // format 3
+            Size spriteSize;
+            Vec2 spriteOffset;
+            Size spriteSourceSize;
+            Rect textureRect;
+            bool textureRotated;
+        };
+
+        void setFrameString(RawFrame& raw, const std::string& value)
+        {
+            if (_key == "frame")
+                raw.frameRect = parseRect(value);
+            else if (_key == "offset")
+                raw.offset = parseVec2(value);
+            else if (_key == "sourceSize")
+                raw.sourceSize = parseSize(value);
+            else if (_key == "spriteSize")
+                raw.spriteSize = parseSize(value);
+            else if (_key == "spriteOffset")
+                raw.spriteOffset = parseVec2(value);
+            else if (_key == "spriteSourceSize")
+                raw.spriteSourceSize = parseSize(value);
+            else if (_key == "textureRect")
+                raw.textureRect = parseRect(value);
+            else if (_key == "vertices")
+                parseIntegers(value, raw.frame.vertices);
+            else if (_key == "verticesUV")
+                parseIntegers(value, raw.frame.verticesUV);
+            else if (_key == "triangles")
+                parseIntegers(value, raw.frame.triangles);
+            else if (_key == "anchor")
+            {
+                raw.frame.anchor = parseVec2(value);
+                raw.frame.hasAnchor = true;
+            }
+            else if (_key == "rotated" || _key == "textureRotated")
+                setFrameNumber(raw, parseBool(value) ? 1 : 0);
+            else
+                setFrameNumber(raw, atof(value.c_str()));
+        }
+
+        void setFrameNumber(RawFrame& raw, double value)
+        {
+            if (_key == "x")
+                raw.x = (float)value;
+            else if (_key == "y")
+                raw.y = (float)value;
+            else if (_key == "width")
+                raw.width = (float)value;
+            else if (_key == "height")
+                raw.height = (float)value;
+            else if (_key == "offsetX")
+                raw.offsetX = (float)value;
+            else if (_key == "offsetY")
+                raw.offsetY = (float)value;
+            else if (_key == "originalWidth")
+                raw.originalWidth = (int)value;
+            else if (_key == "originalHeight")
+                raw.originalHeight = (int)value;
+            else if (_key == "rotated")
+                raw.rotated = value != 0;
+            else if (_key == "textureRotated")
+                raw.textureRotated = value != 0;
+        }
+
+        SpriteSheet* _sheet;
+        int _format;
+        std::vector<Context> _contexts;
+        std::string _key;
+        std::vector<RawFrame> _frames;
+    };
+
+    void walkValue(const Value& value, SheetBuilder& builder);
+
+    void walkValueMap(const ValueMap& map, SheetBuilder& builder)
+    {
+        builder.beginDict();
+        for (const auto& iter : map)
+        {
+            builder.key(iter.first.data(), iter.first.size(), true);
+            walkValue(iter.second, builder);
+        }
+        builder.endDict();
+    }
+
+    void walkValue(const Value& value, SheetBuilder& builder)
+    {
+        switch (value.getType())
+        {
+            case Value::Type::MAP:
+                walkValueMap(value.asValueMap(), builder);
+                break;
+            case Value::Type::VECTOR:
+                builder.beginArray();
+                for (const auto& item : value.asValueVector())
+                {
+                    walkValue(item, builder);
+                }
+                builder.endArray();
+                break;
+            case Value::Type::STRING:
+                {
+                    std::string string = value.asString();
+                    builder.string(string.data(), string.size(), true);
+                }
+                break;
+            case Value::Type::BOOLEAN:
+                builder.boolean(value.asBool());
+                break;
+            case Value::Type::BYTE:
+            case Value::Type::INTEGER:
+            case Value::Type::UNSIGNED:
+            case Value::Type::FLOAT:
+            case Value::Type::DOUBLE:
+                builder.real(value.asDouble());
+                break;
+            default:
+                builder.unsupported();
+                break;
+        }
+    }
+
+    std::string readString(const unsigned char* strings, const FileString& string)
+    {
+        return std::string(reinterpret_cast<const char*>(strings) + string.offset, string.size);
+    }
+
+    bool isStringValid(const FileString& string, uint32_t stringsSize)
+    {
+        return string.offset <= stringsSize && string.size <= stringsSize - string.offset;
+    }
+
+    bool isRangeValid(uint32_t index, uint32_t count, uint32_t total)
+    {
+        return index <= total && count <= total - index;
+    }
+
+    FileString addString(std::string& strings, const std::string& string)
+    {
+        FileString fileString;
+        fileString.offset = (uint32_t)strings.size();
+        fileString.size = (uint32_t)string.size();
+        strings += string;
+        return fileString;
+    }
+
+    uint32_t addInts(std::vector<int32_t>& ints, const std::vector<int>& values)
+    {
+        uint32_t index = (uint32_t)ints.size();
+        ints.insert(ints.end(), values.begin(), values.end());
+        return index;
+    }
+}
+
+SpriteSheetFrame::SpriteSheetFrame()
+: rotated(false)
+, hasAnchor(false)
+{
+}
+
+bool SpriteSheetReader::read(const unsigned char* data, ssize_t size, SpriteSheet* sheet)
+{
+    if (!data || size <= 0)
+        return false;
+
+    if (size >= (ssize_t)sizeof(COMPACT_SHEET_MAGIC) && memcmp(data, COMPACT_SHEET_MAGIC, sizeof(COMPACT_SHEET_MAGIC)) == 0)
+        return readCompact(data, size, sheet);
+    if (PlistParser::isBinary(data, (size_t)size))
+        return readBinaryPlist(data, size, sheet);
+    return readXMLPlist(data, size, sheet);
+}
+
+bool SpriteSheetReader::readXMLPlist(const unsigned char* data, ssize_t size, SpriteSheet* sheet)
+{
+    *sheet = SpriteSheet();
+    SheetBuilder builder(sheet);
+    if (size < 0 || !PlistParser::parseXML(reinterpret_cast<const char*>(data), (size_t)size, builder))
+    {
+        *sheet = SpriteSheet();
+        return false;
+    }
+    builder.finish();
+    return true;
+}
+
+bool SpriteSheetReader::readBinaryPlist(const unsigned char* data, ssize_t size, SpriteSheet* sheet)
+{
+    *sheet = SpriteSheet();
+    SheetBuilder builder(sheet);
+    if (size < 0 || !PlistParser::parseBinary(data, (size_t)size, builder))
+    {
+        *sheet = SpriteSheet();
+        return false;
+    }
+    builder.finish();
+    return true;
+}
+
+bool SpriteSheetReader::readValueMap(const ValueMap& dictionary, SpriteSheet* sheet)
+{
+    *sheet = SpriteSheet();
+    SheetBuilder builder(sheet);
+    walkValueMap(dictionary, builder);
+    builder.finish();
+    return true;
+}
+
+bool SpriteSheetReader::readCompact(const unsigned char* data, ssize_t size, SpriteSheet* sheet)
+{
+    *sheet = SpriteSheet();
+
+    FileHeader header;
+    if (size < (ssize_t)sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, COMPACT_SHEET_MAGIC, sizeof(header.magic)) != 0 || header.version != COMPACT_SHEET_VERSION)
+        return false;
+
+    uint64_t framesOffset = sizeof(FileHeader);
+    uint64_t aliasesOffset = framesOffset + (uint64_t)header.frameCount * sizeof(FileFrame);
+    uint64_t intsOffset = aliasesOffset + (uint64_t)header.aliasCount * sizeof(FileString);
+    uint64_t stringsOffset = intsOffset + (uint64_t)header.intCount * sizeof(int32_t);
+    if (stringsOffset + header.stringsSize != (uint64_t)size
+        || !isStringValid({ header.textureFileNameOffset, header.textureFileNameSize }, header.stringsSize)
+        || !isStringValid({ header.pixelFormatOffset, header.pixelFormatSize }, header.stringsSize))
+        return false;
+
+    // the sections are 4 byte aligned in the file, but the data may not be
+    std::vector<FileFrame> frames(header.frameCount);
+    std::vector<FileString> aliases(header.aliasCount);
+    std::vector<int32_t> ints(header.intCount);
+    if (header.frameCount)
+        memcpy(frames.data(), data + framesOffset, frames.size() * sizeof(FileFrame));
+    if (header.aliasCount)
+        memcpy(aliases.data(), data + aliasesOffset, aliases.size() * sizeof(FileString));
+    if (header.intCount)
+        memcpy(ints.data(), data + intsOffset, ints.size() * sizeof(int32_t));
+    const unsigned char* strings = data + stringsOffset;
+
+    sheet->textureSize = Size(header.textureWidth, header.textureHeight);
+    sheet->textureFileName = readString(strings, { header.textureFileNameOffset, header.textureFileNameSize });
+    sheet->pixelFormat = readString(strings, { header.pixelFormatOffset, header.pixelFormatSize });
+    sheet->frames.resize(header.frameCount);
+
+    for (uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        const FileFrame& fileFrame = frames[i];
+        SpriteSheetFrame& frame = sheet->frames[i];
+        if (!isStringValid(fileFrame.name, header.stringsSize)
+            || !isRangeValid(fileFrame.aliasIndex, fileFrame.aliasCount, header.aliasCount)
+            || !isRangeValid(fileFrame.verticesIndex, fileFrame.verticesCount, header.intCount)
+            || !isRangeValid(fileFrame.verticesUVIndex, fileFrame.verticesUVCount, header.intCount)
+            || !isRangeValid(fileFrame.trianglesIndex, fileFrame.trianglesCount, header.intCount))
+        {
+            *sheet = SpriteSheet();
+            return false;
+        }
+
+        frame.name = readString(strings, fileFrame.name);
+        frame.rect = Rect(fileFrame.rect[0], fileFrame.rect[1], fileFrame.rect[2], fileFrame.rect[3]);
+        frame.rotated = (fileFrame.flags & FRAME_ROTATED) != 0;
+        frame.offset = Vec2(fileFrame.offset[0], fileFrame.offset[1]);
+        frame.sourceSize = Size(fileFrame.sourceSize[0], fileFrame.sourceSize[1]);
+        frame.hasAnchor = (fileFrame.flags & FRAME_HAS_ANCHOR) != 0;
+        frame.anchor = Vec2(fileFrame.anchor[0], fileFrame.anchor[1]);
+
+        frame.aliases.reserve(fileFrame.aliasCount);
+        for (uint32_t j = 0; j < fileFrame.aliasCount; ++j)
+        {
+            const FileString& alias = aliases[fileFrame.aliasIndex + j];
+            if (!isStringValid(alias, header.stringsSize))
+            {
+                *sheet = SpriteSheet();
+                return false;
+            }
+            frame.aliases.push_back(readString(strings, alias));
+        }
+
+        frame.vertices.assign(ints.begin() + fileFrame.verticesIndex, ints.begin() + fileFrame.verticesIndex + fileFrame.verticesCount);
+        frame.verticesUV.assign(ints.begin() + fileFrame.verticesUVIndex, ints.begin() + fileFrame.verticesUVIndex + fileFrame.verticesUVCount);
+        frame.triangles.assign(ints.begin() + fileFrame.trianglesIndex, ints.begin() + fileFrame.trianglesIndex + fileFrame.trianglesCount);
+    }
+    return true;
+}
+
+bool SpriteSheetReader::write(const SpriteSheet& sheet, const std::string& outputPath)
+{
+    std::vector<FileFrame> frames;
+    std::vector<FileString> aliases;
+    std::vector<int32_t> ints;
+    std::string strings;
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COMPACT_SHEET_MAGIC, sizeof(header.magic));
+    header.version = COMPACT_SHEET_VERSION;
+    header.textureWidth = sheet.textureSize.width;
+    header.textureHeight = sheet.textureSize.height;
+    FileString textureFileName = addString(strings, sheet.textureFileName);
+    header.textureFileNameOffset = textureFileName.offset;
+    header.textureFileNameSize = textureFileName.size;
+    FileString pixelFormat = addString(strings, sheet.pixelFormat);
+    header.pixelFormatOffset = pixelFormat.offset;
+    header.pixelFormatSize = pixelFormat.size;
+
+    frames.reserve(sheet.frames.size());
+    for (const auto& frame : sheet.frames)
+    {
+        FileFrame fileFrame;
+        memset(&fileFrame, 0, sizeof(fileFrame));
+        fileFrame.name = addString(strings, frame.name);
+        fileFrame.rect[0] = frame.rect.origin.x;
+        fileFrame.rect[1] = frame.rect.origin.y;
+        fileFrame.rect[2] = frame.rect.size.width;
+        fileFrame.rect[3] = frame.rect.size.height;
+        fileFrame.offset[0] = frame.offset.x;
+        fileFrame.offset[1] = frame.offset.y;
+        fileFrame.sourceSize[0] = frame.sourceSize.width;
+        fileFrame.sourceSize[1] = frame.sourceSize.height;
+        fileFrame.anchor[0] = frame.anchor.x;
+        fileFrame.anchor[1] = frame.anchor.y;
+        fileFrame.flags = (frame.rotated ? FRAME_ROTATED : 0) | (frame.hasAnchor ? FRAME_HAS_ANCHOR : 0);
+
+        fileFrame.aliasIndex = (uint32_t)aliases.size();
+        fileFrame.aliasCount = (uint32_t)frame.aliases.size();
+        for (const auto& alias : frame.aliases)
+        {
+            aliases.push_back(addString(strings, alias));
+        }
+
+        fileFrame.verticesIndex = addInts(ints, frame.vertices);
+        fileFrame.verticesCount = (uint32_t)frame.vertices.size();
+        fileFrame.verticesUVIndex = addInts(ints, frame.verticesUV);
+        fileFrame.verticesUVCount = (uint32_t)frame.verticesUV.size();
+        fileFrame.trianglesIndex = addInts(ints, frame.triangles);
+        fileFrame.trianglesCount = (uint32_t)frame.triangles.size();
+        frames.push_back(fileFrame);
+    }
+
+    header.frameCount = (uint32_t)frames.size();
+    header.aliasCount = (uint32_t)aliases.size();
+    header.intCount = (uint32_t)ints.size();
+    header.stringsSize = (uint32_t)strings.size();
+
+    size_t fileSize = sizeof(header) + frames.size() * sizeof(FileFrame) + aliases.size() * sizeof(FileString)
+        + ints.size() * sizeof(int32_t) + strings.size();
+    unsigned char* bytes = static_cast<unsigned char*>(malloc(fileSize));
+    if (!bytes)
+        return false;
+
+    unsigned char* p = bytes;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    if (!frames.empty())
+        memcpy(p, frames.data(), frames.size() * sizeof(FileFrame));
+    p += frames.size() * sizeof(FileFrame);
+    if (!aliases.empty())
+        memcpy(p, aliases.data(), aliases.size() * sizeof(FileString));
+    p += aliases.size() * sizeof(FileString);
+    if (!ints.empty())
+        memcpy(p, ints.data(), ints.size() * sizeof(int32_t));
+    p += ints.size() * sizeof(int32_t);
+    memcpy(p, strings.data(), strings.size());
+
+    Data data;
+    data.fastSet(bytes, fileSize);
+    return FileUtils::getInstance()->writeDataToFile(data, outputPath);
+}
+
+bool SpriteSheetReader::convert(const std::string& sheetFile, const std::string& outputPath)
+{
+    Data data = FileUtils::getInstance()->getDataFromFile(sheetFile);
+    SpriteSheet sheet;
+    if (!read(data.getBytes(), data.getSize(), &sheet))
+    {
+        CCLOG("cocos2d: SpriteSheetReader: can not read %s", sheetFile.c_str());
+        return false;
+    }
+    return write(sheet, outputPath);
+}
+
+NS_CC_END
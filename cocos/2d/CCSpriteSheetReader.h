@@ -0,0 +1,106 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_SPRITE_SHEET_READER_H__
+#define __CC_SPRITE_SHEET_READER_H__
+
+#include <string>
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+#include "platform/CCStdC.h"
+#include "math/CCGeometry.h"
+#include "base/CCValue.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** A frame of a sprite sheet, in the form of SpriteFrame whatever the format of the sheet. */
+struct CC_DLL SpriteSheetFrame
+{
+    SpriteSheetFrame();
+
+    std::string name;
+    Rect rect;
+    bool rotated;
+    Vec2 offset;
+    Size sourceSize;
+    std::vector<std::string> aliases;
+    // polygon outline, empty when the frame is a quad
+    std::vector<int> vertices;
+    std::vector<int> verticesUV;
+    std::vector<int> triangles;
+    bool hasAnchor;
+    Vec2 anchor;
+};
+
+/** The frames and metadata of a sprite sheet. */
+struct CC_DLL SpriteSheet
+{
+    Size textureSize;
+    std::string textureFileName;
+    std::string pixelFormat;
+    std::vector<SpriteSheetFrame> frames;
+};
+
+/**
+ * Reads sprite sheets for SpriteFrameCache, without going through a ValueMap.
+ *
+ * Three forms are read:
+ * - XML plists, by a parser which only keeps the keys of sprite sheets.
+ * - Binary plists ("bplist00"), as written by Xcode or plutil.
+ * - The compact form written by write(), whose frames are read without parsing any text.
+ * The compact form is stored in the byte order of the device, a file of another byte order or
+ * another version of the format is not read.
+ * @since v3.15
+ */
+class CC_DLL SpriteSheetReader
+{
+public:
+    /** Reads a sprite sheet in any of the supported forms, returns false if the data is not a sprite sheet. */
+    static bool read(const unsigned char* data, ssize_t size, SpriteSheet* sheet);
+
+    static bool readXMLPlist(const unsigned char* data, ssize_t size, SpriteSheet* sheet);
+    static bool readBinaryPlist(const unsigned char* data, ssize_t size, SpriteSheet* sheet);
+    static bool readCompact(const unsigned char* data, ssize_t size, SpriteSheet* sheet);
+    /** Reads a sprite sheet from a plist already parsed into a ValueMap. */
+    static bool readValueMap(const ValueMap& dictionary, SpriteSheet* sheet);
+
+    /** Writes a sprite sheet in the compact form. */
+    static bool write(const SpriteSheet& sheet, const std::string& outputPath);
+
+    /** Converts a sprite sheet file, e.g. a plist, into the compact form. */
+    static bool convert(const std::string& sheetFile, const std::string& outputPath);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_SPRITE_SHEET_READER_H__
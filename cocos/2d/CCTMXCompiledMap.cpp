@@ -0,0 +1,636 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "2d/CCTMXCompiledMap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <zlib.h>
+
+#include "2d/CCTMXXMLParser.h"
+#include "base/ccMacros.h"
+#include "base/CCData.h"
+#include "base/ccUTF8.h"
+#include "base/CCParallelTaskPool.h"
+#include "platform/CCFileUtils.h"
+#include "xxhash.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char COMPILED_MAP_MAGIC[4] = { 'C', 'C', 'T', 'M' };
+    const uint32_t COMPILED_MAP_VERSION = 1;
+    // replaces the data element of each layer in the map XML
+    const char COMPILED_DATA_ELEMENT[] = "<data encoding=\"compiled\"/>";
+
+    // finds the data elements of the layers in the TMX source, returns the XML without them
+    bool stripLayerData(const std::string& source, std::string& xml, size_t& dataCount)
+    {
+        xml.clear();
+        xml.reserve(source.size() / 4);
+        dataCount = 0;
+
+        size_t pos = 0;
+        size_t found;
+        while ((found = source.find("<data", pos)) != std::string::npos)
+        {
+            size_t nameEnd = found + 5;
+            if (nameEnd >= source.size())
+                return false;
+
+            char next = source[nameEnd];
+            if (next != '>' && next != '/' && next != ' ' && next != '\t' && next != '\r' && next != '\n')
+            {
+                // another element, e.g. <dataset>
+                xml.append(source, pos, nameEnd - pos);
+                pos = nameEnd;
+                continue;
+            }
+
+            size_t tagEnd = source.find('>', nameEnd);
+            if (tagEnd == std::string::npos)
+                return false;
+
+            size_t end = tagEnd + 1;
+            if (source[tagEnd - 1] != '/')
+            {
+                end = source.find("</data>", tagEnd);
+                if (end == std::string::npos)
+                    return false;
+                end += 7;
+            }
+
+            xml.append(source, pos, found - pos);
+            xml += COMPILED_DATA_ELEMENT;
+            pos = end;
+            ++dataCount;
+        }
+        xml.append(source, pos, std::string::npos);
+        return true;
+    }
+}
+
+const int TMXCompiledMap::CHUNK_SIZE = 32;
+
+bool TMXCompiledMap::s_cacheEnabled = false;
+std::string TMXCompiledMap::s_cacheDirectory;
+
+TMXCompiledMap* TMXCompiledMap::open(const std::string& tmxFullPath)
+{
+    if (tmxFullPath.empty())
+        return nullptr;
+
+    auto fileUtils = FileUtils::getInstance();
+    long sourceSize = fileUtils->getFileSize(tmxFullPath);
+    if (sourceSize < 0)
+        return nullptr;
+
+    auto ret = new (std::nothrow) TMXCompiledMap();
+    if (ret == nullptr)
+        return nullptr;
+
+    // a compiled map is used when the size and the hash of its TMX file match, the TMX file is read but not parsed
+    Data source;
+    auto isCompiledFromSource = [&](const std::string& path) {
+        if (!ret->mapFile(path))
+            return false;
+
+        FileHeader header;
+        memcpy(&header, ret->_fileData, sizeof(header));
+        if (header.sourceSize == (uint32_t)sourceSize)
+        {
+            if (source.isNull())
+                source = fileUtils->getDataFromFile(tmxFullPath);
+            if (!source.isNull() && XXH32(source.getBytes(), (int)source.getSize(), 0) == header.sourceHash)
+                return true;
+        }
+        CCLOG("TMXCompiledMap: ignoring outdated compiled map %s", path.c_str());
+        ret->unmapFile();
+        return false;
+    };
+
+    // a compiled map shipped next to the TMX file, then the cached one
+    auto shippedPath = tmxFullPath + "c";
+    auto cachePath = s_cacheEnabled ? getCachePath(tmxFullPath) : std::string();
+    if ((fileUtils->isFileExist(shippedPath) && isCompiledFromSource(shippedPath))
+        || (!cachePath.empty() && fileUtils->isFileExist(cachePath) && isCompiledFromSource(cachePath)))
+    {
+        ret->autorelease();
+        return ret;
+    }
+
+    delete ret;
+    return nullptr;
+}
+
+bool TMXCompiledMap::compile(const std::string& tmxFile, const std::string& outputPath)
+{
+    auto fileUtils = FileUtils::getInstance();
+    auto fullPath = fileUtils->fullPathForFilename(tmxFile);
+    std::string source = fileUtils->getStringFromFile(fullPath);
+    if (source.empty())
+    {
+        CCLOG("TMXCompiledMap: can't read %s", tmxFile.c_str());
+        return false;
+    }
+
+    // the map is parsed from its XML so that the compiled maps are not used
+    auto slash = fullPath.find_last_of('/');
+    auto resourcePath = slash != std::string::npos ? fullPath.substr(0, slash) : std::string();
+    auto mapInfo = TMXMapInfo::createWithXML(source, resourcePath);
+    if (mapInfo == nullptr)
+    {
+        CCLOG("TMXCompiledMap: can't parse %s", tmxFile.c_str());
+        return false;
+    }
+    return write(source, mapInfo, outputPath);
+}
+
+bool TMXCompiledMap::write(const std::string& source, TMXMapInfo* mapInfo, const std::string& outputPath)
+{
+    auto& layers = mapInfo->getLayers();
+    std::string xml;
+    size_t dataCount = 0;
+    if (!stripLayerData(source, xml, dataCount) || dataCount != (size_t)layers.size())
+    {
+        CCLOG("TMXCompiledMap: the layers of the map can't be compiled");
+        return false;
+    }
+
+    // one job per chunk of every layer
+    struct ChunkJob
+    {
+        int layer;
+        int chunkX;
+        int chunkY;
+        uint32_t maxGID;
+        std::vector<unsigned char> compressed;
+    };
+    std::vector<ChunkJob> jobs;
+    std::vector<FileLayer> fileLayers(layers.size());
+    for (ssize_t i = 0; i < layers.size(); ++i)
+    {
+        auto layer = layers.at(i);
+        if (layer->_tiles == nullptr)
+        {
+            CCLOG("TMXCompiledMap: layer %s has no tiles", layer->_name.c_str());
+            return false;
+        }
+
+        auto& fileLayer = fileLayers[i];
+        fileLayer.width = (uint32_t)layer->_layerSize.width;
+        fileLayer.height = (uint32_t)layer->_layerSize.height;
+        fileLayer.maxGID = 0;
+        fileLayer.chunkTableOffset = 0;
+        int chunksWide = ((int)fileLayer.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        int chunksHigh = ((int)fileLayer.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        for (int chunkY = 0; chunkY < chunksHigh; ++chunkY)
+        {
+            for (int chunkX = 0; chunkX < chunksWide; ++chunkX)
+            {
+                ChunkJob job;
+                job.layer = (int)i;
+                job.chunkX = chunkX;
+                job.chunkY = chunkY;
+                job.maxGID = 0;
+                jobs.push_back(std::move(job));
+            }
+        }
+    }
+
+    std::atomic<bool> failed(false);
+    ParallelTaskPool::getInstance()->parallelFor((int)jobs.size(), 4, [&](int begin, int end) {
+        std::vector<uint32_t> tiles(CHUNK_SIZE * CHUNK_SIZE);
+        for (int j = begin; j < end; ++j)
+        {
+            auto& job = jobs[j];
+            auto layer = layers.at(job.layer);
+            int width = (int)fileLayers[job.layer].width;
+            int height = (int)fileLayers[job.layer].height;
+            int xBegin = job.chunkX * CHUNK_SIZE;
+            int yBegin = job.chunkY * CHUNK_SIZE;
+            int columns = std::min(CHUNK_SIZE, width - xBegin);
+            int rows = std::min(CHUNK_SIZE, height - yBegin);
+
+            std::fill(tiles.begin(), tiles.end(), 0);
+            bool empty = true;
+            for (int y = 0; y < rows; ++y)
+            {
+                const uint32_t* row = layer->_tiles + (yBegin + y) * width + xBegin;
+                for (int x = 0; x < columns; ++x)
+                {
+                    uint32_t gid = row[x];
+                    tiles[x + y * CHUNK_SIZE] = gid;
+                    if (gid != 0)
+                    {
+                        empty = false;
+                        job.maxGID = std::max(job.maxGID, gid & kTMXFlippedMask);
+                    }
+                }
+            }
+            if (empty)
+                continue;
+
+            uLongf size = compressBound(CHUNK_SIZE * CHUNK_SIZE * sizeof(uint32_t));
+            job.compressed.resize(size);
+            if (compress2(job.compressed.data(), &size, (const Bytef*)tiles.data(), CHUNK_SIZE * CHUNK_SIZE * sizeof(uint32_t), Z_DEFAULT_COMPRESSION) != Z_OK)
+            {
+                failed = true;
+                continue;
+            }
+            job.compressed.resize(size);
+        }
+    });
+    if (failed)
+    {
+        CCLOG("TMXCompiledMap: can't compress the tiles");
+        return false;
+    }
+
+    // header, layer table, chunk tables, XML, chunks
+    size_t offset = sizeof(FileHeader) + fileLayers.size() * sizeof(FileLayer);
+    size_t jobIndex = 0;
+    for (auto& fileLayer : fileLayers)
+    {
+        int chunksWide = ((int)fileLayer.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        int chunksHigh = ((int)fileLayer.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        fileLayer.chunkTableOffset = (uint32_t)offset;
+        offset += chunksWide * chunksHigh * sizeof(FileChunk);
+        for (int c = 0; c < chunksWide * chunksHigh; ++c)
+        {
+            fileLayer.maxGID = std::max(fileLayer.maxGID, jobs[jobIndex++].maxGID);
+        }
+    }
+
+    FileHeader header;
+    memcpy(header.magic, COMPILED_MAP_MAGIC, sizeof(header.magic));
+    header.version = COMPILED_MAP_VERSION;
+    header.sourceSize = (uint32_t)source.size();
+    header.sourceHash = XXH32(source.data(), (int)source.size(), 0);
+    header.chunkSize = CHUNK_SIZE;
+    header.xmlOffset = (uint32_t)offset;
+    header.xmlSize = (uint32_t)xml.size();
+    header.layerCount = (uint32_t)fileLayers.size();
+    header.layerTableOffset = sizeof(FileHeader);
+
+    std::vector<unsigned char> buffer;
+    buffer.reserve(offset + xml.size());
+    buffer.insert(buffer.end(), (const unsigned char*)&header, (const unsigned char*)(&header + 1));
+    buffer.insert(buffer.end(), (const unsigned char*)fileLayers.data(), (const unsigned char*)(fileLayers.data() + fileLayers.size()));
+
+    size_t chunkOffset = offset + xml.size();
+    for (auto& job : jobs)
+    {
+        FileChunk chunk;
+        chunk.offset = job.compressed.empty() ? 0 : (uint32_t)chunkOffset;
+        chunk.size = (uint32_t)job.compressed.size();
+        chunkOffset += job.compressed.size();
+        buffer.insert(buffer.end(), (const unsigned char*)&chunk, (const unsigned char*)(&chunk + 1));
+    }
+    buffer.insert(buffer.end(), xml.begin(), xml.end());
+    for (auto& job : jobs)
+    {
+        buffer.insert(buffer.end(), job.compressed.begin(), job.compressed.end());
+    }
+
+    auto fileUtils = FileUtils::getInstance();
+    auto slash = outputPath.find_last_of('/');
+    if (slash != std::string::npos)
+    {
+        auto directory = outputPath.substr(0, slash + 1);
+        if (!fileUtils->isDirectoryExist(directory) && !fileUtils->createDirectory(directory))
+        {
+            CCLOG("TMXCompiledMap: can't create directory %s", directory.c_str());
+            return false;
+        }
+    }
+
+    Data data;
+    data.fastSet(buffer.data(), buffer.size());
+    auto tempPath = outputPath + ".tmp";
+    bool written = fileUtils->writeDataToFile(data, tempPath) && fileUtils->renameFile(tempPath, outputPath);
+    // the buffer is owned by the vector
+    data.takeBuffer(nullptr);
+
+    if (!written)
+    {
+        CCLOG("TMXCompiledMap: can't write %s", outputPath.c_str());
+        fileUtils->removeFile(tempPath);
+        return false;
+    }
+    return true;
+}
+
+void TMXCompiledMap::setCacheDirectory(const std::string& directory)
+{
+    s_cacheDirectory = directory;
+    if (!s_cacheDirectory.empty() && s_cacheDirectory.back() != '/')
+    {
+        s_cacheDirectory += '/';
+    }
+}
+
+const std::string& TMXCompiledMap::getCacheDirectory()
+{
+    if (s_cacheDirectory.empty())
+    {
+        auto writablePath = FileUtils::getInstance()->getWritablePath();
+        if (!writablePath.empty())
+        {
+            setCacheDirectory(writablePath + "tmxcache/");
+        }
+    }
+    return s_cacheDirectory;
+}
+
+std::string TMXCompiledMap::getCachePath(const std::string& tmxFullPath)
+{
+    auto& directory = getCacheDirectory();
+    if (directory.empty())
+        return "";
+
+    return StringUtils::format("%s%08x_%x.tmxc", directory.c_str(),
+        XXH32(tmxFullPath.data(), (int)tmxFullPath.size(), 0), (unsigned int)tmxFullPath.size());
+}
+
+TMXCompiledMap::TMXCompiledMap()
+: _fileData(nullptr)
+, _fileSize(0)
+, _mapping(nullptr)
+, _fileRead(false)
+, _layerCount(0)
+{
+}
+
+TMXCompiledMap::~TMXCompiledMap()
+{
+    unmapFile();
+}
+
+bool TMXCompiledMap::mapFile(const std::string& path)
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    std::u16string widePath;
+    if (StringUtils::UTF8ToUTF16(path, widePath))
+    {
+        HANDLE file = CreateFileW((LPCWSTR)widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER size;
+            HANDLE mapping = nullptr;
+            if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            {
+                mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            }
+            CloseHandle(file);
+            if (mapping != nullptr)
+            {
+                _fileData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (_fileData != nullptr)
+                {
+                    _fileSize = (size_t)size.QuadPart;
+                    _mapping = mapping;
+                }
+                else
+                {
+                    CloseHandle(mapping);
+                }
+            }
+        }
+    }
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        void* address = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            address = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (address != MAP_FAILED)
+        {
+            _fileData = (const unsigned char*)address;
+            _fileSize = (size_t)st.st_size;
+        }
+    }
+#endif
+
+    if (_fileData == nullptr)
+    {
+        // no file mapping on WinRT, and the assets of an Android package are not files: the file is read instead
+        auto data = new (std::nothrow) Data(FileUtils::getInstance()->getDataFromFile(path));
+        if (data == nullptr || data->isNull())
+        {
+            delete data;
+            return false;
+        }
+        _fileData = data->getBytes();
+        _fileSize = (size_t)data->getSize();
+        _mapping = data;
+        _fileRead = true;
+    }
+
+    if (!validate())
+    {
+        CCLOG("TMXCompiledMap: ignoring invalid compiled map %s", path.c_str());
+        unmapFile();
+        return false;
+    }
+    return true;
+}
+
+void TMXCompiledMap::unmapFile()
+{
+    if (_fileRead)
+    {
+        delete static_cast<Data*>(_mapping);
+    }
+    else if (_fileData)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        UnmapViewOfFile(_fileData);
+        CloseHandle((HANDLE)_mapping);
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+        munmap((void*)_fileData, _fileSize);
+#endif
+    }
+    _fileData = nullptr;
+    _fileSize = 0;
+    _mapping = nullptr;
+    _fileRead = false;
+    _layerCount = 0;
+}
+
+bool TMXCompiledMap::validate()
+{
+    if (_fileSize < sizeof(FileHeader))
+        return false;
+
+    FileHeader header;
+    memcpy(&header, _fileData, sizeof(header));
+    if (memcmp(header.magic, COMPILED_MAP_MAGIC, sizeof(header.magic)) != 0
+        || header.version != COMPILED_MAP_VERSION
+        || header.chunkSize != (uint32_t)CHUNK_SIZE
+        || header.xmlOffset > _fileSize || header.xmlSize > _fileSize - header.xmlOffset
+        || header.layerTableOffset % sizeof(uint32_t) != 0 || header.layerTableOffset > _fileSize
+        || header.layerCount > (_fileSize - header.layerTableOffset) / sizeof(FileLayer))
+    {
+        return false;
+    }
+
+    // the tables are at 4 bytes aligned offsets of a page aligned mapping
+    auto fileLayers = reinterpret_cast<const FileLayer*>(_fileData + header.layerTableOffset);
+    for (uint32_t i = 0; i < header.layerCount; ++i)
+    {
+        auto& fileLayer = fileLayers[i];
+        size_t chunkCount = (size_t)((fileLayer.width + CHUNK_SIZE - 1) / CHUNK_SIZE) * ((fileLayer.height + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        if (fileLayer.chunkTableOffset % sizeof(uint32_t) != 0 || fileLayer.chunkTableOffset > _fileSize
+            || chunkCount > (_fileSize - fileLayer.chunkTableOffset) / sizeof(FileChunk))
+        {
+            return false;
+        }
+    }
+    _layerCount = header.layerCount;
+    return true;
+}
+
+std::string TMXCompiledMap::getMapXML() const
+{
+    if (_fileData == nullptr)
+        return "";
+
+    FileHeader header;
+    memcpy(&header, _fileData, sizeof(header));
+    return std::string((const char*)_fileData + header.xmlOffset, header.xmlSize);
+}
+
+const TMXCompiledMap::FileLayer* TMXCompiledMap::getFileLayer(int layer) const
+{
+    if (layer < 0 || layer >= (int)_layerCount)
+        return nullptr;
+
+    FileHeader header;
+    memcpy(&header, _fileData, sizeof(header));
+    return reinterpret_cast<const FileLayer*>(_fileData + header.layerTableOffset) + layer;
+}
+
+Size TMXCompiledMap::getLayerSize(int layer) const
+{
+    auto fileLayer = getFileLayer(layer);
+    return fileLayer ? Size((float)fileLayer->width, (float)fileLayer->height) : Size::ZERO;
+}
+
+uint32_t TMXCompiledMap::getMaxGID(int layer) const
+{
+    auto fileLayer = getFileLayer(layer);
+    return fileLayer ? fileLayer->maxGID : 0;
+}
+
+bool TMXCompiledMap::inflateChunk(const FileLayer* fileLayer, int chunkX, int chunkY, uint32_t* tiles) const
+{
+    int chunksWide = ((int)fileLayer->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int chunksHigh = ((int)fileLayer->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    if (chunkX < 0 || chunkX >= chunksWide || chunkY < 0 || chunkY >= chunksHigh)
+        return false;
+
+    auto& chunk = reinterpret_cast<const FileChunk*>(_fileData + fileLayer->chunkTableOffset)[chunkX + chunkY * chunksWide];
+    if (chunk.size == 0)
+    {
+        memset(tiles, 0, CHUNK_SIZE * CHUNK_SIZE * sizeof(uint32_t));
+        return true;
+    }
+    if (chunk.offset > _fileSize || chunk.size > _fileSize - chunk.offset)
+        return false;
+
+    uLongf size = CHUNK_SIZE * CHUNK_SIZE * sizeof(uint32_t);
+    return uncompress((Bytef*)tiles, &size, _fileData + chunk.offset, chunk.size) == Z_OK
+        && size == CHUNK_SIZE * CHUNK_SIZE * sizeof(uint32_t);
+}
+
+bool TMXCompiledMap::loadChunk(int layer, int chunkX, int chunkY, uint32_t* tiles) const
+{
+    auto fileLayer = getFileLayer(layer);
+    if (fileLayer == nullptr || !inflateChunk(fileLayer, chunkX, chunkY, tiles))
+    {
+        CCLOG("TMXCompiledMap: can't load chunk %d,%d of layer %d", chunkX, chunkY, layer);
+        return false;
+    }
+    return true;
+}
+
+bool TMXCompiledMap::loadTiles(int layer, uint32_t* tiles) const
+{
+    auto fileLayer = getFileLayer(layer);
+    if (fileLayer == nullptr)
+        return false;
+
+    int width = (int)fileLayer->width;
+    int height = (int)fileLayer->height;
+    int chunksWide = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int chunksHigh = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::atomic<bool> failed(false);
+    ParallelTaskPool::getInstance()->parallelFor(chunksWide * chunksHigh, 4, [&](int begin, int end) {
+        std::vector<uint32_t> chunkTiles(CHUNK_SIZE * CHUNK_SIZE);
+        for (int c = begin; c < end; ++c)
+        {
+            int chunkX = c % chunksWide;
+            int chunkY = c / chunksWide;
+            if (!inflateChunk(fileLayer, chunkX, chunkY, chunkTiles.data()))
+            {
+                failed = true;
+                continue;
+            }
+
+            int xBegin = chunkX * CHUNK_SIZE;
+            int yBegin = chunkY * CHUNK_SIZE;
+            int columns = std::min(CHUNK_SIZE, width - xBegin);
+            int rows = std::min(CHUNK_SIZE, height - yBegin);
+            for (int y = 0; y < rows; ++y)
+            {
+                memcpy(tiles + (yBegin + y) * width + xBegin, chunkTiles.data() + y * CHUNK_SIZE, columns * sizeof(uint32_t));
+            }
+        }
+    });
+    if (failed)
+    {
+        CCLOG("TMXCompiledMap: can't load the tiles of layer %d", layer);
+        return false;
+    }
+    return true;
+}
+
+NS_CC_END
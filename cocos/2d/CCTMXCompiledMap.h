@@ -0,0 +1,178 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_TMX_COMPILED_MAP_H__
+#define __CC_TMX_COMPILED_MAP_H__
+
+/// @cond DO_NOT_SHOW
+
+#include <string>
+
+#include "base/CCRef.h"
+#include "math/CCGeometry.h"
+
+NS_CC_BEGIN
+
+class TMXMapInfo;
+
+/**
+ * @addtogroup tilemap_parallax_nodes
+ * @{
+ */
+
+/**
+ * The compiled form of a TMX file, read by TMXMapInfo instead of the TMX file.
+ *
+ * It holds the map XML without the tiles of the layers, and the tiles of each layer
+ * in chunks of CHUNK_SIZE x CHUNK_SIZE tiles compressed separately with zlib.
+ * The file is memory mapped, so a chunk is only read and inflated when it is loaded:
+ * a map can be set up without decoding any tile, and experimental::TMXLayer loads the chunks near the camera.
+ *
+ * The compiled map of a TMX file is looked up first next to it, with a "c" appended to its name (e.g. "map.tmxc"),
+ * which lets a game ship compiled maps made offline by compile(). Those are always used.
+ * When the cache is enabled, it is then looked up in the cache directory, where TMXMapInfo writes it
+ * the first time a TMX file is parsed.
+ * A compiled map is ignored when the size or the hash of its TMX file has changed, or when it was written
+ * in another byte order or another version of the format.
+ *
+ * The cache is disabled by default: writing it compresses every layer and writes the file on the cocos thread,
+ * which makes the first load of each map slower and is wasted for maps that are loaded once, and it uses storage
+ * in the writable path. Games with large maps should rather ship them compiled.
+ * @since v3.15
+ */
+class CC_DLL TMXCompiledMap : public Ref
+{
+public:
+    /** Width and height of a chunk, in tiles. */
+    static const int CHUNK_SIZE;
+
+    /** Opens the compiled map of a TMX file, returns nullptr if there is none or if it is outdated.
+     *
+     * @param tmxFullPath Full path of the TMX file.
+     * @return An autoreleased TMXCompiledMap object.
+     */
+    static TMXCompiledMap* open(const std::string& tmxFullPath);
+
+    /** Compiles a TMX file, e.g. into the path of its file with a "c" appended, to ship it with the TMX file. */
+    static bool compile(const std::string& tmxFile, const std::string& outputPath);
+
+    /** Writes the compiled map of a parsed TMX file.
+     *
+     * @param source Content of the TMX file, its size and hash are stored to detect changes.
+     * @param mapInfo The map parsed from source, its layers must hold their tiles.
+     * @param outputPath Path of the compiled map.
+     */
+    static bool write(const std::string& source, TMXMapInfo* mapInfo, const std::string& outputPath);
+
+    /** Enables the cache of compiled maps written when TMX files are parsed, it is disabled by default.
+     * Shipped compiled maps are used either way.
+     */
+    static void setCacheEnabled(bool enabled) { s_cacheEnabled = enabled; }
+    static bool isCacheEnabled() { return s_cacheEnabled; }
+
+    /** Sets the directory of the cache, the default is "tmxcache/" in the writable path. */
+    static void setCacheDirectory(const std::string& directory);
+    static const std::string& getCacheDirectory();
+
+    /** Returns the path of the compiled map of a TMX file in the cache, or an empty string if there is no writable path. */
+    static std::string getCachePath(const std::string& tmxFullPath);
+
+    virtual ~TMXCompiledMap();
+
+    /** The map XML, where the data element of each layer is replaced by <data encoding="compiled"/>. */
+    std::string getMapXML() const;
+
+    int getLayerCount() const { return (int)_layerCount; }
+    Size getLayerSize(int layer) const;
+    /** The largest GID of a layer, without the flip flags, 0 if the layer has no tile. */
+    uint32_t getMaxGID(int layer) const;
+
+    /** Loads a chunk of a layer into CHUNK_SIZE x CHUNK_SIZE tiles, in rows from the top.
+     * Tiles of the chunk outside of the layer are 0.
+     */
+    bool loadChunk(int layer, int chunkX, int chunkY, uint32_t* tiles) const;
+
+    /** Loads all the tiles of a layer, in the layout of TMXLayerInfo::_tiles. */
+    bool loadTiles(int layer, uint32_t* tiles) const;
+
+protected:
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t sourceSize;
+        uint32_t sourceHash;
+        uint32_t chunkSize;
+        uint32_t xmlOffset;
+        uint32_t xmlSize;
+        uint32_t layerCount;
+        // offset of layerCount FileLayer
+        uint32_t layerTableOffset;
+    };
+
+    struct FileLayer
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t maxGID;
+        // offset of a FileChunk per chunk, in rows from the top
+        uint32_t chunkTableOffset;
+    };
+
+    // size is 0 for chunks without tiles
+    struct FileChunk
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    TMXCompiledMap();
+
+    bool mapFile(const std::string& path);
+    void unmapFile();
+    /** Checks the tables of the file, the chunks are checked when they are loaded. */
+    bool validate();
+    const FileLayer* getFileLayer(int layer) const;
+    bool inflateChunk(const FileLayer* fileLayer, int chunkX, int chunkY, uint32_t* tiles) const;
+
+    // mapped file
+    const unsigned char* _fileData;
+    size_t _fileSize;
+    void* _mapping;
+    // true when the file was read instead of being mapped
+    bool _fileRead;
+
+    uint32_t _layerCount;
+
+    static bool s_cacheEnabled;
+    static std::string s_cacheDirectory;
+};
+
+// end of tilemap_parallax_nodes group
+/// @}
+
+NS_CC_END
+
+/// @endcond
+#endif // __CC_TMX_COMPILED_MAP_H__
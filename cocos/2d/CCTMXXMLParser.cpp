@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include <unordered_map>
 #include <sstream>
 #include "2d/CCTMXTiledMap.h"
+#include "2d/CCTMXCompiledMap.h"
 #include "base/ZipUtils.h"
 #include "base/base64.h"
 #include "base/CCDirector.h"
@@ -44,6 +45,8 @@ TMXLayerInfo::TMXLayerInfo()
 : _name("")
 , _tiles(nullptr)
 , _ownTiles(true)
+, _compiledMap(nullptr)
+, _compiledLayer(-1)
 {
 }
 
@@ -55,6 +58,7 @@ TMXLayerInfo::~TMXLayerInfo()
         free(_tiles);
         _tiles = nullptr;
     }
+    CC_SAFE_RELEASE(_compiledMap);
 }
 
 ValueMap& TMXLayerInfo::getProperties()
@@ -102,10 +106,10 @@ Rect TMXTilesetInfo::getRectForGID(uint32_t gid)
 
 // implementation TMXMapInfo
 
-TMXMapInfo * TMXMapInfo::create(const std::string& tmxFile)
+TMXMapInfo * TMXMapInfo::create(const std::string& tmxFile, bool streamTiles)
 {
     TMXMapInfo *ret = new (std::nothrow) TMXMapInfo();
-    if (ret->initWithTMXFile(tmxFile))
+    if (ret->initWithTMXFile(tmxFile, streamTiles))
     {
         ret->autorelease();
         return ret;
@@ -154,10 +158,93 @@ bool TMXMapInfo::initWithXML(const std::string& tmxString, const std::string& re
     return parseXMLString(tmxString);
 }
 
-bool TMXMapInfo::initWithTMXFile(const std::string& tmxFile)
+bool TMXMapInfo::initWithTMXFile(const std::string& tmxFile, bool streamTiles)
 {
     internalInit(tmxFile, "");
-    return parseXMLFile(_TMXFileName);
+    if (_TMXFileName.empty())
+    {
+        return parseXMLFile(_TMXFileName);
+    }
+
+    auto compiledMap = TMXCompiledMap::open(_TMXFileName);
+    if (compiledMap && initWithCompiledMap(compiledMap, streamTiles))
+    {
+        return true;
+    }
+
+    if (!TMXCompiledMap::isCacheEnabled())
+    {
+        return parseXMLFile(_TMXFileName);
+    }
+
+    std::string source = FileUtils::getInstance()->getStringFromFile(_TMXFileName);
+    if (!parseXMLString(source))
+    {
+        return false;
+    }
+
+    auto cachePath = TMXCompiledMap::getCachePath(_TMXFileName);
+    if (!cachePath.empty())
+    {
+        TMXCompiledMap::write(source, this, cachePath);
+    }
+    return true;
+}
+
+bool TMXMapInfo::initWithCompiledMap(TMXCompiledMap* compiledMap, bool streamTiles)
+{
+    _compiledMap = compiledMap;
+    _compiledLayerIndex = 0;
+    _streamTiles = streamTiles;
+    _compiledMapFailed = false;
+
+    bool parsed = parseXMLString(compiledMap->getMapXML());
+    parsed = parsed && !_compiledMapFailed && _compiledLayerIndex == compiledMap->getLayerCount();
+    _compiledMap = nullptr;
+    if (parsed)
+    {
+        return true;
+    }
+
+    // forget what was parsed, the TMX file is parsed instead
+    CCLOG("cocos2d: TMXFormat: the compiled map of %s can't be read", _TMXFileName.c_str());
+    _layers.clear();
+    _tilesets.clear();
+    _objectGroups.clear();
+    _properties.clear();
+    _tileProperties.clear();
+    internalInit("", "");
+    return false;
+}
+
+void TMXMapInfo::loadCompiledLayer(TMXLayerInfo* layer)
+{
+    int index = _compiledLayerIndex++;
+    if (_compiledMap == nullptr || index >= _compiledMap->getLayerCount()
+        || !_compiledMap->getLayerSize(index).equals(layer->_layerSize))
+    {
+        _compiledMapFailed = true;
+        return;
+    }
+
+    if (_streamTiles)
+    {
+        layer->_compiledMap = _compiledMap;
+        layer->_compiledMap->retain();
+        layer->_compiledLayer = index;
+        return;
+    }
+
+    Size layerSize = layer->_layerSize;
+    int tilesAmount = layerSize.width*layerSize.height;
+    uint32_t *tiles = (uint32_t*) malloc(tilesAmount*sizeof(uint32_t));
+    if (!tiles || !_compiledMap->loadTiles(index, tiles))
+    {
+        free(tiles);
+        _compiledMapFailed = true;
+        return;
+    }
+    layer->_tiles = tiles;
 }
 
 TMXMapInfo::TMXMapInfo()
@@ -174,6 +261,10 @@ TMXMapInfo::TMXMapInfo()
 , _xmlTileIndex(0)
 , _currentFirstGID(-1)
 , _recordFirstGID(true)
+, _compiledMap(nullptr)
+, _compiledLayerIndex(0)
+, _streamTiles(false)
+, _compiledMapFailed(false)
 {
 }
 
@@ -483,6 +574,11 @@ void TMXMapInfo::startElement(void* /*ctx*/, const char *name, const char **atts
             tmxMapInfo->setLayerAttribs(layerAttribs | TMXLayerAttribCSV);
             tmxMapInfo->setStoringCharacters(true);
         }
+        else if (encoding == "compiled")
+        {
+            // the XML of a compiled map, the tiles are in the compiled map
+            loadCompiledLayer(tmxMapInfo->getLayers().back());
+        }
     }
     else if (elementName == "object")
     {
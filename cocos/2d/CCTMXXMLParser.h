@@ -43,6 +43,7 @@ NS_CC_BEGIN
 
 class TMXLayerInfo;
 class TMXTilesetInfo;
+class TMXCompiledMap;
 
 /** @file
 * Internal TMX parser
@@ -116,6 +117,9 @@ public:
     unsigned char       _opacity;
     bool                _ownTiles;
     Vec2               _offset;
+    // when the tiles are streamed, _tiles is nullptr and they are loaded from this layer of the compiled map
+    TMXCompiledMap      *_compiledMap;
+    int                 _compiledLayer;
 };
 
 /** @brief TMXTilesetInfo contains the information about the tilesets like:
@@ -172,8 +176,11 @@ This information is obtained from the TMX file.
 class CC_DLL TMXMapInfo : public Ref, public SAXDelegator
 {    
 public:    
-    /** creates a TMX Format with a tmx file */
-    static TMXMapInfo * create(const std::string& tmxFile);
+    /** creates a TMX Format with a tmx file
+     * When streamTiles is true and the map is read from its compiled form, the tiles of the layers
+     * are not loaded: TMXLayerInfo::_tiles is nullptr, and the tiles are loaded from TMXLayerInfo::_compiledMap.
+     */
+    static TMXMapInfo * create(const std::string& tmxFile, bool streamTiles = false);
     /** creates a TMX Format with an XML string and a TMX resource path */
     static TMXMapInfo * createWithXML(const std::string& tmxString, const std::string& resourcePath);
     
@@ -191,8 +198,8 @@ public:
      */
     virtual ~TMXMapInfo();
     
-    /** initializes a TMX format with a  tmx file */
-    bool initWithTMXFile(const std::string& tmxFile);
+    /** initializes a TMX format with a  tmx file, from its compiled form when it has one, see TMXCompiledMap */
+    bool initWithTMXFile(const std::string& tmxFile, bool streamTiles = false);
     /** initializes a TMX format with an XML string and a TMX resource path */
     bool initWithXML(const std::string& tmxString, const std::string& resourcePath);
     /** initializes parsing of an XML file, either a tmx (Map) file or tsx (Tileset) file */
@@ -299,6 +306,8 @@ public:
 
 protected:
     void internalInit(const std::string& tmxFileName, const std::string& resourcePath);
+    bool initWithCompiledMap(TMXCompiledMap* compiledMap, bool streamTiles);
+    void loadCompiledLayer(TMXLayerInfo* layer);
 
     /// map orientation
     int    _orientation;
@@ -342,6 +351,11 @@ protected:
     int _currentFirstGID;
     bool _recordFirstGID;
     std::string _externalTilesetFilename;
+    //! compiled map being parsed
+    TMXCompiledMap* _compiledMap;
+    int _compiledLayerIndex;
+    bool _streamTiles;
+    bool _compiledMapFailed;
 };
 
 // end of tilemap_parallax_nodes group
@@ -52,8 +52,10 @@ Configuration::Configuration()
 , _supportsOESDepth24(false)
 , _supportsOESPackedDepthStencil(false)
 , _supportsOESMapBuffer(false)
+, _supportsFloatTexture(false)
 , _maxSamplesAllowed(0)
 , _maxTextureUnits(0)
+, _maxVertexTextureUnits(0)
 , _glExtensions(nullptr)
 , _maxDirLightInShader(1)
 , _maxPointLightInShader(1)
@@ -124,6 +126,9 @@ void Configuration::gatherGPUInfo()
     glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &_maxTextureUnits);
 	_valueDict["gl.max_texture_units"] = Value((int)_maxTextureUnits);
 
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &_maxVertexTextureUnits);
+    _valueDict["gl.max_vertex_texture_units"] = Value((int)_maxVertexTextureUnits);
+
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     glGetIntegerv(GL_MAX_SAMPLES_APPLE, &_maxSamplesAllowed);
 	_valueDict["gl.max_samples_allowed"] = Value((int)_maxSamplesAllowed);
@@ -163,6 +168,13 @@ void Configuration::gatherGPUInfo()
     _supportsOESPackedDepthStencil = checkForGLExtension("GL_OES_packed_depth_stencil");
     _valueDict["gl.supports_OES_packed_depth_stencil"] = Value(_supportsOESPackedDepthStencil);
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32 || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+    _supportsFloatTexture = true;
+#else
+    _supportsFloatTexture = checkForGLExtension("GL_OES_texture_float");
+#endif
+    _valueDict["gl.supports_float_texture"] = Value(_supportsFloatTexture);
+
 
     CHECK_GL_ERROR_DEBUG();
 }
@@ -290,6 +302,16 @@ bool Configuration::supportsMapBuffer() const
 #endif
 }
 
+bool Configuration::supportsFloatTexture() const
+{
+    return _supportsFloatTexture;
+}
+
+int Configuration::getMaxVertexTextureUnits() const
+{
+    return _maxVertexTextureUnits;
+}
+
 bool Configuration::supportsOESDepth24() const
 {
     return _supportsOESDepth24;
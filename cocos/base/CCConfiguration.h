@@ -170,6 +170,24 @@ public:
      */
     bool supportsMapBuffer() const;
 
+    /** Whether or not textures with 32 bit float components are supported.
+     *
+     * On Desktop it returns `true`.
+     * On Mobile it checks for the extension `GL_OES_texture_float`.
+     * Rendering into such textures is not guaranteed, check the completeness of the framebuffer.
+     *
+     * @return Is true if supports float textures.
+     * @since v3.15
+     */
+    bool supportsFloatTexture() const;
+
+    /** OpenGL Max texture units readable from a vertex shader.
+     *
+     * @return The OpenGL Max texture units readable from a vertex shader, 0 when vertex texture fetch is not supported.
+     * @since v3.15
+     */
+    int getMaxVertexTextureUnits() const;
+
     
     /** Max support directional light in shader, for Sprite3D.
      *
@@ -260,9 +278,11 @@ protected:
     bool            _supportsOESMapBuffer;
     bool            _supportsOESDepth24;
     bool            _supportsOESPackedDepthStencil;
+    bool            _supportsFloatTexture;
     
     GLint           _maxSamplesAllowed;
     GLint           _maxTextureUnits;
+    GLint           _maxVertexTextureUnits;
     char *          _glExtensions;
     int             _maxDirLightInShader; //max support directional light in shader
     int             _maxPointLightInShader; // max support point light in shader
@@ -79,6 +79,7 @@ void Data::move(Data& other)
     
     _bytes = other._bytes;
     _size = other._size;
+    _owner = std::move(other._owner);
 
     other._bytes = nullptr;
     other._size = 0;
@@ -115,17 +116,41 @@ void Data::fastSet(unsigned char* bytes, const ssize_t size)
 {
     _bytes = bytes;
     _size = size;
+    _owner.reset();
+}
+
+void Data::setView(unsigned char* bytes, const ssize_t size, const std::shared_ptr<void>& owner)
+{
+    clear();
+    _bytes = bytes;
+    _size = size;
+    _owner = owner;
 }
 
 void Data::clear()
 {
-    free(_bytes);
+    if (_owner)
+    {
+        _owner.reset();
+    }
+    else
+    {
+        free(_bytes);
+    }
     _bytes = nullptr;
     _size = 0;
 }
 
 unsigned char* Data::takeBuffer(ssize_t* size)
 {
+    if (_owner)
+    {
+        // the bytes of a view can't be freed by the caller
+        Data copied(*this);
+        clear();
+        return copied.takeBuffer(size);
+    }
+
     auto buffer = getBytes();
     if (size)
         *size = getSize();
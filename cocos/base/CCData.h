@@ -29,6 +29,7 @@
 #include "platform/CCPlatformMacros.h"
 #include <stdint.h> // for ssize_t on android
 #include <string>   // for ssize_t on linux
+#include <memory>
 #include "platform/CCStdC.h" // for ssize_t on window
 
 /**
@@ -108,6 +109,22 @@ public:
      */
     void fastSet(unsigned char* bytes, const ssize_t size);
 
+    /** Sets the data to a view of bytes owned by another object, e.g. a memory mapped file.
+     *  The bytes are not freed by Data, owner keeps them alive as long as the view or one of its moves exists.
+     *  The bytes of a view are read only, they may be shared by other views, e.g. of a read only memory mapped file.
+     *  Copies of the data and takeBuffer() copy the bytes: callers which need to write the bytes must use them.
+     *  @param bytes The read only bytes.
+     *  @param size The size of the bytes.
+     *  @param owner The owner of the bytes.
+     *  @since v3.15
+     */
+    void setView(unsigned char* bytes, const ssize_t size, const std::shared_ptr<void>& owner);
+
+    /** Whether or not the data is a view of bytes owned by another object.
+     *  @since v3.15
+     */
+    bool isView() const { return _owner != nullptr; }
+
     /**
      * Clears data, free buffer and reset data size.
      */
@@ -147,6 +164,8 @@ private:
 private:
     unsigned char* _bytes;
     ssize_t _size;
+    // owner of the bytes of a view
+    std::shared_ptr<void> _owner;
 };
 
 
@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "2d/CCActionManager.h"
 #include "2d/CCFontFNT.h"
 #include "2d/CCFontAtlasCache.h"
+#include "2d/CCParticleSystem.h"
 #include "2d/CCAnimationCache.h"
 #include "2d/CCTransition.h"
 #include "2d/CCFontFreeType.h"
@@ -60,6 +61,8 @@ THE SOFTWARE.
 #include "base/CCAutoreleasePool.h"
 #include "base/CCConfiguration.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCParallelTaskPool.h"
+#include "base/allocator/CCAllocatorStrategyLinear.h"
 #include "platform/CCApplication.h"
 
 #if CC_ENABLE_SCRIPT_BINDING
@@ -152,6 +155,9 @@ bool Director::init(void)
 
     _console = new (std::nothrow) Console;
 
+    // transient per frame memory
+    _frameAllocator = new (std::nothrow) allocator::AllocatorStrategyLinear("cocos2d.x.allocator.frame");
+
     // scheduler
     _scheduler = new (std::nothrow) Scheduler();
     // action manager
@@ -207,6 +213,8 @@ Director::~Director(void)
 
 
     CC_SAFE_RELEASE(_eventDispatcher);
+
+    CC_SAFE_DELETE(_frameAllocator);
     
     Configuration::destroyInstance();
 
@@ -332,6 +340,12 @@ void Director::drawScene()
     {
         calculateMPF();
     }
+
+    // everything allocated for this frame is gone now
+    if (_frameAllocator)
+    {
+        _frameAllocator->reset();
+    }
 }
 
 void Director::calculateDeltaTime()
@@ -997,6 +1011,9 @@ void Director::restart()
 
 void Director::reset()
 {
+    // particle systems updated on worker threads are joined while their listener and the task pool exist
+    ParticleSystem::finishParallelUpdates();
+
 #if CC_ENABLE_GC_FOR_NATIVE_OBJECTS
     auto sEngine = ScriptEngineManager::getInstance()->getScriptEngine();
 #endif // CC_ENABLE_GC_FOR_NATIVE_OBJECTS
@@ -1085,12 +1102,16 @@ void Director::reset()
     SpriteFrameCache::destroyInstance();
     GLProgramCache::destroyInstance();
     GLProgramStateCache::destroyInstance();
-    FileUtils::destroyInstance();
-    AsyncTaskPool::destroyInstance();
     
     // cocos2d-x specific data structures
+    // before FileUtils, which is used to write the values that weren't flushed yet
     UserDefault::destroyInstance();
     
+    FileUtils::destroyInstance();
+    AsyncTaskPool::destroyInstance();
+    // after AsyncTaskPool, whose threads may use it
+    ParallelTaskPool::destroyInstance();
+    
     GL::invalidateStateCache();
 
     RenderState::finalize();
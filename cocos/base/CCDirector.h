@@ -66,6 +66,10 @@ namespace experimental
 {
     class FrameBuffer;
 }
+namespace allocator
+{
+    class AllocatorStrategyLinear;
+}
 
 /**
  * @brief Matrix stack type.
@@ -436,6 +440,16 @@ public:
      */
     Renderer* getRenderer() const { return _renderer; }
 
+    /** Returns the frame allocator associated with this director.
+     * It is a linear arena for transient data that only lives during the current frame,
+     * everything allocated from it is released at once at the end of drawScene().
+     * Use it through allocator::LinearAllocator declared in "base/allocator/CCAllocatorStrategyLinear.h".
+     * It must only be used from the cocos thread.
+     * @since v3.15
+     * @js NA
+     */
+    allocator::AllocatorStrategyLinear* getFrameAllocator() const { return _frameAllocator; }
+
     /** Returns the Console associated with this director.
      * @since v3.0
      * @js NA
@@ -677,6 +691,9 @@ protected:
 
     /* Renderer for the Director */
     Renderer *_renderer;
+
+    /* Per frame linear allocator, reset at the end of every frame */
+    allocator::AllocatorStrategyLinear* _frameAllocator;
     
     /* Default FrameBufferObject*/
     experimental::FrameBuffer* _defaultFBO;
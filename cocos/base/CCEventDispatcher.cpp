@@ -38,6 +38,7 @@
 #include "base/CCDirector.h"
 #include "base/CCEventType.h"
 #include "2d/CCCamera.h"
+#include "base/allocator/CCAllocatorStrategyLinear.h"
 
 #define DUMP_LISTENER_ITEM_PRIORITY_INFO 0
 
@@ -66,6 +67,16 @@ private:
 
 NS_CC_BEGIN
 
+// temporary containers used while dispatching, their storage comes from the frame allocator.
+template <typename T>
+using FrameVector = std::vector<T, allocator::LinearAllocator<T>>;
+
+template <typename T>
+static allocator::LinearAllocator<T> __getFrameAllocator()
+{
+    return allocator::LinearAllocator<T>(Director::getInstance()->getFrameAllocator());
+}
+
 static EventListener::ListenerID __getListenerID(Event* event)
 {
     EventListener::ListenerID ret;
@@ -266,7 +277,7 @@ void EventDispatcher::visitTarget(Node* node, bool isRootNode)
     
     if (isRootNode)
     {
-        std::vector<float> globalZOrders;
+        FrameVector<float> globalZOrders(__getFrameAllocator<float>());
         globalZOrders.reserve(_globalZOrderNodeMap.size());
         
         for (const auto& e : _globalZOrderNodeMap)
@@ -834,7 +845,8 @@ void EventDispatcher::dispatchTouchEventToListeners(EventListenerVector* listene
             // priority == 0, scene graph priority
             
             // first, get all enabled, unPaused and registered listeners
-            std::vector<EventListener*> sceneListeners;
+            FrameVector<EventListener*> sceneListeners(__getFrameAllocator<EventListener*>());
+            sceneListeners.reserve(sceneGraphPriorityListeners->size());
             for (auto& l : *sceneGraphPriorityListeners)
             {
                 if (l->isEnabled() && !l->isPaused() && l->isRegistered())
@@ -845,7 +857,8 @@ void EventDispatcher::dispatchTouchEventToListeners(EventListenerVector* listene
             // second, for all camera call all listeners
             // get a copy of cameras, prevent it's been modified in listener callback
             // if camera's depth is greater, process it earlier
-            auto cameras = scene->getCameras();
+            const auto& sceneCameras = scene->getCameras();
+            FrameVector<Camera*> cameras(sceneCameras.begin(), sceneCameras.end(), __getFrameAllocator<Camera*>());
             for (auto rit = cameras.rbegin(), ritRend = cameras.rend(); rit != ritRend; ++rit)
             {
                 Camera* camera = *rit;
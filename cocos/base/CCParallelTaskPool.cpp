@@ -0,0 +1,206 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCParallelTaskPool.h"
+#include "base/ccMacros.h"
+#include <algorithm>
+
+NS_CC_BEGIN
+
+std::atomic<ParallelTaskPool*> ParallelTaskPool::s_parallelTaskPool(nullptr);
+
+namespace
+{
+    // guards the creation and destruction of the shared instance, which any thread may get
+    std::mutex s_instanceMutex;
+}
+
+ParallelTaskPool::TaskGroup::TaskGroup()
+: _pool(nullptr)
+, _pending(0)
+{
+}
+
+ParallelTaskPool::TaskGroup::~TaskGroup()
+{
+    if (_pool && _pending.load() > 0)
+    {
+        _pool->wait(*this);
+    }
+}
+
+ParallelTaskPool* ParallelTaskPool::getInstance()
+{
+    auto pool = s_parallelTaskPool.load(std::memory_order_acquire);
+    if (pool == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(s_instanceMutex);
+        pool = s_parallelTaskPool.load(std::memory_order_relaxed);
+        if (pool == nullptr)
+        {
+            int threadCount = (int)std::thread::hardware_concurrency() - 1;
+            pool = new (std::nothrow) ParallelTaskPool(threadCount);
+            s_parallelTaskPool.store(pool, std::memory_order_release);
+        }
+    }
+    return pool;
+}
+
+void ParallelTaskPool::destroyInstance()
+{
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    delete s_parallelTaskPool.exchange(nullptr);
+}
+
+ParallelTaskPool::ParallelTaskPool(int threadCount)
+: _stop(false)
+{
+    for (int i = 0; i < threadCount; ++i)
+    {
+        _threads.emplace_back(&ParallelTaskPool::workerLoop, this);
+    }
+}
+
+ParallelTaskPool::~ParallelTaskPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _taskCondition.notify_all();
+    for (auto& thread : _threads)
+    {
+        thread.join();
+    }
+
+    // no thread left, finish whatever is still queued here
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (runOne(lock, nullptr));
+}
+
+void ParallelTaskPool::enqueue(TaskGroup& group, const Task& task)
+{
+    group._pool = this;
+
+    if (_threads.empty())
+    {
+        task();
+        return;
+    }
+
+    ++group._pending;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        Entry entry = { task, &group };
+        _tasks.push_back(std::move(entry));
+    }
+    _taskCondition.notify_one();
+}
+
+void ParallelTaskPool::wait(TaskGroup& group)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (group._pending.load() > 0)
+    {
+        // only tasks of this group are run here, the caller must not be held up by longer ones of other groups
+        if (!runOne(lock, &group))
+        {
+            _doneCondition.wait(lock, [&]{ return group._pending.load() == 0 || findTask(&group) != _tasks.end(); });
+        }
+    }
+}
+
+void ParallelTaskPool::parallelFor(int count, int grain, const std::function<void(int, int)>& func)
+{
+    if (count <= 0)
+        return;
+
+    int chunks = MIN(getThreadCount() + 1, count / MAX(grain, 1));
+    if (chunks <= 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    TaskGroup group;
+    int begin = 0;
+    for (int i = 0; i < chunks; ++i)
+    {
+        int end = (int)((long long)count * (i + 1) / chunks);
+        if (i == chunks - 1)
+        {
+            // the calling thread takes the last range itself
+            func(begin, end);
+        }
+        else
+        {
+            enqueue(group, [&func, begin, end]{ func(begin, end); });
+        }
+        begin = end;
+    }
+    wait(group);
+}
+
+void ParallelTaskPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _taskCondition.wait(lock, [this]{ return _stop || !_tasks.empty(); });
+        if (_stop && _tasks.empty())
+            return;
+        runOne(lock, nullptr);
+    }
+}
+
+std::deque<ParallelTaskPool::Entry>::iterator ParallelTaskPool::findTask(const TaskGroup* group)
+{
+    if (group == nullptr)
+        return _tasks.begin();
+
+    return std::find_if(_tasks.begin(), _tasks.end(), [group](const Entry& entry){ return entry.group == group; });
+}
+
+bool ParallelTaskPool::runOne(std::unique_lock<std::mutex>& lock, const TaskGroup* group)
+{
+    auto it = findTask(group);
+    if (it == _tasks.end())
+        return false;
+
+    Entry entry = std::move(*it);
+    _tasks.erase(it);
+
+    lock.unlock();
+    entry.task();
+    lock.lock();
+
+    // decremented under the lock so that a waiting thread can't miss the notification
+    if (--entry.group->_pending == 0)
+    {
+        _doneCondition.notify_all();
+    }
+    return true;
+}
+
+NS_CC_END
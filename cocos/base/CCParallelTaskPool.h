@@ -0,0 +1,148 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCPARALLEL_TASK_POOL_H_
+#define __CCPARALLEL_TASK_POOL_H_
+
+#include "platform/CCPlatformMacros.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/**
+* @addtogroup base
+* @{
+*/
+NS_CC_BEGIN
+
+/**
+ * @class ParallelTaskPool
+ * @brief A pool of worker threads running short CPU bound tasks in parallel.
+ *
+ * Unlike AsyncTaskPool, tasks have no callback: they are submitted as part of a TaskGroup,
+ * and the submitting thread waits for the group to complete, helping with queued tasks meanwhile.
+ * Tasks must not touch the scene graph, OpenGL or anything else that is only safe on the cocos thread.
+ * @since v3.15
+ * @js NA
+ */
+class CC_DLL ParallelTaskPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief A set of tasks that can be waited for together.
+     */
+    class CC_DLL TaskGroup
+    {
+    public:
+        TaskGroup();
+        /** Waits for any task still running. */
+        ~TaskGroup();
+
+        /** Returns true if every task of the group has finished. */
+        bool isDone() const { return _pending.load() == 0; }
+
+    private:
+        friend class ParallelTaskPool;
+        ParallelTaskPool* _pool;
+        std::atomic<int> _pending;
+    };
+
+    /**
+     * Returns the shared instance of the parallel task pool, it may be called from any thread.
+     * It has one thread per hardware thread, minus the cocos thread.
+     * The director destroys it on reset, after the threads of AsyncTaskPool have exited,
+     * the next call creates a new one.
+     */
+    static ParallelTaskPool* getInstance();
+
+    /**
+     * Destroys the parallel task pool, queued tasks are run before the threads exit.
+     * No other thread may use the pool meanwhile.
+     */
+    static void destroyInstance();
+
+    /**
+     * Enqueues a task in a group.
+     * When the pool has no thread the task is run immediately.
+     *
+     * @param group The group the task belongs to.
+     * @param task The task.
+     */
+    void enqueue(TaskGroup& group, const Task& task);
+
+    /**
+     * Waits until every task of the group has finished.
+     * The calling thread runs queued tasks of the same group while it waits.
+     */
+    void wait(TaskGroup& group);
+
+    /**
+     * Calls func(begin, end) for consecutive ranges covering [0, count) in parallel, and waits for all of them.
+     *
+     * @param count Number of items.
+     * @param grain Minimum number of items of a range.
+     * @param func Function called for each range.
+     */
+    void parallelFor(int count, int grain, const std::function<void(int, int)>& func);
+
+    /** Returns the number of worker threads, the cocos thread not included. */
+    int getThreadCount() const { return (int)_threads.size(); }
+
+CC_CONSTRUCTOR_ACCESS:
+    explicit ParallelTaskPool(int threadCount);
+    ~ParallelTaskPool();
+
+protected:
+    struct Entry
+    {
+        Task task;
+        TaskGroup* group;
+    };
+
+    void workerLoop();
+    // returns the first queued task of the group, or of any group when it is nullptr. _mutex must be locked.
+    std::deque<Entry>::iterator findTask(const TaskGroup* group);
+    // runs a queued task found by findTask, returns false when there is none. _mutex must be locked.
+    bool runOne(std::unique_lock<std::mutex>& lock, const TaskGroup* group);
+
+    std::vector<std::thread> _threads;
+    std::deque<Entry> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _taskCondition;
+    std::condition_variable _doneCondition;
+    bool _stop;
+
+    static std::atomic<ParallelTaskPool*> s_parallelTaskPool;
+};
+
+NS_CC_END
+// end group
+/// @}
+#endif //__CCPARALLEL_TASK_POOL_H_
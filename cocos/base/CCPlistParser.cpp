@@ -0,0 +1,515 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "base/CCPlistParser.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "base/ccUTF8.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char BINARY_PLIST_MAGIC[8] = { 'b', 'p', 'l', 'i', 's', 't', '0', '0' };
+    // deeper plists are rejected rather than overflowing the stack
+    const size_t MAX_DEPTH = 256;
+
+    // a text of the parsed data, which is not null terminated
+    struct Text
+    {
+        Text() : data(""), size(0) {}
+        Text(const char* d, size_t s) : data(d), size(s) {}
+
+        bool operator==(const char* other) const
+        {
+            return strncmp(data, other, size) == 0 && other[size] == '\0';
+        }
+
+        const char* data;
+        size_t size;
+    };
+
+    template <typename T, typename F>
+    T parseNumber(const Text& text, F convert)
+    {
+        char buffer[64];
+        size_t size = std::min(text.size, sizeof(buffer) - 1);
+        memcpy(buffer, text.data, size);
+        buffer[size] = '\0';
+        return (T)convert(buffer);
+    }
+
+    // Parses the elements of an XML plist
+    class XMLParser
+    {
+    public:
+        XMLParser(const char* data, size_t size, PlistParser::Handler& handler)
+        : _p(data)
+        , _end(data + size)
+        , _handler(handler)
+        , _hasTopObject(false)
+        {}
+
+        bool parse()
+        {
+            while (skipTo('<'))
+            {
+                ++_p;
+                if (startsWith("?"))
+                {
+                    if (!skipPast("?>"))
+                        return false;
+                }
+                else if (startsWith("!--"))
+                {
+                    if (!skipPast("-->"))
+                        return false;
+                }
+                else if (startsWith("!"))
+                {
+                    // DOCTYPE
+                    if (!skipPast(">"))
+                        return false;
+                }
+                else if (startsWith("/"))
+                {
+                    ++_p;
+                    Text name = readName();
+                    if (!skipPast(">"))
+                        return false;
+                    if ((name == "dict" || name == "array") && !endContainer(name == "dict"))
+                        return false;
+                }
+                else if (!parseElement())
+                {
+                    return false;
+                }
+            }
+            // every dict and array is closed
+            return _containers.empty() && _hasTopObject;
+        }
+
+    private:
+        bool parseElement()
+        {
+            Text name = readName();
+            const char* tagEnd = static_cast<const char*>(memchr(_p, '>', _end - _p));
+            if (!tagEnd)
+                return false;
+            bool empty = tagEnd > _p && tagEnd[-1] == '/';
+            _p = tagEnd + 1;
+
+            if (name == "dict" || name == "array")
+            {
+                bool dict = name == "dict";
+                if (_containers.size() >= MAX_DEPTH || !beginValue())
+                    return false;
+                _containers.push_back(dict);
+                if (!(dict ? _handler.beginDict() : _handler.beginArray()))
+                    return false;
+                return empty ? endContainer(dict) : true;
+            }
+            if (name == "plist")
+            {
+                return true;
+            }
+            if (name == "true" || name == "false")
+            {
+                return (empty || skipClosingTag()) && beginValue() && _handler.boolean(name == "true");
+            }
+
+            Text text;
+            bool persistent = true;
+            if (!empty && (!readText(text, persistent) || !skipClosingTag()))
+                return false;
+
+            if (name == "key")
+                return _handler.key(text.data, text.size, persistent);
+            if (name == "string")
+                return beginValue() && _handler.string(text.data, text.size, persistent);
+            if (name == "integer")
+                return beginValue() && _handler.integer(parseNumber<int64_t>(text, [](const char* s) { return strtoll(s, nullptr, 10); }));
+            if (name == "real")
+                return beginValue() && _handler.real(parseNumber<double>(text, [](const char* s) { return atof(s); }));
+            // <date> and <data>
+            return _handler.unsupported();
+        }
+
+        // a value outside of the containers is the top object, there is only one
+        bool beginValue()
+        {
+            if (!_containers.empty())
+                return true;
+            if (_hasTopObject)
+                return false;
+            _hasTopObject = true;
+            return true;
+        }
+
+        bool endContainer(bool dict)
+        {
+            if (_containers.empty() || _containers.back() != dict)
+                return false;
+            _containers.pop_back();
+            return dict ? _handler.endDict() : _handler.endArray();
+        }
+
+        bool skipTo(char c)
+        {
+            const char* found = static_cast<const char*>(memchr(_p, c, _end - _p));
+            _p = found ? found : _end;
+            return found != nullptr;
+        }
+
+        bool skipPast(const char* pattern)
+        {
+            size_t length = strlen(pattern);
+            for (; _p + length <= _end; ++_p)
+            {
+                if (memcmp(_p, pattern, length) == 0)
+                {
+                    _p += length;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool startsWith(const char* prefix) const
+        {
+            size_t length = strlen(prefix);
+            return (size_t)(_end - _p) >= length && memcmp(_p, prefix, length) == 0;
+        }
+
+        Text readName()
+        {
+            const char* start = _p;
+            while (_p < _end && *_p != '>' && *_p != '/' && *_p != ' ' && *_p != '\t' && *_p != '\r' && *_p != '\n')
+                ++_p;
+            return Text(start, _p - start);
+        }
+
+        bool skipClosingTag()
+        {
+            return startsWith("</") && skipPast(">");
+        }
+
+        // the text up to the next element, a reference to the data unless it has entities to decode
+        bool readText(Text& text, bool& persistent)
+        {
+            const char* start = _p;
+            if (!skipTo('<'))
+                return false;
+            const char* end = _p;
+            if (!memchr(start, '&', end - start))
+            {
+                text = Text(start, end - start);
+                persistent = true;
+                return true;
+            }
+
+            _decoded.clear();
+            for (const char* p = start; p < end;)
+            {
+                if (*p != '&')
+                {
+                    _decoded += *p++;
+                    continue;
+                }
+                const char* semicolon = static_cast<const char*>(memchr(p, ';', end - p));
+                if (!semicolon)
+                    return false;
+                Text entity(p + 1, semicolon - p - 1);
+                if (entity == "lt")
+                    _decoded += '<';
+                else if (entity == "gt")
+                    _decoded += '>';
+                else if (entity == "amp")
+                    _decoded += '&';
+                else if (entity == "quot")
+                    _decoded += '"';
+                else if (entity == "apos")
+                    _decoded += '\'';
+                else if (entity.size > 1 && entity.data[0] == '#')
+                {
+                    std::string number(entity.data, entity.size);
+                    char32_t code = (char32_t)(number[1] == 'x' ? strtoul(number.c_str() + 2, nullptr, 16) : strtoul(number.c_str() + 1, nullptr, 10));
+                    std::string utf8;
+                    if (!StringUtils::UTF32ToUTF8(std::u32string(1, code), utf8))
+                        return false;
+                    _decoded += utf8;
+                }
+                else
+                    return false;
+                p = semicolon + 1;
+            }
+            text = Text(_decoded.data(), _decoded.size());
+            persistent = false;
+            return true;
+        }
+
+        const char* _p;
+        const char* _end;
+        PlistParser::Handler& _handler;
+        // true for a dict, false for an array, the innermost container at the end
+        std::vector<bool> _containers;
+        bool _hasTopObject;
+        // the last text with entities
+        std::string _decoded;
+    };
+
+    // Walks the objects of a binary plist from the top object
+    class BinaryParser
+    {
+    public:
+        BinaryParser(const unsigned char* data, size_t size, PlistParser::Handler& handler)
+        : _data(data)
+        , _size(size)
+        , _handler(handler)
+        , _offsetSize(0)
+        , _refSize(0)
+        , _objectCount(0)
+        , _offsetTable(0)
+        , _objectsLeft(0)
+        {}
+
+        bool parse()
+        {
+            // the trailer is the last 32 bytes
+            if (_size < sizeof(BINARY_PLIST_MAGIC) + 32)
+                return false;
+            const unsigned char* trailer = _data + _size - 32;
+            _offsetSize = trailer[6];
+            _refSize = trailer[7];
+            _objectCount = readInt(trailer + 8, 8);
+            uint64_t topObject = readInt(trailer + 16, 8);
+            _offsetTable = readInt(trailer + 24, 8);
+
+            if (_offsetSize < 1 || _offsetSize > 8 || _refSize < 1 || _refSize > 8
+                || _objectCount == 0 || topObject >= _objectCount
+                || _offsetTable >= _size || (_size - _offsetTable) / _offsetSize < _objectCount)
+                return false;
+
+            // Objects may be referenced several times, or in a loop. Each object read comes from its own
+            // reference in the file unless containers are shared, so reading more objects than there are
+            // bytes means that a small file is expanded without bound.
+            _objectsLeft = _size;
+            return parseObject(topObject, 0, false);
+        }
+
+    private:
+        static uint64_t readInt(const unsigned char* p, size_t size)
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < size; ++i)
+            {
+                value = (value << 8) | p[i];
+            }
+            return value;
+        }
+
+        bool objectOffset(uint64_t object, uint64_t* offset) const
+        {
+            if (object >= _objectCount)
+                return false;
+            *offset = readInt(_data + _offsetTable + object * _offsetSize, _offsetSize);
+            return *offset < _offsetTable;
+        }
+
+        // reads the count of an array, dict or string, after its marker
+        bool readCount(uint64_t& offset, unsigned int info, uint64_t* count) const
+        {
+            if (info != 0xF)
+            {
+                *count = info;
+                return true;
+            }
+            if (offset >= _offsetTable || (_data[offset] & 0xF0) != 0x10)
+                return false;
+            size_t size = (size_t)1 << (_data[offset] & 0xF);
+            if (size > 8 || offset + 1 + size > _offsetTable)
+                return false;
+            *count = readInt(_data + offset + 1, size);
+            offset += 1 + size;
+            return true;
+        }
+
+        bool parseObject(uint64_t object, size_t depth, bool isKey)
+        {
+            uint64_t offset;
+            if (depth > MAX_DEPTH || _objectsLeft == 0 || !objectOffset(object, &offset))
+                return false;
+            --_objectsLeft;
+
+            unsigned char marker = _data[offset++];
+            unsigned int type = marker >> 4;
+            unsigned int info = marker & 0xF;
+            // the keys of a dict are strings
+            if (isKey && type != 0x5 && type != 0x6)
+                return false;
+
+            switch (type)
+            {
+                case 0x0:
+                    if (info == 0x8 || info == 0x9)
+                        return _handler.boolean(info == 0x9);
+                    // null
+                    return depth > 0 && _handler.unsupported();
+                case 0x1:
+                {
+                    size_t size = (size_t)1 << info;
+                    if (offset + size > _offsetTable)
+                        return false;
+                    // 16 byte integers keep their value in the low 8 bytes
+                    uint64_t value = size > 8 ? readInt(_data + offset + size - 8, 8) : readInt(_data + offset, size);
+                    return _handler.integer((int64_t)value);
+                }
+                case 0x2:
+                {
+                    size_t size = (size_t)1 << info;
+                    if ((size != 4 && size != 8) || offset + size > _offsetTable)
+                        return false;
+                    uint64_t bits = readInt(_data + offset, size);
+                    if (size == 4)
+                    {
+                        uint32_t bits32 = (uint32_t)bits;
+                        float value;
+                        memcpy(&value, &bits32, sizeof(value));
+                        return _handler.real(value);
+                    }
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    return _handler.real(value);
+                }
+                case 0x5:
+                case 0x6:
+                {
+                    uint64_t count;
+                    if (!readCount(offset, info, &count))
+                        return false;
+                    // the count is checked before it is doubled, a huge count would overflow
+                    if (count > (type == 0x5 ? _offsetTable - offset : (_offsetTable - offset) / 2))
+                        return false;
+                    if (type == 0x5)
+                    {
+                        // ASCII, a reference to the data
+                        const char* text = reinterpret_cast<const char*>(_data + offset);
+                        return isKey ? _handler.key(text, (size_t)count, true) : _handler.string(text, (size_t)count, true);
+                    }
+                    // big endian UTF-16
+                    std::u16string utf16((size_t)count, u'\0');
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        utf16[i] = (char16_t)((_data[offset + i * 2] << 8) | _data[offset + i * 2 + 1]);
+                    }
+                    std::string utf8;
+                    if (!StringUtils::UTF16ToUTF8(utf16, utf8))
+                        return false;
+                    return isKey ? _handler.key(utf8.data(), utf8.size(), false) : _handler.string(utf8.data(), utf8.size(), false);
+                }
+                case 0xA:
+                case 0xD:
+                {
+                    uint64_t count;
+                    if (!readCount(offset, info, &count))
+                        return false;
+                    // a dict has a key and a value reference per entry, the count is checked before it is doubled
+                    uint64_t maxRefCount = (_offsetTable - offset) / _refSize;
+                    if (count > (type == 0xD ? maxRefCount / 2 : maxRefCount))
+                        return false;
+
+                    const unsigned char* refs = _data + offset;
+                    if (type == 0xA)
+                    {
+                        if (!_handler.beginArray())
+                            return false;
+                        for (uint64_t i = 0; i < count; ++i)
+                        {
+                            if (!parseObject(readInt(refs + i * _refSize, _refSize), depth + 1, false))
+                                return false;
+                        }
+                        return _handler.endArray();
+                    }
+
+                    if (!_handler.beginDict())
+                        return false;
+                    for (uint64_t i = 0; i < count; ++i)
+                    {
+                        if (!parseObject(readInt(refs + i * _refSize, _refSize), depth + 1, true)
+                            || !parseObject(readInt(refs + (count + i) * _refSize, _refSize), depth + 1, false))
+                            return false;
+                    }
+                    return _handler.endDict();
+                }
+                default:
+                    // dates, data and uids, the top object has to be read
+                    return depth > 0 && _handler.unsupported();
+            }
+        }
+
+        const unsigned char* _data;
+        size_t _size;
+        PlistParser::Handler& _handler;
+        size_t _offsetSize;
+        size_t _refSize;
+        uint64_t _objectCount;
+        uint64_t _offsetTable;
+        uint64_t _objectsLeft;
+    };
+}
+
+bool PlistParser::isBinary(const unsigned char* data, size_t size)
+{
+    return data && size >= sizeof(BINARY_PLIST_MAGIC) && memcmp(data, BINARY_PLIST_MAGIC, sizeof(BINARY_PLIST_MAGIC)) == 0;
+}
+
+bool PlistParser::parse(const unsigned char* data, size_t size, Handler& handler)
+{
+    if (isBinary(data, size))
+        return parseBinary(data, size, handler);
+    return parseXML(reinterpret_cast<const char*>(data), size, handler);
+}
+
+bool PlistParser::parseXML(const char* data, size_t size, Handler& handler)
+{
+    if (!data)
+        return false;
+    XMLParser parser(data, size, handler);
+    return parser.parse();
+}
+
+bool PlistParser::parseBinary(const unsigned char* data, size_t size, Handler& handler)
+{
+    if (!isBinary(data, size))
+        return false;
+    BinaryParser parser(data, size, handler);
+    return parser.parse();
+}
+
+NS_CC_END
@@ -0,0 +1,84 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#ifndef __CC_PLIST_PARSER_H__
+#define __CC_PLIST_PARSER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "platform/CCPlatformMacros.h"
+
+/// @cond DO_NOT_SHOW
+
+NS_CC_BEGIN
+
+/**
+ * Parses XML and binary plists without building a DOM, the values are reported to a Handler in the
+ * order of the document. It is shared by the readers which don't go through a ValueMap, i.e. ValueDocument
+ * and SpriteSheetReader.
+ * @since v3.15
+ */
+class CC_DLL PlistParser
+{
+public:
+    /** Receives the values of a plist, parsing stops as soon as a callback returns false. */
+    class CC_DLL Handler
+    {
+    public:
+        virtual ~Handler() {}
+
+        virtual bool beginDict() = 0;
+        virtual bool endDict() = 0;
+        virtual bool beginArray() = 0;
+        virtual bool endArray() = 0;
+        /** The key of the next value of a dict.
+         * The text is a reference to the parsed data if persistent is true, otherwise it is only valid during the call.
+         */
+        virtual bool key(const char* text, size_t size, bool persistent) = 0;
+        /** A string, the text is like the one of key(). */
+        virtual bool string(const char* text, size_t size, bool persistent) = 0;
+        virtual bool integer(int64_t value) = 0;
+        virtual bool real(double value) = 0;
+        virtual bool boolean(bool value) = 0;
+        /** A date, data, uid or null, which are not read by cocos2d-x. */
+        virtual bool unsupported() = 0;
+    };
+
+    /** Whether the data starts like a binary plist ("bplist00"). */
+    static bool isBinary(const unsigned char* data, size_t size);
+
+    /** Parses an XML or a binary plist, depending on its header. */
+    static bool parse(const unsigned char* data, size_t size, Handler& handler);
+    static bool parseXML(const char* data, size_t size, Handler& handler);
+    static bool parseBinary(const unsigned char* data, size_t size, Handler& handler);
+};
+
+NS_CC_END
+
+/// @endcond
+
+#endif // __CC_PLIST_PARSER_H__
@@ -32,6 +32,8 @@ THE SOFTWARE.
 #include "base/ccCArray.h"
 #include "base/CCScriptSupport.h"
 
+#include <chrono>
+
 NS_CC_BEGIN
 
 // data structures
@@ -68,6 +70,14 @@ typedef struct _hashSelectorEntry
     UT_hash_handle      hh;
 } tHashTimerEntry;
 
+// Node of the lock-free queue used for "perform Function"
+typedef struct _performEntry
+{
+    std::atomic<struct _performEntry*> next;
+    std::function<void()> function;
+    std::string         key;
+} tPerformEntry;
+
 // implementation Timer
 
 Timer::Timer()
@@ -256,14 +266,34 @@ Scheduler::Scheduler(void)
 #if CC_ENABLE_SCRIPT_BINDING
 , _scriptHandlerEntries(20)
 #endif
+, _performTail(nullptr)
+, _performTimeBudget(0.0f)
 {
-    // I don't expect to have more than 30 functions to all per frame
-    _functionsToPerform.reserve(30);
+    // The queue always holds a dummy entry, so producers never have to deal with an empty queue.
+    // Plain new: the queue can't work without it, and a failure is reported like any other allocation.
+    _performTail = new tPerformEntry();
+    _performTail->next.store(nullptr, std::memory_order_relaxed);
+    _performHead.store(_performTail, std::memory_order_relaxed);
 }
 
 Scheduler::~Scheduler(void)
 {
     unscheduleAll();
+
+    for (auto entry : _functionsToPerform)
+    {
+        delete entry;
+    }
+    _functionsToPerform.clear();
+    _coalescedFunctions.clear();
+
+    tPerformEntry *entry = _performTail;
+    while (entry)
+    {
+        tPerformEntry *next = entry->next.load(std::memory_order_acquire);
+        delete entry;
+        entry = next;
+    }
 }
 
 void Scheduler::removeHashElement(_hashSelectorEntry *element)
@@ -818,11 +848,100 @@ void Scheduler::resumeTargets(const std::set<void*>& targetsToResume)
 
 void Scheduler::performFunctionInCocosThread(const std::function<void ()> &function)
 {
-    _performMutex.lock();
+    performFunctionInCocosThread(function, "");
+}
+
+void Scheduler::performFunctionInCocosThread(const std::function<void ()> &function, const std::string &key)
+{
+    // Plain new, like the copy of the function below: a function must not be dropped silently
+    tPerformEntry *entry = new tPerformEntry();
+    entry->next.store(nullptr, std::memory_order_relaxed);
+    entry->function = function;
+    entry->key = key;
 
-    _functionsToPerform.push_back(function);
+    pushFunctionToPerform(entry);
+}
 
-    _performMutex.unlock();
+void Scheduler::pushFunctionToPerform(tPerformEntry *entry)
+{
+    // Producers only contend on one atomic exchange; the entry is linked after it is published as the new head.
+    tPerformEntry *prev = _performHead.exchange(entry, std::memory_order_acq_rel);
+    prev->next.store(entry, std::memory_order_release);
+}
+
+void Scheduler::collectFunctionsToPerform()
+{
+    // Only called from cocos thread, which is the single consumer of the queue.
+    // An entry whose producer hasn't linked it yet stops the walk; it will be collected next frame.
+    tPerformEntry *tail = _performTail;
+    tPerformEntry *next = tail->next.load(std::memory_order_acquire);
+    while (next)
+    {
+        // 'next' becomes the new dummy entry, so move its payload into a fresh entry
+        tPerformEntry *entry = tail;
+        entry->next.store(nullptr, std::memory_order_relaxed);
+        entry->function = std::move(next->function);
+        entry->key = std::move(next->key);
+        next->function = nullptr;
+        next->key.clear();
+
+        if (!entry->key.empty())
+        {
+            auto iter = _coalescedFunctions.find(entry->key);
+            if (iter != _coalescedFunctions.end())
+            {
+                // A newer function with the same key supersedes the pending one
+                iter->second->function = nullptr;
+                iter->second = entry;
+            }
+            else
+            {
+                _coalescedFunctions.emplace(entry->key, entry);
+            }
+        }
+        _functionsToPerform.push_back(entry);
+
+        tail = next;
+        next = tail->next.load(std::memory_order_acquire);
+    }
+    _performTail = tail;
+}
+
+void Scheduler::performFunctions()
+{
+    collectFunctionsToPerform();
+
+    if (_functionsToPerform.empty())
+        return;
+
+    const bool useBudget = _performTimeBudget > 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    const auto budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(_performTimeBudget));
+    bool performedOne = false;
+
+    while (!_functionsToPerform.empty())
+    {
+        if (useBudget && performedOne && std::chrono::steady_clock::now() - start >= budget)
+            break;
+
+        tPerformEntry *entry = _functionsToPerform.front();
+        _functionsToPerform.pop_front();
+
+        if (!entry->key.empty())
+        {
+            auto iter = _coalescedFunctions.find(entry->key);
+            if (iter != _coalescedFunctions.end() && iter->second == entry)
+                _coalescedFunctions.erase(iter);
+        }
+
+        // Entries are removed before being invoked, so functions may safely post new functions
+        if (entry->function)
+        {
+            entry->function();
+            performedOne = true;
+        }
+        delete entry;
+    }
 }
 
 // main loop
@@ -965,19 +1084,9 @@ void Scheduler::update(float dt)
     // Functions allocated from another thread
     //
 
-    // Testing size is faster than locking / unlocking.
-    // And almost never there will be functions scheduled to be called.
-    if( !_functionsToPerform.empty() ) {
-        _performMutex.lock();
-        // fixed #4123: Save the callback functions, they must be invoked after '_performMutex.unlock()', otherwise if new functions are added in callback, it will cause thread deadlock.
-        auto temp = _functionsToPerform;
-        _functionsToPerform.clear();
-        _performMutex.unlock();
-        for( const auto &function : temp ) {
-            function();
-        }
-        
-    }
+    // The queue is lock free, so draining it never blocks the threads posting functions.
+    // Functions are run outside of the queue, so new functions may be added in callbacks (#4123).
+    performFunctions();
 }
 
 void Scheduler::schedule(SEL_SCHEDULE selector, Ref *target, float interval, unsigned int repeat, float delay, bool paused)
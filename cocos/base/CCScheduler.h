@@ -28,9 +28,12 @@ THE SOFTWARE.
 #ifndef __CCSCHEDULER_H__
 #define __CCSCHEDULER_H__
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <mutex>
 #include <set>
+#include <unordered_map>
 
 #include "base/CCRef.h"
 #include "base/CCVector.h"
@@ -429,6 +432,30 @@ public:
      @js NA
      */
     void performFunctionInCocosThread( const std::function<void()> &function);
+
+    /** Calls a function on the cocos2d thread, coalescing it with other pending functions posted with the same key.
+     If a function with the same key is still waiting to be run, it is dropped and only the latest one is invoked.
+     This function is thread safe and lock free.
+     @param function The function to be run in cocos2d thread.
+     @param key The key used to collapse redundant callbacks. An empty key disables coalescing.
+     @since v3.15
+     @js NA
+     */
+    void performFunctionInCocosThread(const std::function<void()> &function, const std::string &key);
+
+    /** Sets the maximum time, in seconds, spent each frame running functions posted by `performFunctionInCocosThread`.
+     Functions that don't fit in the budget are kept, in order, for the next frames. At least one function is run per frame.
+     @param seconds The time budget. 0 (the default) means no limit.
+     @since v3.15
+     @js NA
+     */
+    void setPerformFunctionsTimeBudget(float seconds) { _performTimeBudget = seconds; }
+
+    /** Gets the time budget used to run functions posted by `performFunctionInCocosThread`.
+     @since v3.15
+     @js NA
+     */
+    float getPerformFunctionsTimeBudget() const { return _performTimeBudget; }
     
     /////////////////////////////////////
     
@@ -507,6 +534,12 @@ protected:
     void priorityIn(struct _listEntry **list, const ccSchedulerFunc& callback, void *target, int priority, bool paused);
     void appendIn(struct _listEntry **list, const ccSchedulerFunc& callback, void *target, bool paused);
 
+    // perform function specific
+
+    void pushFunctionToPerform(struct _performEntry *entry);
+    void collectFunctionsToPerform();
+    void performFunctions();
+
 
     float _timeScale;
 
@@ -530,8 +563,13 @@ protected:
 #endif
     
     // Used for "perform Function"
-    std::vector<std::function<void()>> _functionsToPerform;
-    std::mutex _performMutex;
+    // Intrusive multi-producer / single-consumer queue: other threads push to the head, cocos thread pops from the tail.
+    std::atomic<struct _performEntry*> _performHead;
+    struct _performEntry *_performTail;
+    // Functions popped from the queue but not run yet. Only accessed from cocos thread.
+    std::deque<struct _performEntry*> _functionsToPerform;
+    std::unordered_map<std::string, struct _performEntry*> _coalescedFunctions;
+    float _performTimeBudget;
 };
 
 // end of base group
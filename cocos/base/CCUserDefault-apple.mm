@@ -542,6 +542,10 @@ void UserDefault::flush()
     [[NSUserDefaults standardUserDefaults] synchronize];
 }
 
+void UserDefault::setWriteDeferred(bool /*deferred*/)
+{
+}
+
 void UserDefault::deleteValueForKey(const char* key)
 {
     // check the params
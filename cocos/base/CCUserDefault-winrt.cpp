@@ -330,6 +330,10 @@ void UserDefault::flush()
 {
 }
 
+void UserDefault::setWriteDeferred(bool /*deferred*/)
+{
+}
+
 void UserDefault::deleteValueForKey(const char* key)
 {
     // check the params
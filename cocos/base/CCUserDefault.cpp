@@ -28,6 +28,14 @@ THE SOFTWARE.
 #include "tinyxml2.h"
 #include "base/base64.h"
 #include "base/ccUtils.h"
+#include "base/CCDirector.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCEventType.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <zlib.h>
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_IOS && CC_TARGET_PLATFORM != CC_PLATFORM_MAC && CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
 
@@ -36,105 +44,373 @@ THE SOFTWARE.
 
 #define XML_FILE_NAME "UserDefault.xml"
 
+#define KV_FILE_NAME "UserDefault.kv"
+
 using namespace std;
 
 NS_CC_BEGIN
 
-/**
- * define the functions here because we don't want to
- * export xmlNodePtr and other types in "CCUserDefault.h"
- */
-
-static tinyxml2::XMLElement* getXMLNodeForKey(const char* pKey, tinyxml2::XMLElement** rootNode, tinyxml2::XMLDocument **doc)
+namespace
 {
-    tinyxml2::XMLElement* curNode = nullptr;
+    const char KV_MAGIC[4] = { 'C', 'C', 'U', 'D' };
+    const uint32_t KV_VERSION = 1;
+    const size_t KV_HEADER_SIZE = 8;
+    // type, key size, value size before the key and value, CRC32 of all of them after
+    const size_t KV_RECORD_OVERHEAD = 1 + 4 + 4 + 4;
 
-    // check the key value
-    if (! pKey)
+    enum : unsigned char
     {
-        return nullptr;
+        RECORD_SET = 1,
+        RECORD_DELETE = 2
+    };
+
+    // when writes are deferred, pending records are written by flush(), at the end of the frame, or once they reach this size
+    const size_t MAX_PENDING_SIZE = 16 * 1024;
+    // the log is rewritten with the current values only when it is this many times larger, and larger than MIN_COMPACTION_SIZE
+    const size_t COMPACTION_RATIO = 2;
+    const size_t MIN_COMPACTION_SIZE = 64 * 1024;
+
+    void appendLittleEndian32(std::string& buffer, uint32_t value)
+    {
+        char bytes[4] = { (char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24) };
+        buffer.append(bytes, 4);
     }
 
-    do 
+    uint32_t readLittleEndian32(const unsigned char* p)
     {
-         tinyxml2::XMLDocument* xmlDoc = new (std::nothrow) tinyxml2::XMLDocument();
-        *doc = xmlDoc;
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
 
-        std::string xmlBuffer = FileUtils::getInstance()->getStringFromFile(UserDefault::getInstance()->getXMLFilePath());
+    void appendRecord(std::string& buffer, unsigned char type, const std::string& key, const std::string& value)
+    {
+        size_t start = buffer.size();
+        buffer.push_back((char)type);
+        appendLittleEndian32(buffer, (uint32_t)key.size());
+        appendLittleEndian32(buffer, (uint32_t)value.size());
+        buffer.append(key);
+        buffer.append(value);
+        appendLittleEndian32(buffer, (uint32_t)crc32(0, (const Bytef*)buffer.data() + start, (uInt)(buffer.size() - start)));
+    }
 
-        if (xmlBuffer.empty())
+    /**
+     * The values of UserDefault, kept in memory and persisted in an append-only log.
+     * Setting a value appends a record to the log, which is compacted once most of its records are outdated.
+     * Records are written at once, unless writes are deferred.
+     * A record cut by a crash is detected by its CRC and dropped with the records after it.
+     */
+    class UserDefaultStore
+    {
+    public:
+        UserDefaultStore(const std::string& path, const std::string& xmlPath);
+        ~UserDefaultStore();
+
+        bool get(const char* key, std::string* value);
+        void set(const char* key, const std::string& value);
+        void remove(const char* key);
+        void flush();
+        void setDeferred(bool deferred);
+
+    private:
+        bool load();
+        // imports the values of the UserDefault.xml of older versions
+        bool migrateXML(const std::string& xmlPath);
+        // updates the values, and the size of the compacted log
+        void apply(unsigned char type, const std::string& key, const char* value, size_t valueSize);
+        void addRecord(unsigned char type, const std::string& key, const std::string& value);
+        bool writePending();
+        bool compact();
+
+        std::mutex _mutex;
+        std::unordered_map<std::string, std::string> _values;
+        std::string _path;
+        // records not written yet
+        std::string _pending;
+        size_t _fileSize;
+        // size of the log if it were compacted
+        size_t _liveSize;
+        // the log has a damaged tail or can't be appended to
+        bool _needsCompaction;
+        bool _deferred;
+    };
+
+    UserDefaultStore* s_store = nullptr;
+    // flush the deferred writes, retained so they can be removed after the dispatcher dropped them
+    EventListenerCustom* s_afterDrawListener = nullptr;
+    EventListenerCustom* s_backgroundListener = nullptr;
+    EventListenerCustom* s_resetListener = nullptr;
+
+    UserDefaultStore::UserDefaultStore(const std::string& path, const std::string& xmlPath)
+    : _path(path)
+    , _fileSize(0)
+    , _liveSize(KV_HEADER_SIZE)
+    , _needsCompaction(false)
+    , _deferred(false)
+    {
+        if (!load() && FileUtils::getInstance()->isFileExist(xmlPath) && migrateXML(xmlPath))
+        {
+            FileUtils::getInstance()->removeFile(xmlPath);
+        }
+    }
+
+    UserDefaultStore::~UserDefaultStore()
+    {
+        flush();
+    }
+
+    bool UserDefaultStore::load()
+    {
+        Data data = FileUtils::getInstance()->getDataFromFile(_path);
+        if (data.isNull())
+            return false;
+
+        const unsigned char* bytes = data.getBytes();
+        size_t size = (size_t)data.getSize();
+        if (size < KV_HEADER_SIZE || memcmp(bytes, KV_MAGIC, sizeof(KV_MAGIC)) != 0
+            || readLittleEndian32(bytes + 4) != KV_VERSION)
+        {
+            CCLOG("UserDefault: %s is not a valid file, it is ignored", _path.c_str());
+            _needsCompaction = true;
+            return true;
+        }
+
+        size_t offset = KV_HEADER_SIZE;
+        while (offset < size)
         {
-            CCLOG("can not read xml file");
-            break;
+            if (size - offset < KV_RECORD_OVERHEAD)
+                break;
+            const unsigned char* record = bytes + offset;
+            unsigned char type = record[0];
+            size_t keySize = readLittleEndian32(record + 1);
+            size_t valueSize = readLittleEndian32(record + 5);
+            if (keySize > size || valueSize > size || KV_RECORD_OVERHEAD + keySize + valueSize > size - offset)
+                break;
+
+            size_t recordSize = KV_RECORD_OVERHEAD + keySize + valueSize;
+            uint32_t crc = (uint32_t)crc32(0, record, (uInt)(recordSize - 4));
+            if (crc != readLittleEndian32(record + recordSize - 4))
+                break;
+
+            std::string key((const char*)record + 9, keySize);
+            apply(type, key, (const char*)record + 9 + keySize, valueSize);
+            offset += recordSize;
         }
-        xmlDoc->Parse(xmlBuffer.c_str(), xmlBuffer.size());
 
-        // get root node
-        *rootNode = xmlDoc->RootElement();
-        if (nullptr == *rootNode)
+        _fileSize = offset;
+        if (offset < size)
+        {
+            CCLOG("UserDefault: dropped a damaged record at the end of %s", _path.c_str());
+            _needsCompaction = true;
+        }
+        return true;
+    }
+
+    bool UserDefaultStore::migrateXML(const std::string& xmlPath)
+    {
+        std::string xmlBuffer = FileUtils::getInstance()->getStringFromFile(xmlPath);
+        if (xmlBuffer.empty())
+            return false;
+
+        tinyxml2::XMLDocument doc;
+        doc.Parse(xmlBuffer.c_str(), xmlBuffer.size());
+        tinyxml2::XMLElement* rootNode = doc.RootElement();
+        if (nullptr == rootNode)
         {
             CCLOG("read root node error");
-            break;
+            return false;
         }
-        // find the node
-        curNode = (*rootNode)->FirstChildElement();
-        while (nullptr != curNode)
+
+        for (tinyxml2::XMLElement* node = rootNode->FirstChildElement(); node; node = node->NextSiblingElement())
         {
-            const char* nodeName = curNode->Value();
-            if (!strcmp(nodeName, pKey))
+            const char* value = node->FirstChild() ? node->FirstChild()->Value() : nullptr;
+            if (value)
             {
-                break;
+                addRecord(RECORD_SET, node->Value(), value);
             }
+        }
 
-            curNode = curNode->NextSiblingElement();
+        // the XML file is only removed once its values are stored
+        return compact();
+    }
+
+    bool UserDefaultStore::get(const char* key, std::string* value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _values.find(key);
+        if (it == _values.end())
+            return false;
+        *value = it->second;
+        return true;
+    }
+
+    void UserDefaultStore::set(const char* key, const std::string& value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _values.find(key);
+        if (it != _values.end() && it->second == value)
+            return;
+        addRecord(RECORD_SET, key, value);
+        if (!_deferred || _pending.size() >= MAX_PENDING_SIZE)
+            writePending();
+    }
+
+    void UserDefaultStore::remove(const char* key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_values.find(key) == _values.end())
+            return;
+        addRecord(RECORD_DELETE, key, std::string());
+        if (!_deferred || _pending.size() >= MAX_PENDING_SIZE)
+            writePending();
+    }
+
+    void UserDefaultStore::flush()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        writePending();
+    }
+
+    void UserDefaultStore::setDeferred(bool deferred)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _deferred = deferred;
+        if (!deferred)
+            writePending();
+    }
+
+    void removeFlushListeners()
+    {
+        if (!s_afterDrawListener)
+            return;
+
+        auto dispatcher = Director::getInstance()->getEventDispatcher();
+        dispatcher->removeEventListener(s_afterDrawListener);
+        dispatcher->removeEventListener(s_backgroundListener);
+        dispatcher->removeEventListener(s_resetListener);
+        CC_SAFE_RELEASE_NULL(s_afterDrawListener);
+        CC_SAFE_RELEASE_NULL(s_backgroundListener);
+        CC_SAFE_RELEASE_NULL(s_resetListener);
+    }
+
+    void UserDefaultStore::apply(unsigned char type, const std::string& key, const char* value, size_t valueSize)
+    {
+        auto it = _values.find(key);
+        if (it != _values.end())
+        {
+            _liveSize -= KV_RECORD_OVERHEAD + key.size() + it->second.size();
         }
-    } while (0);
 
-    return curNode;
-}
+        if (type == RECORD_SET)
+        {
+            _liveSize += KV_RECORD_OVERHEAD + key.size() + valueSize;
+            if (it != _values.end())
+                it->second.assign(value, valueSize);
+            else
+                _values.emplace(key, std::string(value, valueSize));
+        }
+        else if (type == RECORD_DELETE && it != _values.end())
+        {
+            _values.erase(it);
+        }
+    }
 
-static void setValueForKey(const char* pKey, const char* pValue)
-{
-     tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    // check the params
-    if (! pKey || ! pValue)
+    void UserDefaultStore::addRecord(unsigned char type, const std::string& key, const std::string& value)
     {
-        return;
+        apply(type, key, value.data(), value.size());
+        appendRecord(_pending, type, key, value);
     }
-    // find the node
-    node = getXMLNodeForKey(pKey, &rootNode, &doc);
-    // if node exist, change the content
-    if (node)
+
+    bool UserDefaultStore::writePending()
     {
-        if (node->FirstChild())
+        if (_pending.empty() && !_needsCompaction)
+            return true;
+
+        if (_needsCompaction || _fileSize == 0
+            || (_fileSize + _pending.size() > MIN_COMPACTION_SIZE && _fileSize + _pending.size() > _liveSize * COMPACTION_RATIO))
+        {
+            return compact();
+        }
+
+        FILE* fp = fopen(FileUtils::getInstance()->getSuitableFOpen(_path).c_str(), "ab");
+        if (!fp)
         {
-            node->FirstChild()->SetValue(pValue);
+            CCLOG("UserDefault: can't write %s", _path.c_str());
+            return false;
         }
-        else
+        bool written = fwrite(_pending.data(), 1, _pending.size(), fp) == _pending.size();
+        written = fclose(fp) == 0 && written;
+        if (!written)
         {
-            tinyxml2::XMLText* content = doc->NewText(pValue);
-            node->LinkEndChild(content);
+            // the tail of the log may be damaged, it is rewritten next time
+            _needsCompaction = true;
+            return false;
         }
+        _fileSize += _pending.size();
+        _pending.clear();
+        return true;
     }
-    else
+
+    bool UserDefaultStore::compact()
     {
-        if (rootNode)
+        std::string buffer(KV_MAGIC, sizeof(KV_MAGIC));
+        appendLittleEndian32(buffer, KV_VERSION);
+        buffer.reserve(_liveSize);
+        for (const auto& value : _values)
         {
-            tinyxml2::XMLElement* tmpNode = doc->NewElement(pKey);//new tinyxml2::XMLElement(pKey);
-            rootNode->LinkEndChild(tmpNode);
-            tinyxml2::XMLText* content = doc->NewText(pValue);//new tinyxml2::XMLText(pValue);
-            tmpNode->LinkEndChild(content);
-        }    
+            appendRecord(buffer, RECORD_SET, value.first, value.second);
+        }
+
+        // the log is replaced once the new one is complete
+        std::string tempPath = _path + ".tmp";
+        FILE* fp = fopen(FileUtils::getInstance()->getSuitableFOpen(tempPath).c_str(), "wb");
+        if (!fp)
+        {
+            CCLOG("UserDefault: can't write %s", tempPath.c_str());
+            return false;
+        }
+        bool written = fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+        written = fclose(fp) == 0 && written;
+        if (!written || !FileUtils::getInstance()->renameFile(tempPath, _path))
+        {
+            CCLOG("UserDefault: can't write %s", _path.c_str());
+            FileUtils::getInstance()->removeFile(tempPath);
+            return false;
+        }
+
+        _fileSize = buffer.size();
+        _liveSize = buffer.size();
+        _pending.clear();
+        _needsCompaction = false;
+        return true;
     }
+}
+
+static UserDefaultStore* getStore()
+{
+    if (!s_store)
+    {
+        UserDefault::getInstance();
+    }
+    return s_store;
+}
 
-    // save file and free doc
-    if (doc)
+static bool getValueForKey(const char* pKey, std::string* value)
+{
+    // check the key value
+    if (! pKey)
+    {
+        return false;
+    }
+    return getStore()->get(pKey, value);
+}
+
+static void setValueForKey(const char* pKey, const char* pValue)
+{
+    // check the params
+    if (! pKey || ! pValue)
     {
-        doc->SaveFile(FileUtils::getInstance()->getSuitableFOpen(UserDefault::getInstance()->getXMLFilePath()).c_str());
-        delete doc;
+        return;
     }
+    getStore()->set(pKey, pValue);
 }
 
 /**
@@ -160,27 +436,12 @@ bool UserDefault::getBoolForKey(const char* pKey)
 
 bool UserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 {
-    const char* value = nullptr;
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-    // find the node
-    if (node && node->FirstChild())
-    {
-        value = (const char*)(node->FirstChild()->Value());
-    }
-
-    bool ret = defaultValue;
-
-    if (value)
+    std::string value;
+    if (getValueForKey(pKey, &value))
     {
-        ret = (! strcmp(value, "true"));
+        return value == "true";
     }
-
-    if (doc) delete doc;
-
-    return ret;
+    return defaultValue;
 }
 
 int UserDefault::getIntegerForKey(const char* pKey)
@@ -190,31 +451,12 @@ int UserDefault::getIntegerForKey(const char* pKey)
 
 int UserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 {
-    const char* value = nullptr;
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-    // find the node
-    if (node && node->FirstChild())
+    std::string value;
+    if (getValueForKey(pKey, &value))
     {
-        value = (const char*)(node->FirstChild()->Value());
+        return atoi(value.c_str());
     }
-
-    int ret = defaultValue;
-
-    if (value)
-    {
-        ret = atoi(value);
-    }
-
-    if(doc)
-    {
-        delete doc;
-    }
-
-
-    return ret;
+    return defaultValue;
 }
 
 float UserDefault::getFloatForKey(const char* pKey)
@@ -236,27 +478,12 @@ double  UserDefault::getDoubleForKey(const char* pKey)
 
 double UserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 {
-    const char* value = nullptr;
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-    // find the node
-    if (node && node->FirstChild())
+    std::string value;
+    if (getValueForKey(pKey, &value))
     {
-        value = (const char*)(node->FirstChild()->Value());
+        return utils::atof(value.c_str());
     }
-
-    double ret = defaultValue;
-
-    if (value)
-    {
-        ret = utils::atof(value);
-    }
-
-    if (doc) delete doc;
-
-    return ret;
+    return defaultValue;
 }
 
 std::string UserDefault::getStringForKey(const char* pKey)
@@ -266,27 +493,12 @@ std::string UserDefault::getStringForKey(const char* pKey)
 
 string UserDefault::getStringForKey(const char* pKey, const std::string & defaultValue)
 {
-    const char* value = nullptr;
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-    // find the node
-    if (node && node->FirstChild())
+    std::string value;
+    if (getValueForKey(pKey, &value))
     {
-        value = (const char*)(node->FirstChild()->Value());
+        return value;
     }
-
-    string ret = defaultValue;
-
-    if (value)
-    {
-        ret = string(value);
-    }
-
-    if (doc) delete doc;
-
-    return ret;
+    return defaultValue;
 }
 
 Data UserDefault::getDataForKey(const char* pKey)
@@ -296,31 +508,19 @@ Data UserDefault::getDataForKey(const char* pKey)
 
 Data UserDefault::getDataForKey(const char* pKey, const Data& defaultValue)
 {
-    const char* encodedData = nullptr;
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
-    node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-    // find the node
-    if (node && node->FirstChild())
-    {
-        encodedData = (const char*)(node->FirstChild()->Value());
-    }
-    
+    std::string encodedData;
     Data ret = defaultValue;
     
-    if (encodedData)
+    if (getValueForKey(pKey, &encodedData))
     {
         unsigned char * decodedData = nullptr;
-        int decodedDataLen = base64Decode((unsigned char*)encodedData, (unsigned int)strlen(encodedData), &decodedData);
+        int decodedDataLen = base64Decode((unsigned char*)encodedData.c_str(), (unsigned int)encodedData.size(), &decodedData);
         
         if (decodedData) {
             ret.fastSet(decodedData, decodedDataLen);
         }
     }
     
-    if (doc) delete doc;
-    
     return ret;    
 }
 
@@ -406,17 +606,16 @@ void UserDefault::setDataForKey(const char* pKey, const Data& value) {
 
 UserDefault* UserDefault::getInstance()
 {
-    if (!_userDefault)
-    {
-        initXMLFilePath();
+    initXMLFilePath();
 
-        // only create xml file one time
-        // the file exists after the program exit
-        if ((!isXMLFileExist()) && (!createXMLFile()))
-        {
-            return nullptr;
-        }
+    // values of the xml file of older versions are moved into the store
+    if (!s_store)
+    {
+        s_store = new (std::nothrow) UserDefaultStore(FileUtils::getInstance()->getWritablePath() + KV_FILE_NAME, _filePath);
+    }
 
+    if (!_userDefault)
+    {
         _userDefault = new (std::nothrow) UserDefault();
     }
 
@@ -425,7 +624,10 @@ UserDefault* UserDefault::getInstance()
 
 void UserDefault::destroyInstance()
 {
+    removeFlushListeners();
     CC_SAFE_DELETE(_userDefault);
+    // writes the values which weren't flushed
+    CC_SAFE_DELETE(s_store);
 }
 
 void UserDefault::setDelegate(UserDefault *delegate)
@@ -501,39 +703,52 @@ const string& UserDefault::getXMLFilePath()
 
 void UserDefault::flush()
 {
+    if (s_store)
+    {
+        s_store->flush();
+    }
 }
 
-void UserDefault::deleteValueForKey(const char* key)
+void UserDefault::setWriteDeferred(bool deferred)
 {
-    tinyxml2::XMLElement* rootNode;
-    tinyxml2::XMLDocument* doc;
-    tinyxml2::XMLElement* node;
+    getStore()->setDeferred(deferred);
 
-    // check the params
-    if (!key)
+    if (!deferred)
     {
-        CCLOG("the key is invalid");
+        removeFlushListeners();
         return;
     }
+    if (s_afterDrawListener)
+        return;
 
-    // find the node
-    node = getXMLNodeForKey(key, &rootNode, &doc);
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    auto flushStore = [](EventCustom* /*event*/) {
+        if (s_store)
+            s_store->flush();
+    };
+    s_afterDrawListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_DRAW, flushStore);
+    s_backgroundListener = dispatcher->addCustomEventListener(EVENT_COME_TO_BACKGROUND, flushStore);
+    // the director removes every listener and destroys FileUtils after this event, write the pending values before
+    s_resetListener = dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom* /*event*/) {
+        if (s_store)
+            s_store->flush();
+        removeFlushListeners();
+    });
+    s_afterDrawListener->retain();
+    s_backgroundListener->retain();
+    s_resetListener->retain();
+}
 
-    // if node not exist, don't need to delete
-    if (!node)
+void UserDefault::deleteValueForKey(const char* key)
+{
+    // check the params
+    if (!key)
     {
+        CCLOG("the key is invalid");
         return;
     }
 
-    // save file and free doc
-    if (doc)
-    {
-        doc->DeleteNode(node);
-        doc->SaveFile(FileUtils::getInstance()->getSuitableFOpen(UserDefault::getInstance()->getXMLFilePath()).c_str());
-        delete doc;
-    }
-
-    flush();
+    getStore()->remove(key);
 }
 
 NS_CC_END
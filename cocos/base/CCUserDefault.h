@@ -43,6 +43,10 @@ NS_CC_BEGIN
  * 
  * It supports the following base types:
  * bool, int, float, double, string
+ *
+ * On platforms other than iOS, Mac and Android the values are kept in memory, and persisted in an
+ * append-only log in the writable path which is compacted from time to time. Values set are written at once,
+ * or at the end of the frame when writes are deferred. The values of the xml file of older versions are moved into the log the first time.
  */
 class CC_DLL UserDefault
 {
@@ -202,6 +206,16 @@ public:
      */
     virtual void flush();
 
+    /**
+     * Defers the writes of the values set, which are then written together by flush(), at the end of each frame,
+     * when the application enters the background, or once enough of them are pending.
+     * Writes are not deferred by default, the platforms which don't keep the values in the log above ignore it.
+     * @param deferred Whether writes are deferred, the pending values are written when it is false.
+     * @since v3.15
+     * @js NA
+     */
+    void setWriteDeferred(bool deferred);
+
     /**
     * delete any value by key,
     * @param key The key to delete value.
@@ -240,7 +254,8 @@ public:
      * @js NA
      */
     CC_DEPRECATED_ATTRIBUTE static void purgeSharedUserDefault();
-    /** All supported platforms other iOS & Android use xml file to save values. This function is return the file path of the xml path.
+    /** All supported platforms other iOS & Android used xml file to save values before v3.15. This function is return the file path of the xml path,
+     * whose values are moved into the current store when it exists.
      * @js NA
      */
     static const std::string& getXMLFilePath();
@@ -0,0 +1,583 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "base/CCValueDocument.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <string.h>
+#include <stdlib.h>
+
+#include "base/CCPlistParser.h"
+#include "platform/CCFileUtils.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const size_t ARENA_BLOCK_SIZE = 16 * 1024;
+
+    uint32_t hashString(const char* data, size_t size)
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= (unsigned char)data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    int compareStrings(const char* a, size_t aSize, const char* b, size_t bSize)
+    {
+        int result = memcmp(a, b, std::min(aSize, bSize));
+        if (result != 0)
+            return result;
+        return aSize < bSize ? -1 : (aSize > bSize ? 1 : 0);
+    }
+
+    // parses a number which is not null terminated
+    template <typename T, typename F>
+    T parseNumber(const char* data, size_t size, F convert)
+    {
+        char buffer[64];
+        size = std::min(size, sizeof(buffer) - 1);
+        memcpy(buffer, data, size);
+        buffer[size] = '\0';
+        return (T)convert(buffer);
+    }
+
+    int parseInt(const char* data, size_t size)
+    {
+        return parseNumber<int>(data, size, [](const char* s) { return atoi(s); });
+    }
+
+    double parseDouble(const char* data, size_t size)
+    {
+        return parseNumber<double>(data, size, [](const char* s) { return atof(s); });
+    }
+}
+
+// Blocks of memory freed with the document
+class ValueDocument::Arena
+{
+public:
+    Arena() : _current(nullptr), _left(0) {}
+
+    void* allocate(size_t size)
+    {
+        size = (size + alignof(double) - 1) & ~(alignof(double) - 1);
+        if (size > _left)
+        {
+            // large allocations get their own block, the current block keeps its space
+            if (size > ARENA_BLOCK_SIZE / 4)
+            {
+                _blocks.emplace_back(new (std::nothrow) double[(size + sizeof(double) - 1) / sizeof(double)]);
+                return _blocks.back().get();
+            }
+            _blocks.emplace_back(new (std::nothrow) double[ARENA_BLOCK_SIZE / sizeof(double)]);
+            _current = reinterpret_cast<char*>(_blocks.back().get());
+            _left = ARENA_BLOCK_SIZE;
+        }
+        void* result = _current;
+        _current += size;
+        _left -= size;
+        return result;
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count)
+    {
+        return count > 0 ? static_cast<T*>(allocate(sizeof(T) * count)) : nullptr;
+    }
+
+private:
+    std::vector<std::unique_ptr<double[]>> _blocks;
+    char* _current;
+    size_t _left;
+};
+
+// Builds the nodes of a document from the values of a plist
+class ValueDocument::Builder : public PlistParser::Handler
+{
+public:
+    explicit Builder(Arena& arena)
+    : _arena(arena)
+    , _key(nullptr)
+    , _hasRoot(false)
+    {
+        _root.type = Type::NONE;
+        _root.count = 0;
+    }
+
+    const NodeData* finish()
+    {
+        // every dict and array is closed
+        if (!_containers.empty() || !_hasRoot)
+            return nullptr;
+
+        NodeData* root = _arena.allocateArray<NodeData>(1);
+        *root = _root;
+        return root;
+    }
+
+    bool beginDict() override
+    {
+        return beginContainer(true);
+    }
+
+    bool endDict() override
+    {
+        return endContainer(true);
+    }
+
+    bool beginArray() override
+    {
+        return beginContainer(false);
+    }
+
+    bool endArray() override
+    {
+        return endContainer(false);
+    }
+
+    bool key(const char* text, size_t size, bool persistent) override
+    {
+        _key = internKey(text, size, persistent);
+        return true;
+    }
+
+    bool string(const char* text, size_t size, bool persistent) override
+    {
+        NodeData node;
+        node.type = Type::STRING;
+        node.count = (uint32_t)size;
+        node.stringValue = persistent ? text : copyText(text, size);
+        return addNode(node);
+    }
+
+    bool integer(int64_t value) override
+    {
+        NodeData node;
+        node.type = Type::INTEGER;
+        node.count = 0;
+        node.intValue = (int)value;
+        return addNode(node);
+    }
+
+    bool real(double value) override
+    {
+        NodeData node;
+        node.type = Type::DOUBLE;
+        node.count = 0;
+        node.doubleValue = value;
+        return addNode(node);
+    }
+
+    bool boolean(bool value) override
+    {
+        NodeData node;
+        node.type = Type::BOOLEAN;
+        node.count = 0;
+        node.boolValue = value;
+        return addNode(node);
+    }
+
+    bool unsupported() override
+    {
+        // dates and data are skipped with their key, like FileUtils::getValueMapFromFile does
+        _key = nullptr;
+        return true;
+    }
+
+private:
+    struct Container
+    {
+        bool map;
+        // key of the container in its parent map
+        const KeyData* key;
+        // index of the first element of the container in _elements
+        size_t first;
+    };
+
+    // the elements of the open containers, the innermost container at the end
+    std::vector<EntryData> _elements;
+    std::vector<Container> _containers;
+    struct KeyHash
+    {
+        size_t operator()(const KeyData* key) const { return key->hash; }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const KeyData* a, const KeyData* b) const
+        {
+            return a->size == b->size && memcmp(a->data, b->data, a->size) == 0;
+        }
+    };
+
+    std::unordered_set<const KeyData*, KeyHash, KeyEqual> _keys;
+
+    bool beginContainer(bool map)
+    {
+        Container container = { map, _key, _elements.size() };
+        _containers.push_back(container);
+        _key = nullptr;
+        return true;
+    }
+
+    bool addNode(const NodeData& node)
+    {
+        if (_containers.empty())
+        {
+            // the top object
+            if (_hasRoot)
+                return false;
+            _root = node;
+            _hasRoot = true;
+            return true;
+        }
+        if (_containers.back().map && !_key)
+        {
+            CCLOG("ValueDocument: a value of a dict has no key");
+            return true;
+        }
+        EntryData entry;
+        entry.key = _containers.back().map ? _key : nullptr;
+        entry.value = node;
+        _elements.push_back(entry);
+        _key = nullptr;
+        return true;
+    }
+
+    bool endContainer(bool map)
+    {
+        if (_containers.empty() || _containers.back().map != map)
+            return false;
+        Container container = _containers.back();
+        _containers.pop_back();
+
+        auto first = _elements.begin() + container.first;
+        size_t count = _elements.end() - first;
+        NodeData node;
+        if (map)
+        {
+            // sorted for binary search, the last value of a duplicated key wins like in a ValueMap
+            std::stable_sort(first, _elements.end(), [](const EntryData& a, const EntryData& b) {
+                return compareStrings(a.key->data, a.key->size, b.key->data, b.key->size) < 0;
+            });
+            auto last = first;
+            for (auto it = first; it != _elements.end(); ++it)
+            {
+                if (it != first && it->key == (last - 1)->key)
+                    *(last - 1) = *it;
+                else
+                    *last++ = *it;
+            }
+            count = last - first;
+            EntryData* entries = _arena.allocateArray<EntryData>(count);
+            std::copy(first, last, entries);
+            node.type = Type::MAP;
+            node.entries = entries;
+        }
+        else
+        {
+            NodeData* elements = _arena.allocateArray<NodeData>(count);
+            for (size_t i = 0; i < count; ++i)
+                elements[i] = first[i].value;
+            node.type = Type::VECTOR;
+            node.elements = elements;
+        }
+        node.count = (uint32_t)count;
+        _elements.erase(first, _elements.end());
+
+        _key = container.key;
+        return addNode(node);
+    }
+
+    const KeyData* internKey(const char* text, size_t size, bool persistent)
+    {
+        KeyData key = { text, (uint32_t)size, hashString(text, size) };
+        auto found = _keys.find(&key);
+        if (found != _keys.end())
+            return *found;
+
+        // the keys which are not in the document are copied once
+        if (!persistent)
+            key.data = copyText(text, size);
+        KeyData* interned = _arena.allocateArray<KeyData>(1);
+        *interned = key;
+        _keys.insert(interned);
+        return interned;
+    }
+
+    const char* copyText(const char* text, size_t size)
+    {
+        char* copy = _arena.allocateArray<char>(size);
+        if (size > 0)
+            memcpy(copy, text, size);
+        return copy ? copy : "";
+    }
+
+    Arena& _arena;
+    // key of the next value of the innermost map
+    const KeyData* _key;
+    NodeData _root;
+    bool _hasRoot;
+};
+
+bool ValueDocument::StringRef::operator==(const std::string& other) const
+{
+    return size == other.size() && memcmp(data, other.data(), size) == 0;
+}
+
+bool ValueDocument::StringRef::operator==(const char* other) const
+{
+    return strncmp(data, other, size) == 0 && other[size] == '\0';
+}
+
+ValueDocument::Type ValueDocument::Node::getType() const
+{
+    return _data ? _data->type : Type::NONE;
+}
+
+bool ValueDocument::Node::asBool() const
+{
+    switch (getType())
+    {
+        case Type::BOOLEAN:
+            return _data->boolValue;
+        case Type::INTEGER:
+            return _data->intValue != 0;
+        case Type::DOUBLE:
+            return _data->doubleValue != 0.0;
+        case Type::STRING:
+            {
+                StringRef text = asStringRef();
+                return !(text == "0" || text == "false");
+            }
+        default:
+            return false;
+    }
+}
+
+int ValueDocument::Node::asInt() const
+{
+    switch (getType())
+    {
+        case Type::BOOLEAN:
+            return _data->boolValue ? 1 : 0;
+        case Type::INTEGER:
+            return _data->intValue;
+        case Type::DOUBLE:
+            return (int)_data->doubleValue;
+        case Type::STRING:
+            return parseInt(_data->stringValue, _data->count);
+        default:
+            return 0;
+    }
+}
+
+float ValueDocument::Node::asFloat() const
+{
+    return (float)asDouble();
+}
+
+double ValueDocument::Node::asDouble() const
+{
+    switch (getType())
+    {
+        case Type::BOOLEAN:
+            return _data->boolValue ? 1.0 : 0.0;
+        case Type::INTEGER:
+            return _data->intValue;
+        case Type::DOUBLE:
+            return _data->doubleValue;
+        case Type::STRING:
+            return parseDouble(_data->stringValue, _data->count);
+        default:
+            return 0.0;
+    }
+}
+
+std::string ValueDocument::Node::asString() const
+{
+    if (getType() == Type::STRING)
+        return asStringRef().str();
+    return toValue().asString();
+}
+
+ValueDocument::StringRef ValueDocument::Node::asStringRef() const
+{
+    if (getType() != Type::STRING)
+        return StringRef();
+    return StringRef(_data->stringValue, _data->count);
+}
+
+size_t ValueDocument::Node::size() const
+{
+    Type type = getType();
+    return (type == Type::VECTOR || type == Type::MAP) ? _data->count : 0;
+}
+
+ValueDocument::Node ValueDocument::Node::at(size_t index) const
+{
+    if (getType() != Type::VECTOR || index >= _data->count)
+        return Node();
+    return Node(_data->elements + index);
+}
+
+ValueDocument::Node ValueDocument::Node::find(const StringRef& key) const
+{
+    if (getType() != Type::MAP)
+        return Node();
+
+    const EntryData* entries = _data->entries;
+    size_t low = 0;
+    size_t high = _data->count;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        int result = compareStrings(entries[middle].key->data, entries[middle].key->size, key.data, key.size);
+        if (result == 0)
+            return Node(&entries[middle].value);
+        if (result < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return Node();
+}
+
+ValueDocument::StringRef ValueDocument::Node::keyAt(size_t index) const
+{
+    if (getType() != Type::MAP || index >= _data->count)
+        return StringRef();
+    const KeyData* key = _data->entries[index].key;
+    return StringRef(key->data, key->size);
+}
+
+ValueDocument::Node ValueDocument::Node::valueAt(size_t index) const
+{
+    if (getType() != Type::MAP || index >= _data->count)
+        return Node();
+    return Node(&_data->entries[index].value);
+}
+
+Value ValueDocument::Node::toValue() const
+{
+    switch (getType())
+    {
+        case Type::BOOLEAN:
+            return Value(_data->boolValue);
+        case Type::INTEGER:
+            return Value(_data->intValue);
+        case Type::DOUBLE:
+            return Value(_data->doubleValue);
+        case Type::STRING:
+            return Value(asStringRef().str());
+        case Type::VECTOR:
+            {
+                ValueVector vector;
+                vector.reserve(_data->count);
+                for (uint32_t i = 0; i < _data->count; ++i)
+                    vector.push_back(Node(_data->elements + i).toValue());
+                return Value(std::move(vector));
+            }
+        case Type::MAP:
+            {
+                ValueMap map;
+                map.reserve(_data->count);
+                for (uint32_t i = 0; i < _data->count; ++i)
+                {
+                    const EntryData& entry = _data->entries[i];
+                    map.emplace(std::string(entry.key->data, entry.key->size), Node(&entry.value).toValue());
+                }
+                return Value(std::move(map));
+            }
+        default:
+            return Value::Null;
+    }
+}
+
+ValueDocument* ValueDocument::create(Data&& data)
+{
+    ValueDocument* document = new (std::nothrow) ValueDocument();
+    if (document && document->init(std::move(data)))
+    {
+        document->autorelease();
+        return document;
+    }
+    CC_SAFE_DELETE(document);
+    return nullptr;
+}
+
+ValueDocument* ValueDocument::createWithFile(const std::string& filename)
+{
+    Data data = FileUtils::getInstance()->getDataFromFile(filename);
+    if (data.isNull())
+        return nullptr;
+    return create(std::move(data));
+}
+
+ValueDocument::ValueDocument()
+: _arena(nullptr)
+, _root(nullptr)
+{
+}
+
+ValueDocument::~ValueDocument()
+{
+    CC_SAFE_DELETE(_arena);
+}
+
+bool ValueDocument::init(Data&& data)
+{
+    _data = std::move(data);
+    if (_data.isNull())
+        return false;
+
+    _arena = new (std::nothrow) Arena();
+    if (!_arena)
+        return false;
+
+    Builder builder(*_arena);
+    if (!PlistParser::parse(_data.getBytes(), (size_t)_data.getSize(), builder))
+        return false;
+    _root = builder.finish();
+    return _root != nullptr;
+}
+
+ValueMap ValueDocument::toValueMap() const
+{
+    Node root = getRoot();
+    if (root.getType() != Type::MAP)
+        return ValueMap();
+    Value value = root.toValue();
+    return std::move(value.asValueMap());
+}
+
+NS_CC_END
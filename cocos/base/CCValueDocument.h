@@ -0,0 +1,195 @@
+/****************************************************************************
+ Copyright (c) 2017 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __CC_VALUE_DOCUMENT_H__
+#define __CC_VALUE_DOCUMENT_H__
+
+#include <string>
+#include <vector>
+
+#include "base/CCRef.h"
+#include "base/CCData.h"
+#include "base/CCValue.h"
+
+/**
+ * @addtogroup base
+ * @{
+ */
+
+NS_CC_BEGIN
+
+/**
+ * @class ValueDocument
+ * @brief An immutable plist, the read only counterpart of the ValueMap returned by FileUtils::getValueMapFromFile.
+ *
+ * The document keeps the file it was parsed from: strings are references to the file, except the few ones
+ * with XML entities or stored as UTF-16 in a binary plist, which are decoded once. Nodes are stored in blocks owned by the document, and the keys of
+ * all the dictionaries are interned, so parsing does a handful of allocations instead of several per value.
+ * Nodes are only valid while the document is alive. Dictionaries are sorted by key and looked up by binary search.
+ * @since v3.15
+ * @js NA
+ */
+class CC_DLL ValueDocument : public Ref
+{
+public:
+    enum class Type
+    {
+        NONE,
+        BOOLEAN,
+        INTEGER,
+        DOUBLE,
+        STRING,
+        VECTOR,
+        MAP
+    };
+
+    /** A string of a document, which is not null terminated. */
+    struct CC_DLL StringRef
+    {
+        StringRef() : data(""), size(0) {}
+        StringRef(const char* d, size_t s) : data(d), size(s) {}
+
+        std::string str() const { return std::string(data, size); }
+        bool empty() const { return size == 0; }
+        bool operator==(const std::string& other) const;
+        bool operator==(const char* other) const;
+        bool operator!=(const std::string& other) const { return !(*this == other); }
+        bool operator!=(const char* other) const { return !(*this == other); }
+
+        const char* data;
+        size_t size;
+    };
+
+protected:
+    struct KeyData;
+    struct NodeData;
+    struct EntryData;
+
+public:
+    /** A value of a document, a null node when it does not exist. */
+    class CC_DLL Node
+    {
+    public:
+        Node() : _data(nullptr) {}
+
+        Type getType() const;
+        bool isNull() const { return getType() == Type::NONE; }
+
+        /** Converts the value like Value does, e.g. a string is parsed by asInt. */
+        bool asBool() const;
+        int asInt() const;
+        float asFloat() const;
+        double asDouble() const;
+        std::string asString() const;
+        /** The string without copy, empty if the node is not a string. */
+        StringRef asStringRef() const;
+
+        /** The number of elements of a vector or entries of a map, 0 otherwise. */
+        size_t size() const;
+        /** An element of a vector. */
+        Node at(size_t index) const;
+        /** A value of a map. */
+        Node find(const StringRef& key) const;
+        Node operator[](const std::string& key) const { return find(StringRef(key.data(), key.size())); }
+        /** The key of an entry of a map, entries are sorted by key. */
+        StringRef keyAt(size_t index) const;
+        /** The value of an entry of a map. */
+        Node valueAt(size_t index) const;
+
+        /** Copies the node into a Value. */
+        Value toValue() const;
+
+    private:
+        friend class ValueDocument;
+        explicit Node(const NodeData* data) : _data(data) {}
+
+        const NodeData* _data;
+    };
+
+    /** Parses an XML or a binary plist, the document keeps the data.
+     * @return An autoreleased ValueDocument, or nullptr if the data is not a plist.
+     */
+    static ValueDocument* create(Data&& data);
+
+    /** Parses an XML or a binary plist file.
+     * @return An autoreleased ValueDocument, or nullptr if the file can't be read or is not a plist.
+     */
+    static ValueDocument* createWithFile(const std::string& filename);
+
+    virtual ~ValueDocument();
+
+    /** The top object of the plist, usually a map. */
+    Node getRoot() const { return Node(_root); }
+
+    /** Copies the document into a ValueMap, which is empty if the top object is not a map. */
+    ValueMap toValueMap() const;
+
+protected:
+    // an interned key, shared by all the maps of the document
+    struct KeyData
+    {
+        const char* data;
+        uint32_t size;
+        uint32_t hash;
+    };
+
+    struct NodeData
+    {
+        Type type;
+        // number of elements or entries, or size of a string
+        uint32_t count;
+        union
+        {
+            bool boolValue;
+            int intValue;
+            double doubleValue;
+            const char* stringValue;
+            const NodeData* elements;
+            const EntryData* entries;
+        };
+    };
+
+    struct EntryData
+    {
+        const KeyData* key;
+        NodeData value;
+    };
+
+    class Arena;
+    class Builder;
+
+    ValueDocument();
+
+    bool init(Data&& data);
+
+    Data _data;
+    Arena* _arena;
+    const NodeData* _root;
+};
+
+NS_CC_END
+// end group
+/// @}
+
+#endif // __CC_VALUE_DOCUMENT_H__
@@ -38,8 +38,22 @@
 
 #include "base/CCData.h"
 #include "base/ccMacros.h"
+#include "base/CCParallelTaskPool.h"
 #include "platform/CCFileUtils.h"
 #include <map>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <string.h>
+#include <errno.h>
+
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // FIXME: Other platforms should use upstream minizip like mingw-w64  
 #ifdef MINIZIP_FROM_SYSTEM
@@ -143,13 +157,151 @@ inline unsigned int ZipUtils::checksumPvr(const unsigned int *data, ssize_t len)
 // Should buffer factor be 1.5 instead of 2 ?
 #define BUFFER_INC_FACTOR (2)
 
+namespace
+{
+    // deflate can't compress more than 1032:1, larger sizes read from a gzip trailer are garbage
+    const ssize_t MAX_DEFLATE_RATIO = 1032;
+
+    // extra field of the members written by ZipUtils::deflateGZipBlocks, holding the size of the member
+    const unsigned char GZIP_BLOCK_SUBFIELD_ID1 = 'C';
+    const unsigned char GZIP_BLOCK_SUBFIELD_ID2 = 'C';
+    const size_t GZIP_BLOCK_HEADER_SIZE = 20;
+    const size_t GZIP_TRAILER_SIZE = 8;
+
+    struct GZipMember
+    {
+        size_t offset;
+        size_t size;
+        size_t outOffset;
+        size_t outSize;
+    };
+
+    uint32_t readLittleEndian32(const unsigned char* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    void writeLittleEndian32(unsigned char* p, uint32_t value)
+    {
+        p[0] = (unsigned char)value;
+        p[1] = (unsigned char)(value >> 8);
+        p[2] = (unsigned char)(value >> 16);
+        p[3] = (unsigned char)(value >> 24);
+    }
+
+    // the uncompressed size of the last gzip member, 0 if the buffer isn't gzip
+    ssize_t getGZipSizeHint(const unsigned char* in, ssize_t inLength)
+    {
+        if (!ZipUtils::isGZipBuffer(in, inLength) || inLength < (ssize_t)(10 + GZIP_TRAILER_SIZE))
+            return 0;
+
+        ssize_t size = readLittleEndian32(in + inLength - 4);
+        return size <= inLength * MAX_DEFLATE_RATIO ? size : 0;
+    }
+
+    // Finds the members of a buffer written by deflateGZipBlocks, returns false if any part of the buffer isn't such a member.
+    bool indexGZipBlocks(const unsigned char* in, ssize_t inLength, std::vector<GZipMember>* members)
+    {
+        size_t offset = 0;
+        size_t outOffset = 0;
+        while (offset < (size_t)inLength)
+        {
+            const unsigned char* header = in + offset;
+            size_t left = (size_t)inLength - offset;
+            if (left < GZIP_BLOCK_HEADER_SIZE + GZIP_TRAILER_SIZE
+                || header[0] != 0x1F || header[1] != 0x8B || header[2] != Z_DEFLATED || header[3] != 0x04
+                || header[10] != 8 || header[11] != 0
+                || header[12] != GZIP_BLOCK_SUBFIELD_ID1 || header[13] != GZIP_BLOCK_SUBFIELD_ID2
+                || header[14] != 4 || header[15] != 0)
+            {
+                return false;
+            }
+
+            size_t size = readLittleEndian32(header + 16);
+            if (size < GZIP_BLOCK_HEADER_SIZE + GZIP_TRAILER_SIZE || size > left)
+                return false;
+
+            GZipMember member;
+            member.offset = offset;
+            member.size = size;
+            member.outOffset = outOffset;
+            member.outSize = readLittleEndian32(header + size - 4);
+            if (member.outSize > size * MAX_DEFLATE_RATIO)
+                return false;
+
+            members->push_back(member);
+            offset += size;
+            outOffset += member.outSize;
+        }
+        return !members->empty();
+    }
+
+    // inflates members into a buffer holding all of them, in parallel. zlib checks the CRC and size of each member.
+    int inflateGZipBlocks(const unsigned char* in, const std::vector<GZipMember>& members, unsigned char** out, ssize_t* outLength)
+    {
+        const GZipMember& last = members.back();
+        size_t totalSize = last.outOffset + last.outSize;
+        *out = (unsigned char*)malloc(totalSize > 0 ? totalSize : 1);
+        if (!*out)
+            return Z_MEM_ERROR;
+
+        std::atomic<int> error(Z_OK);
+        ParallelTaskPool::getInstance()->parallelFor((int)members.size(), 1, [&](int begin, int end) {
+            for (int i = begin; i < end && error.load() == Z_OK; ++i)
+            {
+                const GZipMember& member = members[i];
+                z_stream stream;
+                memset(&stream, 0, sizeof(stream));
+                stream.next_in = const_cast<Bytef*>(in + member.offset);
+                stream.avail_in = static_cast<unsigned int>(member.size);
+                stream.next_out = *out + member.outOffset;
+                stream.avail_out = static_cast<unsigned int>(member.outSize);
+
+                int err = inflateInit2(&stream, 15 + 16);
+                if (err == Z_OK)
+                {
+                    err = inflate(&stream, Z_FINISH);
+                    err = (err == Z_STREAM_END && stream.total_out == member.outSize) ? Z_OK : Z_DATA_ERROR;
+                    inflateEnd(&stream);
+                }
+                if (err != Z_OK)
+                {
+                    error = err;
+                }
+            }
+        });
+
+        if (error.load() != Z_OK)
+        {
+            free(*out);
+            *out = nullptr;
+            return error.load();
+        }
+        *outLength = totalSize;
+        return Z_OK;
+    }
+}
+
 int ZipUtils::inflateMemoryWithHint(unsigned char *in, ssize_t inLength, unsigned char **out, ssize_t *outLength, ssize_t outLengthHint)
 {
+    *out = nullptr;
+
+    std::vector<GZipMember> members;
+    if (indexGZipBlocks(in, inLength, &members))
+    {
+        return inflateGZipBlocks(in, members, out, outLength);
+    }
+
     /* ret value */
     int err = Z_OK;
     
-    ssize_t bufferSize = outLengthHint;
+    // a gzip trailer tells the size of the last member, which is the whole size unless there are several members
+    ssize_t bufferSize = std::max(std::max(outLengthHint, getGZipSizeHint(in, inLength)), (ssize_t)64);
     *out = (unsigned char*)malloc(bufferSize);
+    if (! *out)
+    {
+        return Z_MEM_ERROR;
+    }
     
     z_stream d_stream; /* decompression stream */
     d_stream.zalloc = (alloc_func)0;
@@ -167,40 +319,50 @@ int ZipUtils::inflateMemoryWithHint(unsigned char *in, ssize_t inLength, unsigne
     
     for (;;)
     {
-        err = inflate(&d_stream, Z_NO_FLUSH);
+        // Z_FINISH lets zlib inflate straight into the output when it is large enough, without updating its window
+        err = inflate(&d_stream, Z_FINISH);
         
         if (err == Z_STREAM_END)
         {
+            // gzip files may hold several members, one after the other
+            if (isGZipBuffer(d_stream.next_in, d_stream.avail_in))
+            {
+                inflateReset(&d_stream);
+                continue;
+            }
             break;
         }
         
-        switch (err)
+        if (err == Z_BUF_ERROR && d_stream.avail_out == 0)
         {
-            case Z_NEED_DICT:
-                err = Z_DATA_ERROR;
-            case Z_DATA_ERROR:
-            case Z_MEM_ERROR:
-                inflateEnd(&d_stream);
-                return err;
-        }
-        
-        // not enough memory ?
-        if (err != Z_STREAM_END)
-        {
-            *out = (unsigned char*)realloc(*out, bufferSize * BUFFER_INC_FACTOR);
+            // not enough memory, grow by what the rest of the input should inflate to, going by the ratio so far
+            ssize_t used = bufferSize;
+            ssize_t estimate = (ssize_t)((double)d_stream.total_out / std::max(d_stream.total_in, (uLong)1) * d_stream.avail_in * 1.125);
+            ssize_t newSize = std::max(used + estimate + 4096, used + used / BUFFER_INC_FACTOR);
+            unsigned char* tmp = (unsigned char*)realloc(*out, newSize);
             
             /* not enough memory, ouch */
-            if (! *out )
+            if (! tmp )
             {
                 CCLOG("cocos2d: ZipUtils: realloc failed");
                 inflateEnd(&d_stream);
                 return Z_MEM_ERROR;
             }
             
-            d_stream.next_out = *out + bufferSize;
-            d_stream.avail_out = static_cast<unsigned int>(bufferSize);
-            bufferSize *= BUFFER_INC_FACTOR;
+            *out = tmp;
+            d_stream.next_out = *out + used;
+            d_stream.avail_out = static_cast<unsigned int>(newSize - used);
+            bufferSize = newSize;
+            continue;
         }
+        
+        // Z_BUF_ERROR with room left in the output means the input is truncated
+        if (err == Z_NEED_DICT || err == Z_BUF_ERROR)
+        {
+            err = Z_DATA_ERROR;
+        }
+        inflateEnd(&d_stream);
+        return err;
     }
     
     *outLength = bufferSize - d_stream.avail_out;
@@ -247,74 +409,127 @@ ssize_t ZipUtils::inflateMemory(unsigned char *in, ssize_t inLength, unsigned ch
     return inflateMemoryWithHint(in, inLength, out, 256 * 1024);
 }
 
+ssize_t ZipUtils::inflateGZipBuffer(const unsigned char *in, ssize_t inLength, unsigned char **out)
+{
+    CCASSERT(out, "out can't be nullptr.");
+
+    if (!isGZipBuffer(in, inLength))
+    {
+        CCLOG("cocos2d: ZipUtils: Invalid gzip data");
+        *out = nullptr;
+        return -1;
+    }
+
+    // the size is read from the gzip trailer
+    ssize_t outLength = inflateMemoryWithHint(const_cast<unsigned char*>(in), inLength, out, 0);
+    return *out ? outLength : -1;
+}
+
 int ZipUtils::inflateGZipFile(const char *path, unsigned char **out)
 {
-    int len;
-    unsigned int offset = 0;
-    
     CCASSERT(out, "out can't be nullptr.");
     CCASSERT(&*out, "&*out can't be nullptr.");
     
-    gzFile inFile = gzopen(FileUtils::getInstance()->getSuitableFOpen(path).c_str(), "rb");
-    if( inFile == nullptr ) {
+    Data compressedData = FileUtils::getInstance()->getDataFromFile(path);
+    if (compressedData.isNull())
+    {
         CCLOG("cocos2d: ZipUtils: error open gzip file: %s", path);
         return -1;
     }
     
-    /* 512k initial decompress buffer */
-    unsigned int bufferSize = 512 * 1024;
-    unsigned int totalBufferSize = bufferSize;
-    
-    *out = (unsigned char*)malloc( bufferSize );
-    if( ! out )
+    if (!isGZipBuffer(compressedData.getBytes(), compressedData.getSize()))
     {
-        CCLOG("cocos2d: ZipUtils: out of memory");
-        return -1;
+        // like gzread, a file which isn't compressed is read as is
+        ssize_t size = 0;
+        *out = compressedData.takeBuffer(&size);
+        return (int)size;
     }
     
-    for (;;) {
-        len = gzread(inFile, *out + offset, bufferSize);
-        if (len < 0)
-        {
-            CCLOG("cocos2d: ZipUtils: error in gzread");
-            free( *out );
-            *out = nullptr;
-            return -1;
-        }
-        if (len == 0)
-        {
-            break;
-        }
-        
-        offset += len;
-        
-        // finish reading the file
-        if( (unsigned int)len < bufferSize )
-        {
-            break;
-        }
-        
-        bufferSize *= BUFFER_INC_FACTOR;
-        totalBufferSize += bufferSize;
-        unsigned char *tmp = (unsigned char*)realloc(*out, totalBufferSize );
-        
-        if( ! tmp )
+    return (int)inflateGZipBuffer(compressedData.getBytes(), compressedData.getSize(), out);
+}
+
+ssize_t ZipUtils::deflateGZipBlocks(const unsigned char *in, ssize_t inLength, unsigned char **out, ssize_t blockSize, int level)
+{
+    CCASSERT(out, "out can't be nullptr.");
+    CCASSERT(blockSize > 0 && blockSize <= (1 << 30), "blockSize must be in (0, 1GB].");
+    
+    *out = nullptr;
+    size_t blockCount = std::max((size_t)((inLength + blockSize - 1) / blockSize), (size_t)1);
+    std::vector<std::vector<unsigned char>> blocks(blockCount);
+    std::atomic<bool> failed(false);
+    
+    ParallelTaskPool::getInstance()->parallelFor((int)blockCount, 1, [&](int begin, int end) {
+        for (int i = begin; i < end && !failed.load(); ++i)
         {
-            CCLOG("cocos2d: ZipUtils: out of memory");
-            free( *out );
-            *out = nullptr;
-            return -1;
+            size_t offset = (size_t)i * blockSize;
+            size_t size = std::min((size_t)blockSize, (size_t)inLength - offset);
+            
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            // raw deflate, the gzip header and trailer are written here to add the size of the member
+            if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                failed = true;
+                break;
+            }
+            
+            std::vector<unsigned char>& block = blocks[i];
+            uLong bound = deflateBound(&stream, (uLong)size);
+            block.resize(GZIP_BLOCK_HEADER_SIZE + bound + GZIP_TRAILER_SIZE);
+            stream.next_in = const_cast<Bytef*>(in + offset);
+            stream.avail_in = static_cast<unsigned int>(size);
+            stream.next_out = block.data() + GZIP_BLOCK_HEADER_SIZE;
+            stream.avail_out = static_cast<unsigned int>(bound);
+            
+            int err = deflate(&stream, Z_FINISH);
+            deflateEnd(&stream);
+            if (err != Z_STREAM_END)
+            {
+                failed = true;
+                break;
+            }
+            
+            size_t memberSize = GZIP_BLOCK_HEADER_SIZE + stream.total_out + GZIP_TRAILER_SIZE;
+            block.resize(memberSize);
+            
+            // gzip header with FEXTRA, xfl 0, OS unknown, and an extra field of 8 bytes
+            const unsigned char header[] = {
+                0x1F, 0x8B, Z_DEFLATED, 0x04, 0, 0, 0, 0, 0, 0xFF,
+                8, 0, GZIP_BLOCK_SUBFIELD_ID1, GZIP_BLOCK_SUBFIELD_ID2, 4, 0
+            };
+            memcpy(block.data(), header, sizeof(header));
+            writeLittleEndian32(block.data() + 16, (uint32_t)memberSize);
+            writeLittleEndian32(block.data() + memberSize - 8, (uint32_t)crc32(crc32(0, Z_NULL, 0), in + offset, (uInt)size));
+            writeLittleEndian32(block.data() + memberSize - 4, (uint32_t)size);
         }
-        
-        *out = tmp;
+    });
+    
+    if (failed.load())
+    {
+        CCLOG("cocos2d: ZipUtils: deflate failed");
+        return -1;
+    }
+    
+    size_t totalSize = 0;
+    for (const auto& block : blocks)
+    {
+        totalSize += block.size();
     }
     
-    if (gzclose(inFile) != Z_OK)
+    *out = (unsigned char*)malloc(totalSize);
+    if (! *out)
     {
-        CCLOG("cocos2d: ZipUtils: gzclose failed");
+        CCLOG("cocos2d: ZipUtils: out of memory");
+        return -1;
     }
     
-    return offset;
+    size_t offset = 0;
+    for (const auto& block : blocks)
+    {
+        memcpy(*out + offset, block.data(), block.size());
+        offset += block.size();
+    }
+    return totalSize;
 }
 
 bool ZipUtils::isCCZFile(const char *path)
@@ -371,6 +586,7 @@ bool ZipUtils::isGZipBuffer(const unsigned char *buffer, ssize_t len)
 int ZipUtils::inflateCCZBuffer(const unsigned char *buffer, ssize_t bufferLen, unsigned char **out)
 {
     struct CCZHeader *header = (struct CCZHeader*) buffer;
+    std::vector<unsigned char> decrypted;
 
     // verify header
     if( header->sig[0] == 'C' && header->sig[1] == 'C' && header->sig[2] == 'Z' && header->sig[3] == '!' )
@@ -410,8 +626,11 @@ int ZipUtils::inflateCCZBuffer(const unsigned char *buffer, ssize_t bufferLen, u
             return -1;
         }
 
-        // decrypt
-        unsigned int* ints = (unsigned int*)(buffer+12);
+        // decrypt a copy, the buffer is const and may be a read only view of the file
+        decrypted.assign(buffer, buffer + bufferLen);
+        buffer = decrypted.data();
+        header = (struct CCZHeader*) buffer;
+        unsigned int* ints = (unsigned int*)(decrypted.data()+12);
         ssize_t enclen = (bufferLen-12)/4;
 
         decodeEncodedPvr(ints, enclen);
@@ -500,22 +719,589 @@ void ZipUtils::setPvrEncryptionKey(unsigned int keyPart1, unsigned int keyPart2,
 
 static const std::string emptyFilename("");
 
+namespace
+{
+    const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    const uint32_t ZIP_END_SIGNATURE = 0x06054b50;
+    const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+    const uint32_t ZIP64_END_LOCATOR_SIGNATURE = 0x07064b50;
+    const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+    const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+    const size_t ZIP_END_SIZE = 22;
+    const size_t ZIP64_END_SIZE = 56;
+    // size of the chunks of ZipFile::readFile
+    const size_t ZIP_READ_CHUNK_SIZE = 64 * 1024;
+    const size_t ZIP64_END_LOCATOR_SIZE = 20;
+    const size_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+    const uint16_t ZIP64_EXTRA_ID = 0x0001;
+
+    uint16_t readLittleEndian16(const unsigned char* p)
+    {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    uint64_t readLittleEndian64(const unsigned char* p)
+    {
+        return (uint64_t)readLittleEndian32(p) | ((uint64_t)readLittleEndian32(p + 4) << 32);
+    }
+}
+
 struct ZipEntryInfo
 {
     unz_file_pos pos;
     uLong uncompressed_size;
+    // read without minizip when the entry is stored or deflated, and not encrypted
+    bool direct;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t localHeaderOffset;
 };
 
 class ZipFilePrivate
 {
 public:
+    ZipFilePrivate();
+    ~ZipFilePrivate();
+
+    bool openArchive(const std::string& path);
+    void setArchiveBuffer(const void* buffer, uLong size);
+    void closeArchive();
+
+    /** Lists the entries from the central directory, returns false if it can't be read without minizip. */
+    bool readCentralDirectory(const std::string& filter);
+    /** Lists the entries with minizip. */
+    void readEntriesWithMinizip(const std::string& filter);
+    void addEntry(const std::string& name, const ZipEntryInfo& entry);
+
+    bool readAt(uint64_t offset, size_t size, unsigned char* dest);
+    bool readEntry(const ZipEntryInfo& entry, unsigned char* dest);
+    bool readEntryWithMinizip(const ZipEntryInfo& entry, unsigned char* dest);
+    /** Reads an entry in chunks of ZIP_READ_CHUNK_SIZE, which are passed to consumer. */
+    bool readEntryInChunks(const ZipEntryInfo& entry, const std::function<bool(const unsigned char*, size_t)>& consumer);
+    bool readEntryInChunksWithMinizip(const ZipEntryInfo& entry, const std::function<bool(const unsigned char*, size_t)>& consumer);
+    /** Gets the offset of the data of a direct entry, after its local header. */
+    bool getEntryDataOffset(const ZipEntryInfo& entry, uint64_t* offset);
+
     unzFile zipFile;
-    
+    // minizip reads one file at a time
+    std::mutex zipFileMutex;
+
+    // the archive read without minizip, either the buffer of createWithBuffer or a file
+    const unsigned char* archiveBuffer;
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    // there is no pread, the reads are serialized but entries are still inflated in parallel
+    FILE* archiveFile;
+    std::mutex archiveFileMutex;
+#else
+    int archiveFile;
+#endif
+    uint64_t archiveSize;
+    // size of any data before the archive, e.g. of a self-extracting archive
+    uint64_t archiveBase;
+
     // std::unordered_map is faster if available on the platform
     typedef std::unordered_map<std::string, struct ZipEntryInfo> FileListContainer;
     FileListContainer fileList;
+    // names of fileList in the order of the archive
+    std::vector<std::string> fileNames;
 };
 
+ZipFilePrivate::ZipFilePrivate()
+: zipFile(nullptr)
+, archiveBuffer(nullptr)
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+, archiveFile(nullptr)
+#else
+, archiveFile(-1)
+#endif
+, archiveSize(0)
+, archiveBase(0)
+{
+}
+
+ZipFilePrivate::~ZipFilePrivate()
+{
+    if (zipFile)
+    {
+        unzClose(zipFile);
+    }
+    closeArchive();
+}
+
+bool ZipFilePrivate::openArchive(const std::string& path)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    archiveFile = fopen(path.c_str(), "rb");
+    if (!archiveFile)
+        return false;
+    _fseeki64(archiveFile, 0, SEEK_END);
+    archiveSize = (uint64_t)_ftelli64(archiveFile);
+#else
+    archiveFile = open(path.c_str(), O_RDONLY);
+    if (archiveFile < 0)
+        return false;
+    struct stat st;
+    if (fstat(archiveFile, &st) != 0)
+    {
+        closeArchive();
+        return false;
+    }
+    archiveSize = (uint64_t)st.st_size;
+#endif
+    return true;
+}
+
+void ZipFilePrivate::setArchiveBuffer(const void* buffer, uLong size)
+{
+    archiveBuffer = (const unsigned char*)buffer;
+    archiveSize = size;
+}
+
+void ZipFilePrivate::closeArchive()
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    if (archiveFile)
+    {
+        fclose(archiveFile);
+        archiveFile = nullptr;
+    }
+#else
+    if (archiveFile >= 0)
+    {
+        close(archiveFile);
+        archiveFile = -1;
+    }
+#endif
+    archiveBuffer = nullptr;
+    archiveSize = 0;
+}
+
+bool ZipFilePrivate::readAt(uint64_t offset, size_t size, unsigned char* dest)
+{
+    if (offset > archiveSize || size > archiveSize - offset)
+        return false;
+
+    if (archiveBuffer)
+    {
+        memcpy(dest, archiveBuffer + offset, size);
+        return true;
+    }
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    std::lock_guard<std::mutex> lock(archiveFileMutex);
+    if (!archiveFile || _fseeki64(archiveFile, (__int64)offset, SEEK_SET) != 0)
+        return false;
+    return fread(dest, 1, size, archiveFile) == size;
+#else
+    if (archiveFile < 0)
+        return false;
+    while (size > 0)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+        ssize_t n = pread64(archiveFile, dest, size, (off64_t)offset);
+#else
+        ssize_t n = pread(archiveFile, dest, size, (off_t)offset);
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        dest += n;
+        offset += n;
+        size -= n;
+    }
+    return true;
+#endif
+}
+
+void ZipFilePrivate::addEntry(const std::string& name, const ZipEntryInfo& entry)
+{
+    if (fileList.find(name) == fileList.end())
+    {
+        fileNames.push_back(name);
+    }
+    fileList[name] = entry;
+}
+
+bool ZipFilePrivate::readCentralDirectory(const std::string& filter)
+{
+    if (archiveSize < ZIP_END_SIZE)
+        return false;
+
+    // the end of central directory record is followed by a comment of up to 64K
+    size_t tailSize = (size_t)std::min(archiveSize, (uint64_t)(ZIP_END_SIZE + ZIP_MAX_COMMENT_SIZE));
+    std::vector<unsigned char> tail(tailSize);
+    uint64_t tailOffset = archiveSize - tailSize;
+    if (!readAt(tailOffset, tailSize, tail.data()))
+        return false;
+
+    ssize_t endPos = -1;
+    for (ssize_t i = (ssize_t)(tailSize - ZIP_END_SIZE); i >= 0; --i)
+    {
+        if (readLittleEndian32(&tail[i]) == ZIP_END_SIGNATURE)
+        {
+            endPos = i;
+            break;
+        }
+    }
+    if (endPos < 0)
+        return false;
+
+    const unsigned char* end = &tail[endPos];
+    uint64_t endOffset = tailOffset + endPos;
+    uint64_t entryCount = readLittleEndian16(end + 10);
+    uint64_t directorySize = readLittleEndian32(end + 12);
+    uint64_t directoryOffset = readLittleEndian32(end + 16);
+    // multi-disk archives are left to minizip
+    if (readLittleEndian16(end + 4) != 0 || readLittleEndian16(end + 6) != 0)
+        return false;
+
+    uint64_t directoryEnd = endOffset;
+    if (entryCount == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF)
+    {
+        unsigned char locator[ZIP64_END_LOCATOR_SIZE];
+        unsigned char end64[ZIP64_END_SIZE];
+        if (endOffset < ZIP64_END_LOCATOR_SIZE
+            || !readAt(endOffset - ZIP64_END_LOCATOR_SIZE, ZIP64_END_LOCATOR_SIZE, locator)
+            || readLittleEndian32(locator) != ZIP64_END_LOCATOR_SIGNATURE)
+        {
+            return false;
+        }
+
+        // the zip64 end of central directory record is right before its locator
+        directoryEnd = endOffset - ZIP64_END_LOCATOR_SIZE;
+        if (directoryEnd < ZIP64_END_SIZE
+            || !readAt(directoryEnd - ZIP64_END_SIZE, ZIP64_END_SIZE, end64)
+            || readLittleEndian32(end64) != ZIP64_END_SIGNATURE)
+        {
+            return false;
+        }
+        directoryEnd -= ZIP64_END_SIZE;
+        entryCount = readLittleEndian64(end64 + 32);
+        directorySize = readLittleEndian64(end64 + 40);
+        directoryOffset = readLittleEndian64(end64 + 48);
+    }
+
+    if (directorySize > directoryEnd || directoryOffset > directoryEnd - directorySize)
+        return false;
+    // offsets are relative to the start of the archive
+    archiveBase = directoryEnd - directorySize - directoryOffset;
+
+    std::vector<unsigned char> directory((size_t)directorySize);
+    if (!readAt(archiveBase + directoryOffset, (size_t)directorySize, directory.data()))
+        return false;
+
+    std::vector<std::pair<std::string, ZipEntryInfo>> entries;
+    entries.reserve((size_t)std::min(entryCount, directorySize / ZIP_CENTRAL_HEADER_SIZE));
+    size_t offset = 0;
+    for (uint64_t i = 0; i < entryCount; ++i)
+    {
+        if (directory.size() - offset < ZIP_CENTRAL_HEADER_SIZE)
+            return false;
+        const unsigned char* header = &directory[offset];
+        if (readLittleEndian32(header) != ZIP_CENTRAL_HEADER_SIGNATURE)
+            return false;
+
+        uint16_t flags = readLittleEndian16(header + 8);
+        uint16_t nameSize = readLittleEndian16(header + 28);
+        uint16_t extraSize = readLittleEndian16(header + 30);
+        uint16_t commentSize = readLittleEndian16(header + 32);
+        size_t headerSize = ZIP_CENTRAL_HEADER_SIZE + nameSize + extraSize + commentSize;
+        if (directory.size() - offset < headerSize)
+            return false;
+
+        ZipEntryInfo entry;
+        memset(&entry.pos, 0, sizeof(entry.pos));
+        entry.method = readLittleEndian16(header + 10);
+        entry.crc = readLittleEndian32(header + 16);
+        entry.compressedSize = readLittleEndian32(header + 20);
+        uint64_t uncompressedSize = readLittleEndian32(header + 24);
+        entry.localHeaderOffset = readLittleEndian32(header + 42);
+
+        // sizes and offset which don't fit in 32 bits are in the zip64 extra field, in this order
+        const unsigned char* extra = header + ZIP_CENTRAL_HEADER_SIZE + nameSize;
+        const unsigned char* extraEnd = extra + extraSize;
+        while (extraEnd - extra >= 4)
+        {
+            uint16_t id = readLittleEndian16(extra);
+            uint16_t size = readLittleEndian16(extra + 2);
+            const unsigned char* field = extra + 4;
+            if (size > extraEnd - field)
+                break;
+            if (id == ZIP64_EXTRA_ID)
+            {
+                const unsigned char* fieldEnd = field + size;
+                uint64_t* values[] = { &uncompressedSize, &entry.compressedSize, &entry.localHeaderOffset };
+                for (uint64_t* value : values)
+                {
+                    if (*value != 0xFFFFFFFF)
+                        continue;
+                    if (fieldEnd - field < 8)
+                        return false;
+                    *value = readLittleEndian64(field);
+                    field += 8;
+                }
+            }
+            extra += 4 + size;
+        }
+
+        if (uncompressedSize > std::numeric_limits<uLong>::max())
+            return false;
+        entry.uncompressed_size = (uLong)uncompressedSize;
+        entry.direct = (flags & 1) == 0 && (entry.method == 0 || entry.method == Z_DEFLATED);
+
+        std::string name((const char*)header + ZIP_CENTRAL_HEADER_SIZE, nameSize);
+        offset += headerSize;
+
+        // cache info about filtered files only (like 'assets/')
+        if (filter.empty() || name.compare(0, filter.length(), filter) == 0)
+        {
+            entries.push_back(std::make_pair(std::move(name), entry));
+        }
+    }
+
+    for (auto& entry : entries)
+    {
+        // minizip reads what can't be read directly, e.g. encrypted entries
+        if (!entry.second.direct)
+        {
+            if (!zipFile
+                || unzLocateFile(zipFile, entry.first.c_str(), 1) != UNZ_OK
+                || unzGetFilePos(zipFile, &entry.second.pos) != UNZ_OK)
+            {
+                continue;
+            }
+        }
+        addEntry(entry.first, entry.second);
+    }
+    return true;
+}
+
+void ZipFilePrivate::readEntriesWithMinizip(const std::string& filter)
+{
+    // UNZ_MAXFILENAMEINZIP + 1 - it is done so in unzLocateFile
+    char szCurrentFileName[UNZ_MAXFILENAMEINZIP + 1];
+    unz_file_info64 fileInfo;
+    
+    // go through all files and store position information about the required files
+    int err = unzGoToFirstFile64(zipFile, &fileInfo,
+                                 szCurrentFileName, sizeof(szCurrentFileName) - 1);
+    while (err == UNZ_OK)
+    {
+        unz_file_pos posInfo;
+        int posErr = unzGetFilePos(zipFile, &posInfo);
+        if (posErr == UNZ_OK)
+        {
+            std::string currentFileName = szCurrentFileName;
+            // cache info about filtered files only (like 'assets/')
+            if (filter.empty()
+                || currentFileName.substr(0, filter.length()) == filter)
+            {
+                ZipEntryInfo entry;
+                entry.pos = posInfo;
+                entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
+                entry.direct = false;
+                entry.method = 0;
+                entry.crc = 0;
+                entry.compressedSize = 0;
+                entry.localHeaderOffset = 0;
+                addEntry(currentFileName, entry);
+            }
+        }
+        // next file - also get the information about it
+        err = unzGoToNextFile64(zipFile, &fileInfo,
+                                szCurrentFileName, sizeof(szCurrentFileName) - 1);
+    }
+}
+
+bool ZipFilePrivate::readEntry(const ZipEntryInfo& entry, unsigned char* dest)
+{
+    if (!entry.direct)
+    {
+        return readEntryWithMinizip(entry, dest);
+    }
+
+    uint64_t dataOffset = 0;
+    if (!getEntryDataOffset(entry, &dataOffset))
+        return false;
+
+    if (entry.method == 0)
+    {
+        if (entry.compressedSize != entry.uncompressed_size || !readAt(dataOffset, entry.uncompressed_size, dest))
+            return false;
+    }
+    else
+    {
+        if (dataOffset > archiveSize || entry.compressedSize > archiveSize - dataOffset
+            || entry.compressedSize > 0xFFFFFFFF || entry.uncompressed_size > 0xFFFFFFFF)
+        {
+            return false;
+        }
+
+        // a buffer is inflated in place, a file is read first
+        std::vector<unsigned char> compressed;
+        const unsigned char* source = archiveBuffer ? archiveBuffer + dataOffset : nullptr;
+        if (!source)
+        {
+            compressed.resize((size_t)entry.compressedSize);
+            if (!readAt(dataOffset, compressed.size(), compressed.data()))
+                return false;
+            source = compressed.data();
+        }
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+            return false;
+        stream.next_in = const_cast<Bytef*>(source);
+        stream.avail_in = static_cast<unsigned int>(entry.compressedSize);
+        stream.next_out = dest;
+        stream.avail_out = static_cast<unsigned int>(entry.uncompressed_size);
+        int err = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if (err != Z_STREAM_END || stream.total_out != entry.uncompressed_size)
+            return false;
+    }
+
+    return crc32(crc32(0, Z_NULL, 0), dest, (uInt)entry.uncompressed_size) == entry.crc;
+}
+
+bool ZipFilePrivate::readEntryWithMinizip(const ZipEntryInfo& entry, unsigned char* dest)
+{
+    std::lock_guard<std::mutex> lock(zipFileMutex);
+    if (!zipFile)
+        return false;
+
+    unz_file_pos pos = entry.pos;
+    if (unzGoToFilePos(zipFile, &pos) != UNZ_OK || unzOpenCurrentFile(zipFile) != UNZ_OK)
+        return false;
+
+    int nSize = unzReadCurrentFile(zipFile, dest, static_cast<unsigned int>(entry.uncompressed_size));
+    unzCloseCurrentFile(zipFile);
+    return nSize == (int)entry.uncompressed_size;
+}
+
+bool ZipFilePrivate::getEntryDataOffset(const ZipEntryInfo& entry, uint64_t* offset)
+{
+    // the data follows the local header, whose name and extra field may differ from the central directory
+    unsigned char header[ZIP_LOCAL_HEADER_SIZE];
+    uint64_t headerOffset = archiveBase + entry.localHeaderOffset;
+    if (!readAt(headerOffset, sizeof(header), header) || readLittleEndian32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+        return false;
+    *offset = headerOffset + ZIP_LOCAL_HEADER_SIZE + readLittleEndian16(header + 26) + readLittleEndian16(header + 28);
+    return true;
+}
+
+bool ZipFilePrivate::readEntryInChunks(const ZipEntryInfo& entry, const std::function<bool(const unsigned char*, size_t)>& consumer)
+{
+    if (!entry.direct)
+    {
+        return readEntryInChunksWithMinizip(entry, consumer);
+    }
+
+    uint64_t dataOffset = 0;
+    if (!getEntryDataOffset(entry, &dataOffset)
+        || dataOffset > archiveSize || entry.compressedSize > archiveSize - dataOffset)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> output(ZIP_READ_CHUNK_SIZE);
+    uLong crc = crc32(0, Z_NULL, 0);
+    uint64_t total = 0;
+
+    if (entry.method == 0)
+    {
+        if (entry.compressedSize != entry.uncompressed_size)
+            return false;
+        while (total < entry.uncompressed_size)
+        {
+            size_t size = (size_t)std::min<uint64_t>(output.size(), entry.uncompressed_size - total);
+            if (!readAt(dataOffset + total, size, output.data()) || !consumer(output.data(), size))
+                return false;
+            crc = crc32(crc, output.data(), (uInt)size);
+            total += size;
+        }
+        return crc == entry.crc;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+
+    // a buffer is inflated in place, a file is read in chunks too
+    std::vector<unsigned char> input;
+    uint64_t consumed = 0;
+    int err = Z_OK;
+    while (err == Z_OK)
+    {
+        if (stream.avail_in == 0 && consumed < entry.compressedSize)
+        {
+            size_t size = (size_t)std::min<uint64_t>(ZIP_READ_CHUNK_SIZE, entry.compressedSize - consumed);
+            if (archiveBuffer)
+            {
+                stream.next_in = const_cast<Bytef*>(archiveBuffer + dataOffset + consumed);
+            }
+            else
+            {
+                input.resize(size);
+                if (!readAt(dataOffset + consumed, size, input.data()))
+                    break;
+                stream.next_in = input.data();
+            }
+            stream.avail_in = (uInt)size;
+            consumed += size;
+        }
+
+        stream.next_out = output.data();
+        stream.avail_out = (uInt)output.size();
+        err = inflate(&stream, Z_NO_FLUSH);
+        size_t size = output.size() - stream.avail_out;
+        if (size > 0)
+        {
+            if (!consumer(output.data(), size))
+                break;
+            crc = crc32(crc, output.data(), (uInt)size);
+            total += size;
+        }
+        // the compressed data ended before the stream
+        if (err == Z_BUF_ERROR && stream.avail_in == 0 && consumed == entry.compressedSize)
+            break;
+        if (err == Z_BUF_ERROR)
+            err = Z_OK;
+    }
+    inflateEnd(&stream);
+
+    return err == Z_STREAM_END && total == entry.uncompressed_size && crc == entry.crc;
+}
+
+bool ZipFilePrivate::readEntryInChunksWithMinizip(const ZipEntryInfo& entry, const std::function<bool(const unsigned char*, size_t)>& consumer)
+{
+    std::lock_guard<std::mutex> lock(zipFileMutex);
+    if (!zipFile)
+        return false;
+
+    unz_file_pos pos = entry.pos;
+    if (unzGoToFilePos(zipFile, &pos) != UNZ_OK || unzOpenCurrentFile(zipFile) != UNZ_OK)
+        return false;
+
+    std::vector<unsigned char> output(ZIP_READ_CHUNK_SIZE);
+    uint64_t total = 0;
+    int size = 0;
+    while ((size = unzReadCurrentFile(zipFile, output.data(), (unsigned int)output.size())) > 0)
+    {
+        if (!consumer(output.data(), (size_t)size))
+            break;
+        total += size;
+    }
+    // minizip checks the CRC when the file is closed
+    bool ret = size == 0 && total == entry.uncompressed_size;
+    return unzCloseCurrentFile(zipFile) == UNZ_OK && ret;
+}
+
 ZipFile *ZipFile::createWithBuffer(const void* buffer, uLong size)
 {
     ZipFile *zip = new (std::nothrow) ZipFile();
@@ -530,23 +1316,22 @@ ZipFile *ZipFile::createWithBuffer(const void* buffer, uLong size)
 ZipFile::ZipFile()
 : _data(new ZipFilePrivate)
 {
-    _data->zipFile = nullptr;
 }
 
 ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
 : _data(new ZipFilePrivate)
 {
-    _data->zipFile = unzOpen(FileUtils::getInstance()->getSuitableFOpen(zipFile).c_str());
+    std::string path = FileUtils::getInstance()->getSuitableFOpen(zipFile);
+    _data->zipFile = unzOpen(path.c_str());
+    if (_data->zipFile)
+    {
+        _data->openArchive(path);
+    }
     setFilter(filter);
 }
 
 ZipFile::~ZipFile()
 {
-    if (_data && _data->zipFile)
-    {
-        unzClose(_data->zipFile);
-    }
-
     CC_SAFE_DELETE(_data);
 }
 
@@ -558,36 +1343,18 @@ bool ZipFile::setFilter(const std::string &filter)
         CC_BREAK_IF(!_data);
         CC_BREAK_IF(!_data->zipFile);
         
+        std::lock_guard<std::mutex> lock(_data->zipFileMutex);
+
         // clear existing file list
         _data->fileList.clear();
+        _data->fileNames.clear();
         
-        // UNZ_MAXFILENAMEINZIP + 1 - it is done so in unzLocateFile
-        char szCurrentFileName[UNZ_MAXFILENAMEINZIP + 1];
-        unz_file_info64 fileInfo;
-        
-        // go through all files and store position information about the required files
-        int err = unzGoToFirstFile64(_data->zipFile, &fileInfo,
-                                     szCurrentFileName, sizeof(szCurrentFileName) - 1);
-        while (err == UNZ_OK)
+        if (!_data->readCentralDirectory(filter))
         {
-            unz_file_pos posInfo;
-            int posErr = unzGetFilePos(_data->zipFile, &posInfo);
-            if (posErr == UNZ_OK)
-            {
-                std::string currentFileName = szCurrentFileName;
-                // cache info about filtered files only (like 'assets/')
-                if (filter.empty()
-                    || currentFileName.substr(0, filter.length()) == filter)
-                {
-                    ZipEntryInfo entry;
-                    entry.pos = posInfo;
-                    entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
-                    _data->fileList[currentFileName] = entry;
-                }
-            }
-            // next file - also get the information about it
-            err = unzGoToNextFile64(_data->zipFile, &fileInfo,
-                                    szCurrentFileName, sizeof(szCurrentFileName) - 1);
+            // e.g. a split archive, everything is read by minizip
+            _data->fileList.clear();
+            _data->fileNames.clear();
+            _data->readEntriesWithMinizip(filter);
         }
         ret = true;
         
@@ -596,6 +1363,11 @@ bool ZipFile::setFilter(const std::string &filter)
     return ret;
 }
 
+bool ZipFile::isOpen() const
+{
+    return _data && _data->zipFile;
+}
+
 bool ZipFile::fileExists(const std::string &fileName) const
 {
     bool ret = false;
@@ -609,6 +1381,17 @@ bool ZipFile::fileExists(const std::string &fileName) const
     return ret;
 }
 
+const std::vector<std::string>& ZipFile::getFileNames() const
+{
+    return _data->fileNames;
+}
+
+ssize_t ZipFile::getFileSize(const std::string &fileName) const
+{
+    auto it = _data->fileList.find(fileName);
+    return it != _data->fileList.end() ? (ssize_t)it->second.uncompressed_size : -1;
+}
+
 unsigned char *ZipFile::getFileData(const std::string &fileName, ssize_t *size)
 {
     unsigned char * buffer = nullptr;
@@ -623,23 +1406,22 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, ssize_t *size)
         ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
         CC_BREAK_IF(it ==  _data->fileList.end());
         
-        ZipEntryInfo fileInfo = it->second;
+        const ZipEntryInfo& fileInfo = it->second;
         
-        int nRet = unzGoToFilePos(_data->zipFile, &fileInfo.pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        nRet = unzOpenCurrentFile(_data->zipFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        buffer = (unsigned char*)malloc(fileInfo.uncompressed_size);
-        int CC_UNUSED nSize = unzReadCurrentFile(_data->zipFile, buffer, static_cast<unsigned int>(fileInfo.uncompressed_size));
-        CCASSERT(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
+        buffer = (unsigned char*)malloc(fileInfo.uncompressed_size > 0 ? fileInfo.uncompressed_size : 1);
+        CC_BREAK_IF(!buffer);
+        if (!_data->readEntry(fileInfo, buffer))
+        {
+            CCLOG("cocos2d: ZipFile: can't read %s", fileName.c_str());
+            free(buffer);
+            buffer = nullptr;
+            break;
+        }
         
         if (size)
         {
             *size = fileInfo.uncompressed_size;
         }
-        unzCloseCurrentFile(_data->zipFile);
     } while (0);
     
     return buffer;
@@ -656,26 +1438,40 @@ bool ZipFile::getFileData(const std::string &fileName, ResizableBuffer* buffer)
         ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
         CC_BREAK_IF(it ==  _data->fileList.end());
         
-        ZipEntryInfo fileInfo = it->second;
-        
-        int nRet = unzGoToFilePos(_data->zipFile, &fileInfo.pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        nRet = unzOpenCurrentFile(_data->zipFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
+        const ZipEntryInfo& fileInfo = it->second;
         
         buffer->resize(fileInfo.uncompressed_size);
-        int CC_UNUSED nSize = unzReadCurrentFile(_data->zipFile, buffer->buffer(), static_cast<unsigned int>(fileInfo.uncompressed_size));
-        CCASSERT(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
-        unzCloseCurrentFile(_data->zipFile);
+        if (fileInfo.uncompressed_size > 0 && !_data->readEntry(fileInfo, (unsigned char*)buffer->buffer()))
+        {
+            CCLOG("cocos2d: ZipFile: can't read %s", fileName.c_str());
+            break;
+        }
         res = true;
     } while (0);
     
     return res;
 }
 
+bool ZipFile::readFile(const std::string &fileName, const std::function<bool(const unsigned char*, size_t)>& consumer)
+{
+    if (!_data->zipFile || fileName.empty())
+        return false;
+
+    auto it = _data->fileList.find(fileName);
+    if (it == _data->fileList.end())
+        return false;
+
+    if (!_data->readEntryInChunks(it->second, consumer))
+    {
+        CCLOG("cocos2d: ZipFile: can't read %s", fileName.c_str());
+        return false;
+    }
+    return true;
+}
+
 std::string ZipFile::getFirstFilename()
 {
+    std::lock_guard<std::mutex> lock(_data->zipFileMutex);
     if (unzGoToFirstFile(_data->zipFile) != UNZ_OK) return emptyFilename;
     std::string path;
     unz_file_info info;
@@ -685,6 +1481,7 @@ std::string ZipFile::getFirstFilename()
 
 std::string ZipFile::getNextFilename()
 {
+    std::lock_guard<std::mutex> lock(_data->zipFileMutex);
     if (unzGoToNextFile(_data->zipFile) != UNZ_OK) return emptyFilename;
     std::string path;
     unz_file_info info;
@@ -711,6 +1508,7 @@ bool ZipFile::initWithBuffer(const void *buffer, uLong size)
     _data->zipFile = unzOpenBuffer(buffer, size);
     if (!_data->zipFile) return false;
     
+    _data->setArchiveBuffer(buffer, size);
     setFilter(emptyFilename);
     return true;
 }
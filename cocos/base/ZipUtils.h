@@ -28,6 +28,8 @@ THE SOFTWARE.
 /// @cond DO_NOT_SHOW
 
 #include <string>
+#include <vector>
+#include <functional>
 #include "platform/CCPlatformConfig.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCPlatformDefine.h"
@@ -86,6 +88,7 @@ typedef struct unz_file_info_s unz_file_info;
         * Inflates either zlib or gzip deflated memory. The inflated memory is expected to be freed by the caller.
         *
         * @param outLengthHint It is assumed to be the needed room to allocate the inflated buffer.
+        * When it is the exact size, the buffer is allocated once and inflated in a single pass.
         *
         * @return The length of the deflated buffer.
         * @since v1.0.0
@@ -101,6 +104,28 @@ typedef struct unz_file_info_s unz_file_info;
          */
         CC_DEPRECATED_ATTRIBUTE static int ccInflateGZipFile(const char *filename, unsigned char **out) { return inflateGZipFile(filename, out); }
         static int inflateGZipFile(const char *filename, unsigned char **out);
+
+        /**
+         * Inflates a GZip buffer into memory, the buffer may hold several members.
+         * The output is allocated once, with the size read from the gzip trailer.
+         * Buffers written by deflateGZipBlocks are inflated in parallel.
+         *
+         * @return The length of the inflated buffer, or -1 on error.
+         * @since v3.15
+         */
+        static ssize_t inflateGZipBuffer(const unsigned char *in, ssize_t inLength, unsigned char **out);
+
+        /**
+         * Compresses a buffer in parallel into gzip members of blockSize bytes each, like pigz does.
+         * The output can be read by any gzip reader, and each member holds its compressed size in an extra field,
+         * so inflateGZipBuffer and inflateMemory inflate the members in parallel.
+         *
+         * @param blockSize Uncompressed size of a member.
+         * @param level zlib compression level, -1 for the default level.
+         * @return The length of the compressed buffer, or -1 on error.
+         * @since v3.15
+         */
+        static ssize_t deflateGZipBlocks(const unsigned char *in, ssize_t inLength, unsigned char **out, ssize_t blockSize = 1024 * 1024, int level = -1);
         
         /** 
          * Test a file is a GZip format file or not.
@@ -228,6 +253,10 @@ typedef struct unz_file_info_s unz_file_info;
     * It will cache the file list of a particular zip file with positions inside an archive,
     * so it would be much faster to read some particular files or to check their existence.
     *
+    * The central directory is parsed once, and stored or deflated files are then read with pread and inflated
+    * without minizip, so getFileData may be called from several threads at once. Other files, e.g. encrypted ones,
+    * are read by minizip one at a time. setFilter must not be called while files are read.
+    *
     * @since v2.0.5
     */
     class CC_DLL ZipFile
@@ -266,6 +295,15 @@ typedef struct unz_file_info_s unz_file_info;
         */
         bool fileExists(const std::string &fileName) const;
 
+        /** Returns true if the zip file was opened. @since v3.15 */
+        bool isOpen() const;
+
+        /** Returns the names of the accessible files, in the order of the zip file. @since v3.15 */
+        const std::vector<std::string>& getFileNames() const;
+
+        /** Returns the uncompressed size of a file, or -1 if it isn't in the zip file. @since v3.15 */
+        ssize_t getFileSize(const std::string &fileName) const;
+
         /**
         * Get resource file data from a zip file.
         * @param fileName File name
@@ -285,6 +323,16 @@ typedef struct unz_file_info_s unz_file_info;
         */
         bool getFileData(const std::string &fileName, ResizableBuffer* buffer);
 
+        /**
+        * Reads a file of the zip file in chunks, without holding it whole in memory, e.g. to extract it.
+        * Like getFileData, it may be called from several threads at once.
+        * @param fileName File name
+        * @param consumer Called with each chunk of the file, in order, reading stops when it returns false.
+        * @return True if the whole file was read and its CRC is valid.
+        * @since v3.15
+        */
+        bool readFile(const std::string &fileName, const std::function<bool(const unsigned char* data, size_t size)>& consumer);
+
         std::string getFirstFilename();
         std::string getNextFilename();
         
@@ -37,13 +37,13 @@ AllocatorDiagnostics::AllocatorDiagnostics()
 
 AllocatorDiagnostics* AllocatorDiagnostics::instance()
 {
-    static AllocatorDiagnostics* _this = nullptr;
-    if (nullptr == _this)
-    {
+    // the initialization of a local static is thread safe, allocators may be created by any thread
+    static AllocatorDiagnostics* _this = []() {
         // have to use global allocator because none of the constructors will have been called.
-        _this = (AllocatorDiagnostics*)ccAllocatorGlobal.allocate(sizeof(AllocatorDiagnostics));
-        new (_this) AllocatorDiagnostics();
-    }
+        auto diagnostics = (AllocatorDiagnostics*)ccAllocatorGlobal.allocate(sizeof(AllocatorDiagnostics));
+        CC_ASSERT(diagnostics);
+        return new (diagnostics) AllocatorDiagnostics();
+    }();
     return _this;
 }
 
@@ -27,6 +27,8 @@
 #define CC_ALLOCATOR_MACROS_H
 /// @cond DO_NOT_SHOW
 
+#include <new>
+
 #include "base/ccConfig.h"
 #include "platform/CCPlatformMacros.h"
 
@@ -87,6 +89,50 @@
             A.deallocate((T*)object, size); \
         }
 
+    // @brief declares pooled new/delete operators for class T, including the nothrow ones used by create().
+    // Must be placed in a public section of the class, and matched by CC_DEFINE_ALLOCATOR_POOL in its source file.
+    // Subclasses without their own pool inherit the operators and fall back to the global allocator.
+    #define CC_DECLARE_ALLOCATOR_POOL(T) \
+        static void* operator new (size_t size); \
+        static void* operator new (size_t size, const std::nothrow_t&) noexcept; \
+        static void operator delete (void* object, size_t size); \
+        static void operator delete (void* object, const std::nothrow_t&) noexcept;
+
+    // @brief defines the operators declared by CC_DECLARE_ALLOCATOR_POOL, using a thread safe
+    // AllocatorStrategyPool growing by S objects at a time.
+    // The pool is created on first use by any thread, so it does not read its page size from Configuration,
+    // and it is never destroyed, since pooled objects may outlive static destruction.
+    // Like the global operator new, the throwing operator throws std::bad_alloc when the pool can't grow.
+    // Requires "base/allocator/CCAllocatorStrategyPool.h".
+    #define CC_DEFINE_ALLOCATOR_POOL(T, S) \
+        typedef NS_CC_ALLOCATOR::AllocatorStrategyPool<T, NS_CC_ALLOCATOR::StorageTraits<T>, NS_CC_ALLOCATOR::locking_semantics> T##AllocatorPool; \
+        static T##AllocatorPool& get##T##AllocatorPool() \
+        { \
+            /* the initialization of a local static is thread safe */ \
+            static T##AllocatorPool* pool = new T##AllocatorPool("cocos2d.x.allocator.pool." #T, S, false); \
+            return *pool; \
+        } \
+        void* T::operator new (size_t size) \
+        { \
+            void* object = get##T##AllocatorPool().allocate(size); \
+            if (nullptr == object) \
+                throw std::bad_alloc(); \
+            return object; \
+        } \
+        void* T::operator new (size_t size, const std::nothrow_t&) noexcept \
+        { \
+            return get##T##AllocatorPool().allocate(size); \
+        } \
+        void T::operator delete (void* object, size_t size) \
+        { \
+            get##T##AllocatorPool().deallocate(object, size); \
+        } \
+        void T::operator delete (void* object, const std::nothrow_t&) noexcept \
+        { \
+            auto& pool = get##T##AllocatorPool(); \
+            pool.deallocate(object, pool.owns(object) ? sizeof(T) : 0); \
+        }
+
 #else
 
     // macros for new/delete
@@ -104,6 +150,8 @@
 
     // throw these away if not enabled
     #define CC_USE_ALLOCATOR_POOL(...)
+    #define CC_DECLARE_ALLOCATOR_POOL(...)
+    #define CC_DEFINE_ALLOCATOR_POOL(...)
     #define CC_OVERRIDE_GLOBAL_NEWDELETE_WITH_ALLOCATOR(...)
 
 #endif
@@ -43,20 +43,19 @@
     pthread_mutex_unlock(&m);
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32 || CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
 #include "windows.h"
-#define MUTEX HANDLE
+// critical sections are recursive and don't enter the kernel when uncontended, unlike mutex handles
+#define MUTEX CRITICAL_SECTION
 #if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
 #define MUTEX_INIT(m) \
-    m = CreateMutex(0, FALSE, 0)
-#define MUTEX_LOCK(m) \
-    WaitForSingleObject(m, INFINITE)
+    InitializeCriticalSection(&m)
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_WINRT
 #define MUTEX_INIT(m) \
-	m = CreateMutexEx(NULL,FALSE,0,NULL);
-#define MUTEX_LOCK(m) \
-    WaitForSingleObjectEx(m, INFINITE, false)
+    InitializeCriticalSectionEx(&m, 0, 0)
 #endif
+#define MUTEX_LOCK(m) \
+    EnterCriticalSection(&m)
 #define MUTEX_UNLOCK(m) \
-    ReleaseMutex(m)
+    LeaveCriticalSection(&m)
 #else
 #message "Unsupported platform for AllocatorMutex, Locking semantics will not be supported"
 #define MUTEX
@@ -78,8 +78,11 @@ public:
     {
 #if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
         _highestCount = 0;
+        _pageCount = 0;
         AllocatorDiagnostics::instance()->trackAllocator(this);
         AllocatorBase::setTag(tag ? tag : typeid(AllocatorStrategyFixedBlock).name());
+#else
+        CC_UNUSED_PARAM(tag);
 #endif
     }
     
@@ -89,14 +92,13 @@ public:
         AllocatorDiagnostics::instance()->untrackAllocator(this);
 #endif
 
-        do
+        while (_pages)
         {
             intptr_t* page = (intptr_t*)_pages;
             intptr_t* next = (intptr_t*)*page;
             ccAllocatorGlobal.deallocate(page);
             _pages = (void*)next;
         }
-        while (_pages);
     }
     
     // @brief
@@ -164,6 +166,7 @@ public:
         return s.str();
     }
     size_t _highestCount;
+    size_t _pageCount;
 #endif
     
 protected:
@@ -205,6 +208,8 @@ protected:
         if (nullptr == _list)
         {
             allocatePage();
+            if (nullptr == _list)
+                return nullptr;
         }
         auto next = (void*)*(uintptr_t*)_list;
         auto block = _list;
@@ -221,17 +226,31 @@ protected:
     
 protected:
         
-    // @brief Returns the size of a page in bytes + overhead.
+    // @brief Returns the distance in bytes between two blocks of a page.
+    // Small blocks are rounded up to a power of two, larger ones only to the default alignment,
+    // so pools of large objects don't waste up to half of their pages.
+    size_t blockStride() const
+    {
+        if (block_size <= AllocatorBase::kDefaultAlignment)
+            return AllocatorBase::nextPow2BlockSize(block_size);
+        return (block_size + AllocatorBase::kDefaultAlignment - 1) & ~(size_t)(AllocatorBase::kDefaultAlignment - 1);
+    }
+
+    // @brief Returns the size of a page in bytes + overhead for the linked list node and the alignment.
     size_t pageSize() const
     {
-        return AllocatorBase::kDefaultAlignment + AllocatorBase::nextPow2BlockSize(block_size) * _pageSize;
+        return 2 * AllocatorBase::kDefaultAlignment + blockStride() * _pageSize;
     }
     
     // @brief Allocates a new page from the global allocator,
     // and adds all the blocks to the free list.
     CC_ALLOCATOR_INLINE void allocatePage()
     {
-        uint8_t* p = (uint8_t*)AllocatorBase::aligned(ccAllocatorGlobal.allocate(pageSize()));
+        // the page keeps the address returned by the global allocator, so it can be freed as is
+        // even on platforms where malloc is only 8 bytes aligned.
+        uint8_t* p = (uint8_t*)ccAllocatorGlobal.allocate(pageSize());
+        if (nullptr == p)
+            return;
         intptr_t* page = (intptr_t*)p;
         if (nullptr == _pages)
         {
@@ -244,10 +263,13 @@ protected:
             _pages = page;
         }
         
-        p += AllocatorBase::kDefaultAlignment; // step past the linked list node
+        p = (uint8_t*)AllocatorBase::aligned(p + sizeof(intptr_t)); // step past the linked list node
         
         _allocated += _pageSize;
-        size_t aligned_size = AllocatorBase::nextPow2BlockSize(block_size);
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        ++_pageCount;
+#endif
+        size_t aligned_size = blockStride();
         uint8_t* block = (uint8_t*)p;
         for (unsigned int i = 0; i < _pageSize; ++i, block += aligned_size)
         {
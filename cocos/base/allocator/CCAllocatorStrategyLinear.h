@@ -0,0 +1,339 @@
+/****************************************************************************
+ Copyright (c) 2014-2016 Chukong Technologies Inc.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef CC_ALLOCATOR_STRATEGY_LINEAR_H
+#define CC_ALLOCATOR_STRATEGY_LINEAR_H
+/// @cond DO_NOT_SHOW
+
+/****************************************************************************
+                                    WARNING!
+     Do not use Console::log or any other methods that use NEW inside of this
+     allocator. Failure to do so will result in recursive memory allocation.
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include <sstream>
+
+#include "base/allocator/CCAllocatorBase.h"
+#include "base/allocator/CCAllocatorMacros.h"
+#include "base/allocator/CCAllocatorGlobal.h"
+#include "base/allocator/CCAllocatorDiagnostics.h"
+
+NS_CC_BEGIN
+NS_CC_ALLOCATOR_BEGIN
+
+// @brief
+// Linear (bump pointer) allocator strategy for short lived data.
+// Allocations are carved sequentially out of a page, deallocate is a no-op
+// and all memory is reclaimed at once by calling reset().
+// When a page is exhausted another page is chained on, and on the next reset
+// the chain is collapsed into a single page large enough to hold everything
+// that was allocated, so that a steady workload settles into one page.
+// This allocator is not thread safe, it is intended to be owned by a single thread.
+// @param pageSize the initial size in bytes of the arena.
+class AllocatorStrategyLinear
+    : public AllocatorBase
+{
+public:
+
+    AllocatorStrategyLinear(const char* tag = nullptr, size_t pageSize = 64 * 1024)
+        : _pages(nullptr)
+        , _current(nullptr)
+        , _pageSize(pageSize)
+        , _used(0)
+        , _overflow(0)
+    {
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        _highestUsed = 0;
+        _pageCount = 0;
+        AllocatorDiagnostics::instance()->trackAllocator(this);
+        AllocatorBase::setTag(tag ? tag : "cocos2d.x.allocator.linear");
+#else
+        CC_UNUSED_PARAM(tag);
+#endif
+    }
+
+    virtual ~AllocatorStrategyLinear()
+    {
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        AllocatorDiagnostics::instance()->untrackAllocator(this);
+#endif
+        freePages();
+    }
+
+    // @brief
+    // Allocate size bytes aligned to alignment from the current page.
+    // When the current page cannot hold the request a new page is added.
+    // Never returns nullptr unless the system is out of memory.
+    CC_ALLOCATOR_INLINE void* allocate(size_t size, size_t alignment = kDefaultAlignment)
+    {
+        CC_ASSERT(alignment <= kDefaultAlignment && 0 == (alignment & (alignment - 1)));
+
+        if (nullptr == _current || !fits(_current, size, alignment))
+        {
+            if (!grow(size))
+                return nullptr;
+        }
+
+        auto r = (uint8_t*)aligned(_current->top, alignment);
+        _current->top = r + size;
+        _used += size;
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        if (_used > _highestUsed)
+            _highestUsed = _used;
+#endif
+        return r;
+    }
+
+    // @brief Deallocate is a no-op except when freeing the most recent allocation,
+    // memory is otherwise reclaimed by reset().
+    CC_ALLOCATOR_INLINE void deallocate(void* address, size_t size = 0)
+    {
+        if (_current && size && (uint8_t*)address + size == _current->top)
+        {
+            _current->top = (uint8_t*)address;
+            _used -= size;
+        }
+    }
+
+    // @brief Returns true if address lies within one of the pages of this allocator.
+    CC_ALLOCATOR_INLINE bool owns(const void* const address) const
+    {
+        for (auto page = _pages; page; page = page->next)
+        {
+            if ((const uint8_t*)address >= page->data() && (const uint8_t*)address < page->end)
+                return true;
+        }
+        return false;
+    }
+
+    // @brief
+    // Reclaims every allocation made since the last reset.
+    // Any memory handed out before this call must no longer be referenced.
+    // If more than one page was needed the pages are replaced with a single
+    // page big enough to hold the whole of the previous workload.
+    void reset()
+    {
+        if (_pages && _pages->next)
+        {
+            _pageSize = _pageSize + _overflow;
+            freePages();
+        }
+
+        _current = _pages;
+        if (_current)
+            _current->top = _current->data();
+        _used = 0;
+        _overflow = 0;
+    }
+
+    // @brief Returns the number of bytes currently allocated since the last reset.
+    size_t getUsedSize() const
+    {
+        return _used;
+    }
+
+    // @brief Returns the size in bytes of the initial page.
+    size_t getPageSize() const
+    {
+        return _pageSize;
+    }
+
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+    std::string diagnostics() const
+    {
+        std::stringstream s;
+        s << AllocatorBase::tag() << " size:" << _pageSize << " used:" << _used << " highest:" << _highestUsed << " pages:" << _pageCount << "\n";
+        return s.str();
+    }
+    size_t _highestUsed;
+    size_t _pageCount;
+#endif
+
+protected:
+
+    // @brief header at the start of every page, the usable memory follows it.
+    struct Page
+    {
+        Page* next;
+        uint8_t* top;
+        uint8_t* end;
+
+        uint8_t* data() { return (uint8_t*)this + kHeaderSize; }
+        const uint8_t* data() const { return (const uint8_t*)this + kHeaderSize; }
+    };
+
+    enum { kHeaderSize = (sizeof(Page) + kDefaultAlignment - 1) & ~(kDefaultAlignment - 1) };
+
+    CC_ALLOCATOR_INLINE bool fits(Page* page, size_t size, size_t alignment)
+    {
+        auto p = (uint8_t*)aligned(page->top, alignment);
+        return p <= page->end && (size_t)(page->end - p) >= size;
+    }
+
+    // @brief Chains on a new page that is at least big enough for size.
+    // Overflow pages are half the initial page size, they only live until the next reset.
+    bool grow(size_t size)
+    {
+        size_t capacity = _pages ? _pageSize / 2 : _pageSize;
+        if (capacity < size + kDefaultAlignment)
+            capacity = size + kDefaultAlignment;
+
+        auto page = (Page*)CC_MALLOC(kHeaderSize + capacity);
+        if (nullptr == page)
+            return false;
+
+        page->top = page->data();
+        page->end = page->data() + capacity;
+
+        page->next = nullptr;
+        if (_current)
+        {
+            _current->next = page;
+            _overflow += capacity;
+        }
+        else
+        {
+            _pages = page;
+        }
+        _current = page;
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        ++_pageCount;
+#endif
+        return true;
+    }
+
+    void freePages()
+    {
+        while (_pages)
+        {
+            auto next = _pages->next;
+            CC_FREE(_pages);
+            _pages = next;
+        }
+        _current = nullptr;
+#if CC_ENABLE_ALLOCATOR_DIAGNOSTICS
+        _pageCount = 0;
+#endif
+    }
+
+protected:
+
+    Page* _pages;
+    Page* _current;
+    size_t _pageSize;
+    size_t _used;
+    size_t _overflow;
+};
+
+// @brief
+// STL compatible allocator that takes its memory from an AllocatorStrategyLinear.
+// Containers using it must not outlive the next reset() of the arena.
+// e.g. std::vector<Node*, LinearAllocator<Node*>> nodes(LinearAllocator<Node*>(arena));
+template <typename T>
+class LinearAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef LinearAllocator<U> other;
+    };
+
+    explicit LinearAllocator(AllocatorStrategyLinear* arena)
+        : _arena(arena)
+    {}
+
+    template <typename U>
+    LinearAllocator(const LinearAllocator<U>& other)
+        : _arena(other._arena)
+    {}
+
+    pointer allocate(size_type n, const void* = nullptr)
+    {
+        auto size = n * sizeof(T);
+        auto p = _arena ? _arena->allocate(size, alignof(T) < (size_t)AllocatorBase::kDefaultAlignment ? alignof(T) : (size_t)AllocatorBase::kDefaultAlignment) : ::operator new(size);
+        if (nullptr == p)
+            throw std::bad_alloc();
+        return (pointer)p;
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (_arena)
+            _arena->deallocate(p, n * sizeof(T));
+        else
+            ::operator delete(p);
+    }
+
+    size_type max_size() const
+    {
+        return size_type(-1) / sizeof(T);
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+
+    template <typename U>
+    bool operator==(const LinearAllocator<U>& other) const
+    {
+        return _arena == other._arena;
+    }
+
+    template <typename U>
+    bool operator!=(const LinearAllocator<U>& other) const
+    {
+        return _arena != other._arena;
+    }
+
+    AllocatorStrategyLinear* _arena;
+};
+
+NS_CC_ALLOCATOR_END
+NS_CC_END
+
+/// @endcond
+#endif//CC_ALLOCATOR_STRATEGY_LINEAR_H
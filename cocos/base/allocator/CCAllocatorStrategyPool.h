@@ -81,6 +81,28 @@ public:
     }
 };
 
+/**
+ * StorageTraits describes the raw storage of an object allocated by a class operator new.
+ *
+ * The new expression constructs the object and the delete expression destroys it,
+ * so the pool must neither construct nor destroy it.
+ * Blocks use the default alignment, which is safe for SSE types.
+ *
+ * @param T Type of object.
+ * @see CC_DECLARE_ALLOCATOR_POOL
+ */
+template <typename T>
+class StorageTraits : public ObjectTraits<T, AllocatorBase::kDefaultAlignment>
+{
+public:
+    
+    void construct(T* /*address*/)
+    {}
+    
+    void destroy(T* /*address*/)
+    {}
+};
+
 /**
  * Fixed sized pool allocator strategy for objects of type T.
  *
@@ -105,10 +127,15 @@ public:
     /** Ugh wish I knew a way that I could declare this just once.*/
     typedef AllocatorStrategyFixedBlock<sizeof(T), O::alignment, locking_traits> tParentStrategy;
     
-    AllocatorStrategyPool(const char* tag = nullptr, size_t poolSize = 100)
+    /**
+     * @param configurable Whether the page size may be overridden by Configuration, using the tag as key.
+     * Configuration is not thread safe, pools which may be created by any thread must not use it.
+     */
+    AllocatorStrategyPool(const char* tag = nullptr, size_t poolSize = 100, bool configurable = true)
         : tParentStrategy(tag)
     {
-        poolSize = Configuration::getInstance()->getValue(tag, Value((int)poolSize)).asInt();
+        if (configurable)
+            poolSize = Configuration::getInstance()->getValue(tag, Value((int)poolSize)).asInt();
         tParentStrategy::_pageSize = poolSize;
     }
     
@@ -159,7 +186,7 @@ public:
     std::string diagnostics() const
     {
         std::stringstream s;
-        s << AllocatorBase::tag() << " initial:" << tParentStrategy::_pageSize << " count:" << tParentStrategy::_allocated << " highest:" << tParentStrategy::_highestCount << "\n";
+        s << AllocatorBase::tag() << " size:" << sizeof(T) << " initial:" << tParentStrategy::_pageSize << " count:" << tParentStrategy::_allocated << " highest:" << tParentStrategy::_highestCount << " pages:" << tParentStrategy::_pageCount << "\n";
         return s.str();
     }    
 #endif
@@ -46,6 +46,17 @@ THE SOFTWARE.
 #define CC_ENABLE_STACKABLE_ACTIONS 1
 #endif
 
+/** @def CC_ENABLE_BATCHED_ACTIONS
+ * If enabled, ActionManager updates the most common interval actions (MoveTo/By, ScaleTo/By, RotateTo, FadeTo/In/Out and TintTo,
+ * optionally wrapped by one ease action) from contiguous arrays instead of calling Action::step() on each of them.
+ * Other actions, and actions created by a script engine, always use the regular path.
+ * Enabled by default.
+ * @since v3.15
+ */
+#ifndef CC_ENABLE_BATCHED_ACTIONS
+#define CC_ENABLE_BATCHED_ACTIONS 1
+#endif
+
 /** @def CC_ENABLE_GL_STATE_CACHE
  * If enabled, cocos2d will maintain an OpenGL state cache internally to avoid unnecessary switches.
  * In order to use them, you have to use the following functions, instead of the GL ones:
@@ -358,17 +369,25 @@ THE SOFTWARE.
 /** @def CC_ENABLE_ALLOCATOR
  * Turn on creation of global allocator and pool allocators
  * as specified by CC_ALLOCATOR_GLOBAL below.
+ * Node, Sprite, Label, the common actions and render commands are allocated from
+ * per class pools when enabled. The pools are thread safe. Enabled by default.
  */
 #ifndef CC_ENABLE_ALLOCATOR
-# define CC_ENABLE_ALLOCATOR 0
+# define CC_ENABLE_ALLOCATOR 1
 #endif
 
 /** @def CC_ENABLE_ALLOCATOR_DIAGNOSTICS
  * Turn on debugging of allocators. This is slower, uses
  * more memory, and should not be used for production builds.
+ * The count and high water mark of every pool are reported by the console "allocator" command.
+ * Enabled by default in debug builds only.
  */
 #ifndef CC_ENABLE_ALLOCATOR_DIAGNOSTICS
-# define CC_ENABLE_ALLOCATOR_DIAGNOSTICS CC_ENABLE_ALLOCATOR
+# if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
+#  define CC_ENABLE_ALLOCATOR_DIAGNOSTICS 1
+# else
+#  define CC_ENABLE_ALLOCATOR_DIAGNOSTICS 0
+# endif
 #endif
 
 /** @def CC_ENABLE_ALLOCATOR_GLOBAL_NEW_DELETE
@@ -405,4 +424,15 @@ THE SOFTWARE.
 # define CC_ENABLE_PREMULTIPLIED_ALPHA 1
 #endif
 
+/** @def CC_ENABLE_FONT_GLYPH_CACHE
+ * If enabled, the glyphs rendered into the atlases of TTF fonts are kept in files of the writable path,
+ * and copied from them on the next launches instead of being rendered again.
+ * It mostly helps distance field labels and fonts with many glyphs, e.g. CJK fonts.
+ * To disable set it to 0. Enabled by default.
+ * @since v3.15
+ */
+#ifndef CC_ENABLE_FONT_GLYPH_CACHE
+# define CC_ENABLE_FONT_GLYPH_CACHE 1
+#endif
+
 #endif // __CCCONFIG_H__
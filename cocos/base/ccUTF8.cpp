@@ -28,8 +28,162 @@
 #include "base/CCConsole.h"
 #include "ConvertUTF.h"
 
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 NS_CC_BEGIN
 
+namespace
+{
+    // Most strings of a game are ASCII, or mix ASCII with other scripts: runs of ASCII are found and
+    // converted 16 bytes at a time with SSE2 or NEON, or 8 bytes at a time otherwise.
+
+    // the number of ASCII bytes at the start of in
+    inline size_t getASCIILength(const unsigned char* in, size_t size)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= size; i += 16)
+        {
+            int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+            if (mask != 0)
+                return i + __builtin_ctz(mask);
+        }
+#else
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, in + i, sizeof(word));
+            if (word & 0x8080808080808080ULL)
+                break;
+        }
+#endif
+        while (i < size && in[i] < 0x80)
+            ++i;
+        return i;
+    }
+
+    // the number of ASCII code units at the start of in
+    inline size_t getASCIILength(const char16_t* in, size_t size)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i nonASCII = _mm_set1_epi16((short)0xFF80);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m128i units = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), nonASCII);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(units, _mm_setzero_si128())) != 0xFFFF)
+                break;
+        }
+#else
+        for (; i + 4 <= size; i += 4)
+        {
+            uint64_t word;
+            memcpy(&word, in + i, sizeof(word));
+            if (word & 0xFF80FF80FF80FF80ULL)
+                break;
+        }
+#endif
+        while (i < size && in[i] < 0x80)
+            ++i;
+        return i;
+    }
+
+    inline void widenASCII(const unsigned char* in, size_t size, char16_t* out)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+        for (; i + 16 <= size; i += 16)
+        {
+            uint8x16_t bytes = vld1q_u8(in + i);
+            vst1q_u16(reinterpret_cast<uint16_t*>(out + i), vmovl_u8(vget_low_u8(bytes)));
+            vst1q_u16(reinterpret_cast<uint16_t*>(out + i + 8), vmovl_u8(vget_high_u8(bytes)));
+        }
+#endif
+        for (; i < size; ++i)
+            out[i] = in[i];
+    }
+
+    inline void narrowASCII(const char16_t* in, size_t size, unsigned char* out)
+    {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+        }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+        for (; i + 8 <= size; i += 8)
+        {
+            vst1_u8(out + i, vmovn_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(in + i))));
+        }
+#endif
+        for (; i < size; ++i)
+            out[i] = (unsigned char)in[i];
+    }
+
+    // the length of the sequence starting with lead, which must be valid
+    inline size_t getUTF8SequenceLength(unsigned char lead)
+    {
+        return lead < 0x80 ? 1 : (lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4));
+    }
+
+    // Decodes the sequence at the start of in, returns its length, or 0 if the sequence is
+    // truncated, overlong, a surrogate or above U+10FFFF, which ConvertUTF rejects as well.
+    inline size_t decodeUTF8(const unsigned char* in, size_t size, char32_t& code)
+    {
+        unsigned char lead = in[0];
+        if (lead < 0x80)
+        {
+            code = lead;
+            return 1;
+        }
+        if (lead < 0xC2)
+            return 0;
+        if (lead < 0xE0)
+        {
+            if (size < 2 || (in[1] & 0xC0) != 0x80)
+                return 0;
+            code = ((lead & 0x1F) << 6) | (in[1] & 0x3F);
+            return 2;
+        }
+        if (lead < 0xF0)
+        {
+            if (size < 3 || (in[1] & 0xC0) != 0x80 || (in[2] & 0xC0) != 0x80)
+                return 0;
+            if ((lead == 0xE0 && in[1] < 0xA0) || (lead == 0xED && in[1] > 0x9F))
+                return 0;
+            code = ((lead & 0x0F) << 12) | ((in[1] & 0x3F) << 6) | (in[2] & 0x3F);
+            return 3;
+        }
+        if (lead < 0xF5)
+        {
+            if (size < 4 || (in[1] & 0xC0) != 0x80 || (in[2] & 0xC0) != 0x80 || (in[3] & 0xC0) != 0x80)
+                return 0;
+            if ((lead == 0xF0 && in[1] < 0x90) || (lead == 0xF4 && in[1] > 0x8F))
+                return 0;
+            code = ((lead & 0x07) << 18) | ((in[1] & 0x3F) << 12) | ((in[2] & 0x3F) << 6) | (in[3] & 0x3F);
+            return 4;
+        }
+        return 0;
+    }
+}
+
 namespace StringUtils {
 
 std::string format(const char* format, ...)
@@ -199,7 +353,49 @@ bool utfConvert(
 
 bool UTF8ToUTF16(const std::string& utf8, std::u16string& outUtf16)
 {
-    return utfConvert(utf8, outUtf16, ConvertUTF8toUTF16);
+    if (utf8.empty())
+    {
+        outUtf16.clear();
+        return true;
+    }
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(utf8.data());
+    const size_t size = utf8.size();
+    // a byte is at most one UTF-16 code unit
+    std::u16string working(size, 0);
+    char16_t* out = &working[0];
+
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t ascii = getASCIILength(in + i, size - i);
+        widenASCII(in + i, ascii, out);
+        i += ascii;
+        out += ascii;
+
+        while (i < size && in[i] >= 0x80)
+        {
+            char32_t code;
+            size_t length = decodeUTF8(in + i, size - i, code);
+            if (length == 0)
+                return false;
+            i += length;
+            if (code >= 0x10000)
+            {
+                code -= 0x10000;
+                *out++ = (char16_t)(0xD800 + (code >> 10));
+                *out++ = (char16_t)(0xDC00 + (code & 0x3FF));
+            }
+            else
+            {
+                *out++ = (char16_t)code;
+            }
+        }
+    }
+
+    working.resize(out - &working[0]);
+    outUtf16 = std::move(working);
+    return true;
 }
 
 bool UTF8ToUTF32(const std::string& utf8, std::u32string& outUtf32)
@@ -209,7 +405,56 @@ bool UTF8ToUTF32(const std::string& utf8, std::u32string& outUtf32)
 
 bool UTF16ToUTF8(const std::u16string& utf16, std::string& outUtf8)
 {
-    return utfConvert(utf16, outUtf8, ConvertUTF16toUTF8);
+    if (utf16.empty())
+    {
+        outUtf8.clear();
+        return true;
+    }
+
+    const char16_t* in = utf16.data();
+    const size_t size = utf16.size();
+    // a code unit is at most 3 bytes, a surrogate pair is 4 bytes
+    std::string working(size * 3, 0);
+    unsigned char* out = reinterpret_cast<unsigned char*>(&working[0]);
+
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t ascii = getASCIILength(in + i, size - i);
+        narrowASCII(in + i, ascii, out);
+        i += ascii;
+        out += ascii;
+
+        while (i < size && in[i] >= 0x80)
+        {
+            char32_t code = in[i++];
+            if (code < 0x800)
+            {
+                *out++ = (unsigned char)(0xC0 | (code >> 6));
+                *out++ = (unsigned char)(0x80 | (code & 0x3F));
+                continue;
+            }
+            if (code >= 0xD800 && code <= 0xDFFF)
+            {
+                // a high surrogate followed by a low one
+                if (code > 0xDBFF || i == size || in[i] < 0xDC00 || in[i] > 0xDFFF)
+                    return false;
+                code = 0x10000 + ((code - 0xD800) << 10) + (in[i++] - 0xDC00);
+                *out++ = (unsigned char)(0xF0 | (code >> 18));
+                *out++ = (unsigned char)(0x80 | ((code >> 12) & 0x3F));
+            }
+            else
+            {
+                *out++ = (unsigned char)(0xE0 | (code >> 12));
+            }
+            *out++ = (unsigned char)(0x80 | ((code >> 6) & 0x3F));
+            *out++ = (unsigned char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    working.resize(reinterpret_cast<char*>(out) - &working[0]);
+    outUtf8 = std::move(working);
+    return true;
 }
     
 bool UTF16ToUTF32(const std::u16string& utf16, std::u32string& outUtf32)
@@ -284,16 +529,40 @@ std::vector<char16_t> getChar16VectorFromUTF16String(const std::u16string& utf16
 
 long getCharacterCountInUTF8String(const std::string& utf8)
 {
-    return getUTF8StringLength((const UTF8*)utf8.c_str());
+    // like the C string, the count stops at the first null character
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(utf8.c_str());
+    const size_t size = strlen(utf8.c_str());
+
+    long count = 0;
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t ascii = getASCIILength(in + i, size - i);
+        i += ascii;
+        count += (long)ascii;
+
+        while (i < size && in[i] >= 0x80)
+        {
+            char32_t code;
+            size_t length = decodeUTF8(in + i, size - i, code);
+            if (length == 0)
+                return 0;
+            i += length;
+            ++count;
+        }
+    }
+    return count;
 }
 
 
 StringUTF8::StringUTF8()
+: _byteLength(0)
 {
 
 }
 
 StringUTF8::StringUTF8(const std::string& newStr)
+: _byteLength(0)
 {
     replace(newStr);
 }
@@ -311,11 +580,11 @@ std::size_t StringUTF8::length() const
 void StringUTF8::replace(const std::string& newStr)
 {
     _str.clear();
+    _byteLength = 0;
     if (!newStr.empty())
     {
-        UTF8* sequenceUtf8 = (UTF8*)newStr.c_str();
-
-        int lengthString = getUTF8StringLength(sequenceUtf8);
+        // validates the string, and sizes the store once
+        long lengthString = getCharacterCountInUTF8String(newStr);
 
         if (lengthString == 0)
         {
@@ -323,22 +592,22 @@ void StringUTF8::replace(const std::string& newStr)
             return;
         }
 
-        while (*sequenceUtf8)
+        _str.resize(lengthString);
+        const char* sequenceUtf8 = newStr.c_str();
+        for (auto& charUTF8 : _str)
         {
-            std::size_t lengthChar = getNumBytesForUTF8(*sequenceUtf8);
-
-            CharUTF8 charUTF8;
-            charUTF8._char.append((char*)sequenceUtf8, lengthChar);
+            std::size_t lengthChar = getUTF8SequenceLength((unsigned char)*sequenceUtf8);
+            charUTF8._char.assign(sequenceUtf8, lengthChar);
             sequenceUtf8 += lengthChar;
-
-            _str.push_back(charUTF8);
         }
+        _byteLength = sequenceUtf8 - newStr.c_str();
     }
 }
 
 std::string StringUTF8::getAsCharSequence() const
 {
     std::string charSequence;
+    charSequence.reserve(getByteLength());
 
     for (auto& charUtf8 : _str)
     {
@@ -348,10 +617,30 @@ std::string StringUTF8::getAsCharSequence() const
     return charSequence;
 }
 
+std::size_t StringUTF8::getByteLength() const
+{
+    if (_byteLength == INVALID_BYTE_LENGTH)
+    {
+        _byteLength = 0;
+        for (auto& charUtf8 : _str)
+            _byteLength += charUtf8._char.size();
+    }
+    return _byteLength;
+}
+
+StringUTF8::CharUTF8Store& StringUTF8::getString()
+{
+    // the characters may be changed through the reference
+    _byteLength = INVALID_BYTE_LENGTH;
+    return _str;
+}
+
 bool StringUTF8::deleteChar(std::size_t pos)
 {
     if (pos < _str.size())
     {
+        if (_byteLength != INVALID_BYTE_LENGTH)
+            _byteLength -= _str[pos]._char.size();
         _str.erase(_str.begin() + pos);
         return true;
     }
@@ -373,6 +662,8 @@ bool StringUTF8::insert(std::size_t pos, const StringUTF8& insertStr)
     if (pos <= _str.size())
     {
         _str.insert(_str.begin() + pos, insertStr._str.begin(), insertStr._str.end());
+        if (_byteLength != INVALID_BYTE_LENGTH)
+            _byteLength += insertStr.getByteLength();
 
         return true;
     }
@@ -203,15 +203,23 @@ public:
     void replace(const std::string& newStr);
 
     std::string getAsCharSequence() const;
+    /** The length of the string in bytes, which is cached.
+     * @since v3.15
+     */
+    std::size_t getByteLength() const;
 
     bool deleteChar(std::size_t pos);
     bool insert(std::size_t pos, const std::string& insertStr);
     bool insert(std::size_t pos, const StringUTF8& insertStr);
 
-    CharUTF8Store& getString() { return _str; }
+    CharUTF8Store& getString();
 
 private:
+    static const std::size_t INVALID_BYTE_LENGTH = (std::size_t)-1;
+
     CharUTF8Store _str;
+    // the cached byte length, invalidated when the store is given out by getString
+    mutable std::size_t _byteLength;
 };
 
 } // namespace StringUtils {
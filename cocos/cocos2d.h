@@ -55,6 +55,7 @@ THE SOFTWARE.
 #include "base/CCScheduler.h"
 #include "base/CCUserDefault.h"
 #include "base/CCValue.h"
+#include "base/CCValueDocument.h"
 #include "base/CCVector.h"
 #include "base/ZipUtils.h"
 #include "base/base64.h"
@@ -128,6 +129,7 @@ THE SOFTWARE.
 #include "2d/CCParticleExamples.h"
 #include "2d/CCParticleSystem.h"
 #include "2d/CCParticleSystemQuad.h"
+#include "2d/CCParticleSystemGPU.h"
 #include "2d/CCProgressTimer.h"
 #include "2d/CCProtectedNode.h"
 #include "2d/CCRenderTexture.h"
@@ -184,6 +186,7 @@ THE SOFTWARE.
 #include "platform/CCCommon.h"
 #include "platform/CCDevice.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCAssetPack.h"
 #include "platform/CCImage.h"
 #include "platform/CCPlatformConfig.h"
 #include "platform/CCPlatformMacros.h"
@@ -260,6 +263,7 @@ THE SOFTWARE.
 #include "2d/CCSpriteBatchNode.h"
 #include "2d/CCSpriteFrame.h"
 #include "2d/CCSpriteFrameCache.h"
+#include "2d/CCSpriteSheetReader.h"
 
 // text_input_node
 #include "2d/CCTextFieldTTF.h"
@@ -273,6 +277,7 @@ THE SOFTWARE.
 #include "2d/CCTMXObjectGroup.h"
 #include "2d/CCTMXTiledMap.h"
 #include "2d/CCTMXXMLParser.h"
+#include "2d/CCTMXCompiledMap.h"
 #include "2d/CCTileMapAtlas.h"
 #include "2d/CCFastTMXLayer.h"
 #include "2d/CCFastTMXTiledMap.h"
@@ -429,6 +429,7 @@ void BoneNode::updateVertices()
             _squareVertices[i] += _anchorPointInPoints;
         }
         _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+        markFrozenParentsDirty();
     }
 }
 
@@ -439,6 +440,7 @@ void BoneNode::updateColor()
         _squareColors[i] = _rackColor;
     }
     _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+    markFrozenParentsDirty();
 }
 
 void BoneNode::updateDisplayedColor(const cocos2d::Color3B& /*parentColor*/)
@@ -137,6 +137,7 @@ void SkeletonNode::updateVertices()
         }
 
         _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+        markFrozenParentsDirty();
     }
 }
 
@@ -147,6 +148,7 @@ void SkeletonNode::updateColor()
         _squareColors[i] = _rackColor;
     }
     _transformUpdated = _transformDirty = _inverseDirty = _contentSizeDirty = true;
+    markFrozenParentsDirty();
 }
 
 void SkeletonNode::visit(cocos2d::Renderer *renderer, const cocos2d::Mat4& parentTransform, uint32_t parentFlags)
@@ -0,0 +1,504 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCAssetPack.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+#include "base/ccMacros.h"
+#include "base/ccUTF8.h"
+#include "base/CCParallelTaskPool.h"
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+#include <windows.h>
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+#include <android/asset_manager.h>
+#include "platform/android/CCFileUtils-android.h"
+#endif
+
+NS_CC_BEGIN
+
+namespace
+{
+    const char ASSET_PACK_MAGIC[4] = { 'C', 'C', 'P', 'K' };
+    const uint32_t ASSET_PACK_VERSION = 1;
+    // files are stored at page aligned offsets, so that the views of a mapping are page aligned
+    const uint64_t ASSET_PACK_ALIGNMENT = 4096;
+
+    int compareName(const char* name, size_t nameSize, const std::string& other)
+    {
+        int result = memcmp(name, other.data(), std::min(nameSize, other.size()));
+        if (result != 0)
+            return result;
+        return nameSize < other.size() ? -1 : (nameSize > other.size() ? 1 : 0);
+    }
+}
+
+struct AssetPack::Mapping
+{
+    Mapping();
+    ~Mapping();
+
+    bool map(const std::string& fullPath);
+
+    const unsigned char* data;
+    size_t size;
+    // true when the pack is mapped read only rather than read into memory, its bytes are then shared as views
+    bool readOnly;
+
+    // mapped region, it starts before data when the pack is not at a page aligned offset of an Android package
+    void* address;
+    size_t mappedSize;
+    void* handle;
+    Data readData;
+};
+
+AssetPack::Mapping::Mapping()
+: data(nullptr)
+, size(0)
+, readOnly(false)
+, address(nullptr)
+, mappedSize(0)
+, handle(nullptr)
+{
+}
+
+AssetPack::Mapping::~Mapping()
+{
+    if (address)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+        UnmapViewOfFile(address);
+        CloseHandle((HANDLE)handle);
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+        munmap(address, mappedSize);
+#endif
+    }
+}
+
+bool AssetPack::Mapping::map(const std::string& fullPath)
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    std::u16string widePath;
+    if (StringUtils::UTF8ToUTF16(fullPath, widePath))
+    {
+        HANDLE file = CreateFileW((LPCWSTR)widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER fileSize;
+            HANDLE mapping = nullptr;
+            if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+            {
+                mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            }
+            CloseHandle(file);
+            if (mapping != nullptr)
+            {
+                address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (address != nullptr)
+                {
+                    data = (const unsigned char*)address;
+                    size = mappedSize = (size_t)fileSize.QuadPart;
+                    handle = mapping;
+                    readOnly = true;
+                    return true;
+                }
+                CloseHandle(mapping);
+            }
+        }
+    }
+#elif CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+    int fd = -1;
+    off_t start = 0;
+    off_t length = 0;
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    if (fullPath[0] != '/')
+    {
+        // a pack stored uncompressed in the package can be mapped from the package
+        static const std::string apkPrefix("assets/");
+        auto relativePath = fullPath.compare(0, apkPrefix.size(), apkPrefix) == 0 ? fullPath.substr(apkPrefix.size()) : fullPath;
+        auto assetManager = FileUtilsAndroid::getAssetManager();
+        AAsset* asset = assetManager ? AAssetManager_open(assetManager, relativePath.c_str(), AASSET_MODE_UNKNOWN) : nullptr;
+        if (asset)
+        {
+            fd = AAsset_openFileDescriptor(asset, &start, &length);
+            AAsset_close(asset);
+        }
+    }
+    else
+#endif
+    {
+        fd = ::open(fullPath.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0)
+        {
+            length = st.st_size;
+        }
+    }
+
+    if (fd >= 0)
+    {
+        off_t pageSize = (off_t)sysconf(_SC_PAGESIZE);
+        off_t alignedStart = start - start % pageSize;
+        void* mapped = MAP_FAILED;
+        if (length > 0)
+        {
+            mapped = mmap(nullptr, (size_t)(length + start - alignedStart), PROT_READ, MAP_PRIVATE, fd, alignedStart);
+        }
+        close(fd);
+        if (mapped != MAP_FAILED)
+        {
+            address = mapped;
+            mappedSize = (size_t)(length + start - alignedStart);
+            data = (const unsigned char*)mapped + (start - alignedStart);
+            size = (size_t)length;
+            readOnly = true;
+            return true;
+        }
+    }
+#endif
+
+    // no file mapping on WinRT, and a compressed asset of an Android package is not a file: the pack is read instead
+    readData = FileUtils::getInstance()->getDataFromFile(fullPath);
+    if (readData.isNull())
+        return false;
+
+    data = readData.getBytes();
+    size = (size_t)readData.getSize();
+    return true;
+}
+
+AssetPack* AssetPack::create(const std::string& fullPath)
+{
+    auto ret = new (std::nothrow) AssetPack();
+    if (ret && ret->init(fullPath))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+std::shared_ptr<AssetPack> AssetPack::open(const std::string& fullPath)
+{
+    auto ret = new (std::nothrow) AssetPack();
+    if (ret && ret->init(fullPath))
+    {
+        return std::shared_ptr<AssetPack>(ret, [](AssetPack* assetPack) { assetPack->release(); });
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+AssetPack::AssetPack()
+: _entries(nullptr)
+, _entryCount(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+bool AssetPack::init(const std::string& fullPath)
+{
+    _path = fullPath;
+    _mapping = std::make_shared<Mapping>();
+    if (!_mapping->map(fullPath))
+    {
+        CCLOG("AssetPack: can't read %s", fullPath.c_str());
+        return false;
+    }
+    if (!validate())
+    {
+        CCLOG("AssetPack: %s is not a valid asset pack", fullPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AssetPack::validate()
+{
+    auto data = _mapping->data;
+    auto size = _mapping->size;
+    if (size < sizeof(FileHeader))
+        return false;
+
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0
+        || header.version != ASSET_PACK_VERSION
+        || header.entryTableOffset % sizeof(uint64_t) != 0 || header.entryTableOffset > size
+        || header.entryCount > (size - header.entryTableOffset) / sizeof(FileEntry))
+    {
+        return false;
+    }
+
+    // the table is at an 8 bytes aligned offset of the mapping, names and files are checked once here
+    auto entries = reinterpret_cast<const FileEntry*>(data + header.entryTableOffset);
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        auto& entry = entries[i];
+        if (entry.nameOffset > size || entry.nameSize > size - entry.nameOffset
+            || entry.offset > size || entry.storedSize > size - entry.offset
+            || (entry.compression == COMPRESSION_NONE && entry.storedSize != entry.size)
+            || entry.compression > COMPRESSION_ZLIB)
+        {
+            return false;
+        }
+    }
+
+    _entries = entries;
+    _entryCount = header.entryCount;
+    return true;
+}
+
+const AssetPack::FileEntry* AssetPack::lowerBound(const std::string& name) const
+{
+    auto data = _mapping->data;
+    return std::lower_bound(_entries, _entries + _entryCount, name, [data](const FileEntry& entry, const std::string& value) {
+        return compareName((const char*)data + entry.nameOffset, entry.nameSize, value) < 0;
+    });
+}
+
+const AssetPack::FileEntry* AssetPack::findEntry(const std::string& name) const
+{
+    auto entry = lowerBound(name);
+    if (entry == _entries + _entryCount
+        || compareName((const char*)_mapping->data + entry->nameOffset, entry->nameSize, name) != 0)
+    {
+        return nullptr;
+    }
+    return entry;
+}
+
+bool AssetPack::isFileExist(const std::string& name) const
+{
+    return findEntry(name) != nullptr;
+}
+
+bool AssetPack::isDirectoryExist(const std::string& name) const
+{
+    std::string prefix = name;
+    while (!prefix.empty() && prefix.back() == '/')
+    {
+        prefix.pop_back();
+    }
+    if (prefix.empty())
+        return true;
+
+    // the files of a directory follow its name in the sorted table
+    prefix += '/';
+    auto entry = lowerBound(prefix);
+    return entry != _entries + _entryCount && entry->nameSize > prefix.size()
+        && memcmp(_mapping->data + entry->nameOffset, prefix.data(), prefix.size()) == 0;
+}
+
+long AssetPack::getFileSize(const std::string& name) const
+{
+    auto entry = findEntry(name);
+    return entry ? (long)entry->size : -1;
+}
+
+bool AssetPack::readEntry(const FileEntry* entry, unsigned char* buffer) const
+{
+    auto stored = _mapping->data + entry->offset;
+    if (entry->compression == COMPRESSION_NONE)
+    {
+        memcpy(buffer, stored, (size_t)entry->size);
+        return true;
+    }
+
+    uLongf size = (uLongf)entry->size;
+    return uncompress(buffer, &size, stored, (uLong)entry->storedSize) == Z_OK && size == entry->size;
+}
+
+Data AssetPack::getData(const std::string& name) const
+{
+    Data data;
+    auto entry = findEntry(name);
+    if (entry == nullptr || entry->size == 0)
+        return data;
+
+    if (entry->compression == COMPRESSION_NONE && _mapping->readOnly)
+    {
+        data.setView(const_cast<unsigned char*>(_mapping->data + entry->offset), (ssize_t)entry->size, _mapping);
+        return data;
+    }
+
+    auto bytes = (unsigned char*)malloc((size_t)entry->size);
+    if (bytes && readEntry(entry, bytes))
+    {
+        data.fastSet(bytes, (ssize_t)entry->size);
+    }
+    else
+    {
+        CCLOG("AssetPack: can't read %s from %s", name.c_str(), _path.c_str());
+        free(bytes);
+    }
+    return data;
+}
+
+FileUtils::Status AssetPack::getContents(const std::string& name, ResizableBuffer* buffer) const
+{
+    auto entry = findEntry(name);
+    if (entry == nullptr)
+        return FileUtils::Status::NotExists;
+    if (entry->size > UINT32_MAX)
+        return FileUtils::Status::TooLarge;
+    if (entry->size == 0)
+        return FileUtils::Status::OK;
+
+    buffer->resize((size_t)entry->size);
+    if (!readEntry(entry, (unsigned char*)buffer->buffer()))
+    {
+        CCLOG("AssetPack: can't read %s from %s", name.c_str(), _path.c_str());
+        return FileUtils::Status::ReadFailed;
+    }
+    return FileUtils::Status::OK;
+}
+
+bool AssetPack::write(const std::string& packPath, const std::vector<SourceFile>& files)
+{
+    std::vector<const SourceFile*> sorted;
+    sorted.reserve(files.size());
+    for (auto& file : files)
+    {
+        sorted.push_back(&file);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const SourceFile* a, const SourceFile* b) {
+        return a->name < b->name;
+    });
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        if (sorted[i]->name == sorted[i - 1]->name)
+        {
+            CCLOG("AssetPack: %s is added twice", sorted[i]->name.c_str());
+            return false;
+        }
+    }
+
+    // FileUtils is used from this thread only, the files are compressed in parallel
+    auto fileUtils = FileUtils::getInstance();
+    std::vector<Data> contents(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        if (!fileUtils->isFileExist(sorted[i]->path))
+        {
+            CCLOG("AssetPack: can't read %s", sorted[i]->path.c_str());
+            return false;
+        }
+        contents[i] = fileUtils->getDataFromFile(sorted[i]->path);
+    }
+
+    std::vector<std::vector<unsigned char>> compressed(sorted.size());
+    ParallelTaskPool::getInstance()->parallelFor((int)sorted.size(), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            if (!sorted[i]->compress || contents[i].isNull())
+                continue;
+
+            uLongf size = compressBound((uLong)contents[i].getSize());
+            compressed[i].resize(size);
+            if (compress2(compressed[i].data(), &size, contents[i].getBytes(), (uLong)contents[i].getSize(), Z_BEST_COMPRESSION) != Z_OK
+                || size >= (uLongf)contents[i].getSize())
+            {
+                compressed[i].clear();
+                continue;
+            }
+            compressed[i].resize(size);
+        }
+    });
+
+    // header, entries, names, then the files at aligned offsets
+    std::vector<FileEntry> entries(sorted.size());
+    uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(FileEntry);
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        entries[i].nameOffset = (uint32_t)offset;
+        entries[i].nameSize = (uint32_t)sorted[i]->name.size();
+        offset += sorted[i]->name.size();
+    }
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        auto& entry = entries[i];
+        entry.offset = offset;
+        entry.size = (uint64_t)contents[i].getSize();
+        entry.compression = compressed[i].empty() ? COMPRESSION_NONE : COMPRESSION_ZLIB;
+        entry.storedSize = compressed[i].empty() ? entry.size : (uint64_t)compressed[i].size();
+        entry.reserved = 0;
+        offset += entry.storedSize;
+    }
+
+    FileHeader header;
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = (uint32_t)entries.size();
+    header.entryTableOffset = sizeof(FileHeader);
+
+    std::vector<unsigned char> buffer;
+    buffer.reserve((size_t)offset);
+    buffer.insert(buffer.end(), (const unsigned char*)&header, (const unsigned char*)(&header + 1));
+    buffer.insert(buffer.end(), (const unsigned char*)entries.data(), (const unsigned char*)(entries.data() + entries.size()));
+    for (auto file : sorted)
+    {
+        buffer.insert(buffer.end(), file->name.begin(), file->name.end());
+    }
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        buffer.resize((size_t)entries[i].offset, 0);
+        if (compressed[i].empty())
+        {
+            buffer.insert(buffer.end(), contents[i].getBytes(), contents[i].getBytes() + contents[i].getSize());
+        }
+        else
+        {
+            buffer.insert(buffer.end(), compressed[i].begin(), compressed[i].end());
+        }
+    }
+
+    Data data;
+    data.fastSet(buffer.data(), buffer.size());
+    bool written = fileUtils->writeDataToFile(data, packPath);
+    // the buffer is owned by the vector
+    data.takeBuffer(nullptr);
+
+    if (!written)
+    {
+        CCLOG("AssetPack: can't write %s", packPath.c_str());
+    }
+    return written;
+}
+
+NS_CC_END
@@ -0,0 +1,161 @@
+/****************************************************************************
+Copyright (c) 2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_ASSET_PACK_H__
+#define __CC_ASSET_PACK_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/CCRef.h"
+#include "platform/CCFileUtils.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * @class AssetPack
+ * @brief A read only pack of files, mounted into FileUtils with FileUtils::mountAssetPack.
+ *
+ * The pack starts with a table of contents sorted by file name, so looking up a file is a binary search
+ * in memory, without any system call. Each file is stored at a 4K aligned offset, either as is or compressed with zlib.
+ * The pack is memory mapped read only: the files stored as is are returned by getData as read only views
+ * of the mapping, without copying them. When the pack can't be mapped, e.g. when it is compressed in an Android package,
+ * it is read into memory and the files are copied out of it.
+ *
+ * Packs are made by write(), e.g. by a desktop build of a game, and are stored in the byte order of the device,
+ * a pack of another byte order or another version of the format is not mounted.
+ * @since v3.15
+ * @js NA
+ */
+class CC_DLL AssetPack : public Ref
+{
+public:
+    /** A file to write into a pack. */
+    struct SourceFile
+    {
+        /** Path of the file in the pack, relative and with '/' separators. */
+        std::string name;
+        /** Path of the file to read. */
+        std::string path;
+        /** Compresses the file, it is stored as is when compression does not make it smaller. */
+        bool compress;
+    };
+
+    /** Opens a pack.
+     *
+     * @param fullPath The full path of the pack file.
+     * @return An autoreleased AssetPack, or nullptr if the pack can't be read.
+     */
+    static AssetPack* create(const std::string& fullPath);
+
+    /** Opens a pack which is not autoreleased, it is released when the last shared pointer is.
+     * Only the shared pointers touch its reference count, so they can be released on any thread.
+     *
+     * @param fullPath The full path of the pack file.
+     * @return The pack, or nullptr if the pack can't be read.
+     * @since v3.15
+     */
+    static std::shared_ptr<AssetPack> open(const std::string& fullPath);
+
+    /** Writes a pack, returns false if a file can't be read or the pack can't be written. */
+    static bool write(const std::string& packPath, const std::vector<SourceFile>& files);
+
+    virtual ~AssetPack();
+
+    /** The full path of the pack file. */
+    const std::string& getPath() const { return _path; }
+
+    /** Returns the number of files of the pack. */
+    int getFileCount() const { return (int)_entryCount; }
+
+    bool isFileExist(const std::string& name) const;
+    /** A directory exists when it holds a file, the empty name is the root of the pack. */
+    bool isDirectoryExist(const std::string& name) const;
+    /** Returns the uncompressed size of a file, or -1 if the file does not exist. */
+    long getFileSize(const std::string& name) const;
+
+    /** Reads a file, files stored as is are views of the memory mapped pack. */
+    Data getData(const std::string& name) const;
+    /** Reads a file into a buffer. */
+    FileUtils::Status getContents(const std::string& name, ResizableBuffer* buffer) const;
+
+protected:
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        // offset of entryCount FileEntry, sorted by name
+        uint32_t entryTableOffset;
+    };
+
+    struct FileEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t storedSize;
+        // offset of the name from the start of the file, names are not null terminated
+        uint32_t nameOffset;
+        uint32_t nameSize;
+        uint32_t compression;
+        uint32_t reserved;
+    };
+
+    enum
+    {
+        COMPRESSION_NONE,
+        COMPRESSION_ZLIB
+    };
+
+    // the mapped file, shared with the views returned by getData
+    struct Mapping;
+
+    AssetPack();
+
+    bool init(const std::string& fullPath);
+    /** Checks the table of contents, returns false if an entry is out of the file. */
+    bool validate();
+    const FileEntry* findEntry(const std::string& name) const;
+    /** The first entry whose name is not less than name. */
+    const FileEntry* lowerBound(const std::string& name) const;
+    bool readEntry(const FileEntry* entry, unsigned char* buffer) const;
+
+    std::string _path;
+    std::shared_ptr<Mapping> _mapping;
+    const FileEntry* _entries;
+    uint32_t _entryCount;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_ASSET_PACK_H__
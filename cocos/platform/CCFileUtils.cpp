@@ -26,11 +26,18 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 
 #include <stack>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "base/CCData.h"
+#include "base/CCValueDocument.h"
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
+#include "base/CCScheduler.h"
 #include "platform/CCSAXParser.h"
+#include "platform/CCAssetPack.h"
 //#include "base/ccUtils.h"
 
 #include "tinyxml2.h"
@@ -335,6 +342,11 @@ ValueMap FileUtils::getValueMapFromData(const char* filedata, int filesize)
     return tMaker.dictionaryWithDataOfFile(filedata, filesize);
 }
 
+ValueDocument* FileUtils::getValueDocumentFromFile(const std::string& filename)
+{
+    return ValueDocument::createWithFile(fullPathForFilename(filename));
+}
+
 ValueVector FileUtils::getValueVectorFromFile(const std::string& filename)
 {
     const std::string fullPath = fullPathForFilename(filename);
@@ -392,6 +404,8 @@ bool FileUtils::writeValueMapToFile(const ValueMap& dict, const std::string& ful
     rootEle->LinkEndChild(innerDict);
 
     bool ret = tinyxml2::XML_SUCCESS == doc->SaveFile(getSuitableFOpen(fullPath).c_str());
+    if (ret)
+        addToPathIndex(fullPath);
 
     delete doc;
     return ret;
@@ -432,6 +446,8 @@ bool FileUtils::writeValueVectorToFile(const ValueVector& vecData, const std::st
     rootEle->LinkEndChild(innerDict);
 
     bool ret = tinyxml2::XML_SUCCESS == doc->SaveFile(getSuitableFOpen(fullPath).c_str());
+    if (ret)
+        addToPathIndex(fullPath);
 
     delete doc;
     return ret;
@@ -538,24 +554,259 @@ FileUtils* FileUtils::s_sharedFileUtils = nullptr;
 
 void FileUtils::destroyInstance()
 {
+    if (s_sharedFileUtils)
+        s_sharedFileUtils->stopAsyncReads();
     CC_SAFE_DELETE(s_sharedFileUtils);
 }
 
 void FileUtils::setDelegate(FileUtils *delegate)
 {
     if (s_sharedFileUtils)
+    {
+        s_sharedFileUtils->stopAsyncReads();
         delete s_sharedFileUtils;
+    }
 
     s_sharedFileUtils = delegate;
 }
 
+// Reads files for readAsync on a few IO threads. Reads are queued by priority and merged by full path,
+// the results are delivered on the cocos thread by the scheduler.
+class FileUtils::AsyncReader : public std::enable_shared_from_this<FileUtils::AsyncReader>
+{
+public:
+    enum class Kind
+    {
+        DATA,
+        STRING,
+        VALUE_MAP
+    };
+
+    struct Result
+    {
+        Data data;
+        std::string string;
+        ValueMap valueMap;
+    };
+
+    typedef std::function<void(const Result&)> Callback;
+
+    explicit AsyncReader(FileUtils* fileUtils);
+    ~AsyncReader();
+
+    AsyncReadID read(const std::string& fullPath, Kind kind, int priority, const Callback& callback);
+    void cancel(AsyncReadID id);
+    /** Stops and joins the threads, the queued reads are dropped. */
+    void stop();
+
+private:
+    struct Request
+    {
+        std::string key;
+        std::string fullPath;
+        Kind kind;
+        int priority;
+        unsigned int sequence;
+        bool started;
+        std::vector<std::pair<AsyncReadID, Callback>> callbacks;
+    };
+
+    void run();
+    void deliver(const std::shared_ptr<Request>& request, const Result& result);
+
+    FileUtils* _fileUtils;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    // requests not started yet
+    std::vector<std::shared_ptr<Request>> _queue;
+    // requests not delivered yet, by kind and full path
+    std::unordered_map<std::string, std::shared_ptr<Request>> _requests;
+    // requests by id of their reads
+    std::unordered_map<AsyncReadID, std::shared_ptr<Request>> _reads;
+    AsyncReadID _nextID;
+    unsigned int _nextSequence;
+    bool _stop;
+};
+
+namespace
+{
+    // reads are bound by storage, more threads would not read faster
+    const int ASYNC_READ_THREAD_COUNT = 2;
+}
+
+FileUtils::AsyncReader::AsyncReader(FileUtils* fileUtils)
+: _fileUtils(fileUtils)
+, _nextID(1)
+, _nextSequence(0)
+, _stop(false)
+{
+    for (int i = 0; i < ASYNC_READ_THREAD_COUNT; ++i)
+    {
+        _threads.emplace_back(&AsyncReader::run, this);
+    }
+}
+
+FileUtils::AsyncReader::~AsyncReader()
+{
+    stop();
+}
+
+void FileUtils::AsyncReader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop)
+            return;
+        _stop = true;
+        _queue.clear();
+    }
+    _condition.notify_all();
+    for (auto& thread : _threads)
+    {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+FileUtils::AsyncReadID FileUtils::AsyncReader::read(const std::string& fullPath, Kind kind, int priority, const Callback& callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    AsyncReadID id = _nextID++;
+    if (_nextID == 0)
+        _nextID = 1;
+
+    std::string key = std::to_string((int)kind) + ":" + fullPath;
+    std::shared_ptr<Request> request;
+    auto iter = _requests.find(key);
+    if (iter != _requests.end())
+    {
+        // merged with the read of the same file
+        request = iter->second;
+        if (!request->started && priority > request->priority)
+            request->priority = priority;
+    }
+    else
+    {
+        request = std::make_shared<Request>();
+        request->key = key;
+        request->fullPath = fullPath;
+        request->kind = kind;
+        request->priority = priority;
+        request->sequence = _nextSequence++;
+        request->started = false;
+        _requests.emplace(key, request);
+        _queue.push_back(request);
+    }
+    request->callbacks.emplace_back(id, callback);
+    _reads.emplace(id, request);
+
+    _condition.notify_one();
+    return id;
+}
+
+void FileUtils::AsyncReader::cancel(AsyncReadID id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto iter = _reads.find(id);
+    if (iter == _reads.end())
+        return;
+
+    auto request = iter->second;
+    _reads.erase(iter);
+
+    auto& callbacks = request->callbacks;
+    callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [id](const std::pair<AsyncReadID, Callback>& callback) {
+        return callback.first == id;
+    }), callbacks.end());
+
+    // nobody waits for the file any more, don't read it
+    if (callbacks.empty() && !request->started)
+    {
+        _queue.erase(std::remove(_queue.begin(), _queue.end(), request), _queue.end());
+        _requests.erase(request->key);
+    }
+}
+
+void FileUtils::AsyncReader::run()
+{
+    for (;;)
+    {
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_stop)
+                return;
+
+            // highest priority first, then first queued
+            auto next = _queue.begin();
+            for (auto iter = _queue.begin() + 1; iter != _queue.end(); ++iter)
+            {
+                if ((*iter)->priority > (*next)->priority
+                    || ((*iter)->priority == (*next)->priority && (*iter)->sequence < (*next)->sequence))
+                {
+                    next = iter;
+                }
+            }
+            request = *next;
+            _queue.erase(next);
+            request->started = true;
+        }
+
+        // the path is absolute, so the file utils only read the file system here
+        auto result = std::make_shared<Result>();
+        switch (request->kind)
+        {
+            case Kind::DATA:
+                result->data = _fileUtils->getDataFromFile(request->fullPath);
+                break;
+            case Kind::STRING:
+                result->string = _fileUtils->getStringFromFile(request->fullPath);
+                break;
+            case Kind::VALUE_MAP:
+                result->valueMap = _fileUtils->getValueMapFromFile(request->fullPath);
+                break;
+        }
+
+        std::shared_ptr<AsyncReader> reader = shared_from_this();
+        Director::getInstance()->getScheduler()->performFunctionInCocosThread([reader, request, result] {
+            reader->deliver(request, *result);
+        });
+    }
+}
+
+void FileUtils::AsyncReader::deliver(const std::shared_ptr<Request>& request, const Result& result)
+{
+    std::vector<std::pair<AsyncReadID, Callback>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _requests.erase(request->key);
+        callbacks.swap(request->callbacks);
+        for (const auto& callback : callbacks)
+        {
+            _reads.erase(callback.first);
+        }
+    }
+
+    for (const auto& callback : callbacks)
+    {
+        callback.second(result);
+    }
+}
+
 FileUtils::FileUtils()
-    : _writablePath("")
+    : _pathIndexEnabled(false)
+    , _writablePath("")
 {
 }
 
 FileUtils::~FileUtils()
 {
+    // already stopped by destroyInstance and setDelegate, a subclass deleted otherwise should stop it too
+    stopAsyncReads();
 }
 
 bool FileUtils::writeStringToFile(const std::string& dataStr, const std::string& fullPath)
@@ -588,6 +839,7 @@ bool FileUtils::writeDataToFile(const Data& data, const std::string& fullPath)
 
         fclose(fp);
 
+        addToPathIndex(fullPath);
         return true;
     } while (0);
 
@@ -604,6 +856,7 @@ bool FileUtils::init()
 void FileUtils::purgeCachedEntries()
 {
     _fullPathCache.clear();
+    purgePathIndex();
 }
 
 std::string FileUtils::getStringFromFile(const std::string& filename)
@@ -615,11 +868,66 @@ std::string FileUtils::getStringFromFile(const std::string& filename)
 
 Data FileUtils::getDataFromFile(const std::string& filename)
 {
+    if (!filename.empty() && hasAssetPacks())
+    {
+        std::string name;
+        auto assetPack = findAssetPack(fullPathForFilename(filename), &name);
+        if (assetPack)
+        {
+            return assetPack->getData(name);
+        }
+    }
+
     Data d;
     getContents(filename, &d);
     return d;
 }
 
+FileUtils::AsyncReadID FileUtils::readAsync(const std::string& filename, const std::function<void(const Data&)>& callback, int priority)
+{
+    if (!_asyncReader)
+        _asyncReader = std::make_shared<AsyncReader>(this);
+
+    return _asyncReader->read(fullPathForFilename(filename), AsyncReader::Kind::DATA, priority, [callback](const AsyncReader::Result& result) {
+        callback(result.data);
+    });
+}
+
+FileUtils::AsyncReadID FileUtils::readStringAsync(const std::string& filename, const std::function<void(const std::string&)>& callback, int priority)
+{
+    if (!_asyncReader)
+        _asyncReader = std::make_shared<AsyncReader>(this);
+
+    return _asyncReader->read(fullPathForFilename(filename), AsyncReader::Kind::STRING, priority, [callback](const AsyncReader::Result& result) {
+        callback(result.string);
+    });
+}
+
+FileUtils::AsyncReadID FileUtils::readValueMapAsync(const std::string& filename, const std::function<void(const ValueMap&)>& callback, int priority)
+{
+    if (!_asyncReader)
+        _asyncReader = std::make_shared<AsyncReader>(this);
+
+    return _asyncReader->read(fullPathForFilename(filename), AsyncReader::Kind::VALUE_MAP, priority, [callback](const AsyncReader::Result& result) {
+        callback(result.valueMap);
+    });
+}
+
+void FileUtils::cancelAsyncRead(AsyncReadID id)
+{
+    if (_asyncReader)
+        _asyncReader->cancel(id);
+}
+
+void FileUtils::stopAsyncReads()
+{
+    if (_asyncReader)
+    {
+        // the callbacks already queued in the scheduler keep the reader alive
+        _asyncReader->stop();
+    }
+}
+
 
 FileUtils::Status FileUtils::getContents(const std::string& filename, ResizableBuffer* buffer)
 {
@@ -632,6 +940,11 @@ FileUtils::Status FileUtils::getContents(const std::string& filename, ResizableB
     if (fullPath.empty())
         return Status::NotExists;
 
+    std::string name;
+    auto assetPack = findAssetPack(fullPath, &name);
+    if (assetPack)
+        return assetPack->getContents(name, buffer);
+
     FILE *fp = fopen(fs->getSuitableFOpen(fullPath).c_str(), "rb");
     if (!fp)
         return Status::OpenFailed;
@@ -753,6 +1066,20 @@ std::string FileUtils::getPathForFilename(const std::string& filename, const std
     path += file_path;
     path += resolutionDirectory;
 
+    if (hasAssetPacks())
+    {
+        if (!path.empty() && path.back() != '/')
+        {
+            path += '/';
+        }
+        std::string name;
+        auto assetPack = findAssetPack(path, &name);
+        if (assetPack)
+        {
+            return assetPack->isFileExist(name + file) ? path + file : "";
+        }
+    }
+
     path = getFullPathForDirectoryAndFilename(path, file);
 
     return path;
@@ -780,13 +1107,52 @@ std::string FileUtils::fullPathForFilename(const std::string &filename) const
     // Get the new file name.
     const std::string newFilename( getNewFilename(filename) );
 
+    // The index holds normalized paths, others are looked up on the file system.
+    bool useIndex = _pathIndexEnabled
+        && newFilename.find("./") == std::string::npos
+        && newFilename.find("//") == std::string::npos
+        && newFilename.find('\\') == std::string::npos;
+
+    std::string directory;
+    std::string file = newFilename;
+    size_t pos = newFilename.find_last_of('/');
+    if (pos != std::string::npos)
+    {
+        directory = newFilename.substr(0, pos + 1);
+        file = newFilename.substr(pos + 1);
+    }
+
     std::string fullpath;
 
     for (const auto& searchIt : _searchPathArray)
     {
+        std::unique_lock<std::mutex> indexLock(_pathIndexMutex, std::defer_lock);
+        const PathIndex* pathIndex = nullptr;
+        if (useIndex)
+        {
+            indexLock.lock();
+            pathIndex = &getPathIndex(searchIt);
+            if (!pathIndex->listed)
+            {
+                pathIndex = nullptr;
+                indexLock.unlock();
+            }
+        }
+
         for (const auto& resolutionIt : _searchResolutionsOrderArray)
         {
-            fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            if (pathIndex)
+            {
+                // file_path + resolutionDirectory + file, relative to the search path
+                std::string path = directory + resolutionIt + file;
+                if (pathIndex->files.find(path) == pathIndex->files.end())
+                    continue;
+                fullpath = pathIndex->directory + path;
+            }
+            else
+            {
+                fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            }
 
             if (!fullpath.empty())
             {
@@ -876,6 +1242,7 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
     bool existDefaultRootPath = false;
 
     _fullPathCache.clear();
+    purgePathIndex();
     _searchPathArray.clear();
     for (const auto& iter : searchPaths)
     {
@@ -923,6 +1290,239 @@ void FileUtils::addSearchPath(const std::string &searchpath,const bool front)
     }
 }
 
+bool FileUtils::mountAssetPack(const std::string& packFile, bool front)
+{
+    std::string fullPath = fullPathForFilename(packFile);
+    if (fullPath.empty())
+        return false;
+
+    std::string root = fullPath + "/";
+    {
+        std::lock_guard<std::mutex> lock(_assetPackMutex);
+        for (const auto& assetPack : _assetPacks)
+        {
+            if (assetPack.first == root)
+                return true;
+        }
+    }
+
+    auto assetPack = AssetPack::open(fullPath);
+    if (assetPack == nullptr)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(_assetPackMutex);
+        _assetPacks.emplace_back(root, assetPack);
+    }
+    _fullPathCache.clear();
+    addSearchPath(root, front);
+    return true;
+}
+
+void FileUtils::unmountAssetPack(const std::string& packFile)
+{
+    std::string fullPath = fullPathForFilename(packFile);
+    std::string root = fullPath + "/";
+    {
+        // the reads in progress keep the pack alive
+        std::lock_guard<std::mutex> lock(_assetPackMutex);
+        auto it = std::find_if(_assetPacks.begin(), _assetPacks.end(), [&root](const std::pair<std::string, std::shared_ptr<AssetPack>>& assetPack) {
+            return assetPack.first == root;
+        });
+        if (it == _assetPacks.end())
+            return;
+        _assetPacks.erase(it);
+    }
+    _searchPathArray.erase(std::remove(_searchPathArray.begin(), _searchPathArray.end(), root), _searchPathArray.end());
+    _fullPathCache.clear();
+}
+
+void FileUtils::setPathIndexEnabled(bool enabled)
+{
+    _pathIndexEnabled = enabled;
+    if (!enabled)
+    {
+        purgePathIndex();
+    }
+}
+
+void FileUtils::buildPathIndex()
+{
+    for (const auto& searchPath : _searchPathArray)
+    {
+        std::lock_guard<std::mutex> lock(_pathIndexMutex);
+        getPathIndex(searchPath);
+    }
+}
+
+bool FileUtils::loadPathIndex(const std::string& indexFile, const std::string& searchPath)
+{
+    std::string content;
+    if (getContents(indexFile, &content) != Status::OK)
+        return false;
+
+    std::string path = isAbsolutePath(searchPath) ? searchPath : _defaultResRootPath + searchPath;
+    if (!path.empty() && path[path.length()-1] != '/')
+    {
+        path += "/";
+    }
+
+    std::lock_guard<std::mutex> lock(_pathIndexMutex);
+    PathIndex& pathIndex = _pathIndexes[path];
+    pathIndex.directory = getPathIndexDirectory(path);
+    pathIndex.files.clear();
+    pathIndex.listed = true;
+    pathIndex.loaded = true;
+
+    size_t start = 0;
+    while (start < content.size())
+    {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos)
+            end = content.size();
+        size_t lineEnd = end;
+        if (lineEnd > start && content[lineEnd - 1] == '\r')
+            --lineEnd;
+        if (lineEnd > start)
+            pathIndex.files.emplace(content, start, lineEnd - start);
+        start = end + 1;
+    }
+    return true;
+}
+
+bool FileUtils::writePathIndex(const std::string& searchPath, const std::string& indexFile)
+{
+    std::string path = isAbsolutePath(searchPath) ? searchPath : _defaultResRootPath + searchPath;
+    if (!path.empty() && path[path.length()-1] != '/')
+    {
+        path += "/";
+    }
+
+    std::vector<std::string> files;
+    if (!listFilesForPathIndex(getPathIndexDirectory(path), &files) || files.empty())
+        return false;
+
+    std::sort(files.begin(), files.end());
+    std::string content;
+    for (const auto& file : files)
+    {
+        content += file;
+        content += '\n';
+    }
+    return writeStringToFile(content, indexFile);
+}
+
+const FileUtils::PathIndex& FileUtils::getPathIndex(const std::string& searchPath) const
+{
+    auto iter = _pathIndexes.find(searchPath);
+    if (iter != _pathIndexes.end())
+    {
+        return iter->second;
+    }
+
+    PathIndex& pathIndex = _pathIndexes[searchPath];
+    pathIndex.directory = getPathIndexDirectory(searchPath);
+    pathIndex.loaded = false;
+
+    // asset packs are looked up in memory already
+    std::string name;
+    std::vector<std::string> files;
+    pathIndex.listed = !pathIndex.directory.empty()
+        && findAssetPack(searchPath, &name) == nullptr
+        && listFilesForPathIndex(pathIndex.directory, &files);
+    pathIndex.files.reserve(files.size());
+    for (auto& file : files)
+    {
+        pathIndex.files.insert(std::move(file));
+    }
+    return pathIndex;
+}
+
+void FileUtils::purgePathIndex()
+{
+    std::lock_guard<std::mutex> lock(_pathIndexMutex);
+    for (auto iter = _pathIndexes.begin(); iter != _pathIndexes.end();)
+    {
+        if (iter->second.loaded)
+            ++iter;
+        else
+            iter = _pathIndexes.erase(iter);
+    }
+}
+
+void FileUtils::addToPathIndex(const std::string& fullPath)
+{
+    std::string path = fullPath;
+    std::replace(path.begin(), path.end(), '\\', '/');
+
+    std::lock_guard<std::mutex> lock(_pathIndexMutex);
+    for (auto& iter : _pathIndexes)
+    {
+        PathIndex& pathIndex = iter.second;
+        const std::string& directory = pathIndex.directory;
+        if (pathIndex.listed && !directory.empty() && path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0)
+        {
+            pathIndex.files.insert(path.substr(directory.size()));
+        }
+    }
+}
+
+void FileUtils::removeFromPathIndex(const std::string& fullPath)
+{
+    // the index has '/' separators, like the paths given to writeDataToFile
+    std::string path = fullPath;
+    std::replace(path.begin(), path.end(), '\\', '/');
+
+    std::lock_guard<std::mutex> lock(_pathIndexMutex);
+    for (auto& iter : _pathIndexes)
+    {
+        PathIndex& pathIndex = iter.second;
+        const std::string& directory = pathIndex.directory;
+        if (!pathIndex.listed || directory.empty() || path.size() <= directory.size() || path.compare(0, directory.size(), directory) != 0)
+            continue;
+
+        std::string file = path.substr(directory.size());
+        if (file.back() != '/')
+        {
+            pathIndex.files.erase(file);
+            continue;
+        }
+        // a directory, with all its files
+        for (auto fileIter = pathIndex.files.begin(); fileIter != pathIndex.files.end();)
+        {
+            if (fileIter->compare(0, file.size(), file) == 0)
+                fileIter = pathIndex.files.erase(fileIter);
+            else
+                ++fileIter;
+        }
+    }
+}
+
+std::string FileUtils::getPathIndexDirectory(const std::string& searchPath) const
+{
+    return searchPath;
+}
+
+std::shared_ptr<AssetPack> FileUtils::findAssetPack(const std::string& fullPath, std::string* name) const
+{
+    std::lock_guard<std::mutex> lock(_assetPackMutex);
+    for (const auto& assetPack : _assetPacks)
+    {
+        if (fullPath.compare(0, assetPack.first.size(), assetPack.first) == 0)
+        {
+            *name = fullPath.substr(assetPack.first.size());
+            return assetPack.second;
+        }
+    }
+    return nullptr;
+}
+
+bool FileUtils::hasAssetPacks() const
+{
+    std::lock_guard<std::mutex> lock(_assetPackMutex);
+    return !_assetPacks.empty();
+}
+
 void FileUtils::setFilenameLookupDictionary(const ValueMap& filenameLookupDict)
 {
     _fullPathCache.clear();
@@ -969,7 +1569,9 @@ bool FileUtils::isFileExist(const std::string& filename) const
 {
     if (isAbsolutePath(filename))
     {
-        return isFileExistInternal(filename);
+        std::string name;
+        auto assetPack = findAssetPack(filename, &name);
+        return assetPack ? assetPack->isFileExist(name) : isFileExistInternal(filename);
     }
     else
     {
@@ -990,16 +1592,22 @@ bool FileUtils::isDirectoryExist(const std::string& dirPath) const
 {
     CCASSERT(!dirPath.empty(), "Invalid path");
 
+    auto isDirectory = [this](const std::string& fullpath) {
+        std::string name;
+        auto assetPack = findAssetPack(fullpath, &name);
+        return assetPack ? assetPack->isDirectoryExist(name) : isDirectoryExistInternal(fullpath);
+    };
+
     if (isAbsolutePath(dirPath))
     {
-        return isDirectoryExistInternal(dirPath);
+        return isDirectory(dirPath);
     }
 
     // Already Cached ?
     auto cacheIter = _fullPathCache.find(dirPath);
     if( cacheIter != _fullPathCache.end() )
     {
-        return isDirectoryExistInternal(cacheIter->second);
+        return isDirectory(cacheIter->second);
     }
 
     std::string fullpath;
@@ -1009,7 +1617,7 @@ bool FileUtils::isDirectoryExist(const std::string& dirPath) const
         {
             // searchPath + file_path + resourceDirectory
             fullpath = fullPathForFilename(searchIt + dirPath + resolutionIt);
-            if (isDirectoryExistInternal(fullpath))
+            if (isDirectory(fullpath))
             {
                 _fullPathCache.emplace(dirPath, fullpath);
                 return true;
@@ -1069,6 +1677,11 @@ long FileUtils::getFileSize(const std::string &filepath)
     return 0;
 }
 
+bool FileUtils::listFilesForPathIndex(const std::string& directory, std::vector<std::string>* files) const
+{
+    return false;
+}
+
 #else
 // default implements for unix like os
 #include <sys/types.h>
@@ -1154,7 +1767,10 @@ bool FileUtils::removeDirectory(const std::string& path)
     // Path may include space.
     command += "\"" + path + "\"";
     if (system(command.c_str()) >= 0)
+    {
+        removeFromPathIndex(path.back() == '/' ? path : path + "/");
         return true;
+    }
     else
         return false;
 }
@@ -1164,6 +1780,7 @@ bool FileUtils::removeFile(const std::string &path)
     if (remove(path.c_str())) {
         return false;
     } else {
+        removeFromPathIndex(path);
         return true;
     }
 }
@@ -1180,6 +1797,8 @@ bool FileUtils::renameFile(const std::string &oldfullpath, const std::string &ne
         CCLOGERROR("Fail to rename file %s to %s !Error code is %d", oldfullpath.c_str(), newfullpath.c_str(), errorCode);
         return false;
     }
+    removeFromPathIndex(oldfullpath);
+    addToPathIndex(newfullpath);
     return true;
 }
 
@@ -1210,6 +1829,11 @@ long FileUtils::getFileSize(const std::string &filepath)
             return 0;
     }
 
+    std::string name;
+    auto assetPack = findAssetPack(fullpath, &name);
+    if (assetPack)
+        return assetPack->getFileSize(name);
+
     struct stat info;
     // Get data associated with "crt_stat.c":
     int result = stat(fullpath.c_str(), &info);
@@ -1225,6 +1849,50 @@ long FileUtils::getFileSize(const std::string &filepath)
         return (long)(info.st_size);
     }
 }
+
+bool FileUtils::listFilesForPathIndex(const std::string& directory, std::vector<std::string>* files) const
+{
+    // directories to list, relative to directory, with their depth to stop at symbolic link loops
+    std::vector<std::pair<std::string, int>> directories(1, std::make_pair(std::string(), 0));
+    while (!directories.empty())
+    {
+        std::string subdirectory = directories.back().first;
+        int depth = directories.back().second;
+        directories.pop_back();
+
+        DIR* dir = opendir((directory + subdirectory).c_str());
+        if (!dir)
+        {
+            if (subdirectory.empty())
+                return false;
+            continue;
+        }
+
+        while (struct dirent* entry = readdir(dir))
+        {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+
+            std::string path = subdirectory + name;
+            bool isDirectory = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+            {
+                struct stat st;
+                if (stat((directory + path).c_str(), &st) != 0)
+                    continue;
+                isDirectory = S_ISDIR(st.st_mode);
+            }
+
+            if (!isDirectory)
+                files->push_back(path);
+            else if (depth < 64)
+                directories.push_back(std::make_pair(path + "/", depth + 1));
+        }
+        closedir(dir);
+    }
+    return true;
+}
 #endif
 
 //////////////////////////////////////////////////////////////////////////
@@ -27,7 +27,11 @@ THE SOFTWARE.
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <type_traits>
 
 #include "platform/CCPlatformMacros.h"
@@ -100,6 +104,10 @@ class ResizableBufferAdapter<Data> : public ResizableBuffer {
 public:
     explicit ResizableBufferAdapter(BufferType* buffer) : _buffer(buffer) {}
     virtual void resize(size_t size) override {
+        if (_buffer->isView()) {
+            // the bytes of a view can't be reallocated
+            *_buffer = Data(*_buffer);
+        }
         if (static_cast<size_t>(_buffer->getSize()) < size) {
             auto old = _buffer->getBytes();
             void* buffer = realloc(old, size);
@@ -112,6 +120,9 @@ public:
     }
 };
 
+class AssetPack;
+class ValueDocument;
+
 /** Helper class to handle file operations. */
 class CC_DLL FileUtils
 {
@@ -155,7 +166,8 @@ public:
     virtual ~FileUtils();
 
     /**
-     *  Purges full path caches.
+     *  Purges full path caches, and the path indexes built from the search paths.
+     *  Call it after adding or removing files without FileUtils, e.g. after a download.
      */
     virtual void purgeCachedEntries();
 
@@ -170,6 +182,46 @@ public:
      */
     virtual Data getDataFromFile(const std::string& filename);
 
+    /** Identifies an asynchronous read, to cancel it. 0 is never used by a read. */
+    typedef unsigned int AsyncReadID;
+
+    /**
+     *  Reads a file on an IO thread, like getDataFromFile.
+     *  The full path of the file is found immediately, then the file is read by one of the IO threads,
+     *  and the callback is called on the cocos thread by the scheduler, with empty data if the file can't be read.
+     *  Reads of the same file are merged while the file is being read, so it is read once for all of them.
+     *  Must be called on the cocos thread.
+     *
+     *  @param filename The file to read.
+     *  @param callback Called with the content of the file.
+     *  @param priority Reads of higher priority start first, reads of the same priority start in order.
+     *  @return The id of the read, to cancel it.
+     *  @since v3.15
+     */
+    AsyncReadID readAsync(const std::string& filename, const std::function<void(const Data&)>& callback, int priority = 0);
+
+    /**
+     *  Reads a file on an IO thread, like getStringFromFile.
+     *  @see readAsync
+     *  @since v3.15
+     */
+    AsyncReadID readStringAsync(const std::string& filename, const std::function<void(const std::string&)>& callback, int priority = 0);
+
+    /**
+     *  Reads a file on an IO thread, like getValueMapFromFile, the file is also parsed on the IO thread.
+     *  @see readAsync
+     *  @since v3.15
+     */
+    AsyncReadID readValueMapAsync(const std::string& filename, const std::function<void(const ValueMap&)>& callback, int priority = 0);
+
+    /**
+     *  Cancels an asynchronous read, its callback is not called.
+     *  The file is not read if no other read waits for it and it is not being read yet.
+     *  Must be called on the cocos thread.
+     *  @since v3.15
+     */
+    void cancelAsyncRead(AsyncReadID id);
+
 
     enum class Status
     {
@@ -442,6 +494,65 @@ public:
      */
     virtual const std::vector<std::string>& getSearchPaths() const;
 
+    /**
+     *  Mounts an asset pack written by AssetPack::write.
+     *  The files of the pack are found under the path of the pack used as a directory, e.g. "res.pack/images/a.png",
+     *  and this directory is added to the search paths, so "images/a.png" is found in the pack too.
+     *  Looking up a file of a pack does no system call, and its uncompressed files are read
+     *  by getDataFromFile without copy. setSearchPaths removes the pack from the search paths, but it stays mounted.
+     *  Packs can be mounted and unmounted while readAsync reads files, a pack stays alive until its reads end.
+     *
+     *  @param packFile The pack file.
+     *  @param front Whether the pack is searched before the other search paths.
+     *  @return False if the pack can't be read.
+     *  @since v3.15
+     */
+    bool mountAssetPack(const std::string& packFile, bool front = true);
+
+    /**
+     *  Unmounts an asset pack and removes it from the search paths.
+     *  The data returned by getDataFromFile stays valid.
+     *  @since v3.15
+     */
+    void unmountAssetPack(const std::string& packFile);
+
+    /**
+     *  Enables the path index, it is disabled by default.
+     *  When it is enabled, the files under each search path are listed once, at the first lookup in the search path,
+     *  and fullPathForFilename looks up a file in these lists instead of checking the file system for each
+     *  search path and resolution directory. Files which don't exist are then found to be missing without any system call.
+     *  The lists are dropped by setSearchPaths and purgeCachedEntries. Lookups in the index are case sensitive.
+     *  Search paths which can't be listed, like the assets of an Android package, are looked up on the file system,
+     *  unless their index is loaded with loadPathIndex.
+     *  @since v3.15
+     */
+    void setPathIndexEnabled(bool enabled);
+    bool isPathIndexEnabled() const { return _pathIndexEnabled; }
+
+    /**
+     *  Lists the files of all the search paths now, instead of at their first lookup.
+     *  @since v3.15
+     */
+    void buildPathIndex();
+
+    /**
+     *  Loads the index of a search path written by writePathIndex, e.g. made on desktop and shipped with the game.
+     *  A loaded index is kept by setSearchPaths and purgeCachedEntries.
+     *
+     *  @param indexFile The index file, with one file per line, relative to the search path.
+     *  @param searchPath The search path, the default is the resource root path.
+     *  @return False if the index file can't be read.
+     *  @since v3.15
+     */
+    bool loadPathIndex(const std::string& indexFile, const std::string& searchPath = "");
+
+    /**
+     *  Lists the files of a search path into an index file for loadPathIndex.
+     *  @return False if the search path can't be listed or the index file can't be written.
+     *  @since v3.15
+     */
+    bool writePathIndex(const std::string& searchPath, const std::string& indexFile);
+
     /**
      *  Gets the writable path.
      *  @return  The path that can be write/read a file in
@@ -477,6 +588,14 @@ public:
      */
     virtual ValueMap getValueMapFromData(const char* filedata, int filesize);
 
+    /**
+     *  Parses a plist file into an immutable ValueDocument, which costs much fewer allocations than a ValueMap.
+     *  @param filename The filename of the file to gets content.
+     *  @return An autoreleased ValueDocument, or nullptr if the file can't be read or is not a plist.
+     *  @since v3.15
+     */
+    virtual ValueDocument* getValueDocumentFromFile(const std::string& filename);
+
     /**
     * write a ValueMap into a plist file
     *
@@ -688,6 +807,67 @@ protected:
      */
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& directory, const std::string& filename) const;
 
+    /**
+     *  Finds the mounted asset pack holding a full path.
+     *
+     *  @param fullPath The full path of a file or a directory.
+     *  @param name Receives the path in the pack.
+     *  @return The pack, or nullptr if the path is not in a mounted pack. It is shared,
+     *  so it can be read by the IO threads of readAsync while it is unmounted.
+     *  @since v3.15
+     */
+    std::shared_ptr<AssetPack> findAssetPack(const std::string& fullPath, std::string* name) const;
+
+    /** Whether an asset pack is mounted. */
+    bool hasAssetPacks() const;
+
+    /**
+     *  Stops the IO threads of readAsync, before the file utils are destroyed:
+     *  the threads call virtual methods, which can't run once the subclass is destroyed.
+     *  @since v3.15
+     */
+    void stopAsyncReads();
+
+    /** The IO threads of readAsync. */
+    class AsyncReader;
+
+    /**
+     *  Gets the directory which the full paths of the files under a search path start with.
+     *  @note Only iOS and Mac need to override this method, for the search paths in the application bundle.
+     *  @since v3.15
+     */
+    virtual std::string getPathIndexDirectory(const std::string& searchPath) const;
+
+    /**
+     *  Lists the files under a directory recursively, for the path index.
+     *
+     *  @param directory The directory, ending with '/'.
+     *  @param files Receives the paths of the files relative to the directory, with '/' separators.
+     *  @return False if the directory can't be listed.
+     *  @since v3.15
+     */
+    virtual bool listFilesForPathIndex(const std::string& directory, std::vector<std::string>* files) const;
+
+    /** The files under a search path. */
+    struct PathIndex
+    {
+        std::string directory;
+        std::unordered_set<std::string> files;
+        // false when the search path can't be listed, its files are then looked up on the file system
+        bool listed;
+        // true when loaded by loadPathIndex
+        bool loaded;
+    };
+
+    /** Gets the index of a search path, lists it at the first call. _pathIndexMutex must be locked. */
+    const PathIndex& getPathIndex(const std::string& searchPath) const;
+    /** Drops the listed indexes, the loaded ones are kept. */
+    void purgePathIndex();
+    /** Adds a written file to the listed indexes. */
+    void addToPathIndex(const std::string& fullPath);
+    /** Removes a file from the listed indexes, or all the files under a directory if the path ends with '/'. */
+    void removeFromPathIndex(const std::string& fullPath);
+
     /** Dictionary used to lookup filenames based on a key.
      *  It is used internally by the following methods:
      *
@@ -724,6 +904,26 @@ protected:
      */
     mutable std::unordered_map<std::string, std::string> _fullPathCache;
 
+    /**
+     *  The mounted asset packs, with the directory of their files.
+     */
+    std::vector<std::pair<std::string, std::shared_ptr<AssetPack>>> _assetPacks;
+    mutable std::mutex _assetPackMutex;
+
+    /**
+     *  The path indexes, by search path.
+     *  They are updated by the threads writing files, the mutex guards them.
+     */
+    bool _pathIndexEnabled;
+    mutable std::unordered_map<std::string, PathIndex> _pathIndexes;
+    mutable std::mutex _pathIndexMutex;
+
+    /**
+     *  Reads the files of readAsync, created at the first read.
+     *  It is shared with the callbacks queued in the scheduler.
+     */
+    std::shared_ptr<AsyncReader> _asyncReader;
+
     /**
      * Writable path.
      */
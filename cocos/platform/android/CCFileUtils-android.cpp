@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "android/asset_manager.h"
 #include "android/asset_manager_jni.h"
 #include "base/ZipUtils.h"
+#include "platform/CCAssetPack.h"
 #include <stdlib.h>
 #include <sys/stat.h>
 
@@ -259,6 +260,11 @@ FileUtils::Status FileUtilsAndroid::getContents(const std::string& filename, Res
 
     string fullPath = fullPathForFilename(filename);
 
+    std::string name;
+    auto assetPack = findAssetPack(fullPath, &name);
+    if (assetPack)
+        return assetPack->getContents(name, buffer);
+
     if (fullPath[0] == '/')
         return FileUtils::getContents(fullPath, buffer);
 
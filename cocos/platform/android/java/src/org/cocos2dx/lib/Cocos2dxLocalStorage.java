@@ -27,8 +27,11 @@ import android.content.Context;
 import android.database.Cursor;
 import android.database.sqlite.SQLiteDatabase;
 import android.database.sqlite.SQLiteOpenHelper;
+import android.os.Build;
 import android.util.Log;
 
+import java.util.ArrayList;
+
 
 public class Cocos2dxLocalStorage {
 
@@ -40,6 +43,7 @@ public class Cocos2dxLocalStorage {
     
     private static DBOpenHelper mDatabaseOpenHelper = null;
     private static SQLiteDatabase mDatabase = null;
+    private static int mBatchDepth = 0;
     /**
      * Constructor
      * @param context The Context within which to work, used to create the DB
@@ -51,6 +55,11 @@ public class Cocos2dxLocalStorage {
             TABLE_NAME = tableName;
             mDatabaseOpenHelper = new DBOpenHelper(Cocos2dxActivity.getContext());
             mDatabase = mDatabaseOpenHelper.getWritableDatabase();
+            if (Build.VERSION.SDK_INT >= 11) {
+                // readers and the writer don't block each other
+                mDatabase.enableWriteAheadLogging();
+            }
+            mBatchDepth = 0;
             return true;
         }
         return false;
@@ -58,6 +67,9 @@ public class Cocos2dxLocalStorage {
     
     public static void destroy() {
         if (mDatabase != null) {
+            while (mBatchDepth > 0) {
+                commitBatch();
+            }
             mDatabase.close();
         }
     }
@@ -109,7 +121,55 @@ public class Cocos2dxLocalStorage {
             e.printStackTrace();
         }
     }
-    
+
+
+    public static void beginBatch() {
+        try {
+            if (mBatchDepth++ == 0) {
+                mDatabase.beginTransaction();
+            }
+        } catch (Exception e) {
+            e.printStackTrace();
+        }
+    }
+
+    public static void commitBatch() {
+        try {
+            if (mBatchDepth > 0 && --mBatchDepth == 0) {
+                mDatabase.setTransactionSuccessful();
+                mDatabase.endTransaction();
+            }
+        } catch (Exception e) {
+            e.printStackTrace();
+        }
+    }
+
+    /**
+     * Gets the items whose key is in [first, last) and starts with prefix, sorted by key.
+     * @param last null for no upper bound
+     * @return the keys and values, one after the other
+     */
+    public static String[] getItems(String first, String last, String prefix) {
+        ArrayList<String> ret = new ArrayList<String>();
+        try {
+            String sql = "select key,value from "+TABLE_NAME+" where key>=?"+(last != null ? " and key<?" : "")+" order by key";
+            Cursor c = mDatabase.rawQuery(sql, last != null ? new String[]{first, last} : new String[]{first});
+            while (c.moveToNext()) {
+                String key = c.getString(0);
+                // keys are sorted, the first one without the prefix ends it
+                if (!key.startsWith(prefix)) {
+                    break;
+                }
+                String value = c.getString(1);
+                ret.add(key);
+                ret.add(value != null ? value : "");
+            }
+            c.close();
+        } catch (Exception e) {
+            e.printStackTrace();
+        }
+        return ret.toArray(new String[ret.size()]);
+    }
 
     /**
      * This creates/opens the database.
@@ -50,6 +50,7 @@ public:
     /* override functions */
     virtual std::string getWritablePath() const override;
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& directory, const std::string& filename) const override;
+    virtual std::string getPathIndexDirectory(const std::string& searchPath) const override;
 
     virtual ValueMap getValueMapFromFile(const std::string& filename) override;
     virtual ValueMap getValueMapFromData(const char* filedata, int filesize)override;
@@ -307,7 +307,10 @@ bool FileUtilsApple::removeDirectory(const std::string& path)
     if (nftw(path.c_str(),unlink_cb, 64, FTW_DEPTH | FTW_PHYS))
         return false;
     else
+    {
+        removeFromPathIndex(path.back() == '/' ? path : path + "/");
         return true;
+    }
 }
 
 std::string FileUtilsApple::getFullPathForDirectoryAndFilename(const std::string& directory, const std::string& filename) const
@@ -332,6 +335,16 @@ std::string FileUtilsApple::getFullPathForDirectoryAndFilename(const std::string
     return "";
 }
 
+std::string FileUtilsApple::getPathIndexDirectory(const std::string& searchPath) const
+{
+    if (searchPath.empty() || searchPath[0] != '/')
+    {
+        // relative search paths are in the bundle
+        return std::string([[pimpl_->getBundle() resourcePath] UTF8String]) + "/" + searchPath;
+    }
+    return searchPath;
+}
+
 ValueMap FileUtilsApple::getValueMapFromFile(const std::string& filename)
 {
     auto d(FileUtils::getInstance()->getDataFromFile(filename));
@@ -376,7 +389,10 @@ bool FileUtils::writeValueMapToFile(const ValueMap& dict, const std::string& ful
 
     NSString *file = [NSString stringWithUTF8String:fullPath.c_str()];
     // do it atomically
-    return [nsDict writeToFile:file atomically:YES];
+    if (![nsDict writeToFile:file atomically:YES])
+        return false;
+    addToPathIndex(fullPath);
+    return true;
 }
 
 void FileUtilsApple::valueMapCompact(ValueMap& valueMap)
@@ -441,7 +457,8 @@ bool FileUtils::writeValueVectorToFile(const ValueVector& vecData, const std::st
         addCCValueToNSArray(e, array);
     }
 
-    [array writeToFile:path atomically:YES];
+    if ([array writeToFile:path atomically:YES])
+        addToPathIndex(fullPath);
 
     return true;
 }
@@ -453,8 +470,22 @@ ValueVector FileUtilsApple::getValueVectorFromFile(const std::string& filename)
     //    pPath = [[NSBundle mainBundle] pathForResource:pPath ofType:pathExtension];
     //    fixing cannot read data using Array::createWithContentsOfFile
     std::string fullPath = fullPathForFilename(filename);
-    NSString* path = [NSString stringWithUTF8String:fullPath.c_str()];
-    NSArray* array = [NSArray arrayWithContentsOfFile:path];
+    NSArray* array = nil;
+    std::string name;
+    if (findAssetPack(fullPath, &name))
+    {
+        // files of asset packs are not on disk
+        auto d(getDataFromFile(fullPath));
+        NSData* file = [NSData dataWithBytesNoCopy:d.getBytes() length:d.getSize() freeWhenDone:NO];
+        id plist = [NSPropertyListSerialization propertyListWithData:file options:NSPropertyListImmutable format:nil error:nil];
+        if ([plist isKindOfClass:[NSArray class]])
+            array = plist;
+    }
+    else
+    {
+        NSString* path = [NSString stringWithUTF8String:fullPath.c_str()];
+        array = [NSArray arrayWithContentsOfFile:path];
+    }
 
     ValueVector ret;
 
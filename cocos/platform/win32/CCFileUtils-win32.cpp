@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "platform/win32/CCFileUtils-win32.h"
 #include "platform/win32/CCUtils-win32.h"
 #include "platform/CCCommon.h"
+#include "platform/CCAssetPack.h"
 #include <Shlobj.h>
 #include <cstdlib>
 #include <regex>
@@ -121,6 +122,11 @@ std::string FileUtilsWin32::getSuitableFOpen(const std::string& filenameUtf8) co
 
 long FileUtilsWin32::getFileSize(const std::string &filepath)
 {
+    std::string name;
+    auto assetPack = findAssetPack(isAbsolutePath(filepath) ? filepath : fullPathForFilename(filepath), &name);
+    if (assetPack)
+        return assetPack->getFileSize(name);
+
     WIN32_FILE_ATTRIBUTE_DATA fad;
     if (!GetFileAttributesEx(StringUtf8ToWideChar(filepath).c_str(), GetFileExInfoStandard, &fad))
     {
@@ -171,6 +177,11 @@ FileUtils::Status FileUtilsWin32::getContents(const std::string& filename, Resiz
     // read the file from hardware
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+    std::string name;
+    auto assetPack = findAssetPack(fullPath, &name);
+    if (assetPack)
+        return assetPack->getContents(name, buffer);
+
     HANDLE fileHandle = ::CreateFile(StringUtf8ToWideChar(fullPath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, NULL, nullptr);
     if (fileHandle == INVALID_HANDLE_VALUE)
         return FileUtils::Status::OpenFailed;
@@ -290,6 +301,8 @@ bool FileUtilsWin32::renameFile(const std::string &oldfullpath, const std::strin
 
     if (MoveFile(_wOld.c_str(), _wNew.c_str()))
     {
+        removeFromPathIndex(oldfullpath);
+        addToPathIndex(newfullpath);
         return true;
     }
     else
@@ -376,6 +389,7 @@ bool FileUtilsWin32::removeFile(const std::string &filepath)
 
     if (DeleteFile(StringUtf8ToWideChar(win32path).c_str()))
     {
+        removeFromPathIndex(filepath);
         return true;
     }
     else
@@ -419,11 +433,54 @@ bool FileUtilsWin32::removeDirectory(const std::string& dirPath)
     }
     if (ret && RemoveDirectory(wpath.c_str()))
     {
+        removeFromPathIndex(dirPath);
         return true;
     }
     return false;
 }
 
+bool FileUtilsWin32::listFilesForPathIndex(const std::string& directory, std::vector<std::string>* files) const
+{
+    std::wstring wdirectory = StringUtf8ToWideChar(directory);
+    // directories to list, relative to directory
+    std::vector<std::wstring> directories(1, std::wstring());
+    while (!directories.empty())
+    {
+        std::wstring subdirectory = directories.back();
+        directories.pop_back();
+
+        std::wstring pattern = wdirectory + subdirectory + L"*.*";
+        WIN32_FIND_DATA wfd;
+        HANDLE search = FindFirstFileEx(pattern.c_str(), FindExInfoBasic, &wfd, FindExSearchNameMatch, NULL, 0);
+        if (search == INVALID_HANDLE_VALUE)
+        {
+            if (subdirectory.empty())
+                return false;
+            continue;
+        }
+
+        BOOL find = true;
+        while (find)
+        {
+            std::wstring fileName = wfd.cFileName;
+            if (fileName != L"." && fileName != L"..")
+            {
+                if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                {
+                    directories.push_back(subdirectory + fileName + L'/');
+                }
+                else
+                {
+                    files->push_back(StringWideCharToUtf8(subdirectory + fileName));
+                }
+            }
+            find = FindNextFile(search, &wfd);
+        }
+        FindClose(search);
+    }
+    return true;
+}
+
 NS_CC_END
 
 #endif // CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
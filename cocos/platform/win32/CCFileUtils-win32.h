@@ -132,6 +132,8 @@ protected:
      *  @return The full path of the file, if the file can't be found, it will return an empty string.
      */
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& directory, const std::string& filename) const override;
+
+    virtual bool listFilesForPathIndex(const std::string& directory, std::vector<std::string>* files) const override;
 };
 
 // end of platform group
@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include <regex>
 #include "platform/winrt/CCWinRTUtils.h"
 #include "platform/CCCommon.h"
+#include "platform/CCAssetPack.h"
 using namespace std;
 
 NS_CC_BEGIN
@@ -131,6 +132,11 @@ std::string CCFileUtilsWinRT::getSuitableFOpen(const std::string& filenameUtf8)
 
 long CCFileUtilsWinRT::getFileSize(const std::string &filepath)
 {
+    std::string name;
+    auto assetPack = findAssetPack(isAbsolutePath(filepath) ? filepath : fullPathForFilename(filepath), &name);
+    if (assetPack)
+        return assetPack->getFileSize(name);
+
     WIN32_FILE_ATTRIBUTE_DATA fad;
     if (!GetFileAttributesEx(StringUtf8ToWideChar(filepath).c_str(), GetFileExInfoStandard, &fad))
     {
@@ -150,6 +156,11 @@ FileUtils::Status CCFileUtilsWinRT::getContents(const std::string& filename, Res
     // read the file from hardware
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+    std::string name;
+    auto assetPack = findAssetPack(fullPath, &name);
+    if (assetPack)
+        return assetPack->getContents(name, buffer);
+
     HANDLE fileHandle = ::CreateFile2(StringUtf8ToWideChar(fullPath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING, nullptr);
     if (fileHandle == INVALID_HANDLE_VALUE)
         return FileUtils::Status::OpenFailed;
@@ -300,6 +311,7 @@ bool CCFileUtilsWinRT::removeDirectory(const std::string& path)
     }
     if (ret && RemoveDirectory(wpath.c_str()))
     {
+        removeFromPathIndex(path);
         return true;
     }
     return false;
@@ -321,6 +333,7 @@ bool CCFileUtilsWinRT::removeFile(const std::string &path)
     std::wstring wpath = StringUtf8ToWideChar(path);
     if (DeleteFile(wpath.c_str()))
     {
+        removeFromPathIndex(path);
         return true;
     }
     else
@@ -352,6 +365,8 @@ bool CCFileUtilsWinRT::renameFile(const std::string &oldfullpath, const std::str
     if (MoveFileEx(StringUtf8ToWideChar(_oldfullpath).c_str(), _wNewfullpath.c_str(),
         MOVEFILE_REPLACE_EXISTING & MOVEFILE_WRITE_THROUGH))
     {
+        removeFromPathIndex(oldfullpath);
+        addToPathIndex(newfullpath);
         return true;
     }
     else
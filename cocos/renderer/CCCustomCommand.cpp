@@ -23,9 +23,12 @@
  ****************************************************************************/
 
 #include "renderer/CCCustomCommand.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(CustomCommand, 64)
+
 CustomCommand::CustomCommand()
 : func(nullptr)
 {
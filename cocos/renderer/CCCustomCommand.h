@@ -41,6 +41,8 @@ such as stencil function, depth functions etc. The render command is executed by
 class CC_DLL CustomCommand : public RenderCommand
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(CustomCommand)
+
 	/**Constructor.*/
     CustomCommand();
     /**Destructor.*/
@@ -26,9 +26,12 @@
 #include "renderer/CCGroupCommand.h"
 #include "renderer/CCRenderer.h"
 #include "base/CCDirector.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(GroupCommand, 64)
+
 GroupCommandManager::GroupCommandManager()
 {
 
@@ -62,6 +62,8 @@ protected:
 class CC_DLL GroupCommand : public RenderCommand
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(GroupCommand)
+
     /**@{
      Constructor and Destructor.
      */
@@ -32,9 +32,12 @@
 #include "renderer/CCRenderer.h"
 #include "renderer/CCPass.h"
 #include "renderer/CCTexture2D.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(QuadCommand, 64)
+
 int QuadCommand::__indexCapacity = -1;
 GLushort* QuadCommand::__indices = nullptr;
 
@@ -45,6 +45,8 @@ NS_CC_BEGIN
 class CC_DLL QuadCommand : public TrianglesCommand
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(QuadCommand)
+
     /**Constructor.*/
     QuadCommand();
     /**Destructor.*/
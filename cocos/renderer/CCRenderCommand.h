@@ -30,6 +30,7 @@
 
 #include "platform/CCPlatformMacros.h"
 #include "base/ccTypes.h"
+#include "base/allocator/CCAllocatorMacros.h"
 
 /**
  * @addtogroup renderer
@@ -29,9 +29,12 @@
 #include "xxhash.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCTexture2D.h"
+#include "base/allocator/CCAllocatorStrategyPool.h"
 
 NS_CC_BEGIN
 
+CC_DEFINE_ALLOCATOR_POOL(TrianglesCommand, 64)
+
 TrianglesCommand::TrianglesCommand()
 :_materialID(0)
 ,_textureID(0)
@@ -42,6 +42,8 @@ NS_CC_BEGIN
 class CC_DLL TrianglesCommand : public RenderCommand
 {
 public:
+    CC_DECLARE_ALLOCATOR_POOL(TrianglesCommand)
+
     /**The structure of Triangles. */
     struct Triangles
     {
@@ -0,0 +1,51 @@
+
+const char* ccParticleGPU_vert = R"(
+
+// xy: corner of the quad in [-0.5, 0.5], zw: texel of the particle in the state textures
+attribute vec4 a_position;
+
+uniform sampler2D u_state;
+uniform sampler2D u_life;
+// size, delta size, rotation, delta rotation
+uniform sampler2D u_size;
+uniform sampler2D u_color;
+uniform sampler2D u_deltaColor;
+uniform float u_time;
+uniform float u_opacityModifyRGB;
+// brings the start position of free particles into node space
+uniform mat4 u_startToNode;
+uniform vec2 u_origin;
+// xy: texture coordinates of the bottom left corner, zw: of the top right corner
+uniform vec4 u_texRect;
+
+#ifdef GL_ES
+varying lowp vec4 v_fragmentColor;
+varying mediump vec2 v_texCoord;
+#else
+varying vec4 v_fragmentColor;
+varying vec2 v_texCoord;
+#endif
+
+void main()
+{
+    vec4 life = texture2D(u_life, a_position.zw);
+    vec4 size = texture2D(u_size, a_position.zw);
+    float age = u_time - life.x;
+
+    // dead particles collapse into a point
+    float alive = (age >= 0.0 && age < life.y) ? 1.0 : 0.0;
+    vec2 corner = a_position.xy * max(size.x + size.y * age, 0.0) * alive;
+    float r = -radians(size.z + size.w * age);
+    float cr = cos(r);
+    float sr = sin(r);
+    corner = vec2(corner.x * cr - corner.y * sr, corner.x * sr + corner.y * cr);
+
+    vec2 start = (u_startToNode * vec4(life.zw, 0.0, 1.0)).xy;
+    vec2 position = texture2D(u_state, a_position.zw).xy + start - u_origin + corner;
+    gl_Position = CC_MVPMatrix * vec4(position, 0.0, 1.0);
+
+    vec4 color = clamp(texture2D(u_color, a_position.zw) + texture2D(u_deltaColor, a_position.zw) * age, 0.0, 1.0);
+    v_fragmentColor = u_opacityModifyRGB > 0.5 ? vec4(color.rgb * color.a, color.a) : color;
+    v_texCoord = mix(u_texRect.xy, u_texRect.zw, a_position.xy + 0.5);
+}
+)";
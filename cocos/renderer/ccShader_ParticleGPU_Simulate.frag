@@ -0,0 +1,50 @@
+
+const char* ccParticleGPU_Simulate_frag = R"(
+
+#ifdef GL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#endif
+#endif
+
+// x, y, dirX, dirY in gravity mode, x, y, angle, radius in radius mode
+uniform sampler2D u_state;
+// birth time, life, start position
+uniform sampler2D u_life;
+// gravity mode: position, direction. radius mode: radius, delta radius, angle, degrees per second
+uniform sampler2D u_motion;
+// radial and tangential acceleration
+uniform sampler2D u_accel;
+// x: time at the start of the step, y: dt, z: y coordinate flip, w: 1 in radius mode
+uniform vec4 u_step;
+uniform vec2 u_gravity;
+
+varying vec2 v_texCoord;
+
+void main()
+{
+    vec4 life = texture2D(u_life, v_texCoord);
+    vec4 motion = texture2D(u_motion, v_texCoord);
+
+    if (u_step.w > 0.5)
+    {
+        // radius mode has a closed form
+        float age = u_step.x + u_step.y - life.x;
+        float angle = motion.z + motion.w * age;
+        float radius = motion.x + motion.y * age;
+        gl_FragColor = vec4(-cos(angle) * radius, -sin(angle) * radius * u_step.z, angle, radius);
+        return;
+    }
+
+    // particles emitted by this step start from their initial position and direction
+    vec4 state = life.x >= u_step.x ? motion : texture2D(u_state, v_texCoord);
+    vec4 accel = texture2D(u_accel, v_texCoord);
+
+    float len2 = dot(state.xy, state.xy);
+    vec2 radial = len2 > 0.0 ? state.xy * inversesqrt(len2) : vec2(0.0);
+    vec2 tangential = vec2(-radial.y, radial.x);
+    vec2 dir = state.zw + (radial * accel.x + tangential * accel.y + u_gravity) * u_step.y;
+
+    gl_FragColor = vec4(state.xy + dir * u_step.y * u_step.z, dir);
+}
+)";
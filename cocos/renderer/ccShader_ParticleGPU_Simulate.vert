@@ -0,0 +1,14 @@
+
+const char* ccParticleGPU_Simulate_vert = R"(
+
+attribute vec4 a_position;
+
+varying vec2 v_texCoord;
+
+void main()
+{
+    // a quad covering the whole state texture, one fragment per particle
+    gl_Position = vec4(a_position.xy, 0.0, 1.0);
+    v_texCoord = a_position.xy * 0.5 + 0.5;
+}
+)";
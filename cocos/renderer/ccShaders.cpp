@@ -91,6 +91,9 @@ NS_CC_BEGIN
 #include "renderer/ccShader_3D_Terrain.frag"
 #include "renderer/ccShader_CameraClear.vert"
 #include "renderer/ccShader_CameraClear.frag"
+#include "renderer/ccShader_ParticleGPU.vert"
+#include "renderer/ccShader_ParticleGPU_Simulate.vert"
+#include "renderer/ccShader_ParticleGPU_Simulate.frag"
 
 // ETC1 ALPHA support
 #include "renderer/ccShader_ETC1AS_PositionTextureColor.frag"
@@ -130,4 +130,68 @@ void localStorageClear()
     JniHelper::callStaticVoidMethod(className, "clear");
 }
 
+void localStorageBeginBatch()
+{
+    assert( _initialized );
+    JniHelper::callStaticVoidMethod(className, "beginBatch");
+}
+
+void localStorageCommitBatch()
+{
+    assert( _initialized );
+    JniHelper::callStaticVoidMethod(className, "commitBatch");
+}
+
+/** writes stay synchronous on Android, batches are the way to group them */
+void localStorageSetWriteBehind(bool /*enabled*/)
+{
+}
+
+void localStorageFlush()
+{
+}
+
+static void localStorageGetItems( const std::string& first, const std::string* last, const std::string& prefix,
+                                  std::vector<std::pair<std::string, std::string>> *outItems )
+{
+    assert( _initialized );
+    JniMethodInfo t;
+
+    if (JniHelper::getStaticMethodInfo(t, className.c_str(), "getItems", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)[Ljava/lang/String;"))
+    {
+        jstring jfirst = t.env->NewStringUTF(first.c_str());
+        jstring jlast = last ? t.env->NewStringUTF(last->c_str()) : nullptr;
+        jstring jprefix = t.env->NewStringUTF(prefix.c_str());
+        jobjectArray jitems = (jobjectArray)t.env->CallStaticObjectMethod(t.classID, t.methodID, jfirst, jlast, jprefix);
+        if (jitems != nullptr)
+        {
+            jsize count = t.env->GetArrayLength(jitems);
+            for (jsize i = 0; i + 1 < count; i += 2)
+            {
+                jstring jkey = (jstring)t.env->GetObjectArrayElement(jitems, i);
+                jstring jvalue = (jstring)t.env->GetObjectArrayElement(jitems, i + 1);
+                outItems->push_back(std::make_pair(JniHelper::jstring2string(jkey), JniHelper::jstring2string(jvalue)));
+                t.env->DeleteLocalRef(jkey);
+                t.env->DeleteLocalRef(jvalue);
+            }
+            t.env->DeleteLocalRef(jitems);
+        }
+        t.env->DeleteLocalRef(jfirst);
+        if (jlast)
+            t.env->DeleteLocalRef(jlast);
+        t.env->DeleteLocalRef(jprefix);
+        t.env->DeleteLocalRef(t.classID);
+    }
+}
+
+void localStorageGetItemsWithPrefix( const std::string& prefix, std::vector<std::pair<std::string, std::string>> *outItems )
+{
+    localStorageGetItems(prefix, nullptr, prefix, outItems);
+}
+
+void localStorageGetItemsInRange( const std::string& first, const std::string& last, std::vector<std::pair<std::string, std::string>> *outItems )
+{
+    localStorageGetItems(first, last.empty() ? nullptr : &last, std::string(), outItems);
+}
+
 #endif // #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
@@ -34,8 +34,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <sqlite3.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
 
 static int _initialized = 0;
 static sqlite3 *_db;
@@ -43,7 +49,43 @@ static sqlite3_stmt *_stmt_select;
 static sqlite3_stmt *_stmt_remove;
 static sqlite3_stmt *_stmt_update;
 static sqlite3_stmt *_stmt_clear;
+static sqlite3_stmt *_stmt_select_from;
+static sqlite3_stmt *_stmt_select_range;
+static std::string _path;
+// depth of the batches of the synchronous mode
+static int _batchDepth = 0;
 
+// write-behind: writes are queued, and written in batches by a thread with its own connection
+struct PendingWrite
+{
+    enum Type { SET, REMOVE, CLEAR } type;
+    std::string key;
+    std::string value;
+};
+
+// the latest write of a key, read by localStorageGetItem until it is written
+struct PendingItem
+{
+    bool removed;
+    std::string value;
+    unsigned long long seq;
+};
+
+static bool _writeBehind = false;
+static std::thread _writerThread;
+static std::mutex _writeMutex;
+static std::condition_variable _writeCondition;
+static std::condition_variable _writtenCondition;
+static std::vector<PendingWrite> _pendingWrites;
+static std::unordered_map<std::string, PendingItem> _pendingItems;
+// sequence number of a pending clear, 0 if there is none
+static unsigned long long _pendingClearSeq = 0;
+static unsigned long long _queuedSeq = 0;
+static unsigned long long _writtenSeq = 0;
+// depth of the batches of the write-behind mode, the writer waits for the outermost batch
+static int _queuedBatchDepth = 0;
+static int _flushWaiters = 0;
+static bool _stopWriter = false;
 
 static void localStorageCreateTable()
 {
@@ -57,17 +99,156 @@ static void localStorageCreateTable()
         printf("Error in CREATE TABLE\n");
 }
 
+static bool localStorageExec(sqlite3 *db, const char *sql)
+{
+    int ok = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+    if (ok != SQLITE_OK)
+    {
+        printf("Error in %s: %s\n", sql, sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+static bool localStorageIsInMemory()
+{
+    return _path.empty();
+}
+
+static void localStorageWriterLoop(sqlite3 *db)
+{
+    sqlite3_stmt *stmt_update = nullptr;
+    sqlite3_stmt *stmt_remove = nullptr;
+    sqlite3_stmt *stmt_clear = nullptr;
+    int ret = sqlite3_prepare_v2(db, "REPLACE INTO data (key, value) VALUES (?,?);", -1, &stmt_update, nullptr);
+    ret |= sqlite3_prepare_v2(db, "DELETE FROM data WHERE key=?;", -1, &stmt_remove, nullptr);
+    ret |= sqlite3_prepare_v2(db, "DELETE FROM data;", -1, &stmt_clear, nullptr);
+    if (ret != SQLITE_OK)
+        printf("Error initializing the localStorage writer\n");
+
+    std::unique_lock<std::mutex> lock(_writeMutex);
+    for (;;)
+    {
+        _writeCondition.wait(lock, [] {
+            return _stopWriter || (!_pendingWrites.empty() && (_queuedBatchDepth == 0 || _flushWaiters > 0));
+        });
+        if (_pendingWrites.empty())
+            break;
+
+        std::vector<PendingWrite> writes;
+        writes.swap(_pendingWrites);
+        unsigned long long seq = _queuedSeq;
+        lock.unlock();
+
+        // one transaction for all the writes queued meanwhile
+        localStorageExec(db, "BEGIN;");
+        for (const auto& write : writes)
+        {
+            sqlite3_stmt *stmt = write.type == PendingWrite::SET ? stmt_update
+                               : write.type == PendingWrite::REMOVE ? stmt_remove : stmt_clear;
+            int ok = SQLITE_OK;
+            if (write.type != PendingWrite::CLEAR)
+                ok |= sqlite3_bind_text(stmt, 1, write.key.c_str(), -1, SQLITE_STATIC);
+            if (write.type == PendingWrite::SET)
+                ok |= sqlite3_bind_text(stmt, 2, write.value.c_str(), -1, SQLITE_STATIC);
+            ok |= sqlite3_step(stmt);
+            ok |= sqlite3_reset(stmt);
+            if (ok != SQLITE_OK && ok != SQLITE_DONE)
+                printf("Error in localStorage write-behind\n");
+        }
+        localStorageExec(db, "COMMIT;");
+
+        lock.lock();
+        for (auto it = _pendingItems.begin(); it != _pendingItems.end();)
+        {
+            if (it->second.seq <= seq)
+                it = _pendingItems.erase(it);
+            else
+                ++it;
+        }
+        if (_pendingClearSeq != 0 && _pendingClearSeq <= seq)
+            _pendingClearSeq = 0;
+        _writtenSeq = seq;
+        _writtenCondition.notify_all();
+    }
+
+    sqlite3_finalize(stmt_update);
+    sqlite3_finalize(stmt_remove);
+    sqlite3_finalize(stmt_clear);
+    sqlite3_close(db);
+}
+
+static void localStorageStartWriter()
+{
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(_path.c_str(), &db) != SQLITE_OK)
+    {
+        printf("Error opening the localStorage writer\n");
+        sqlite3_close(db);
+        _writeBehind = false;
+        return;
+    }
+    sqlite3_busy_timeout(db, 1000);
+    localStorageExec(db, "PRAGMA synchronous=NORMAL;");
+
+    _stopWriter = false;
+    _writerThread = std::thread(localStorageWriterLoop, db);
+}
+
+static void localStorageStopWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        _stopWriter = true;
+    }
+    _writeCondition.notify_all();
+    _writerThread.join();
+}
+
+static void localStorageQueueWrite(PendingWrite::Type type, const std::string& key, const std::string& value)
+{
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        unsigned long long seq = ++_queuedSeq;
+        PendingWrite write = { type, key, value };
+        _pendingWrites.push_back(std::move(write));
+
+        if (type == PendingWrite::CLEAR)
+        {
+            _pendingItems.clear();
+            _pendingClearSeq = seq;
+        }
+        else
+        {
+            PendingItem& item = _pendingItems[key];
+            item.removed = type == PendingWrite::REMOVE;
+            item.value = value;
+            item.seq = seq;
+        }
+    }
+    _writeCondition.notify_one();
+}
+
 void localStorageInit( const std::string& fullpath/* = "" */)
 {
     if (!_initialized) {
 
         int ret = 0;
 		
+        _path = fullpath;
         if (fullpath.empty())
             ret = sqlite3_open(":memory:", &_db);
         else
             ret = sqlite3_open(fullpath.c_str(), &_db);
 
+        if (!fullpath.empty())
+        {
+            // readers and the writer don't block each other, and commits don't wait for the disk
+            localStorageExec(_db, "PRAGMA journal_mode=WAL;");
+            localStorageExec(_db, "PRAGMA synchronous=NORMAL;");
+            sqlite3_busy_timeout(_db, 1000);
+        }
+
         localStorageCreateTable();
 
         // SELECT
@@ -86,21 +267,38 @@ void localStorageInit( const std::string& fullpath/* = "" */)
         const char *sql_clear = "DELETE FROM data;";
         ret |= sqlite3_prepare_v2(_db, sql_clear, -1, &_stmt_clear, nullptr);
 
+        // Ranges, which use the index of the primary key
+        const char *sql_select_from = "SELECT key, value FROM data WHERE key>=? ORDER BY key;";
+        ret |= sqlite3_prepare_v2(_db, sql_select_from, -1, &_stmt_select_from, nullptr);
+        const char *sql_select_range = "SELECT key, value FROM data WHERE key>=? AND key<? ORDER BY key;";
+        ret |= sqlite3_prepare_v2(_db, sql_select_range, -1, &_stmt_select_range, nullptr);
+
         if (ret != SQLITE_OK) {
             printf("Error initializing DB\n");
             // report error
         }
 		
         _initialized = 1;
+
+        if (_writeBehind && !localStorageIsInMemory())
+            localStorageStartWriter();
     }
 }
 
 void localStorageFree()
 {
     if (_initialized) {
+        if (_writerThread.joinable())
+            localStorageStopWriter();
+        while (_batchDepth > 0)
+            localStorageCommitBatch();
+
         sqlite3_finalize(_stmt_select);
         sqlite3_finalize(_stmt_remove);
         sqlite3_finalize(_stmt_update);
+        sqlite3_finalize(_stmt_clear);
+        sqlite3_finalize(_stmt_select_from);
+        sqlite3_finalize(_stmt_select_range);
 
         sqlite3_close(_db);
 		
@@ -112,6 +310,12 @@ void localStorageFree()
 void localStorageSetItem( const std::string& key, const std::string& value)
 {
     assert( _initialized );
+
+    if (_writerThread.joinable())
+    {
+        localStorageQueueWrite(PendingWrite::SET, key, value);
+        return;
+    }
 	
     int ok = sqlite3_bind_text(_stmt_update, 1, key.c_str(), -1, SQLITE_TRANSIENT);
     ok |= sqlite3_bind_text(_stmt_update, 2, value.c_str(), -1, SQLITE_TRANSIENT);
@@ -129,6 +333,21 @@ bool localStorageGetItem( const std::string& key, std::string *outItem )
 {
     assert( _initialized );
 
+    if (_writerThread.joinable())
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        auto it = _pendingItems.find(key);
+        if (it != _pendingItems.end())
+        {
+            if (it->second.removed)
+                return false;
+            outItem->assign(it->second.value);
+            return true;
+        }
+        if (_pendingClearSeq != 0)
+            return false;
+    }
+
     int ok = sqlite3_reset(_stmt_select);
 
     ok |= sqlite3_bind_text(_stmt_select, 1, key.c_str(), -1, SQLITE_TRANSIENT);
@@ -156,6 +375,12 @@ void localStorageRemoveItem( const std::string& key )
 {
     assert( _initialized );
 
+    if (_writerThread.joinable())
+    {
+        localStorageQueueWrite(PendingWrite::REMOVE, key, std::string());
+        return;
+    }
+
     int ok = sqlite3_bind_text(_stmt_remove, 1, key.c_str(), -1, SQLITE_TRANSIENT);
 	
     ok |= sqlite3_step(_stmt_remove);
@@ -170,11 +395,132 @@ void localStorageRemoveItem( const std::string& key )
 void localStorageClear()
 {
     assert( _initialized );
+
+    if (_writerThread.joinable())
+    {
+        localStorageQueueWrite(PendingWrite::CLEAR, std::string(), std::string());
+        return;
+    }
     
     int ok = sqlite3_step(_stmt_clear);
+    ok |= sqlite3_reset(_stmt_clear);
     
     if( ok != SQLITE_OK && ok != SQLITE_DONE)
         printf("Error in localStorage.clear()\n");
 }
 
+void localStorageBeginBatch()
+{
+    assert( _initialized );
+
+    if (_writerThread.joinable())
+    {
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        ++_queuedBatchDepth;
+        return;
+    }
+
+    if (_batchDepth++ == 0)
+        localStorageExec(_db, "BEGIN;");
+}
+
+void localStorageCommitBatch()
+{
+    assert( _initialized );
+
+    if (_writerThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_writeMutex);
+            assert(_queuedBatchDepth > 0);
+            --_queuedBatchDepth;
+        }
+        _writeCondition.notify_one();
+        return;
+    }
+
+    assert(_batchDepth > 0);
+    if (--_batchDepth == 0)
+        localStorageExec(_db, "COMMIT;");
+}
+
+void localStorageSetWriteBehind(bool enabled)
+{
+    _writeBehind = enabled;
+    if (!_initialized || localStorageIsInMemory())
+        return;
+
+    if (enabled && !_writerThread.joinable())
+    {
+        // the writer has its own transactions
+        while (_batchDepth > 0)
+            localStorageCommitBatch();
+        localStorageStartWriter();
+    }
+    else if (!enabled && _writerThread.joinable())
+    {
+        localStorageStopWriter();
+        _queuedBatchDepth = 0;
+    }
+}
+
+void localStorageFlush()
+{
+    if (!_writerThread.joinable())
+        return;
+
+    std::unique_lock<std::mutex> lock(_writeMutex);
+    unsigned long long seq = _queuedSeq;
+    ++_flushWaiters;
+    _writeCondition.notify_one();
+    _writtenCondition.wait(lock, [seq] { return _writtenSeq >= seq; });
+    --_flushWaiters;
+}
+
+static void localStorageGetItems(const std::string& first, const std::string* last, const std::string& prefix,
+                                 std::vector<std::pair<std::string, std::string>> *outItems)
+{
+    assert( _initialized );
+
+    // the pending writes are written first, so that the query sees them
+    localStorageFlush();
+
+    sqlite3_stmt *stmt = last ? _stmt_select_range : _stmt_select_from;
+    int ok = sqlite3_bind_text(stmt, 1, first.c_str(), -1, SQLITE_TRANSIENT);
+    if (last)
+        ok |= sqlite3_bind_text(stmt, 2, last->c_str(), -1, SQLITE_TRANSIENT);
+
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        const char *key = (const char*)sqlite3_column_text(stmt, 0);
+        const char *value = (const char*)sqlite3_column_text(stmt, 1);
+        if (!key)
+            continue;
+        // keys are sorted, the first one without the prefix ends it
+        if (!prefix.empty() && strncmp(key, prefix.c_str(), prefix.size()) != 0)
+            break;
+        outItems->push_back(std::make_pair(std::string(key), std::string(value ? value : "")));
+    }
+    if (step != SQLITE_ROW && step != SQLITE_DONE)
+        ok |= step;
+    ok |= sqlite3_reset(stmt);
+
+    if (ok != SQLITE_OK)
+        printf("Error in localStorage range query\n");
+}
+
+void localStorageGetItemsWithPrefix( const std::string& prefix, std::vector<std::pair<std::string, std::string>> *outItems )
+{
+    localStorageGetItems(prefix, nullptr, prefix, outItems);
+}
+
+void localStorageGetItemsInRange( const std::string& first, const std::string& last, std::vector<std::pair<std::string, std::string>> *outItems )
+{
+    if (last.empty())
+        localStorageGetItems(first, nullptr, std::string(), outItems);
+    else
+        localStorageGetItems(first, &last, std::string(), outItems);
+}
+
 #endif // #if (CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
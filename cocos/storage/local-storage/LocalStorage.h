@@ -27,6 +27,8 @@ THE SOFTWARE.
 #define __JSB_LOCALSTORAGE_H
 
 #include <string>
+#include <utility>
+#include <vector>
 #include "platform/CCPlatformMacros.h"
 
 /**
@@ -54,6 +56,38 @@ void CC_DLL localStorageRemoveItem( const std::string& key );
 /** Removes all items from the JS. */
 void CC_DLL localStorageClear();
 
+/** Starts a batch: the writes until the matching localStorageCommitBatch are committed together.
+ * Batches may be nested, the outermost one commits.
+ * @since v3.15
+ */
+void CC_DLL localStorageBeginBatch();
+
+/** Ends a batch started by localStorageBeginBatch.
+ * @since v3.15
+ */
+void CC_DLL localStorageCommitBatch();
+
+/** Queues the writes and writes them in batches on a background thread, reads see the queued writes.
+ * Only for file databases, writes stay synchronous in memory and on Android.
+ * @since v3.15
+ */
+void CC_DLL localStorageSetWriteBehind( bool enabled );
+
+/** Waits until the queued writes are written.
+ * @since v3.15
+ */
+void CC_DLL localStorageFlush();
+
+/** Gets the items whose key starts with prefix, sorted by key.
+ * @since v3.15
+ */
+void CC_DLL localStorageGetItemsWithPrefix( const std::string& prefix, std::vector<std::pair<std::string, std::string>> *outItems );
+
+/** Gets the items whose key is in [first, last), sorted by key. An empty last means no upper bound.
+ * @since v3.15
+ */
+void CC_DLL localStorageGetItemsInRange( const std::string& first, const std::string& last, std::vector<std::pair<std::string, std::string>> *outItems );
+
 // end group
 /// @}
 
@@ -27,13 +27,11 @@
 #include "base/CCDirector.h"
 
 #include <stdio.h>
+#include <atomic>
+#include <thread>
 
-#ifdef MINIZIP_FROM_SYSTEM
-#include <minizip/unzip.h>
-#else // from our embedded sources
-#include "unzip.h"
-#endif
 #include "base/CCAsyncTaskPool.h"
+#include "base/ZipUtils.h"
 
 NS_CC_EXT_BEGIN
 
@@ -41,11 +39,11 @@ NS_CC_EXT_BEGIN
 #define TEMP_MANIFEST_FILENAME  "project.manifest.temp"
 #define MANIFEST_FILENAME       "project.manifest"
 
-#define BUFFER_SIZE    8192
-#define MAX_FILENAME   512
-
 #define DEFAULT_CONNECTION_TIMEOUT 8
 
+// extraction is I/O bound, it runs on its own threads instead of the ones of ParallelTaskPool
+#define MAX_DECOMPRESS_THREADS  4
+
 const std::string AssetsManagerEx::VERSION_ID = "@version";
 const std::string AssetsManagerEx::MANIFEST_ID = "@manifest";
 
@@ -287,130 +285,96 @@ bool AssetsManagerEx::decompress(const std::string &zip)
     const std::string rootPath = zip.substr(0, pos+1);
     
     // Open the zip file
-    unzFile zipfile = unzOpen(FileUtils::getInstance()->getSuitableFOpen(zip).c_str());
-    if (! zipfile)
+    ZipFile zipFile(zip);
+    if (!zipFile.isOpen())
     {
         CCLOG("AssetsManagerEx : can not open downloaded zip file %s\n", zip.c_str());
         return false;
     }
     
-    // Get info about the zip file
-    unz_global_info global_info;
-    if (unzGetGlobalInfo(zipfile, &global_info) != UNZ_OK)
-    {
-        CCLOG("AssetsManagerEx : can not read file global info of %s\n", zip.c_str());
-        unzClose(zipfile);
-        return false;
-    }
-    
-    // Buffer to hold data read from the zip file
-    char readBuffer[BUFFER_SIZE];
-    // Loop to extract all files.
-    uLong i;
-    for (i = 0; i < global_info.number_entry; ++i)
+    // Create all directories in advance, the files are then extracted in parallel without FileUtils
+    std::vector<std::string> fileNames;
+    std::vector<std::string> outputPaths;
+    for (const auto& fileName : zipFile.getFileNames())
     {
-        // Get info about current file.
-        unz_file_info fileInfo;
-        char fileName[MAX_FILENAME];
-        if (unzGetCurrentFileInfo(zipfile,
-                                  &fileInfo,
-                                  fileName,
-                                  MAX_FILENAME,
-                                  NULL,
-                                  0,
-                                  NULL,
-                                  0) != UNZ_OK)
-        {
-            CCLOG("AssetsManagerEx : can not read compressed file info\n");
-            unzClose(zipfile);
-            return false;
-        }
         const std::string fullPath = rootPath + fileName;
         
         // Check if this entry is a directory or a file.
-        const size_t filenameLength = strlen(fileName);
-        if (fileName[filenameLength-1] == '/')
+        if (fileName.empty() || fileName.back() == '/')
         {
             //There are not directory entry in some case.
             //So we need to create directory when decompressing file entry
-            if ( !_fileUtils->createDirectory(basename(fullPath)) )
+            if ( !fileName.empty() && !_fileUtils->createDirectory(basename(fullPath)) )
             {
                 // Failed to create directory
                 CCLOG("AssetsManagerEx : can not create directory %s\n", fullPath.c_str());
-                unzClose(zipfile);
                 return false;
             }
         }
         else
         {
-            // Create all directories in advance to avoid issue
             std::string dir = basename(fullPath);
             if (!_fileUtils->isDirectoryExist(dir)) {
                 if (!_fileUtils->createDirectory(dir)) {
                     // Failed to create directory
                     CCLOG("AssetsManagerEx : can not create directory %s\n", fullPath.c_str());
-                    unzClose(zipfile);
                     return false;
                 }
             }
-            // Entry is a file, so extract it.
-            // Open current file.
-            if (unzOpenCurrentFile(zipfile) != UNZ_OK)
-            {
-                CCLOG("AssetsManagerEx : can not extract file %s\n", fileName);
-                unzClose(zipfile);
-                return false;
-            }
-            
+            fileNames.push_back(fileName);
+            outputPaths.push_back(_fileUtils->getSuitableFOpen(fullPath));
+        }
+    }
+    
+    // Each thread takes the next file and streams it into the destination file in chunks
+    std::atomic<bool> failed(false);
+    std::atomic<int> nextFile(0);
+    auto extract = [&]() {
+        for (int i = nextFile++; i < (int)fileNames.size() && !failed.load(); i = nextFile++)
+        {
             // Create a file to store current file.
-            FILE *out = fopen(FileUtils::getInstance()->getSuitableFOpen(fullPath).c_str(), "wb");
+            FILE *out = fopen(outputPaths[i].c_str(), "wb");
             if (!out)
             {
-                CCLOG("AssetsManagerEx : can not create decompress destination file %s (errno: %d)\n", fullPath.c_str(), errno);
-                unzCloseCurrentFile(zipfile);
-                unzClose(zipfile);
-                return false;
+                CCLOG("AssetsManagerEx : can not create decompress destination file %s (errno: %d)\n", outputPaths[i].c_str(), errno);
+                failed = true;
+                break;
             }
             
             // Write current file content to destinate file.
-            int error = UNZ_OK;
-            do
-            {
-                error = unzReadCurrentFile(zipfile, readBuffer, BUFFER_SIZE);
-                if (error < 0)
-                {
-                    CCLOG("AssetsManagerEx : can not read zip file %s, error code is %d\n", fileName, error);
-                    fclose(out);
-                    unzCloseCurrentFile(zipfile);
-                    unzClose(zipfile);
-                    return false;
-                }
-                
-                if (error > 0)
-                {
-                    fwrite(readBuffer, error, 1, out);
-                }
-            } while(error > 0);
-            
+            bool written = true;
+            bool read = zipFile.readFile(fileNames[i], [out, &written](const unsigned char* data, size_t size) {
+                written = fwrite(data, size, 1, out) == 1;
+                return written;
+            });
             fclose(out);
-        }
-        
-        unzCloseCurrentFile(zipfile);
-        
-        // Goto next entry listed in the zip file.
-        if ((i+1) < global_info.number_entry)
-        {
-            if (unzGoToNextFile(zipfile) != UNZ_OK)
+            if (!written)
             {
-                CCLOG("AssetsManagerEx : can not read next file for decompressing\n");
-                unzClose(zipfile);
-                return false;
+                CCLOG("AssetsManagerEx : can not write decompress destination file %s\n", outputPaths[i].c_str());
+                failed = true;
+            }
+            else if (!read)
+            {
+                CCLOG("AssetsManagerEx : can not extract file %s\n", fileNames[i].c_str());
+                failed = true;
             }
         }
+    };
+    
+    // this thread extracts files too
+    std::vector<std::thread> threads;
+    int threadCount = MIN(MAX_DECOMPRESS_THREADS, (int)std::thread::hardware_concurrency());
+    for (int i = 1; i < MIN(threadCount, (int)fileNames.size()); ++i)
+    {
+        threads.emplace_back(extract);
+    }
+    extract();
+    for (auto& thread : threads)
+    {
+        thread.join();
     }
     
-    unzClose(zipfile);
-    return true;
+    return !failed.load();
 }
 
 void AssetsManagerEx::decompressDownloadedZip()
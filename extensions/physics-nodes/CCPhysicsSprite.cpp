@@ -446,6 +446,7 @@ void PhysicsSprite::afterUpdate(EventCustom* /*event*/)
     
     _transformDirty = false;
     _transformUpdated = true;
+    markFrozenParentsDirty();
     setDirtyRecursively(true);
 }
 